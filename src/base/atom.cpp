@@ -0,0 +1,35 @@
+#include "atom.h"
+
+struct AtomState {
+  ConcurrentMap<Atom, String> table;
+  Arena arena;
+  u32 arena_lock;
+};
+
+global AtomState atom_st;
+
+Atom atom_from_str(String str) {
+  AtomState& g = atom_st;
+  Atom atom = {atom_hash((char*)str.str, str.size)};
+  String existing;
+  // checked in every build, two names on one atom would quietly load each other's assets
+  if (g.table.get(atom, &existing)) {
+    AssertAlwaysMsg(str_match(existing, str), "atom collision: %s and %s", existing, str);
+    return atom;
+  }
+  spin_lock(&g.arena_lock);
+  if (!g.arena.base) {
+    g.arena = arena_init_named("atoms");
+  }
+  String copy = push_str_copy(g.arena, str);
+  spin_unlock(&g.arena_lock);
+  existing = g.table.get_or_add(atom, copy);
+  AssertAlwaysMsg(str_match(existing, str), "atom collision: %s and %s", existing, str);
+  return atom;
+}
+
+String atom_str(Atom atom) {
+  String result = {};
+  atom_st.table.get(atom, &result);
+  return result;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include "base.h"
+#include "thread.h"
+
+////////////////////////////////////////////////////////////////////////
+// Atom
+
+// Interned string. The value is the 32-bit FNV-1a hash of the bytes, so a string maps
+// to the same atom on every thread and across hot reloads, and literals hash at compile time.
+// Two registered strings with the same hash trap in every build.
+struct Atom {
+  u32 v;
+};
+
+inline b32 operator==(Atom a, Atom b) { return a.v == b.v; }
+inline b32 operator!=(Atom a, Atom b) { return a.v != b.v; }
+inline u64 hash(Atom a) { return a.v; }
+inline b32 equal(Atom a, Atom b) { return a.v == b.v; }
+
+constexpr u32 atom_hash(const char* str, u64 size) {
+  u32 result = 0x811c9dc5;
+  Loop (i, size) {
+    result = ((u8)str[i] ^ result) * 0x01000193;
+  }
+  return result;
+}
+
+template<u64 N> consteval Atom atom_lit(const char (&str)[N]) { return {atom_hash(str, N-1)}; }
+
+// registers the string so atom_str can give it back, thread safe
+Atom   atom_from_str(String str);
+// null terminated copy owned by the table, empty for atoms that were never registered
+String atom_str(Atom atom);
@@ -1,4 +1,5 @@
 #include "base.h"
+#include "logger.h"
 
 ////////////////////////////////////////////////////////////////////////
 // Basic
@@ -73,8 +74,10 @@ u32 prev_pow2(u32 n) {
 ////////////////////////////////////////////////////////////////////////
 // Asserts
 
+// Trap raises SIGILL and the crash handler flushes. DebugTrap's SIGTRAP stays with the debugger,
+// and it can fire while this thread drains the log, where log_flush would wait on itself
 void Trap()      { __builtin_trap(); }
-void DebugTrap() { __builtin_debugtrap(); }
+void DebugTrap() { log_try_flush(); __builtin_debugtrap(); }
 
 global u64 _cpu_frequency;
 
@@ -41,6 +41,12 @@ typedef va_list VaList;
 #elif __aarch64__ || _M_ARM64
   #define ARCH_ARM64 1
 #endif
+#if ARCH_X64
+  #include <immintrin.h>
+#endif
+#if __AVX2__
+  #define SIMD_AVX2 1
+#endif
 
 ////////////////////////////////////////////////////////////////////////
 // OS
@@ -105,6 +111,7 @@ const u64 U8_MAX  = 0xFF;
 const u64 U16_MAX = 0xFFFF;
 const u64 U32_MAX = 0xFFFFFFFF;
 const u64 U64_MAX = 0xFFFFFFFFFFFFFFFF;
+const f32 F32_MAX = 3.402823466e+38f;
 const u64 INVALID_ID = U32_MAX;
 const u64 PAGE_SIZE = 4096;
 
@@ -229,11 +236,12 @@ void DebugTrap();
 #define InvalidDefaultCase  default: {InvalidPath;}
 #define NotImplemented      Assert(!"Not Implemented!")
 #define AssertAlways(x)     if (!(x)) { Trap(); }
+#define AssertAlwaysMsg(x, message, ...) if (!(x)) { _log_output(LogCategory_General, LogLevel_Error, message, ##__VA_ARGS__); Trap(); }
 #define UnusedVariable(x)   (void)x
 
 #if BUILD_DEBUG
   #define Assert(x) if (!(x)) { DebugTrap(); }
-  #define AssertMsg(x, message, ...) if (!(x)) { _log_output(LogLevel_Error, message, ##__VA_ARGS__); DebugTrap(); }
+  #define AssertMsg(x, message, ...) if (!(x)) { _log_output(LogCategory_General, LogLevel_Error, message, ##__VA_ARGS__); DebugTrap(); }
 #else
   #define Assert(x)
   #define AssertMsg(x, message, ...)
@@ -255,6 +263,12 @@ void DebugTrap();
 #define atomic_u32_cmp_exchange(x, old, new) __atomic_compare_exchange_n((x), (old), (new), 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)
 #define atomic_u32_cond_exchange(x, v, c) ({ u32 _new = (c); __atomic_compare_exchange_n((x), (&_new), (v), 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST); _new; })
 
+#define atomic_u64_load(x)                   __atomic_load_n((x), __ATOMIC_SEQ_CST)
+#define atomic_u64_store(x, v)               __atomic_store_n((x), (v), __ATOMIC_SEQ_CST)
+#define atomic_u64_or(x, v)                  __atomic_fetch_or((x), (v), __ATOMIC_SEQ_CST)
+#define atomic_u64_and(x, v)                 __atomic_fetch_and((x), (v), __ATOMIC_SEQ_CST)
+#define atomic_u64_xor(x, v)                 __atomic_fetch_xor((x), (v), __ATOMIC_SEQ_CST)
+
 ////////////////////////////////////////////////////////////////////////
 // Link list
 
@@ -335,7 +349,8 @@ void estimate_cpu_frequency();
 
 const u32 DEFAULT_CAPACITY = 8;
 const u32 DEFAULT_RESIZE_FACTOR = 2;
-const u32 THREAD_COUNT = 2;
+// most workers the thread pool launches, also sizes the profiler's per-thread slots
+const u32 THREAD_MAX = 16;
 
 ////////////////////////////////////////////////////////////////////////
 // Types
@@ -393,7 +408,7 @@ struct String {
 struct String64 {
   u8 str[64];
   u32 size;
-  operator String();
+  operator String() const;
 };
 
 // AllocatorInfo* data = ...;
@@ -7,6 +7,7 @@
 #include "str.cpp"
 #include "thread_ctx.cpp"
 #include "thread.cpp"
+#include "atom.cpp"
 #include "profiler.cpp"
 
 #include "os/os_impl.cpp"
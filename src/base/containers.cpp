@@ -175,6 +175,90 @@ void StaticIdPool::free(u32 id) {
   ids[--count] = idx;
 }
 
+////////////////////////////////////////////////////////////////////////
+// Bitset
+
+void bits_and(u64* dst, u64* src, u32 word_count) {
+  u32 i = 0;
+#if SIMD_AVX2
+  for (; i + 4 <= word_count; i += 4) {
+    __m256i a = _mm256_loadu_si256((__m256i*)(dst + i));
+    __m256i b = _mm256_loadu_si256((__m256i*)(src + i));
+    _mm256_storeu_si256((__m256i*)(dst + i), _mm256_and_si256(a, b));
+  }
+#endif
+  for (; i < word_count; ++i) {
+    dst[i] &= src[i];
+  }
+}
+
+void bits_or(u64* dst, u64* src, u32 word_count) {
+  u32 i = 0;
+#if SIMD_AVX2
+  for (; i + 4 <= word_count; i += 4) {
+    __m256i a = _mm256_loadu_si256((__m256i*)(dst + i));
+    __m256i b = _mm256_loadu_si256((__m256i*)(src + i));
+    _mm256_storeu_si256((__m256i*)(dst + i), _mm256_or_si256(a, b));
+  }
+#endif
+  for (; i < word_count; ++i) {
+    dst[i] |= src[i];
+  }
+}
+
+void bits_andnot(u64* dst, u64* src, u32 word_count) {
+  u32 i = 0;
+#if SIMD_AVX2
+  for (; i + 4 <= word_count; i += 4) {
+    __m256i a = _mm256_loadu_si256((__m256i*)(dst + i));
+    __m256i b = _mm256_loadu_si256((__m256i*)(src + i));
+    _mm256_storeu_si256((__m256i*)(dst + i), _mm256_andnot_si256(b, a));
+  }
+#endif
+  for (; i < word_count; ++i) {
+    dst[i] &= ~src[i];
+  }
+}
+
+u64 bits_count(u64* words, u32 word_count) {
+  u64 result = 0;
+  u32 i = 0;
+#if SIMD_AVX2
+  // nibble lookup popcount, sums bytes with sad
+  __m256i lookup = _mm256_setr_epi8(0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4,
+                                    0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4);
+  __m256i low_mask = _mm256_set1_epi8(0x0f);
+  __m256i acc = _mm256_setzero_si256();
+  for (; i + 4 <= word_count; i += 4) {
+    __m256i v = _mm256_loadu_si256((__m256i*)(words + i));
+    __m256i lo = _mm256_and_si256(v, low_mask);
+    __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+    __m256i cnt = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo), _mm256_shuffle_epi8(lookup, hi));
+    acc = _mm256_add_epi64(acc, _mm256_sad_epu8(cnt, _mm256_setzero_si256()));
+  }
+  result += (u64)_mm256_extract_epi64(acc, 0) + (u64)_mm256_extract_epi64(acc, 1) +
+            (u64)_mm256_extract_epi64(acc, 2) + (u64)_mm256_extract_epi64(acc, 3);
+#endif
+  for (; i < word_count; ++i) {
+    result += __builtin_popcountll(words[i]);
+  }
+  return result;
+}
+
+u32 bits_find_next(u64* words, u32 word_count, u32 from) {
+  u32 word_idx = from / 64;
+  if (word_idx >= word_count) return INVALID_ID;
+  u64 word = words[word_idx] & (U64_MAX << (from % 64));
+  for (;;) {
+    if (word) {
+      return word_idx*64 + __builtin_ctzll(word);
+    }
+    if (++word_idx >= word_count) break;
+    word = words[word_idx];
+  }
+  return INVALID_ID;
+}
+
 // struct Entity {
 //   v3 pos;
 //   f32 health;
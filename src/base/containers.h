@@ -67,22 +67,46 @@ struct Array {
 ////////////////////////////////////////////////////////////////////////
 // Darray
 
+// NOTE: Darray<T, N> keeps first N elements inline and goes to alloc only after that
+template <typename T, i32 N>
+struct DarrayInline {
+  alignas(T) u8 mem[N * sizeof(T)];
+  T* ptr() { return (T*)mem; }
+};
+
 template <typename T>
+struct DarrayInline<T, 0> {
+  T* ptr() { return null; }
+};
+
+template <typename T, i32 N = 0>
 struct Darray {
   u32 count;
   u32 cap;
   Allocator alloc;
   T* data;
+  [[no_unique_address]] DarrayInline<T, N> inline_data;
   Darray() = default;
   Darray(Allocator alloc_) { init(alloc_); }
-  void init(Allocator alloc_) { *this = {}; alloc = alloc_; }
+  // data points into itself, so inline darray can't be copied
+  Darray(const Darray&) requires (N == 0) = default;
+  Darray(const Darray&) requires (N > 0) = delete;
+  Darray& operator=(const Darray&) requires (N == 0) = default;
+  Darray& operator=(const Darray&) requires (N > 0) = delete;
+  void init(Allocator alloc_) {
+    count = 0;
+    cap = N;
+    alloc = alloc_;
+    data = inline_data.ptr();
+  }
   void init(Allocator alloc_, u32 count_, u32 cap_) { 
     count = count_;
     cap = cap_;
     alloc = alloc_;
     data = push_array(alloc, T, cap);
   }
-  void deinit() { if (data) { mem_free(alloc, data); } }
+  void deinit() { if (data && !is_inline()) { mem_free(alloc, data); } }
+  b32 is_inline() { return N > 0 && data == inline_data.ptr(); }
   T* begin() { return data; }
   T* end()   { return data + count; }
   T& operator[](u32 idx) {
@@ -116,23 +140,23 @@ struct Darray {
     count += elem_count;
   }
   void grow(u32 elem_count) {
-    if (data) {
-      u32 old_cap = cap;
-      cap = Max(cap * DEFAULT_RESIZE_FACTOR, count + elem_count);
-      data = mem_realloc_array(alloc, data, old_cap, cap);
-    } else {
-      cap = Max(DEFAULT_CAPACITY, elem_count);
-      data = push_array(alloc, T, cap);
-    }
+    u32 new_cap = Max(cap * DEFAULT_RESIZE_FACTOR, count + elem_count);
+    set_cap(Max(new_cap, DEFAULT_CAPACITY));
   }
   void reserve(u32 min_cap) { 
     if (cap >= min_cap) return;
-    u32 old_cap = cap;
-    u32 new_cap = Max(old_cap*DEFAULT_RESIZE_FACTOR, min_cap);
-    if (data) {
-      data = mem_realloc_array(alloc, data, old_cap, new_cap);
+    set_cap(Max(cap*DEFAULT_RESIZE_FACTOR, min_cap));
+  }
+  // NOTE: arena grows last allocation in place, so realloc is not always a copy
+  void set_cap(u32 new_cap) {
+    if (data && !is_inline()) {
+      data = mem_realloc_array(alloc, data, cap, new_cap);
     } else {
-      data = push_array(alloc, T, new_cap);
+      T* heap = push_array(alloc, T, new_cap);
+      if (count) {
+        MemCopyArray(heap, data, count);
+      }
+      data = heap;
     }
     cap = new_cap;
   }
@@ -165,12 +189,8 @@ struct Darray {
     return false;
   }
   Darray<T> clone(Allocator alloc_) {
-    Darray<T> result = {
-      .count = count,
-      .cap = cap,
-      .alloc = alloc_,
-      .data = push_array(alloc_, T, cap),
-    };
+    Darray<T> result;
+    result.init(alloc_, count, cap);
     MemCopyArray(result.data, data, count);
     return result;
   }
@@ -860,6 +880,122 @@ struct StaticIdPool {
   void free(u32 id);
 };
 
+////////////////////////////////////////////////////////////////////////
+// Bitset
+
+// word-wide ops, AVX2 when available
+void bits_and(u64* dst, u64* src, u32 word_count);
+void bits_or(u64* dst, u64* src, u32 word_count);
+void bits_andnot(u64* dst, u64* src, u32 word_count);
+u64  bits_count(u64* words, u32 word_count);
+u32  bits_find_next(u64* words, u32 word_count, u32 from);
+
+#define BitsetWordCount(bit_count) (((bit_count) + 63) / 64)
+
+template<typename Fn> void bits_for_each_set(u64* words, u32 word_count, Fn fn) {
+  Loop (word_idx, word_count) {
+    u64 word = words[word_idx];
+    while (word) {
+      fn((u32)(word_idx*64 + __builtin_ctzll(word)));
+      word &= word - 1;
+    }
+  }
+}
+
+template<i32 N>
+struct Bitset {
+  static constexpr i32 cap = N;
+  static constexpr u32 word_count = BitsetWordCount(N);
+  alignas(32) u64 words[word_count];
+  void set(u32 idx)    { Assert(idx < cap); words[idx/64] |= 1ull << (idx%64); }
+  void clear(u32 idx)  { Assert(idx < cap); words[idx/64] &= ~(1ull << (idx%64)); }
+  void toggle(u32 idx) { Assert(idx < cap); words[idx/64] ^= 1ull << (idx%64); }
+  b32 has(u32 idx)     { Assert(idx < cap); return (words[idx/64] >> (idx%64)) & 1; }
+  // return previous state of the bit
+  b32 set_atomic(u32 idx) {
+    Assert(idx < cap);
+    u64 mask = 1ull << (idx%64);
+    return (atomic_u64_or(&words[idx/64], mask) & mask) != 0;
+  }
+  b32 clear_atomic(u32 idx) {
+    Assert(idx < cap);
+    u64 mask = 1ull << (idx%64);
+    return (atomic_u64_and(&words[idx/64], ~mask) & mask) != 0;
+  }
+  void clear_all() { MemZeroArray(words, word_count); }
+  void bit_and(Bitset& b)    { bits_and(words, b.words, word_count); }
+  void bit_or(Bitset& b)     { bits_or(words, b.words, word_count); }
+  void bit_andnot(Bitset& b) { bits_andnot(words, b.words, word_count); }
+  u64 count()                { return bits_count(words, word_count); }
+  // INVALID_ID when there is no set bit
+  u32 find_first()           { return bits_find_next(words, word_count, 0); }
+  u32 find_next(u32 from)    { return bits_find_next(words, word_count, from); }
+  template<typename Fn> void for_each_set(Fn fn) { bits_for_each_set(words, word_count, fn); }
+};
+
+struct DBitset {
+  u32 cap;
+  u32 word_count;
+  Allocator alloc;
+  u64* words;
+  DBitset() = default;
+  DBitset(Allocator alloc_) { init(alloc_); }
+  void init(Allocator alloc_) { *this = {}; alloc = alloc_; }
+  void init(Allocator alloc_, u32 cap_) {
+    *this = {};
+    alloc = alloc_;
+    reserve(cap_);
+  }
+  void deinit() { if (words) { mem_free(alloc, words); } }
+  void set(u32 idx) { 
+    if (idx >= cap) {
+      reserve(idx+1);
+    }
+    words[idx/64] |= 1ull << (idx%64);
+  }
+  void clear(u32 idx)  { Assert(idx < cap); words[idx/64] &= ~(1ull << (idx%64)); }
+  void toggle(u32 idx) { Assert(idx < cap); words[idx/64] ^= 1ull << (idx%64); }
+  b32 has(u32 idx)     { return idx < cap ? (words[idx/64] >> (idx%64)) & 1 : false; }
+  // bitset must be reserved up front, atomics don't grow
+  b32 set_atomic(u32 idx) {
+    Assert(idx < cap);
+    u64 mask = 1ull << (idx%64);
+    return (atomic_u64_or(&words[idx/64], mask) & mask) != 0;
+  }
+  b32 clear_atomic(u32 idx) {
+    Assert(idx < cap);
+    u64 mask = 1ull << (idx%64);
+    return (atomic_u64_and(&words[idx/64], ~mask) & mask) != 0;
+  }
+  void clear_all() { MemZeroArray(words, word_count); }
+  void bit_and(DBitset& b) {
+    u32 common = Min(word_count, b.word_count);
+    bits_and(words, b.words, common);
+    MemZeroArray(words + common, word_count - common);
+  }
+  void bit_or(DBitset& b) {
+    reserve(b.cap);
+    bits_or(words, b.words, b.word_count);
+  }
+  void bit_andnot(DBitset& b) { bits_andnot(words, b.words, Min(word_count, b.word_count)); }
+  u64 count()                 { return bits_count(words, word_count); }
+  u32 find_first()            { return bits_find_next(words, word_count, 0); }
+  u32 find_next(u32 from)     { return bits_find_next(words, word_count, from); }
+  template<typename Fn> void for_each_set(Fn fn) { bits_for_each_set(words, word_count, fn); }
+  void reserve(u32 min_cap) {
+    if (cap >= min_cap) return;
+    u32 old_word_count = word_count;
+    word_count = Max(BitsetWordCount(min_cap), old_word_count*DEFAULT_RESIZE_FACTOR);
+    if (words) {
+      words = mem_realloc_array(alloc, words, old_word_count, word_count);
+    } else {
+      words = push_array(alloc, u64, word_count);
+    }
+    MemZeroArray(words + old_word_count, word_count - old_word_count);
+    cap = word_count*64;
+  }
+};
+
 ////////////////////////////////////////////////////////////////////////
 // Hashmap
 
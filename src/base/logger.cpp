@@ -2,25 +2,108 @@
 #include "thread_ctx.h"
 #include "os/os_core.h"
 
-void _log_output(LogLevel level, String fmt, ...) {
+// per-frame diagnostics in the tagged categories are Trace, they stay quiet unless asked for
+u8 log_levels[LogCategory_Count] = {
+  [LogCategory_General]   = LogLevel_Trace,
+  [LogCategory_Vk]        = LogLevel_Debug,
+  [LogCategory_Assets]    = LogLevel_Debug,
+  [LogCategory_Hotreload] = LogLevel_Debug,
+  [LogCategory_Profiler]  = LogLevel_Debug,
+};
+
+global String log_category_names[] = {"", "vk", "assets", "hotreload", "profiler"};
+static_assert(ArrayCount(log_category_names) == LogCategory_Count);
+
+String log_level_prefix(LogLevel level) {
+  String level_strings[] = {"", "[TRACE]: ", "[DEBUG]: ", "[INFO]:  ", "[WARN]:  ", "[ERROR]: ",};
+  return level_strings[level];
+}
+
+String log_prefix(u8* buf, LogLevel level, LogCategory category) {
+  String level_prefix = log_level_prefix(level);
+  if (category == LogCategory_General) return level_prefix;
+  String name = log_category_names[category];
+  u8* at = buf;
+  MemCopy(at, level_prefix.str, level_prefix.size);
+  at += level_prefix.size;
+  *at++ = '[';
+  MemCopy(at, name.str, name.size);
+  at += name.size;
+  *at++ = ']';
+  *at++ = ' ';
+  return {buf, (u64)(at - buf)};
+}
+
+void log_set_level(LogCategory category, LogLevel level) {
+  __atomic_store_n(&log_levels[category], (u8)level, __ATOMIC_RELAXED);
+}
+
+void log_set_levels(String spec) {
+  String level_names[] = {"", "trace", "debug", "info", "warn", "error", "off"};
+  while (spec.size) {
+    i32 comma = str_index_of(spec, ',');
+    String item = str_trim(comma < 0 ? spec : str_prefix(spec, comma));
+    spec = comma < 0 ? String{} : str_skip(spec, comma + 1);
+    i32 equals = str_index_of(item, '=');
+    String category_name = equals < 0 ? String{} : str_trim(str_prefix(item, equals));
+    String level_name = equals < 0 ? item : str_trim(str_skip(item, equals + 1));
+    u32 level = 0;
+    for (u32 i = LogLevel_Trace; i <= LogLevel_Off; ++i) {
+      if (str_matchi(level_name, level_names[i])) level = i;
+    }
+    if (!level) {
+      Warn("unknown log level '%s'", level_name);
+      continue;
+    }
+    if (equals < 0) {
+      Loop (i, LogCategory_Count) log_set_level((LogCategory)i, (LogLevel)level);
+      continue;
+    }
+    b32 found = false;
+    for (u32 i = LogCategory_General + 1; i < LogCategory_Count; ++i) {
+      if (str_matchi(category_name, log_category_names[i])) {
+        log_set_level((LogCategory)i, (LogLevel)level);
+        found = true;
+      }
+    }
+    if (!found && str_matchi(category_name, "general")) {
+      log_set_level(LogCategory_General, (LogLevel)level);
+      found = true;
+    }
+    if (!found) Warn("unknown log category '%s'", category_name);
+  }
+}
+
+// level 0 is plain output without color
+void log_write(LogLevel level, String line) {
+  os_console_write(line, level);
+}
+
+intern void log_output_text(Allocator arena, LogCategory category, LogLevel level, b32 newline, String text) {
+  FmtStr<String> fmt = "%s";
+  if (!log_push(category, level, newline, fmt, text)) {
+    u8 prefix[LOG_PREFIX_MAX_SIZE];
+    log_write(level, log_format(arena, log_prefix(prefix, level, category), newline, fmt, text));
+  }
+}
+
+void _log_output(LogCategory category, LogLevel level, String fmt, ...) {
+  if (!log_enabled(category, level)) return;
   Scratch scratch;
-  String level_strings[] = {"[TRACE]: ", "[DEBUG]: ", "[INFO]:  ", "[WARN]:  ", "[ERROR]: ",};
   VaList argc;
   va_start(argc, fmt);
   String formatted = push_strfv(scratch, fmt, argc);
   va_end(argc);
-  String out_message = push_strf(scratch, "%s%s\n", level_strings[level-1], formatted);
-  os_console_write(out_message, level);
+  log_output_text(scratch, category, level, true, formatted);
 }
 
-void _log_output(Allocator arena, LogLevel level, String fmt, ...) {
-  String level_strings[] = {"[TRACE]: ", "[DEBUG]: ", "[INFO]:  ", "[WARN]:  ", "[ERROR]: ",};
+void _log_output(Allocator arena, LogCategory category, LogLevel level, String fmt, ...) {
+  if (!log_enabled(category, level)) return;
   VaList argc;
   va_start(argc, fmt);
   String formatted = push_strfv(arena, fmt, argc);
   va_end(argc);
-  String out_message = push_strf(arena, "%s%s\n", level_strings[level-1], formatted);
-  os_console_write(out_message, level);
+  log_output_text(arena, category, level, true, formatted);
 }
 
 void print(String fmt, ...) {
@@ -29,8 +112,7 @@ void print(String fmt, ...) {
   va_start(argc, fmt);
   String formatted = push_strfv(scratch, fmt, argc);
   va_end(argc);
-  String out_message = push_strf(scratch, "%s", formatted);
-  os_console_write(out_message, 0);
+  log_output_text(scratch, LogCategory_General, (LogLevel)0, false, formatted);
 }
 
 void println(String fmt, ...) {
@@ -39,6 +121,356 @@ void println(String fmt, ...) {
   va_start(argc, fmt);
   String formatted = push_strfv(scratch, fmt, argc);
   va_end(argc);
-  String out_message = push_strf(scratch, "%s\n", formatted);
-  os_console_write(out_message, 0);
+  log_output_text(scratch, LogCategory_General, (LogLevel)0, true, formatted);
+}
+
+////////////////////////////////////////////////////////////////////////
+// Async Logging
+
+// single producer - the owning thread, single consumer - whoever holds drain_lock
+struct LogRing {
+  alignas(64) u64 write_pos;
+  u64 reserve_pos;
+  u64 read_pos_cached; // producer's copy, refreshed only when the ring looks full
+  alignas(64) u64 read_pos;
+  u8* data;
+};
+
+struct LoggerState {
+  b32 running;
+  b32 console;
+  u32 ring_count;
+  LogRing* rings[LOG_MAX_THREADS];
+  // the logger thread waits on wake once it finds nothing, producers bump it only then
+  u32 sleeping;
+  u32 wake;
+  // bumped after every drain, producers with a full ring wait on it
+  u32 drained;
+  // taken by whoever drains: the logger thread, log_flush or the crash handler
+  u32 drain_lock;
+  Arena arena;
+  StrBuilder file_sb;
+  StrBuilder console_sb;
+  u8 console_level;
+  OS_Handle file;
+  u64 file_size;
+  String file_path;
+  Thread thread;
+};
+
+global LoggerState log_st;
+global thread_local LogRing* log_thread_ring;
+global thread_local b32 log_thread_no_ring;
+// set while this thread holds drain_lock, an assert that fires inside log_drain must not wait on it
+global thread_local b32 log_thread_draining;
+
+intern LogRing* log_ring_get() {
+  LoggerState& g = log_st;
+  if (log_thread_ring || log_thread_no_ring) return log_thread_ring;
+  u32 idx = atomic_u32_inc(&g.ring_count);
+  if (idx >= LOG_MAX_THREADS) {
+    log_thread_no_ring = true;
+    return null;
+  }
+  u64 header_size = AlignUp(sizeof(LogRing), 64);
+  u8* mem = os_reserve(header_size + LOG_RING_SIZE);
+  os_commit(mem, header_size + LOG_RING_SIZE);
+  LogRing* ring = (LogRing*)mem;
+  *ring = {};
+  ring->data = mem + header_size;
+  __atomic_store_n(&g.rings[idx], ring, __ATOMIC_RELEASE);
+  log_thread_ring = ring;
+  return ring;
+}
+
+intern void log_wake_logger() {
+  LoggerState& g = log_st;
+  atomic_u32_inc(&g.wake);
+  os_futex_wake(&g.wake);
+}
+
+LogRecord* log_record_begin(u64 size) {
+  LoggerState& g = log_st;
+  if (!__atomic_load_n(&g.running, __ATOMIC_RELAXED)) return null;
+  size = AlignUp(size, 8);
+  if (size > LOG_RECORD_MAX_SIZE) return null;
+  LogRing* ring = log_ring_get();
+  if (!ring) return null;
+
+  u64 pos = ring->write_pos;
+  u64 tail = LOG_RING_SIZE - (pos & (LOG_RING_SIZE-1));
+  // a record never wraps, the tail it doesn't fit in is skipped
+  u64 needed = size <= tail ? size : tail + size;
+  while (pos + needed - ring->read_pos_cached > LOG_RING_SIZE) {
+    u32 drained = atomic_u32_load(&g.drained);
+    ring->read_pos_cached = __atomic_load_n(&ring->read_pos, __ATOMIC_ACQUIRE);
+    if (pos + needed - ring->read_pos_cached <= LOG_RING_SIZE) break;
+    // full, nothing is dropped, the caller waits for the next drain
+    log_wake_logger();
+    os_futex_wait(&g.drained, drained);
+  }
+  if (size > tail) {
+    if (tail >= sizeof(LogRecord)) {
+      LogRecord* padding = (LogRecord*)(ring->data + (pos & (LOG_RING_SIZE-1)));
+      padding->size = tail;
+      padding->format = null;
+    }
+    pos += tail;
+  }
+  LogRecord* record = (LogRecord*)(ring->data + (pos & (LOG_RING_SIZE-1)));
+  record->size = size;
+  record->tsc = cpu_timer_now();
+  ring->reserve_pos = pos + size;
+  return record;
+}
+
+void log_record_end(LogRecord* record) {
+  LoggerState& g = log_st;
+  LogRing* ring = log_thread_ring;
+  // seq_cst pairs with the logger's store to sleeping, one of the two sides sees the other
+  atomic_u64_store(&ring->write_pos, ring->reserve_pos);
+  if (atomic_u32_load(&g.sleeping)) {
+    log_wake_logger();
+  }
+}
+
+// skips padding, null when the ring has nothing before end
+intern LogRecord* log_ring_peek(LogRing* ring, u64* cursor, u64 end) {
+  while (*cursor < end) {
+    u64 tail = LOG_RING_SIZE - (*cursor & (LOG_RING_SIZE-1));
+    LogRecord* record = (LogRecord*)(ring->data + (*cursor & (LOG_RING_SIZE-1)));
+    if (tail >= sizeof(LogRecord) && record->format) return record;
+    *cursor += tail;
+  }
+  return null;
+}
+
+intern b32 log_rings_pending() {
+  LoggerState& g = log_st;
+  u32 ring_count = Min(atomic_u32_load(&g.ring_count), LOG_MAX_THREADS);
+  Loop (i, ring_count) {
+    LogRing* ring = __atomic_load_n(&g.rings[i], __ATOMIC_ACQUIRE);
+    if (ring && atomic_u64_load(&ring->write_pos) != __atomic_load_n(&ring->read_pos, __ATOMIC_RELAXED)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// path -> path.1 -> .. -> path.(LOG_FILE_COUNT-1), the oldest is overwritten
+intern void log_file_open_next() {
+  LoggerState& g = log_st;
+  Scratch scratch;
+  os_file_close(g.file);
+  for (u32 i = LOG_FILE_COUNT - 1; i > 0; --i) {
+    String src = i == 1 ? g.file_path : push_strf(scratch, "%s.%u", g.file_path, i - 1);
+    String dst = push_strf(scratch, "%s.%u", g.file_path, i);
+    os_file_path_rename(dst, src);
+  }
+  g.file = os_file_open(g.file_path, OS_AccessFlag_Write);
+  g.file_size = 0;
+  if (g.file.v == 0) {
+    // written directly, this runs under drain_lock
+    log_write(LogLevel_Warn, push_strf(scratch, "%scan't open log file %s\n", log_level_prefix(LogLevel_Warn), g.file_path));
+  }
+}
+
+intern void log_emit(LogRecord* record) {
+  LoggerState& g = log_st;
+  u8 prefix[LOG_PREFIX_MAX_SIZE];
+  String line = record->format(&g.file_sb, log_prefix(prefix, (LogLevel)record->level, (LogCategory)record->category), record->newline, (u8*)(record + 1));
+  if (!g.console) return;
+  // one color per console write, a level change ends the run
+  if (g.console_sb.total_size && g.console_level != record->level) {
+    os_console_write_builder(&g.console_sb, g.console_level);
+    g.console_sb.clear();
+  }
+  g.console_level = record->level;
+  g.console_sb.add_ref(line);
+}
+
+// formats everything published so far, merging threads by timestamp, the caller holds drain_lock
+intern u32 log_drain() {
+  LoggerState& g = log_st;
+  LogRing* rings[LOG_MAX_THREADS];
+  u64 cursors[LOG_MAX_THREADS];
+  u64 ends[LOG_MAX_THREADS];
+  u32 count = 0;
+  u32 ring_count = Min(atomic_u32_load(&g.ring_count), LOG_MAX_THREADS);
+  Loop (i, ring_count) {
+    LogRing* ring = __atomic_load_n(&g.rings[i], __ATOMIC_ACQUIRE);
+    if (!ring) continue;
+    u64 end = __atomic_load_n(&ring->write_pos, __ATOMIC_ACQUIRE);
+    if (ring->read_pos == end) continue;
+    rings[count] = ring;
+    cursors[count] = ring->read_pos;
+    ends[count] = end;
+    ++count;
+  }
+  if (count == 0) return 0;
+
+  Temp temp = temp_begin(&g.arena);
+  g.file_sb.init(g.arena);
+  g.console_sb.init(g.arena);
+  u32 records = 0;
+  // few rings, a linear pick of the oldest head is enough
+  while (true) {
+    LogRecord* next = null;
+    u32 next_ring = 0;
+    Loop (i, count) {
+      LogRecord* record = log_ring_peek(rings[i], &cursors[i], ends[i]);
+      if (record && (!next || record->tsc < next->tsc)) {
+        next = record;
+        next_ring = i;
+      }
+    }
+    if (!next) break;
+    log_emit(next);
+    cursors[next_ring] += next->size;
+    ++records;
+  }
+  // lines are copied out, producers can have the space back before the writes
+  Loop (i, count) {
+    __atomic_store_n(&rings[i]->read_pos, cursors[i], __ATOMIC_RELEASE);
+  }
+  atomic_u32_inc(&g.drained);
+  os_futex_wake_all(&g.drained);
+
+  if (g.console_sb.total_size) {
+    os_console_write_builder(&g.console_sb, g.console_level);
+  }
+  if (g.file.v) {
+    g.file_size += os_file_write_builder(g.file, &g.file_sb);
+    if (g.file_size >= LOG_FILE_MAX_SIZE) {
+      log_file_open_next();
+    }
+  }
+  temp_end(temp);
+  return records;
+}
+
+intern void log_drain_lock() {
+  LoggerState& g = log_st;
+  while (atomic_u32_exchange(&g.drain_lock, 1)) {
+    os_futex_wait(&g.drain_lock, 1);
+  }
+  log_thread_draining = true;
+}
+
+intern b32 log_drain_try_lock() {
+  LoggerState& g = log_st;
+  if (atomic_u32_exchange(&g.drain_lock, 1)) return false;
+  log_thread_draining = true;
+  return true;
+}
+
+intern void log_drain_unlock() {
+  LoggerState& g = log_st;
+  log_thread_draining = false;
+  atomic_u32_store(&g.drain_lock, 0);
+  os_futex_wake(&g.drain_lock);
+}
+
+intern void log_thread(void* arg) {
+  LoggerState& g = log_st;
+  tctx_init();
+  while (true) {
+    u32 wake = atomic_u32_load(&g.wake);
+    log_drain_lock();
+    u32 records = log_drain();
+    log_drain_unlock();
+    if (records) {
+      // a burst piles up into one batch meanwhile, producers don't wake us for it
+      os_sleep_ms(1);
+      continue;
+    }
+    atomic_u32_store(&g.sleeping, 1);
+    // a record published before sleeping was set didn't wake us, look once more
+    if (!log_rings_pending()) {
+      os_futex_wait(&g.wake, wake);
+    }
+    atomic_u32_store(&g.sleeping, 0);
+  }
+}
+
+// runs on the crashing thread, which may be the one holding drain_lock, so it gives up after a while
+intern void log_crash_flush() {
+  LoggerState& g = log_st;
+  for (u32 i = 0; i < 100 && !log_thread_draining; ++i) {
+    if (log_drain_try_lock()) {
+      log_drain();
+      break;
+    }
+    os_sleep_ms(1);
+  }
+  // whatever is logged while dying goes out directly
+  __atomic_store_n(&g.running, false, __ATOMIC_RELAXED);
+}
+
+void log_init(String file_path) {
+  LoggerState& g = log_st;
+  if (!g.running) {
+    g.arena = arena_init_named("logger arena");
+    g.console = true;
+    os_set_crash_handler(log_crash_flush);
+    log_set_levels(os_get_environment("LOG_LEVELS"));
+    __atomic_store_n(&g.running, true, __ATOMIC_RELEASE);
+    g.thread = os_thread_launch(log_thread, null);
+  }
+  if (file_path.size) {
+    log_drain_lock();
+    g.file_path = push_str_copy(g.arena, file_path);
+    // the previous run's log becomes path.1
+    log_file_open_next();
+    log_drain_unlock();
+  }
+}
+
+void log_set_console(b32 enabled) {
+  LoggerState& g = log_st;
+  log_drain_lock();
+  g.console = enabled;
+  log_drain_unlock();
+}
+
+void log_flush() {
+  LoggerState& g = log_st;
+  if (!__atomic_load_n(&g.running, __ATOMIC_ACQUIRE)) return;
+  log_drain_lock();
+  log_drain();
+  log_drain_unlock();
+}
+
+void log_try_flush() {
+  LoggerState& g = log_st;
+  if (!__atomic_load_n(&g.running, __ATOMIC_ACQUIRE)) return;
+  for (u32 i = 0; i < 100 && !log_thread_draining; ++i) {
+    if (log_drain_try_lock()) {
+      log_drain();
+      log_drain_unlock();
+      return;
+    }
+    os_sleep_ms(1);
+  }
+}
+
+b32 log_limiter_take(LogLimiter* limiter, LogCategory category, LogLevel level, u32 per_second, u32 burst) {
+  u64 now = os_now_ns();
+  u64 interval = Billion(1) / Max(per_second, 1u);
+  // how far ahead of now tat may run, burst lines back to back fit in it
+  u64 tolerance = interval * (Max(burst, 1u) - 1);
+  u64 tat = atomic_u64_load(&limiter->tat);
+  while (true) {
+    u64 start = Max(tat, now);
+    if (start - now > tolerance) {
+      atomic_u32_inc(&limiter->suppressed);
+      return false;
+    }
+    if (__atomic_compare_exchange_n(&limiter->tat, &tat, start + interval, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) break;
+  }
+  u32 suppressed = atomic_u32_exchange(&limiter->suppressed, 0);
+  if (suppressed) {
+    _log_output(category, level, "%u similar lines suppressed", suppressed);
+  }
+  return true;
 }
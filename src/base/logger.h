@@ -14,40 +14,441 @@ enum LogLevel {
   LogLevel_Info,
   LogLevel_Warn,
   LogLevel_Error,
+  LogLevel_Off,
 };
 
-void _log_output(LogLevel level, String fmt, ...); // with \n
-void _log_output(Allocator arena, LogLevel level, String fmt, ...);
+// General lines have no tag, the rest print theirs after the level
+enum LogCategory : u8 {
+  LogCategory_General,
+  LogCategory_Vk,
+  LogCategory_Assets,
+  LogCategory_Hotreload,
+  LogCategory_Profiler,
+  LogCategory_Count,
+};
+
+// runtime filter per category, a call below it costs one compare
+extern u8 log_levels[LogCategory_Count];
+
+INLINE b32 log_enabled(LogCategory category, LogLevel level) {
+  return level >= log_levels[category];
+}
+
+void log_set_level(LogCategory category, LogLevel level);
+// "warn" sets every category, "vk=trace,assets=off" sets the named ones, log_init reads LOG_LEVELS
+void log_set_levels(String spec);
+
+void _log_output(LogCategory category, LogLevel level, String fmt, ...); // with \n
+void _log_output(Allocator arena, LogCategory category, LogLevel level, String fmt, ...);
 void print(String fmt, ...);
 void println(String fmt, ...);
 
+// literal formats with arguments are checked and sized at compile time, see FmtStr
+String log_level_prefix(LogLevel level);
+const u32 LOG_PREFIX_MAX_SIZE = 32;
+// level prefix and category tag, "[WARN]:  [vk] ", buf is used for tagged categories only
+String log_prefix(u8* buf, LogLevel level, LogCategory category);
+// writes on the calling thread
+void log_write(LogLevel level, String line);
+
+////////////////////////////////////////////////////////////////////////
+// Async Logging
+// A log call copies its FmtStr and raw arguments into the calling thread's ring, strings by
+// content, everything else by value. The logger thread formats records in timestamp order and
+// writes them in batches to the console and a rotating file. Before log_init, and on threads
+// past LOG_MAX_THREADS, lines are formatted and written by the caller like before.
+
+const u32 LOG_MAX_THREADS = 64;
+const u64 LOG_RING_SIZE = MB(1);
+// records this big go out synchronously, so one line can't stall on a full ring
+const u64 LOG_RECORD_MAX_SIZE = LOG_RING_SIZE / 4;
+const u64 LOG_FILE_MAX_SIZE = MB(16);
+const u32 LOG_FILE_COUNT = 4; // path, path.1 .. path.3
+
+// formats the payload as one line at the end of sb and returns it
+typedef String LogFormatFn(StrBuilder* sb, String prefix, b32 newline, u8* payload);
+
+struct LogRecord {
+  u32 size; // with header, multiple of 8
+  u8 level; // 0 - print, no prefix or color
+  b8 newline;
+  u8 category;
+  u64 tsc;
+  LogFormatFn* format; // null - padding up to the end of the ring
+};
+
+// starts the logger thread, empty file_path logs to the console only, a later call opens the file
+void log_init(String file_path);
+void log_set_console(b32 enabled);
+// writes every record published before the call, os_exit and fatal signals do it too
+void log_flush();
+// for traps, which can fire inside a drain: skipped on the thread that is draining, and given up
+// after 100 ms when another one is
+void log_try_flush();
+// null when the caller has to write synchronously, log_record_end publishes the record
+LogRecord* log_record_begin(u64 size);
+void log_record_end(LogRecord* record);
+
+template<typename T>
+INLINE u64 log_arg_size(const T& value) {
+  if constexpr (fmt_arg_class<T>() == FmtArgClass_String) {
+    return sizeof(u32) + String(value).size;
+  } else {
+    return sizeof(T);
+  }
+}
+
+// __builtin_memcpy of a known size inlines to a move, MemCopy is an out-of-line call
+template<typename T>
+INLINE u8* log_arg_store(u8* dest, const T& value) {
+  if constexpr (fmt_arg_class<T>() == FmtArgClass_String) {
+    String str = value;
+    u32 size = str.size;
+    __builtin_memcpy(dest, &size, sizeof(size));
+    __builtin_memcpy(dest + sizeof(size), str.str, size);
+    return dest + sizeof(size) + size;
+  } else {
+    __builtin_memcpy(dest, &value, sizeof(T));
+    return dest + sizeof(T);
+  }
+}
+
+// strings come back as String pointing into the record
+template<typename T>
+INLINE auto log_arg_load(u8*& cursor) {
+  if constexpr (fmt_arg_class<T>() == FmtArgClass_String) {
+    u32 size;
+    __builtin_memcpy(&size, cursor, sizeof(size));
+    String str = {cursor + sizeof(size), size};
+    cursor += sizeof(size) + size;
+    return str;
+  } else {
+    T value;
+    __builtin_memcpy(&value, cursor, sizeof(T));
+    cursor += sizeof(T);
+    return value;
+  }
+}
+
+template<typename... Args, typename... Values>
+u64 log_line_bound(String prefix, const FmtStr<Args...>& fmt, const Values&... values) {
+  return prefix.size + fmt_bound(fmt, values...) + 1;
+}
+
+template<typename... Args, typename... Values>
+u64 log_line_write(u8* dest, String prefix, b32 newline, const FmtStr<Args...>& fmt, const Values&... values) {
+  MemCopy(dest, prefix.str, prefix.size);
+  u64 size = prefix.size + fmt_write(dest + prefix.size, fmt, values...);
+  if (newline) dest[size++] = '\n';
+  return size;
+}
+
+// a braced init evaluates the loads in argument order, a plain call doesn't promise that
+template<typename... Args>
+struct LogFormatCall {
+  String line;
+  template<typename... Values>
+  LogFormatCall(StrBuilder* sb, String prefix, b32 newline, const FmtStr<Args...>& fmt, const Values&... values) {
+    u8* dest = sb->reserve(log_line_bound(prefix, fmt, values...));
+    u64 size = log_line_write(dest, prefix, newline, fmt, values...);
+    sb->commit(size);
+    line = {dest, size};
+  }
+};
+
+template<typename... Args>
+String log_record_format(StrBuilder* sb, String prefix, b32 newline, u8* payload) {
+  FmtStr<Args...>& fmt = *(FmtStr<Args...>*)payload;
+  u8* cursor = payload + AlignUp(sizeof(fmt), 8);
+  return LogFormatCall<Args...>{sb, prefix, newline, fmt, log_arg_load<Args>(cursor)...}.line;
+}
+
+template<typename... Args>
+u64 log_record_size(const FmtStr<Args...>& fmt, const Args&... args) {
+  return sizeof(LogRecord) + AlignUp(sizeof(fmt), 8) + (0 + ... + log_arg_size(args));
+}
+
+// everything but size and tsc, those belong to the ring
+template<typename... Args>
+void log_record_fill(LogRecord* record, LogCategory category, LogLevel level, b32 newline, const FmtStr<Args...>& fmt, const Args&... args) {
+  record->level = level;
+  record->newline = newline;
+  record->category = category;
+  record->format = log_record_format<Args...>;
+  u8* payload = (u8*)(record + 1);
+  __builtin_memcpy(payload, &fmt, sizeof(fmt));
+  u8* cursor = payload + AlignUp(sizeof(fmt), 8);
+  ((cursor = log_arg_store(cursor, args)), ...);
+}
+
+// false when the line has to be written synchronously
+template<typename... Args>
+b32 log_push(LogCategory category, LogLevel level, b32 newline, const FmtStr<Args...>& fmt, const Args&... args) {
+  LogRecord* record = log_record_begin(log_record_size(fmt, args...));
+  if (!record) return false;
+  log_record_fill(record, category, level, newline, fmt, args...);
+  log_record_end(record);
+  return true;
+}
+
+template<typename... Args>
+String log_format(Allocator arena, String prefix, b32 newline, const FmtStr<Args...>& fmt, const Args&... args) {
+  u8* buf = push_buffer(arena, log_line_bound(prefix, fmt, args...));
+  return {buf, log_line_write(buf, prefix, newline, fmt, args...)};
+}
+
+template<typename... Args>
+void _log_output(LogCategory category, LogLevel level, FmtStr<FmtNoDeduce<Args>...> fmt, Args... args) {
+  if (!log_enabled(category, level)) return;
+  if (!log_push(category, level, true, fmt, args...)) {
+    Scratch scratch;
+    u8 prefix[LOG_PREFIX_MAX_SIZE];
+    log_write(level, log_format(scratch, log_prefix(prefix, level, category), true, fmt, args...));
+  }
+}
+
+template<typename... Args>
+void _log_output(Allocator arena, LogCategory category, LogLevel level, FmtStr<FmtNoDeduce<Args>...> fmt, Args... args) {
+  if (!log_enabled(category, level)) return;
+  if (!log_push(category, level, true, fmt, args...)) {
+    u8 prefix[LOG_PREFIX_MAX_SIZE];
+    log_write(level, log_format(arena, log_prefix(prefix, level, category), true, fmt, args...));
+  }
+}
+
+template<typename... Args>
+void print(FmtStr<FmtNoDeduce<Args>...> fmt, Args... args) {
+  if (!log_push(LogCategory_General, (LogLevel)0, false, fmt, args...)) {
+    Scratch scratch;
+    log_write((LogLevel)0, log_format(scratch, {}, false, fmt, args...));
+  }
+}
+
+template<typename... Args>
+void println(FmtStr<FmtNoDeduce<Args>...> fmt, Args... args) {
+  if (!log_push(LogCategory_General, (LogLevel)0, true, fmt, args...)) {
+    Scratch scratch;
+    log_write((LogLevel)0, log_format(scratch, {}, true, fmt, args...));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////
+// Structured Logging
+// An event is a literal message followed by typed key-value fields, written as
+// `message key=value key="text"` so log files can be grepped and parsed by field. Values are
+// stored in the record like format arguments and formatted by the logger thread.
+
+template<typename T>
+struct LogField {
+  String key; // literal, the record keeps the pointer
+  T value;
+};
+
+// strings become String, the record stores their bytes
+template<u32 N, typename T>
+INLINE auto log_kv(const char (&key)[N], const T& value) {
+  static_assert(fmt_arg_class<T>() != FmtArgClass_None, "log field value can't be formatted");
+  if constexpr (fmt_arg_class<T>() == FmtArgClass_String) {
+    return LogField<String>{{(u8*)key, N - 1}, String(value)};
+  } else {
+    return LogField<T>{{(u8*)key, N - 1}, value};
+  }
+}
+
+// shortest floats, signedness from the type, strings quoted and not escaped
+template<typename T>
+consteval FmtSpec log_field_spec() {
+  constexpr FmtArgClass arg_class = fmt_arg_class<T>();
+  if constexpr (arg_class == FmtArgClass_Float) {
+    return {sizeof(T) == 4 ? FmtKind_Shortest32 : FmtKind_Shortest64};
+  } else if constexpr (arg_class == FmtArgClass_String) {
+    return {FmtKind_String};
+  } else if constexpr (arg_class == FmtArgClass_Pointer) {
+    return {FmtKind_Pointer};
+  } else if constexpr (__is_enum(T) || T(-1) < T(0)) {
+    return {sizeof(T) <= 4 ? FmtKind_I32 : FmtKind_I64};
+  } else {
+    return {sizeof(T) <= 4 ? FmtKind_U32 : FmtKind_U64};
+  }
+}
+
+template<typename T>
+INLINE u64 log_field_bound(const LogField<T>& field) {
+  constexpr u64 quotes = fmt_arg_class<T>() == FmtArgClass_String ? 2 : 0;
+  return 1 + field.key.size + 1 + quotes + fmt_arg_bound(log_field_spec<T>(), field.value);
+}
+
+template<typename T>
+INLINE u64 log_field_write(u8* dest, const LogField<T>& field) {
+  constexpr b32 quoted = fmt_arg_class<T>() == FmtArgClass_String;
+  u8* start = dest;
+  *dest++ = ' ';
+  MemCopy(dest, field.key.str, field.key.size);
+  dest += field.key.size;
+  *dest++ = '=';
+  if (quoted) *dest++ = '"';
+  dest += fmt_arg_write(dest, log_field_spec<T>(), field.value);
+  if (quoted) *dest++ = '"';
+  return dest - start;
+}
+
+template<typename T>
+INLINE u64 log_field_size(const LogField<T>& field) {
+  return sizeof(String) + log_arg_size(field.value);
+}
+
+template<typename T>
+INLINE u8* log_field_store(u8* dest, const LogField<T>& field) {
+  __builtin_memcpy(dest, &field.key, sizeof(String));
+  return log_arg_store(dest + sizeof(String), field.value);
+}
+
+template<typename T>
+INLINE LogField<T> log_field_load(u8*& cursor) {
+  LogField<T> field;
+  __builtin_memcpy(&field.key, cursor, sizeof(String));
+  cursor += sizeof(String);
+  field.value = log_arg_load<T>(cursor);
+  return field;
+}
+
+template<typename... Fields>
+struct LogEventCall {
+  String line;
+  LogEventCall(StrBuilder* sb, String prefix, b32 newline, String message, const LogField<Fields>&... fields) {
+    u8* dest = sb->reserve(prefix.size + message.size + (0 + ... + log_field_bound(fields)) + 1);
+    u8* at = dest;
+    MemCopy(at, prefix.str, prefix.size);
+    at += prefix.size;
+    MemCopy(at, message.str, message.size);
+    at += message.size;
+    ((at += log_field_write(at, fields)), ...);
+    if (newline) *at++ = '\n';
+    sb->commit(at - dest);
+    line = {dest, (u64)(at - dest)};
+  }
+};
+
+template<typename... Fields>
+String log_event_format(StrBuilder* sb, String prefix, b32 newline, u8* payload) {
+  String message;
+  __builtin_memcpy(&message, payload, sizeof(String));
+  u8* cursor = payload + sizeof(String);
+  return LogEventCall<Fields...>{sb, prefix, newline, message, log_field_load<Fields>(cursor)...}.line;
+}
+
+template<typename... Fields>
+u64 log_event_size(const LogField<Fields>&... fields) {
+  return sizeof(LogRecord) + sizeof(String) + (0 + ... + log_field_size(fields));
+}
+
+template<typename... Fields>
+void log_event_fill(LogRecord* record, LogCategory category, LogLevel level, String message, const LogField<Fields>&... fields) {
+  record->level = level;
+  record->newline = true;
+  record->category = category;
+  record->format = log_event_format<Fields...>;
+  u8* cursor = (u8*)(record + 1);
+  __builtin_memcpy(cursor, &message, sizeof(String));
+  cursor += sizeof(String);
+  ((cursor = log_field_store(cursor, fields)), ...);
+}
+
+template<u32 N, typename... Fields>
+void log_event(LogCategory category, LogLevel level, const char (&message)[N], LogField<Fields>... fields) {
+  if (!log_enabled(category, level)) return;
+  u64 size = log_event_size(fields...);
+  LogRecord* record = log_record_begin(size);
+  if (record) {
+    log_event_fill(record, category, level, {(u8*)message, N - 1}, fields...);
+    log_record_end(record);
+    return;
+  }
+  // the same record built on the stack and formatted here
+  Scratch scratch;
+  record = (LogRecord*)push_buffer(scratch, size);
+  log_event_fill(record, category, level, {(u8*)message, N - 1}, fields...);
+  StrBuilder sb;
+  sb.init(scratch);
+  u8 prefix[LOG_PREFIX_MAX_SIZE];
+  log_write(level, record->format(&sb, log_prefix(prefix, level, category), true, (u8*)(record + 1)));
+}
+
+////////////////////////////////////////////////////////////////////////
+// Category Macros
+// Log(Vk, Warn, ...) checks the compile-time switch, then the category's level, before any
+// argument is evaluated, so a disabled line in a hot loop is one well-predicted branch.
+// The rate limited forms keep their state in a static at the call site:
+//   LogEvery(n, ...)               - first call, then every n-th
+//   LogOnce(...)                   - first call only
+//   LogRate(per_second, burst, ...) - token bucket, says how many lines it dropped
+// LogEvent takes fields instead of format arguments:
+//   LogEvent(Assets, Info, "mesh loaded", log_kv("name", name), log_kv("verts", count));
+
+// generic cell rate: tat is the earliest time the next line conforms, each line adds 1s / per_second
+struct LogLimiter {
+  u64 tat;
+  u32 suppressed;
+};
+
+// false when the line is over the rate, the next line let through reports how many were dropped
+b32 log_limiter_take(LogLimiter* limiter, LogCategory category, LogLevel level, u32 per_second, u32 burst);
+
+#define LOG_LEVEL_ENABLED_Trace LOG_TRACE_ENABLED
+#define LOG_LEVEL_ENABLED_Debug LOG_DEBUG_ENABLED
+#define LOG_LEVEL_ENABLED_Info  LOG_INFO_ENABLED
+#define LOG_LEVEL_ENABLED_Warn  LOG_WARN_ENABLED
+#define LOG_LEVEL_ENABLED_Error LOG_ERROR_ENABLED
+
+// the empty branch comes first so an else after the macro still binds to the caller's if
+#define LogIf(category, level) \
+  if (!(LOG_LEVEL_ENABLED_##level && log_enabled(LogCategory_##category, LogLevel_##level))) {} else
+
+#define Log(category, level, message, ...) \
+  LogIf(category, level) _log_output(LogCategory_##category, LogLevel_##level, message, ##__VA_ARGS__)
+
+#define LogEvery(n, category, level, message, ...) \
+  LogIf(category, level) if (static u32 _log_calls; atomic_u32_inc(&_log_calls) % (n)) {} else \
+  _log_output(LogCategory_##category, LogLevel_##level, message, ##__VA_ARGS__)
+
+#define LogOnce(category, level, message, ...) \
+  LogIf(category, level) if (static u32 _log_done; atomic_u32_exchange(&_log_done, 1)) {} else \
+  _log_output(LogCategory_##category, LogLevel_##level, message, ##__VA_ARGS__)
+
+#define LogRate(per_second, burst, category, level, message, ...) \
+  LogIf(category, level) if (static LogLimiter _log_limiter; !log_limiter_take(&_log_limiter, LogCategory_##category, LogLevel_##level, per_second, burst)) {} else \
+  _log_output(LogCategory_##category, LogLevel_##level, message, ##__VA_ARGS__)
+
+#define LogEvent(category, level, message, ...) \
+  LogIf(category, level) log_event(LogCategory_##category, LogLevel_##level, message, ##__VA_ARGS__)
+
 #if LOG_TRACE_ENABLED
-  #define Trace(message, ...) _log_output(LogLevel_Trace, message, ##__VA_ARGS__)
+  #define Trace(message, ...) Log(General, Trace, message, ##__VA_ARGS__)
 #else
   #define Trace(message, ...)
 #endif
 
 #if LOG_DEBUG_ENABLED
-  #define Debug(message, ...) _log_output(LogLevel_Debug, message, ##__VA_ARGS__)
+  #define Debug(message, ...) Log(General, Debug, message, ##__VA_ARGS__)
 #else
   #define Debug(message, ...)
 #endif
 
 #if LOG_INFO_ENABLED
-  #define Info(message, ...) _log_output(LogLevel_Info, message, ##__VA_ARGS__)
+  #define Info(message, ...) Log(General, Info, message, ##__VA_ARGS__)
 #else
   #define Info(message, ...)
 #endif
 
 #if LOG_WARN_ENABLED
-  #define Warn(message, ...) _log_output(LogLevel_Warn, message, ##__VA_ARGS__)
+  #define Warn(message, ...) Log(General, Warn, message, ##__VA_ARGS__)
 #else
   #define Warn(message, ...)
 #endif
 
 #if LOG_ERROR_ENABLED
-  #define Error(message, ...) _log_output(LogLevel_Error, message, ##__VA_ARGS__);
-  #define ErrorArena(arena, message, ...) _log_output(arena, LogLevel_Error, message, ##__VA_ARGS__);
+  #define Error(message, ...) Log(General, Error, message, ##__VA_ARGS__);
+  #define ErrorArena(arena, message, ...) LogIf(General, Error) _log_output(arena, LogCategory_General, LogLevel_Error, message, ##__VA_ARGS__);
 #else
   #define Error(message, ...)
 #endif
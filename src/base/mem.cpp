@@ -158,16 +158,58 @@ intern u8* arena_alloc_zero(Arena* arena, u64 size, u64 align) {
   return result;
 }
 
+// NOTE: if ptr is the last allocation it's resized by moving pos, no copy
+intern b32 arena_resize_in_place(Arena* arena, void* ptr, u64 old_size, u64 new_size, u64 align) {
+  if (!ptr || !IsAligned((u64)ptr, align)) return false;
+  u64 start = MemDiff(ptr, arena->base);
+  if (start + old_size != arena->pos) return false;
+  u64 end = start + new_size;
+  if (end > arena->cmt) {
+    u64 commit_size = AlignUp(end - arena->cmt, ARENA_DEFAULT_COMMIT_SIZE);
+    Assert((arena->cmt + commit_size) <= arena->cap && "Arena is out of memory");
+    os_commit(Offset(arena->base, arena->cmt), commit_size);
+    MemGuardDealloc(Offset(arena->base, arena->cmt), commit_size);
+    AsanPoisonMemRegion(Offset(arena->base, arena->cmt), commit_size);
+    arena->cmt += commit_size;
+  }
+  if (new_size > old_size) {
+    AsanUnpoisonMemRegion(Offset(ptr, old_size), new_size - old_size);
+    MemGuardAlloc(Offset(ptr, old_size), new_size - old_size);
+  } else {
+    MemGuardDealloc(Offset(ptr, new_size), old_size - new_size);
+    AsanPoisonMemRegion(Offset(ptr, new_size), old_size - new_size);
+  }
+  arena->pos = end;
+#if MEM_TRACK
+  AllocatorInfo* info = arena->info;
+  info->pos = arena->pos;
+  info->exclusive_pos += new_size - old_size;
+  info->cmt = arena->cmt;
+  ++info->reallocs;
+  ++info->reallocs_in_place;
+#endif
+  return true;
+}
+
 intern u8* arena_realloc(Arena* arena, void* ptr, u64 old_size, u64 new_size, u64 align) {
+  if (arena_resize_in_place(arena, ptr, old_size, new_size, align)) {
+    return (u8*)ptr;
+  }
+  u64 copy_size = Min(old_size, new_size);
   u8* result = arena_alloc(arena, new_size, align);
-  MemCopy(result, ptr, old_size);
+  MemCopy(result, ptr, copy_size);
+#if MEM_TRACK
+  ++arena->info->reallocs;
+  arena->info->realloc_copied += copy_size;
+#endif
   return result;
 }
 
 intern u8* arena_realloc_zero(Arena* arena, void* ptr, u64 old_size, u64 new_size, u64 align) {
-  u8* result = arena_alloc(arena, new_size, align);
-  MemCopy(result, ptr, old_size);
-  MemZero(Offset(result, old_size), new_size - old_size);
+  u8* result = arena_realloc(arena, ptr, old_size, new_size, align);
+  if (new_size > old_size) {
+    MemZero(Offset(result, old_size), new_size - old_size);
+  }
   return result;
 }
 
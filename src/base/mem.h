@@ -67,6 +67,9 @@ struct AllocatorInfo {
   u64 frees;
   u64 current_allocs;
   u64 allocs_per_frame;
+  u64 reallocs;
+  u64 reallocs_in_place;
+  u64 realloc_copied;
   String64 name;
 };
 
@@ -1,6 +1,7 @@
 #include "profiler.h"
 
 global ProfilerState profiler_st;
+global thread_local u32 prof_thread_slot;
 
 void profiler_init(Allocator arena) {
   ProfilerState& g = profiler_st;
@@ -21,7 +22,7 @@ void profiler_init(Allocator arena) {
 
 ProfilerState& profiler_get() { return profiler_st; }
 
-ProfileBlock::ProfileBlock(String label_, String func_, ProfileType type) {
+ProfileBlock::ProfileBlock(Atom label_, Atom func_, ProfileType type) {
   ProfilerState& g = profiler_st;
   ProfileThread& prof_thread = profiler_get_prof_thread();
   label = label_;
@@ -72,14 +73,16 @@ void profiler_end(u32 current_frame) {
     write_frame_time.tsc_start = frame_time.tsc_start;
     write_frame_time.tsc_end = frame_time.tsc_end;
   }
+  LogRate(1, 1, Profiler, Trace, "frame %u: %u64 tsc", current_frame, frame_time.tsc_end - frame_time.tsc_start);
 
   u32 read_buf = atomic_u32_xor(&g.current_buf, 1);
 
   for EachElement(j, g.prof_threads) {
     ProfileThread& prof_thread = g.prof_threads[j];
+    // stack stays inline, so anchors is the last scratch allocation and grows in place
     Darray<ProfileAnchor> anchors(scratch);
     u32 depth = 0;
-    Darray<u32> stack(scratch);
+    Darray<u32, 64> stack(scratch);
 
     ///////////////////////////////////
     // Process events
@@ -157,7 +160,13 @@ ProfileFrame profiler_get_prev_frame(u32 current_frame) {
 
 ProfileThread& profiler_get_prof_thread() {
   ProfilerState& g = profiler_st;
-  return g.prof_threads[tctx_get_id()];
+  return g.prof_threads[prof_thread_slot];
+}
+
+void profiler_thread_init(u32 slot) {
+  ProfilerState& g = profiler_st;
+  AssertAlwaysMsg(slot < ArrayCount(g.prof_threads), "profiler: no slot %u", slot);
+  prof_thread_slot = slot;
 }
 
 void profiler_launch_begin() {
@@ -174,9 +183,10 @@ void profiler_launch_end() {
 
   for EachElement(j, g.prof_threads) {
     ProfileThread& prof_thread = g.prof_threads[j];
+    // stack stays inline, so anchors is the last scratch allocation and grows in place
     Darray<ProfileAnchor> anchors(scratch);
     u32 depth = 0;
-    Darray<u32> stack(scratch);
+    Darray<u32, 64> stack(scratch);
 
     ///////////////////////////////////
     // Process events
@@ -2,6 +2,7 @@
 #include "base.h"
 #include "containers.h"
 #include "thread_ctx.h"
+#include "atom.h"
 
 enum ProfileType {
   ProfileType_Work,
@@ -13,8 +14,8 @@ struct ProfileAnchor {
   u64 tsc_elapsed_exclusive; // without children
   u64 tsc_elapsed_inclusive; // with children
   // u64 hit_count;
-  String label;
-  String func;
+  Atom label;
+  Atom func;
   u32 depth;
   u64 tsc_start;
   u64 tsc_end;
@@ -31,14 +32,14 @@ struct ProfileEvent {
   ProfileEventType type;
   ProfileType prof_type;
   u64 tsc;
-  String label;
-  String func;
+  Atom label;
+  Atom func;
 };
 
 struct ProfileBlock {
-  String label;
-  String func;
-  ProfileBlock(String label_, String func, ProfileType type = ProfileType_Work);
+  Atom label;
+  Atom func;
+  ProfileBlock(Atom label_, Atom func, ProfileType type = ProfileType_Work);
   ~ProfileBlock();
 };
 
@@ -71,7 +72,7 @@ enum ProfileTabActive {
 struct ProfilerState {
   ProfileFrameTime current_frame_time;
   ProfileFrameTime frames_times[120];
-  ProfileThread prof_threads[THREAD_COUNT+1];
+  ProfileThread prof_threads[THREAD_MAX+1]; // main thread and the pool workers
   u32 current_buf;
 
   f32 frame_avg_time;
@@ -89,13 +90,25 @@ void profiler_begin(u32 current_frame);
 void profiler_end(u32 current_frame);
 ProfileFrame profiler_get_prev_frame(u32 current_frame);
 ProfileThread& profiler_get_prof_thread();
+// pool workers take slots 1..THREAD_MAX, a thread that never calls it records into the main
+// thread's slot 0, so only the main thread and the pool may time blocks
+void profiler_thread_init(u32 slot);
 void profiler_launch_begin();
 void profiler_launch_end();
 
 #if PROFILE_BUILD
-  #define TimeBlock(Name, ...) ProfileBlock Glue(__profiler_block, __LINE__)(Name, __func__, ##__VA_ARGS__)
+  // Name is interned once per call site
+  #define TimeBlock(Name, ...) \
+    local Atom Glue(__profiler_label, __LINE__) = atom_from_str(Name); \
+    local Atom Glue(__profiler_func, __LINE__) = atom_from_str(__func__); \
+    ProfileBlock Glue(__profiler_block, __LINE__)(Glue(__profiler_label, __LINE__), Glue(__profiler_func, __LINE__), ##__VA_ARGS__)
   #define TimeFunction TimeBlock(__func__)
+  // Name is interned on every call, for labels only known at runtime
+  #define TimeBlockRuntime(Name, ...) \
+    local Atom Glue(__profiler_func, __LINE__) = atom_from_str(__func__); \
+    ProfileBlock Glue(__profiler_block, __LINE__)(atom_from_str(Name), Glue(__profiler_func, __LINE__), ##__VA_ARGS__)
 #else
   #define TimeBlock(Name)
+  #define TimeBlockRuntime(Name, ...)
   #define TimeFunction
 #endif
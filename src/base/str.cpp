@@ -1,59 +1,63 @@
 #include "str.h"
 #include "logger.h"
+#include "ryu_tables.h"
+#include "lemire_tables.h"
+#include <stdlib.h>
+
+global const u64 POW10_U64[20] = {
+  1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull,
+  1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull,
+  100000000000000ull, 1000000000000000ull, 10000000000000000ull, 100000000000000000ull,
+  1000000000000000000ull, 10000000000000000000ull,
+};
+
+// bit length * log10(2) guesses the digit count, one compare fixes it up
+intern u32 u64_length(u64 v) {
+  v |= 1;
+  u32 guess = ((64 - clz(v)) * 1233) >> 12;
+  return guess + (v >= POW10_U64[guess]);
+}
 
 intern u32 u32_length(u32 v) {
-  if (v < 10) return 1;
-  if (v < 100) return 2;
-  if (v < 1000) return 3;
-  if (v < 10000) return 4;
-  if (v < 100000) return 5;
-  if (v < 1000000) return 6;
-  if (v < 10000000) return 7;
-  if (v < 100000000) return 8;
-  if (v < 1000000000) return 9;
-  return 10;
+  return u64_length(v);
 }
 
-intern u32 u64_length(u64 v) {
-  if (v < 10) return 1;
-  if (v < 100) return 2;
-  if (v < 1000) return 3;
-  if (v < 10000) return 4;
-  if (v < 100000) return 5;
-  if (v < 1000000) return 6;
-  if (v < 10000000) return 7;
-  if (v < 100000000) return 8;
-  if (v < 1000000000) return 9;
-  if (v < 10000000000) return 10;
-  if (v < 100000000000) return 11;
-  if (v < 1000000000000) return 12;
-  if (v < 10000000000000) return 13;
-  if (v < 100000000000000) return 14;
-  if (v < 1000000000000000) return 15;
-  if (v < 10000000000000000) return 16;
-  if (v < 100000000000000000) return 17;
-  if (v < 1000000000000000000) return 18;
-  if (v < 10000000000000000000ull) return 19;
-  return 20;
+global const char DIGIT_PAIRS[] =
+  "00010203040506070809"
+  "10111213141516171819"
+  "20212223242526272829"
+  "30313233343536373839"
+  "40414243444546474849"
+  "50515253545556575859"
+  "60616263646566676869"
+  "70717273747576777879"
+  "80818283848586878889"
+  "90919293949596979899";
+
+// writes last length digits of value, two at a time from the end
+intern void digits_write(u8* dest, u64 value, u32 length) {
+  u32 i = length;
+  while (i >= 2) {
+    u32 pair = (value % 100) * 2;
+    value /= 100;
+    i -= 2;
+    dest[i]   = DIGIT_PAIRS[pair];
+    dest[i+1] = DIGIT_PAIRS[pair+1];
+  }
+  if (i) {
+    dest[0] = '0' + (value % 10);
+  }
 }
 
 intern u32 u32_write(u8* dest, u32 value) {
   u32 length = u32_length(value);
-  u32 i = length;
-  do {
-    dest[--i] = '0' + (value % 10);
-    value /= 10;
-  } while (value);
+  digits_write(dest, value, length);
   return length;
 }
 
-intern u32 u64_write(u8* dest, u64 value) {
+u32 u64_write(u8* dest, u64 value) {
   u32 length = u64_length(value);
-  u32 i = length;
-  do {
-    dest[--i] = '0' + (value % 10);
-    value /= 10;
-  } while (value);
+  digits_write(dest, value, length);
   return length;
 }
 
@@ -91,102 +95,336 @@ intern u32 i64_write(u8* dest, i64 value) {
   }
 }
 
-intern u32 f32_length(f32 value, u32 precision) {
-  u32 len = 0;
-  if (value < 0.0f) {
-    ++len;
-    value = -value;
+////////////////////////////////////////////////////////////////////////
+// Floats
+
+// NOTE: Ryu (Ulf Adams, 2018) finds the shortest decimal that rounds back to the same float.
+// f32 goes through the same f64 tables, they are more than precise enough for its mantissa.
+
+enum FloatKind {
+  FloatKind_Number,
+  FloatKind_Zero,
+  FloatKind_Inf,
+  FloatKind_Nan,
+};
+
+struct FloatDecimal {
+  u64 mantissa;
+  i32 exponent; // value = mantissa * 10^exponent
+  b32 sign;
+  FloatKind kind;
+};
+
+typedef unsigned __int128 u128;
+
+intern i32 pow5_bits(i32 e)  { return ((e * 1217359) >> 19) + 1; }
+intern i32 log10_pow2(i32 e) { return (e * 78913) >> 18; }
+intern i32 log10_pow5(i32 e) { return (e * 732923) >> 20; }
+
+intern b32 multiple_of_pow5(u64 value, i32 p) {
+  i32 count = 0;
+  for (; value % 5 == 0; value /= 5) {
+    ++count;
   }
-  
-  // Process the integer part
-  u32 integer_part = value;
-  value -= integer_part; // Remove the integer part
-  len += u32_length(integer_part);
+  return count >= p;
+}
 
-  // Process the fractional part
-  if (precision > 0) {
-    ++len; // for '.'
-    len += precision;
+intern b32 multiple_of_pow2(u64 value, i32 p) {
+  return (value & ((1ull << p) - 1)) == 0;
+}
+
+intern u64 mul_shift64(u64 m, const u64* mul, i32 j) {
+  u128 b0 = (u128)m * mul[0];
+  u128 b2 = (u128)m * mul[1];
+  return (u64)(((b0 >> 64) + b2) >> (j - 64));
+}
+
+intern FloatDecimal ryu_decimal(u64 ieee_mantissa, u32 ieee_exponent, i32 mantissa_bits, i32 bias) {
+  i32 e2;
+  u64 m2;
+  if (ieee_exponent == 0) {
+    e2 = 1 - bias - mantissa_bits - 2;
+    m2 = ieee_mantissa;
+  } else {
+    e2 = (i32)ieee_exponent - bias - mantissa_bits - 2;
+    m2 = (1ull << mantissa_bits) | ieee_mantissa;
   }
-  return len;
+  b32 accept_bounds = (m2 & 1) == 0;
+
+  // Step 1: interval of valid representations [mm, mp] scaled by 4, shifted into base 10
+  u64 mv = 4 * m2;
+  u32 mm_shift = ieee_mantissa != 0 || ieee_exponent <= 1;
+  u64 vr, vp, vm;
+  i32 e10;
+  b32 vm_is_trailing_zeros = false;
+  b32 vr_is_trailing_zeros = false;
+  if (e2 >= 0) {
+    i32 q = log10_pow2(e2) - (e2 > 3);
+    e10 = q;
+    i32 k = F64_POW5_INV_BITCOUNT + pow5_bits(q) - 1;
+    i32 i = -e2 + q + k;
+    const u64* mul = F64_POW5_INV_SPLIT[q];
+    vr = mul_shift64(4*m2, mul, i);
+    vp = mul_shift64(4*m2 + 2, mul, i);
+    vm = mul_shift64(4*m2 - 1 - mm_shift, mul, i);
+    if (q <= 21) {
+      if (mv % 5 == 0) {
+        vr_is_trailing_zeros = multiple_of_pow5(mv, q);
+      } else if (accept_bounds) {
+        vm_is_trailing_zeros = multiple_of_pow5(mv - 1 - mm_shift, q);
+      } else {
+        vp -= multiple_of_pow5(mv + 2, q);
+      }
+    }
+  } else {
+    i32 q = log10_pow5(-e2) - (-e2 > 1);
+    e10 = q + e2;
+    i32 i = -e2 - q;
+    i32 k = pow5_bits(i) - F64_POW5_BITCOUNT;
+    i32 j = q - k;
+    const u64* mul = F64_POW5_SPLIT[i];
+    vr = mul_shift64(4*m2, mul, j);
+    vp = mul_shift64(4*m2 + 2, mul, j);
+    vm = mul_shift64(4*m2 - 1 - mm_shift, mul, j);
+    if (q <= 1) {
+      vr_is_trailing_zeros = true;
+      if (accept_bounds) {
+        vm_is_trailing_zeros = mm_shift == 1;
+      } else {
+        --vp;
+      }
+    } else if (q < 63) {
+      vr_is_trailing_zeros = multiple_of_pow2(mv, q);
+    }
+  }
+
+  // Step 2: drop digits while the interval still has a shorter representation
+  i32 removed = 0;
+  u32 last_removed_digit = 0;
+  u64 output;
+  if (vm_is_trailing_zeros || vr_is_trailing_zeros) {
+    // rare, exact ties have to be tracked
+    while (vp / 10 > vm / 10) {
+      vm_is_trailing_zeros &= vm % 10 == 0;
+      vr_is_trailing_zeros &= last_removed_digit == 0;
+      last_removed_digit = vr % 10;
+      vr /= 10; vp /= 10; vm /= 10;
+      ++removed;
+    }
+    if (vm_is_trailing_zeros) {
+      while (vm % 10 == 0) {
+        vr_is_trailing_zeros &= last_removed_digit == 0;
+        last_removed_digit = vr % 10;
+        vr /= 10; vp /= 10; vm /= 10;
+        ++removed;
+      }
+    }
+    if (vr_is_trailing_zeros && last_removed_digit == 5 && vr % 2 == 0) {
+      last_removed_digit = 4; // round half to even
+    }
+    output = vr + ((vr == vm && (!accept_bounds || !vm_is_trailing_zeros)) || last_removed_digit >= 5);
+  } else {
+    b32 round_up = false;
+    if (vp / 100 > vm / 100) {
+      round_up = vr % 100 >= 50;
+      vr /= 100; vp /= 100; vm /= 100;
+      removed += 2;
+    }
+    while (vp / 10 > vm / 10) {
+      round_up = vr % 10 >= 5;
+      vr /= 10; vp /= 10; vm /= 10;
+      ++removed;
+    }
+    output = vr + (vr == vm || round_up);
+  }
+  FloatDecimal result = {
+    .mantissa = output,
+    .exponent = e10 + removed,
+  };
+  return result;
 }
 
-intern u32 f64_length(f64 value, u32 precision) {
-  u32 len = 0;
-  if (value < 0.0f) {
-    ++len;
-    value = -value;
+intern FloatDecimal f64_decimal(f64 value) {
+  u64 bits = *(u64*)&value;
+  u64 ieee_mantissa = bits & ((1ull << 52) - 1);
+  u32 ieee_exponent = (bits >> 52) & 0x7FF;
+  FloatDecimal result = {};
+  if (ieee_exponent == 0x7FF) {
+    result.kind = ieee_mantissa ? FloatKind_Nan : FloatKind_Inf;
+  } else if (ieee_exponent == 0 && ieee_mantissa == 0) {
+    result.kind = FloatKind_Zero;
+  } else {
+    result = ryu_decimal(ieee_mantissa, ieee_exponent, 52, 1023);
   }
-  
-  // Process the integer part
-  u64 integer_part = value;
-  value -= integer_part; // Remove the integer part
-  len += u64_length(integer_part);
+  result.sign = bits >> 63;
+  return result;
+}
 
-  // Process the fractional part
-  if (precision > 0) {
-    ++len; // for '.'
-    len += precision;
+intern FloatDecimal f32_decimal(f32 value) {
+  u32 bits = *(u32*)&value;
+  u32 ieee_mantissa = bits & ((1u << 23) - 1);
+  u32 ieee_exponent = (bits >> 23) & 0xFF;
+  FloatDecimal result = {};
+  if (ieee_exponent == 0xFF) {
+    result.kind = ieee_mantissa ? FloatKind_Nan : FloatKind_Inf;
+  } else if (ieee_exponent == 0 && ieee_mantissa == 0) {
+    result.kind = FloatKind_Zero;
+  } else {
+    result = ryu_decimal(ieee_mantissa, ieee_exponent, 23, 127);
   }
-  return len;
+  result.sign = bits >> 31;
+  return result;
 }
 
-intern u32 f32_write(u8* dest, f32 value, u32 precision) {
+intern u32 float_special_write(u8* dest, FloatDecimal d) {
   u32 len = 0;
-  if (value < 0.0f) {
+  if (d.kind == FloatKind_Nan) {
+    MemCopy(dest, (void*)"nan", 3);
+    return 3;
+  }
+  if (d.sign) {
     dest[len++] = '-';
-    value = -value;
   }
+  if (d.kind == FloatKind_Inf) {
+    MemCopy(dest + len, (void*)"inf", 3);
+    len += 3;
+  } else {
+    dest[len++] = '0';
+  }
+  return len;
+}
 
-  // Process the integer part
-  u32 integer_part = (u32)value;
-  value -= integer_part; // Remove the integer part
-  len += u32_write(dest + len, integer_part);
-
-  // Process the fractional part
-  if (precision > 0) {
+// %g: plain digits for 1e-5 <= |x| < 1e21, scientific outside of it
+intern u32 float_decimal_write(u8* dest, FloatDecimal d) {
+  if (d.kind != FloatKind_Number) {
+    return float_special_write(dest, d);
+  }
+  u32 len = 0;
+  if (d.sign) {
+    dest[len++] = '-';
+  }
+  i32 count = u64_length(d.mantissa);
+  i32 point = count + d.exponent; // digits before decimal point
+  if (point > 21 || point < -4) {
+    // d.ddde-x
+    digits_write(dest + len + 1, d.mantissa, count);
+    dest[len] = dest[len+1];
+    if (count > 1) {
+      dest[len+1] = '.';
+      len += count + 1;
+    } else {
+      len += 1;
+    }
+    dest[len++] = 'e';
+    i32 exp = point - 1;
+    if (exp < 0) {
+      dest[len++] = '-';
+      exp = -exp;
+    }
+    len += u32_write(dest + len, exp);
+  } else if (point <= 0) {
+    dest[len++] = '0';
+    dest[len++] = '.';
+    Loop (i, -point) {
+      dest[len++] = '0';
+    }
+    digits_write(dest + len, d.mantissa, count);
+    len += count;
+  } else if (point < count) {
+    u64 frac_pow = POW10_U64[count - point];
+    digits_write(dest + len, d.mantissa / frac_pow, point);
+    len += point;
     dest[len++] = '.';
-    u32 multiplier = 1;
-    for (u32 i = 0; i < precision; ++i) multiplier *= 10;
-    u32 frac_part = (u32)(value * multiplier + 0.5); // rounding since possible 0.02 * multi = 1.999...
-    u32 frac_len = u32_length(frac_part);
-    u32 pad = (frac_len < precision) ? (precision - frac_len) : 0;
-    for (u32 i = 0; i < pad; ++i) {
+    digits_write(dest + len, d.mantissa % frac_pow, count - point);
+    len += count - point;
+  } else {
+    digits_write(dest + len, d.mantissa, count);
+    len += count;
+    Loop (i, point - count) {
       dest[len++] = '0';
     }
-    len += u32_write(dest + len, frac_part);
   }
   return len;
 }
 
-intern u32 f64_write(u8* dest, f64 value, u32 precision) {
+// %.Nf of a whole number, its shortest digits then zeros. printf prints every digit of the
+// binary value instead, the two only differ from 2^53 up
+intern u32 float_decimal_write_fixed(u8* dest, FloatDecimal d, u32 precision) {
+  if (d.kind == FloatKind_Nan || d.kind == FloatKind_Inf) {
+    return float_special_write(dest, d);
+  }
+  Assert(d.exponent >= 0);
   u32 len = 0;
-  if (value < 0.0f) {
+  if (d.sign) {
     dest[len++] = '-';
-    value = -value;
   }
-
-  // Process the integer part
-  u64 integer_part = value;
-  value -= integer_part; // Remove the integer part
-  len += u64_write(dest + len, integer_part);
-
-  // Process the fractional part
+  len += u64_write(dest + len, d.mantissa);
+  Loop (i, d.exponent) {
+    dest[len++] = '0';
+  }
   if (precision > 0) {
     dest[len++] = '.';
-    u64 multiplier = 1;
-    for (u32 i = 0; i < precision; ++i) multiplier *= 10;
-    u64 frac_part = (u64)(value * multiplier + 0.5); // rounding since possible 0.02 * multi = 1.999...
-    u32 frac_len = u64_length(frac_part);
-    u32 pad = (frac_len < precision) ? (precision - frac_len) : 0;
-    for (u32 i = 0; i < pad; ++i) {
+    Loop (i, precision) {
       dest[len++] = '0';
     }
-    len += u64_write(dest + len, frac_part);
   }
   return len;
 }
 
+// %.Nf: rounded from the exact binary value and not from the shortest digits, which would round
+// twice, so ties go to even like printf and 2.675, really 2.67499..., gives 2.67 at %.2f
+u32 f64_write(u8* dest, f64 value, u32 precision) {
+  Assert(precision <= 9);
+  u64 bits = *(u64*)&value;
+  u32 ieee_exponent = (bits >> 52) & 0x7FF;
+  i32 e2 = (i32)Max(ieee_exponent, 1u) - 1075;
+  // no fraction bits, also infinities and nans
+  if (e2 >= 0) {
+    return float_decimal_write_fixed(dest, f64_decimal(value), precision);
+  }
+  u64 m2 = (bits & ((1ull << 52) - 1)) | (u64)(ieee_exponent != 0) << 52;
+  // value * 10^precision = m2 * 10^precision / 2^shift, under 2^83 before the shift, so below
+  // 2^-128 nothing is left to round
+  u128 scaled = 0;
+  u32 shift = -e2;
+  if (shift < 128) {
+    u128 product = (u128)m2 * POW10_U64[precision];
+    scaled = product >> shift;
+    u128 rem = product - (scaled << shift);
+    u128 half = (u128)1 << (shift - 1);
+    scaled += rem > half || (rem == half && (scaled & 1));
+  }
+  u64 precision_pow = POW10_U64[precision];
+  u32 len = 0;
+  if (bits >> 63) {
+    dest[len++] = '-';
+  }
+  len += u64_write(dest + len, (u64)(scaled / precision_pow));
+  if (precision > 0) {
+    dest[len++] = '.';
+    digits_write(dest + len, (u64)(scaled % precision_pow), precision);
+    len += precision;
+  }
+  return len;
+}
+u32 f64_write_shortest(u8* dest, f64 value)       { return float_decimal_write(dest, f64_decimal(value)); }
+u32 f32_write_shortest(u8* dest, f32 value)       { return float_decimal_write(dest, f32_decimal(value)); }
+
+intern u32 f64_length(f64 value, u32 precision) {
+  u8 buf[FLOAT_FIXED_MAX_CHARS];
+  return f64_write(buf, value, precision);
+}
+
+intern u32 f64_shortest_length(f64 value) {
+  u8 buf[FLOAT_SHORTEST_MAX_CHARS];
+  return f64_write_shortest(buf, value);
+}
+
+intern u32 f32_shortest_length(f32 value) {
+  u8 buf[FLOAT_SHORTEST_MAX_CHARS];
+  return f32_write_shortest(buf, value);
+}
+
 #define HEX_LENGTH 16
 global u8 HEX[] = "0123456789ABCDEF";
 
@@ -199,6 +437,37 @@ intern u32 hex_u64_write(u8* dest, u64 value) {
   return len;
 }
 
+////////////////////////////////////////////////////////////////////////
+// Compile-time Formatting
+
+u32 fmt_int_write(u8* dest, FmtSpec spec, u64 bits) {
+  switch (spec.kind) {
+    case FmtKind_U32:     return u32_write(dest, (u32)bits);
+    case FmtKind_I32:     return i32_write(dest, (i32)(u32)bits);
+    case FmtKind_U64:     return u64_write(dest, bits);
+    case FmtKind_I64:     return i64_write(dest, (i64)bits);
+    case FmtKind_Char:    dest[0] = (u8)bits; return 1;
+    case FmtKind_Pointer: return hex_u64_write(dest, bits);
+    default:              return 0;
+  }
+}
+
+u32 fmt_float_bound(FmtSpec spec, f64 value) {
+  if (spec.kind != FmtKind_Fixed) return FLOAT_SHORTEST_MAX_CHARS;
+  // sign, up to 16 integer digits below 1e16, point and precision; nan and inf fit either way
+  b32 small = value < 1e16 && value > -1e16;
+  return small ? 1 + 16 + 1 + spec.precision : FLOAT_FIXED_MAX_CHARS;
+}
+
+u32 fmt_float_write(u8* dest, FmtSpec spec, f64 value) {
+  switch (spec.kind) {
+    case FmtKind_Fixed:      return f64_write(dest, value, spec.precision);
+    case FmtKind_Shortest64: return f64_write_shortest(dest, value);
+    case FmtKind_Shortest32: return f32_write_shortest(dest, (f32)value);
+    default:                 return 0;
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////
 // Great sprintf
 
@@ -237,6 +506,15 @@ intern u32 my_sprintf(u8* buf, String fmt, VaList argc) {
             #define DefaultFloatPrecision 6
             length += f64_length(val, DefaultFloatPrecision);
           } break;
+          case 'g': {
+            f64 val = va_arg(argc, f64); // f64 - because of compiler
+            if (str_match(String(p+1, 2), "32")) {
+              p += 2; // skip "32"
+              length += f32_shortest_length(val);
+            } else {
+              length += f64_shortest_length(val);
+            }
+          } break;
           case 's': {
             String val = va_arg(argc, String);
             length += val.size;
@@ -308,6 +586,15 @@ intern u32 my_sprintf(u8* buf, String fmt, VaList argc) {
           u32 len = f64_write(buf + written, val, DefaultFloatPrecision);
           written += len;
         } break;
+        case 'g': {
+          f64 val = va_arg(argc, f64); // f64 - because of compiler
+          if (str_match(String(p+1, 2), "32")) {
+            p += 2; // skip "32"
+            written += f32_write_shortest(buf + written, val);
+          } else {
+            written += f64_write_shortest(buf + written, val);
+          }
+        } break;
         case 's': {
           String val = va_arg(argc, String);
           MemCopy(buf+written, val.str, val.size);
@@ -385,9 +672,127 @@ void DString::add(String x) {
 
 void DString::clear() { size = 0; }
 
-DString::operator String() { return {str, size}; }
+DString::operator String() const { return {str, size}; }
 
-String64::operator String() { return {str, size}; }
+void StrBuilder::init(Allocator alloc_) {
+  *this = {};
+  alloc = alloc_;
+  next_cap = STR_BUILDER_FIRST_CHUNK;
+}
+
+intern StrBuilderChunk* str_builder_push_chunk(StrBuilder* sb, u8* str, u32 size, u32 cap) {
+  StrBuilderChunk* chunk = null;
+  if (str) {
+    chunk = push_struct(sb->alloc, StrBuilderChunk);
+    chunk->str = str;
+  } else {
+    // header and data in one allocation
+    chunk = (StrBuilderChunk*)mem_alloc(sb->alloc, sizeof(StrBuilderChunk) + cap, alignof(StrBuilderChunk));
+    chunk->str = (u8*)(chunk + 1);
+  }
+  chunk->next = null;
+  chunk->size = size;
+  chunk->cap = cap;
+  SLLQueuePush(sb->first, sb->last, chunk);
+  ++sb->chunk_count;
+  sb->total_size += size;
+  return chunk;
+}
+
+intern StrBuilderChunk* str_builder_grow(StrBuilder* sb, u32 min_size) {
+  u32 cap = Max(sb->next_cap, min_size);
+  sb->next_cap = Min(sb->next_cap * 2, STR_BUILDER_MAX_CHUNK);
+  return str_builder_push_chunk(sb, null, 0, cap);
+}
+
+u8* StrBuilder::reserve(u32 size) {
+  StrBuilderChunk* chunk = last;
+  if (!chunk || chunk->cap - chunk->size < size) {
+    chunk = str_builder_grow(this, size);
+  }
+  return chunk->str + chunk->size;
+}
+
+void StrBuilder::commit(u32 size) {
+  Assert(last && last->cap - last->size >= size);
+  last->size += size;
+  total_size += size;
+}
+
+u8* StrBuilder::push(u32 size) {
+  u8* result = reserve(size);
+  commit(size);
+  return result;
+}
+
+void StrBuilder::add(String str) {
+  // fill the tail of the last block first, the rest goes into a new one
+  if (last) {
+    u32 part = Min(last->cap - last->size, (u32)str.size);
+    MemCopy(last->str + last->size, str.str, part);
+    last->size += part;
+    total_size += part;
+    str = str_skip(str, part);
+  }
+  if (str.size) {
+    MemCopy(push(str.size), str.str, str.size);
+  }
+}
+
+void StrBuilder::add_ref(String str) {
+  if (str.size < STR_BUILDER_MIN_REF) {
+    add(str);
+    return;
+  }
+  StrBuilderChunk* prev = last;
+  str_builder_push_chunk(this, str.str, str.size, str.size);
+  // free tail of the previous block keeps taking appends after the reference
+  if (prev && prev->cap > prev->size) {
+    str_builder_push_chunk(this, prev->str + prev->size, 0, prev->cap - prev->size);
+    prev->cap = prev->size;
+  }
+}
+
+void StrBuilder::addfv(String fmt, VaList args) {
+  VaList args_copy;
+  va_copy(args_copy, args);
+  u32 size = my_sprintf(null, fmt, args_copy);
+  va_end(args_copy);
+  va_copy(args_copy, args);
+  my_sprintf(push(size), fmt, args_copy);
+  va_end(args_copy);
+}
+
+void StrBuilder::addf(String fmt, ...) {
+  VaList args;
+  va_start(args, fmt);
+  addfv(fmt, args);
+  va_end(args);
+}
+
+void StrBuilder::clear() {
+  first = last = null;
+  total_size = 0;
+  chunk_count = 0;
+  next_cap = STR_BUILDER_FIRST_CHUNK;
+}
+
+String StrBuilder::finalize(Allocator arena) {
+  if (chunk_count == 1 && first->size < first->cap) {
+    first->str[first->size] = 0;
+    return {first->str, first->size};
+  }
+  u8* buf = push_buffer(arena, total_size + 1);
+  u64 written = 0;
+  for EachNode(chunk, StrBuilderChunk, first) {
+    MemCopy(buf + written, chunk->str, chunk->size);
+    written += chunk->size;
+  }
+  buf[written] = 0;
+  return {buf, written};
+}
+
+String64::operator String() const { return {(u8*)str, size}; }
 
 ////////////////////////////////////////////////////////////////////////
 // Character Classification & Conversion Functions
@@ -403,6 +808,120 @@ u8 char_to_upper(u8 c) { if (char_is_lower(c)) { c += ('A' - 'a'); } return c; }
 u8 char_to_correct_slash(u8 c) { if (char_is_slash(c)) { c = '/'; } return c; }
 b32 char_is_number_cont(u8 c) { return (c >= '0' && c <= '9') || c == '.' || c == '-' || c == '+'; }
 
+////////////////////////////////////////////////////////////////////////
+// Byte Scanning
+// NOTE: 32 bytes per step with avx2, 16 with sse2, scalar tail. Match bits come from movemask,
+// ctz of the mask is the index inside the block.
+
+#if SIMD_AVX2
+// low nibble lookup: ' ' is 0x20, '\t' 0x09, '\n' 0x0a. Other slots hold 0, which can only
+// equal a byte with low nibble 0 in slot 0. Bytes >= 0x80 shuffle to 0 and never match.
+intern u32 space_mask_256(__m256i v) {
+  __m256i lookup = _mm256_setr_epi8(' ',0,0,0,0,0,0,0,0,'\t','\n',0,0,0,0,0,
+                                    ' ',0,0,0,0,0,0,0,0,'\t','\n',0,0,0,0,0);
+  return (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_shuffle_epi8(lookup, v), v));
+}
+#endif
+
+#if ARCH_X64
+intern u32 space_mask_128(__m128i v) {
+  __m128i space = _mm_cmpeq_epi8(v, _mm_set1_epi8(' '));
+  __m128i newline = _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'));
+  __m128i tab = _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'));
+  return (u32)_mm_movemask_epi8(_mm_or_si128(space, _mm_or_si128(newline, tab)));
+}
+#endif
+
+u64 bytes_find(u8* data, u64 size, u8 c) {
+  u64 i = 0;
+#if SIMD_AVX2
+  __m256i needle_256 = _mm256_set1_epi8(c);
+  for (; i + 32 <= size; i += 32) {
+    __m256i v = _mm256_loadu_si256((__m256i*)(data + i));
+    u32 mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, needle_256));
+    if (mask) return i + ctz(mask);
+  }
+#endif
+#if ARCH_X64
+  __m128i needle_128 = _mm_set1_epi8(c);
+  for (; i + 16 <= size; i += 16) {
+    __m128i v = _mm_loadu_si128((__m128i*)(data + i));
+    u32 mask = _mm_movemask_epi8(_mm_cmpeq_epi8(v, needle_128));
+    if (mask) return i + ctz(mask);
+  }
+#endif
+  for (; i < size; ++i) {
+    if (data[i] == c) return i;
+  }
+  return size;
+}
+
+u64 bytes_mismatch(u8* a, u8* b, u64 size) {
+  u64 i = 0;
+#if SIMD_AVX2
+  for (; i + 32 <= size; i += 32) {
+    __m256i va = _mm256_loadu_si256((__m256i*)(a + i));
+    __m256i vb = _mm256_loadu_si256((__m256i*)(b + i));
+    u32 mask = ~(u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb));
+    if (mask) return i + ctz(mask);
+  }
+#endif
+#if ARCH_X64
+  for (; i + 16 <= size; i += 16) {
+    __m128i va = _mm_loadu_si128((__m128i*)(a + i));
+    __m128i vb = _mm_loadu_si128((__m128i*)(b + i));
+    u32 mask = ~(u32)_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) & 0xffff;
+    if (mask) return i + ctz(mask);
+  }
+#endif
+  for (; i < size; ++i) {
+    if (a[i] != b[i]) return i;
+  }
+  return size;
+}
+
+u64 bytes_find_space(u8* data, u64 size) {
+  u64 i = 0;
+#if SIMD_AVX2
+  for (; i + 32 <= size; i += 32) {
+    u32 mask = space_mask_256(_mm256_loadu_si256((__m256i*)(data + i)));
+    if (mask) return i + ctz(mask);
+  }
+#endif
+#if ARCH_X64
+  for (; i + 16 <= size; i += 16) {
+    u32 mask = space_mask_128(_mm_loadu_si128((__m128i*)(data + i)));
+    if (mask) return i + ctz(mask);
+  }
+#endif
+  for (; i < size; ++i) {
+    if (char_is_space(data[i])) return i;
+  }
+  return size;
+}
+
+u64 bytes_skip_space(u8* data, u64 size) {
+  u64 i = 0;
+  // most runs are a single separator, don't pay for a vector load on them
+  if (i < size && !char_is_space(data[i])) return i;
+#if SIMD_AVX2
+  for (; i + 32 <= size; i += 32) {
+    u32 mask = ~space_mask_256(_mm256_loadu_si256((__m256i*)(data + i)));
+    if (mask) return i + ctz(mask);
+  }
+#endif
+#if ARCH_X64
+  for (; i + 16 <= size; i += 16) {
+    u32 mask = ~space_mask_128(_mm_loadu_si128((__m128i*)(data + i))) & 0xffff;
+    if (mask) return i + ctz(mask);
+  }
+#endif
+  for (; i < size; ++i) {
+    if (!char_is_space(data[i])) return i;
+  }
+  return size;
+}
+
 ////////////////////////////////////////////////////////////////////////
 // String Constructors
 
@@ -444,12 +963,7 @@ String lower_from_str(Allocator arena, String str) {
 
 b32 str_match(String str0, String str1) {
   if (str0.size != str1.size) return false;
-  Loop (i, str0.size) {
-    if (str0.str[i] != str1.str[i]) {
-      return false;
-    }
-  }
-  return true;
+  return bytes_mismatch(str0.str, str1.str, str0.size) == str0.size;
 }
 
 b32 str_matchi(String str0, String str1) {
@@ -594,11 +1108,9 @@ void str_copy(String64& dest, String str) {
 
 String str_next_word(String line, u32& start) {
   // skip spaces
-  while (start < line.size && char_is_space(line.str[start]))
-    start++;
+  start += bytes_skip_space(line.str + start, line.size - start);
   u32 token_start = start;
-  while (start < line.size && !char_is_space(line.str[start]))
-    start++;
+  start += bytes_find_space(line.str + start, line.size - start);
   return {line.str + token_start, start - token_start};
 }
 
@@ -652,12 +1164,8 @@ String str_trim(String string) {
 }
 
 i32 str_index_of(String string, u8 c) {
-  Loop (i, string.size) {
-    if (string.str[i] == c) {
-      return i;
-    }
-  }
-  return -1;
+  u64 idx = bytes_find(string.str, string.size, c);
+  return idx < string.size ? (i32)idx : -1;
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -689,36 +1197,275 @@ i64 i64_from_str(String str) {
   return x;
 }
 
-f64 f64_from_str(String str) {
-  f64 x = 0.0;
-  f64 frac = 0.0;
-  f64 factor = 0.1;
-  b32 negative = false;
-  i32 j = 0;
-  // handle optional sign
-  if (str.size > 0) {
-    if (str.str[j] == '-') {
-      negative = true;
-      j++;
-    }
-  }
-  for (; j < str.size; ++j) {
-    u8 ch = str.str[j];
-    if (ch == '.') {
-      ++j;
-      break;
+////////////////////////////////////////////////////////////////////////
+// String => Float
+// NOTE: Eisel-Lemire (Lemire, "Number Parsing at a Gigabyte per Second", 2021): up to 19
+// significant digits times a 128 bit 5^q approximation is enough to round correctly.
+// Longer inputs that land between two floats go to strtod.
+
+struct FloatFormat {
+  i32 mantissa_bits;
+  i32 min_exponent;
+  i32 infinite_power;
+  i32 round_even_min_q;
+  i32 round_even_max_q;
+  i32 smallest_q; // below rounds to zero
+  i32 largest_q;  // above is inf
+};
+
+global const FloatFormat F64_FORMAT = {52, -1023, 0x7FF, -4, 23, -342, 308};
+global const FloatFormat F32_FORMAT = {23, -127, 0xFF, -17, 10, -64, 38};
+
+struct DecimalNumber {
+  u64 mantissa; // first 19 significant digits
+  i64 exponent; // value = mantissa * 10^exponent
+  b32 negative;
+  b32 truncated; // more than 19 significant digits
+  u8* end;
+};
+
+const u64 SWAR_ZEROS = 0x3030303030303030;
+
+// digits count at start of 8 bytes: carries only go up, so lowest flagged byte is exact
+intern u32 swar_digit_count(u64 val) {
+  u64 flags = ((val + 0x4646464646464646) | (val - SWAR_ZEROS)) & 0x8080808080808080;
+  return flags ? ctz(flags) >> 3 : 8;
+}
+
+// 8 ascii digits to integer, first char is most significant
+intern u32 swar_parse_eight_digits(u64 val) {
+  const u64 mask = 0x000000FF000000FF;
+  const u64 mul1 = 0x000F424000000064; // 100 + (1000000 << 32)
+  const u64 mul2 = 0x0000271000000001; // 1 + (10000 << 32)
+  val -= SWAR_ZEROS;
+  val = (val * 10) + (val >> 8);
+  val = (((val & mask) * mul1) + (((val >> 16) & mask) * mul2)) >> 32;
+  return (u32)val;
+}
+
+// accumulates digit run into mantissa, up to 8 digits per step while 8 bytes are readable
+intern u8* digits_parse(u8* p, u8* end, u64* mantissa) {
+  u64 m = *mantissa;
+  while (end - p >= 8) {
+    u64 val;
+    MemCopy(&val, p, sizeof(val));
+    u32 n = swar_digit_count(val);
+    if (n == 0) break;
+    if (n < 8) {
+      // pad with leading zeros
+      val = (val << (8 - n) * 8) | (SWAR_ZEROS >> n * 8);
     }
-    x = x * 10 + (ch - '0'); // integer part
+    m = m * POW10_U64[n] + swar_parse_eight_digits(val);
+    p += n;
+    if (n < 8) break;
   }
-  for (; j < str.size; ++j) {
-    u8 ch = str.str[j];
-    frac += (ch - '0') * factor; // fractional part
-    factor *= 0.1;
+  while (p < end && char_is_digit(*p)) {
+    m = m * 10 + (*p - '0');
+    ++p;
   }
-  x += frac;
-  if (negative)
-    x = -x;
-  return x;
+  *mantissa = m;
+  return p;
+}
+
+// [+-]digits[.digits][(e|E)[+-]digits], end is null if there is no number
+intern DecimalNumber decimal_parse(u8* p, u8* end) {
+  DecimalNumber result = {};
+  if (p < end && (*p == '-' || *p == '+')) {
+    result.negative = *p == '-';
+    ++p;
+  }
+  u8* int_begin = p;
+  p = digits_parse(p, end, &result.mantissa);
+  u8* int_end = p;
+  u64 digit_count = int_end - int_begin;
+  u8* frac_begin = p;
+  u8* frac_end = p;
+  if (p < end && *p == '.') {
+    frac_begin = ++p;
+    p = digits_parse(p, end, &result.mantissa);
+    frac_end = p;
+    digit_count += frac_end - frac_begin;
+    result.exponent = frac_begin - frac_end;
+  }
+  if (digit_count == 0) {
+    return {};
+  }
+  i64 exp_number = 0;
+  if (p < end && (*p | 0x20) == 'e') {
+    u8* exp_p = p + 1;
+    b32 exp_negative = false;
+    if (exp_p < end && (*exp_p == '-' || *exp_p == '+')) {
+      exp_negative = *exp_p == '-';
+      ++exp_p;
+    }
+    if (exp_p < end && char_is_digit(*exp_p)) {
+      for (; exp_p < end && char_is_digit(*exp_p); ++exp_p) {
+        if (exp_number < 0x10000000) exp_number = exp_number * 10 + (*exp_p - '0');
+      }
+      if (exp_negative) exp_number = -exp_number;
+      result.exponent += exp_number;
+      p = exp_p;
+    }
+  }
+  result.end = p;
+
+  // mantissa overflowed, keep first 19 significant digits
+  if (digit_count > 19) {
+    u8* first = int_begin;
+    while (first < frac_end && (*first == '0' || *first == '.')) {
+      if (*first == '0') --digit_count;
+      ++first;
+    }
+    if (digit_count > 19) {
+      const u64 min_19_digits = 1000000000000000000ull;
+      result.truncated = true;
+      u64 m = 0;
+      u8* it = first;
+      for (; it < int_end && m < min_19_digits; ++it) {
+        m = m * 10 + (*it - '0');
+      }
+      if (m >= min_19_digits) {
+        result.exponent = int_end - it + exp_number;
+      } else {
+        it = Max(it, frac_begin);
+        for (; it < frac_end && m < min_19_digits; ++it) {
+          m = m * 10 + (*it - '0');
+        }
+        result.exponent = frac_begin - it + exp_number;
+      }
+      result.mantissa = m;
+    }
+  }
+  return result;
+}
+
+// returns ieee bits without sign, or U64_MAX when it can't decide and slow path is needed
+intern u64 eisel_lemire(i64 q, u64 w, FloatFormat f) {
+  if (w == 0 || q < f.smallest_q) return 0;
+  if (q > f.largest_q) return (u64)f.infinite_power << f.mantissa_bits;
+  i32 lz = clz(w);
+  w <<= lz;
+
+  // w * 5^q, second half only when first one can't tell the rounding
+  const u64* pow5 = POW5_128[q - POW5_128_MIN_Q];
+  u128 product = (u128)w * pow5[0];
+  u64 precision_mask = U64_MAX >> (f.mantissa_bits + 3);
+  if (((u64)(product >> 64) & precision_mask) == precision_mask) {
+    u128 second = (u128)w * pow5[1];
+    product += second >> 64;
+  }
+  u64 hi = product >> 64;
+  u64 lo = (u64)product;
+
+  i32 upper_bit = hi >> 63;
+  i32 shift = upper_bit + 64 - f.mantissa_bits - 3;
+  u64 mantissa = hi >> shift;
+  i32 power2 = (i32)((((152170 + 65536) * q) >> 16) + 63) + upper_bit - lz - f.min_exponent;
+  if (power2 <= 0) {
+    // subnormal
+    if (-power2 + 1 >= 64) return 0;
+    mantissa >>= -power2 + 1;
+    mantissa += mantissa & 1;
+    mantissa >>= 1;
+    power2 = mantissa < (1ull << f.mantissa_bits) ? 0 : 1;
+    return mantissa | ((u64)power2 << f.mantissa_bits);
+  }
+  // exactly halfway, round to even instead of up
+  if (lo <= 1 && q >= f.round_even_min_q && q <= f.round_even_max_q && (mantissa & 3) == 1) {
+    if ((mantissa << shift) == hi) {
+      mantissa &= ~1ull;
+    }
+  }
+  mantissa += mantissa & 1;
+  mantissa >>= 1;
+  if (mantissa >= (2ull << f.mantissa_bits)) {
+    mantissa = 1ull << f.mantissa_bits;
+    ++power2;
+  }
+  mantissa &= ~(1ull << f.mantissa_bits);
+  if (power2 >= f.infinite_power) {
+    return (u64)f.infinite_power << f.mantissa_bits;
+  }
+  return mantissa | ((u64)power2 << f.mantissa_bits);
+}
+
+// truncated digits are somewhere between w and w+1, both have to round the same way
+intern u64 decimal_to_float_bits(DecimalNumber d, FloatFormat f) {
+  u64 bits = eisel_lemire(d.exponent, d.mantissa, f);
+  if (d.truncated && bits != eisel_lemire(d.exponent, d.mantissa + 1, f)) {
+    return U64_MAX;
+  }
+  return bits;
+}
+
+// Clinger: mantissa and 10^|q| are exact, so one ieee mul/div rounds correctly.
+// Index is never a compile time constant, fast-math can't turn the div into a reciprocal mul.
+global const f64 F64_EXACT_POW10[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+global const f32 F32_EXACT_POW10[] = {
+  1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f,
+};
+
+intern u8* f64_parse(u8* p, u8* end, f64* out) {
+  DecimalNumber d = decimal_parse(p, end);
+  if (!d.end) return null;
+  i64 max_exact = ArrayCount(F64_EXACT_POW10) - 1;
+  if (!d.truncated && d.mantissa <= (1ull << 53) && -max_exact <= d.exponent && d.exponent <= max_exact) {
+    f64 val = (f64)d.mantissa;
+    val = d.exponent < 0 ? val / F64_EXACT_POW10[-d.exponent] : val * F64_EXACT_POW10[d.exponent];
+    *out = d.negative ? -val : val;
+    return d.end;
+  }
+  u64 bits = decimal_to_float_bits(d, F64_FORMAT);
+  if (bits == U64_MAX) {
+    u8 buf[512];
+    u64 size = Min((u64)(d.end - p), sizeof(buf) - 1);
+    MemCopy(buf, p, size);
+    buf[size] = 0;
+    *out = strtod((char*)buf, null);
+    return d.end;
+  }
+  bits |= (u64)d.negative << 63;
+  MemCopy(out, &bits, sizeof(*out));
+  return d.end;
+}
+
+intern u8* f32_parse(u8* p, u8* end, f32* out) {
+  DecimalNumber d = decimal_parse(p, end);
+  if (!d.end) return null;
+  i64 max_exact = ArrayCount(F32_EXACT_POW10) - 1;
+  if (!d.truncated && d.mantissa <= (1ull << 24) && -max_exact <= d.exponent && d.exponent <= max_exact) {
+    f32 val = (f32)d.mantissa;
+    val = d.exponent < 0 ? val / F32_EXACT_POW10[-d.exponent] : val * F32_EXACT_POW10[d.exponent];
+    *out = d.negative ? -val : val;
+    return d.end;
+  }
+  u64 bits = decimal_to_float_bits(d, F32_FORMAT);
+  if (bits == U64_MAX) {
+    u8 buf[512];
+    u64 size = Min((u64)(d.end - p), sizeof(buf) - 1);
+    MemCopy(buf, p, size);
+    buf[size] = 0;
+    *out = strtof((char*)buf, null);
+    return d.end;
+  }
+  u32 bits32 = (u32)bits | ((u32)d.negative << 31);
+  MemCopy(out, &bits32, sizeof(*out));
+  return d.end;
+}
+
+f64 f64_from_str(String str) {
+  f64 result = 0;
+  f64_parse(str.str, str.str + str.size, &result);
+  return result;
+}
+
+f32 f32_from_str(String str) {
+  f32 result = 0;
+  f32_parse(str.str, str.str + str.size, &result);
+  return result;
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -814,6 +1561,307 @@ String str_skip_last_dot(String string) {
   return string;
 }
 
+////////////////////////////////////////////////////////////////////////
+// Unicode
+// NOTE: avx2 validation is the lookup algorithm from Keiser & Lemire, "Validating UTF-8 In
+// Less Than One Instruction Per Byte" (2021): three nibble lookups on each byte pair catch
+// every two byte error, 3 and 4 byte sequences are checked with bytes 2 and 3 back.
+// Transcoders move 32 byte ascii runs with widen/pack, everything else goes through scalar.
+
+// 0 for invalid or truncated sequences
+intern u32 utf8_decode(u8* p, u8* end, u32* out) {
+  u8 c = p[0];
+  if (c < 0x80) {
+    *out = c;
+    return 1;
+  }
+  u32 length, cp, min;
+  if ((c & 0xE0) == 0xC0)      { length = 2; cp = c & 0x1F; min = 0x80; }
+  else if ((c & 0xF0) == 0xE0) { length = 3; cp = c & 0x0F; min = 0x800; }
+  else if ((c & 0xF8) == 0xF0) { length = 4; cp = c & 0x07; min = 0x10000; }
+  else return 0;
+  if ((u64)(end - p) < length) return 0;
+  for (u32 i = 1; i < length; ++i) {
+    if ((p[i] & 0xC0) != 0x80) return 0;
+    cp = (cp << 6) | (p[i] & 0x3F);
+  }
+  if (cp < min || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) return 0;
+  *out = cp;
+  return length;
+}
+
+intern u32 utf8_encode(u8* out, u32 cp) {
+  if (cp < 0x80) {
+    out[0] = cp;
+    return 1;
+  }
+  if (cp < 0x800) {
+    out[0] = 0xC0 | (cp >> 6);
+    out[1] = 0x80 | (cp & 0x3F);
+    return 2;
+  }
+  if (cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) {
+    cp = UNICODE_REPLACEMENT;
+  }
+  if (cp < 0x10000) {
+    out[0] = 0xE0 | (cp >> 12);
+    out[1] = 0x80 | ((cp >> 6) & 0x3F);
+    out[2] = 0x80 | (cp & 0x3F);
+    return 3;
+  }
+  out[0] = 0xF0 | (cp >> 18);
+  out[1] = 0x80 | ((cp >> 12) & 0x3F);
+  out[2] = 0x80 | ((cp >> 6) & 0x3F);
+  out[3] = 0x80 | (cp & 0x3F);
+  return 4;
+}
+
+#if SIMD_AVX2
+// byte n back, crossing from the previous block
+#define Utf8Prev(input, prev_input, n) _mm256_alignr_epi8(input, _mm256_permute2x128_si256(prev_input, input, 0x21), 16 - (n))
+
+enum : u8 {
+  Utf8Error_TooShort   = Bit(0), // 11______ 0_______ or 11______ 11______
+  Utf8Error_TooLong    = Bit(1), // 0_______ 10______
+  Utf8Error_Overlong3  = Bit(2), // 11100000 100_____
+  Utf8Error_TooLarge   = Bit(3), // 11110100 1001____, above 0x10FFFF
+  Utf8Error_Surrogate  = Bit(4), // 11101101 101_____
+  Utf8Error_Overlong2  = Bit(5), // 1100000_ 10______
+  Utf8Error_Large1000  = Bit(6), // 11110101 1000____, and 11110000 1000____ overlong 4
+  Utf8Error_TwoConts   = Bit(7), // 10______ 10______, fine when 3 or 4 byte lead is behind
+  Utf8Error_Carry      = Utf8Error_TooShort | Utf8Error_TooLong | Utf8Error_TwoConts,
+};
+
+intern __m256i utf8_block_errors(__m256i input, __m256i prev_input) {
+  const u8 Short = Utf8Error_TooShort, Long = Utf8Error_TooLong, Over3 = Utf8Error_Overlong3;
+  const u8 Large = Utf8Error_TooLarge, Surr = Utf8Error_Surrogate, Over2 = Utf8Error_Overlong2;
+  const u8 L1000 = Utf8Error_Large1000, Conts = Utf8Error_TwoConts, Carry = Utf8Error_Carry;
+  __m256i byte_1_high_table = _mm256_setr_epi8(
+    Long, Long, Long, Long, Long, Long, Long, Long,
+    Conts, Conts, Conts, Conts, Short | Over2, Short, Short | Over3 | Surr, Short | Large | L1000,
+    Long, Long, Long, Long, Long, Long, Long, Long,
+    Conts, Conts, Conts, Conts, Short | Over2, Short, Short | Over3 | Surr, Short | Large | L1000);
+  __m256i byte_1_low_table = _mm256_setr_epi8(
+    Carry | Over3 | Over2 | L1000, Carry | Over2, Carry, Carry,
+    Carry | Large, Carry | Large | L1000, Carry | Large | L1000, Carry | Large | L1000,
+    Carry | Large | L1000, Carry | Large | L1000, Carry | Large | L1000, Carry | Large | L1000,
+    Carry | Large | L1000, Carry | Large | L1000 | Surr, Carry | Large | L1000, Carry | Large | L1000,
+    Carry | Over3 | Over2 | L1000, Carry | Over2, Carry, Carry,
+    Carry | Large, Carry | Large | L1000, Carry | Large | L1000, Carry | Large | L1000,
+    Carry | Large | L1000, Carry | Large | L1000, Carry | Large | L1000, Carry | Large | L1000,
+    Carry | Large | L1000, Carry | Large | L1000 | Surr, Carry | Large | L1000, Carry | Large | L1000);
+  __m256i byte_2_high_table = _mm256_setr_epi8(
+    Short, Short, Short, Short, Short, Short, Short, Short,
+    Long | Over2 | Conts | Over3 | L1000, Long | Over2 | Conts | Over3 | Large,
+    Long | Over2 | Conts | Surr | Large, Long | Over2 | Conts | Surr | Large,
+    Short, Short, Short, Short,
+    Short, Short, Short, Short, Short, Short, Short, Short,
+    Long | Over2 | Conts | Over3 | L1000, Long | Over2 | Conts | Over3 | Large,
+    Long | Over2 | Conts | Surr | Large, Long | Over2 | Conts | Surr | Large,
+    Short, Short, Short, Short);
+  __m256i nibble = _mm256_set1_epi8(0x0F);
+  __m256i prev1 = Utf8Prev(input, prev_input, 1);
+  __m256i byte_1_high = _mm256_shuffle_epi8(byte_1_high_table, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble));
+  __m256i byte_1_low = _mm256_shuffle_epi8(byte_1_low_table, _mm256_and_si256(prev1, nibble));
+  __m256i byte_2_high = _mm256_shuffle_epi8(byte_2_high_table, _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble));
+  __m256i special = _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+  // two continuations in a row are only fine as 3rd or 4th byte, 111_____ 2 back or 1111____ 3 back
+  __m256i third = _mm256_subs_epu8(Utf8Prev(input, prev_input, 2), _mm256_set1_epi8(0xE0 - 0x80));
+  __m256i fourth = _mm256_subs_epu8(Utf8Prev(input, prev_input, 3), _mm256_set1_epi8(0xF0 - 0x80));
+  __m256i must_be_cont = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8(0x80));
+  return _mm256_xor_si256(must_be_cont, special);
+}
+#endif
+
+b32 utf8_validate(u8* data, u64 size) {
+#if SIMD_AVX2
+  __m256i error = _mm256_setzero_si256();
+  __m256i prev_input = _mm256_setzero_si256();
+  __m256i prev_incomplete = _mm256_setzero_si256();
+  // last 3 bytes above these start a sequence that needs the next block
+  __m256i max_value = _mm256_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                       -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                       0xF0 - 1, 0xE0 - 1, 0xC0 - 1);
+  u8 tail[32];
+  for (u64 i = 0; i < size; i += 32) {
+    u8* block = data + i;
+    // zero padding is ascii, a sequence cut by the end shows up as too short
+    if (size - i < 32) {
+      MemSet(tail, 0, sizeof(tail));
+      MemCopy(tail, block, size - i);
+      block = tail;
+    }
+    __m256i input = _mm256_loadu_si256((__m256i*)block);
+    if (_mm256_movemask_epi8(input) == 0) {
+      error = _mm256_or_si256(error, prev_incomplete);
+      prev_incomplete = _mm256_setzero_si256();
+    } else {
+      error = _mm256_or_si256(error, utf8_block_errors(input, prev_input));
+      prev_incomplete = _mm256_subs_epu8(input, max_value);
+    }
+    prev_input = input;
+  }
+  error = _mm256_or_si256(error, prev_incomplete);
+  return _mm256_testz_si256(error, error);
+#else
+  u8* p = data;
+  u8* end = data + size;
+  while (p < end) {
+    u32 cp;
+    u32 length = utf8_decode(p, end, &cp);
+    if (!length) return false;
+    p += length;
+  }
+  return true;
+#endif
+}
+
+u64 utf32_from_utf8(u32* out, u8* in, u64 size) {
+  u32* out_start = out;
+  u8* end = in + size;
+  while (in < end) {
+    u8* block_end = Min(in + 32, end);
+#if SIMD_AVX2
+    if (end - in >= 32) {
+      __m256i v = _mm256_loadu_si256((__m256i*)in);
+      if (_mm256_movemask_epi8(v) == 0) {
+        __m128i lo = _mm256_castsi256_si128(v);
+        __m128i hi = _mm256_extracti128_si256(v, 1);
+        _mm256_storeu_si256((__m256i*)(out + 0),  _mm256_cvtepu8_epi32(lo));
+        _mm256_storeu_si256((__m256i*)(out + 8),  _mm256_cvtepu8_epi32(_mm_srli_si128(lo, 8)));
+        _mm256_storeu_si256((__m256i*)(out + 16), _mm256_cvtepu8_epi32(hi));
+        _mm256_storeu_si256((__m256i*)(out + 24), _mm256_cvtepu8_epi32(_mm_srli_si128(hi, 8)));
+        in += 32;
+        out += 32;
+        continue;
+      }
+    }
+#endif
+    while (in < block_end) {
+      u32 cp;
+      u32 length = utf8_decode(in, end, &cp);
+      if (!length) {
+        cp = UNICODE_REPLACEMENT;
+        length = 1;
+      }
+      *out++ = cp;
+      in += length;
+    }
+  }
+  return out - out_start;
+}
+
+u64 utf16_from_utf8(u16* out, u8* in, u64 size) {
+  u16* out_start = out;
+  u8* end = in + size;
+  while (in < end) {
+    u8* block_end = Min(in + 32, end);
+#if SIMD_AVX2
+    if (end - in >= 32) {
+      __m256i v = _mm256_loadu_si256((__m256i*)in);
+      if (_mm256_movemask_epi8(v) == 0) {
+        _mm256_storeu_si256((__m256i*)(out + 0),  _mm256_cvtepu8_epi16(_mm256_castsi256_si128(v)));
+        _mm256_storeu_si256((__m256i*)(out + 16), _mm256_cvtepu8_epi16(_mm256_extracti128_si256(v, 1)));
+        in += 32;
+        out += 32;
+        continue;
+      }
+    }
+#endif
+    while (in < block_end) {
+      u32 cp;
+      u32 length = utf8_decode(in, end, &cp);
+      if (!length) {
+        cp = UNICODE_REPLACEMENT;
+        length = 1;
+      }
+      if (cp >= 0x10000) {
+        cp -= 0x10000;
+        *out++ = 0xD800 | (cp >> 10);
+        *out++ = 0xDC00 | (cp & 0x3FF);
+      } else {
+        *out++ = cp;
+      }
+      in += length;
+    }
+  }
+  return out - out_start;
+}
+
+u64 utf8_from_utf32(u8* out, u32* in, u64 count) {
+  u8* out_start = out;
+  u32* end = in + count;
+  while (in < end) {
+#if SIMD_AVX2
+    if (end - in >= 8) {
+      __m256i v = _mm256_loadu_si256((__m256i*)in);
+      if (_mm256_testz_si256(v, _mm256_set1_epi32(~0x7F))) {
+        __m128i words = _mm_packus_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+        _mm_storel_epi64((__m128i*)out, _mm_packus_epi16(words, words));
+        in += 8;
+        out += 8;
+        continue;
+      }
+    }
+#endif
+    out += utf8_encode(out, *in++);
+  }
+  return out - out_start;
+}
+
+u64 utf8_from_utf16(u8* out, u16* in, u64 count) {
+  u8* out_start = out;
+  u16* end = in + count;
+  while (in < end) {
+#if SIMD_AVX2
+    if (end - in >= 16) {
+      __m256i v = _mm256_loadu_si256((__m256i*)in);
+      if (_mm256_testz_si256(v, _mm256_set1_epi16(~0x7F))) {
+        _mm_storeu_si128((__m128i*)out, _mm_packus_epi16(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1)));
+        in += 16;
+        out += 16;
+        continue;
+      }
+    }
+#endif
+    u32 cp = *in++;
+    if (cp >= 0xD800 && cp <= 0xDBFF && in < end && *in >= 0xDC00 && *in <= 0xDFFF) {
+      cp = 0x10000 + ((cp - 0xD800) << 10) + (*in++ - 0xDC00);
+    }
+    // lone surrogates come out as U+FFFD
+    out += utf8_encode(out, cp);
+  }
+  return out - out_start;
+}
+
+String push_str_utf16(Allocator arena, u16* in, u64 count) {
+  u8* buf = push_buffer(arena, count * 3 + 1);
+  u64 size = utf8_from_utf16(buf, in, count);
+  buf[size] = 0;
+  return {buf, size};
+}
+
+String push_str_utf32(Allocator arena, u32* in, u64 count) {
+  u8* buf = push_buffer(arena, count * 4 + 1);
+  u64 size = utf8_from_utf32(buf, in, count);
+  buf[size] = 0;
+  return {buf, size};
+}
+
+Slice<u16> push_utf16_from_str(Allocator arena, String str) {
+  u16* buf = push_array(arena, u16, str.size + 1);
+  u64 count = utf16_from_utf8(buf, str.str, str.size);
+  buf[count] = 0;
+  return {buf, count};
+}
+
+Slice<u32> push_utf32_from_str(Allocator arena, String str) {
+  u32* buf = push_array(arena, u32, str.size + 1);
+  u64 count = utf32_from_utf8(buf, str.str, str.size);
+  buf[count] = 0;
+  return {buf, count};
+}
+
 ////////////////////////////////////////////////////////////////////////
 // Wchar stuff
 
@@ -829,12 +1877,12 @@ u64 wchar_to_char(char* out, const wchar_t* in, u64 out_size) {
 }
 
 String push_str_wchar(Allocator arena, const wchar_t* in, u32 wchar_length) {
-  u8* buf = push_buffer(arena, wchar_length + 1);
-  Loop (i , wchar_length) {
-    buf[i] = in[i];
+  // utf-16 on windows, utf-32 elsewhere
+  if constexpr (sizeof(wchar_t) == 2) {
+    return push_str_utf16(arena, (u16*)in, wchar_length);
+  } else {
+    return push_str_utf32(arena, (u32*)in, wchar_length);
   }
-  buf[wchar_length] = 0;
-  return {buf, wchar_length};
 }
 
 Lexer lexer_init(String buffer) {
@@ -846,28 +1894,52 @@ Lexer lexer_init(String buffer) {
 }
 
 String lexer_next_token(Lexer* l) {
-  while (l->cur < l->end && char_is_space(*l->cur)) {
-    l->cur++;
+#if SIMD_AVX2
+  // one space mask gives both the token start and, for short tokens, its end
+  while (l->end - l->cur >= 32) {
+    u32 spaces = space_mask_256(_mm256_loadu_si256((__m256i*)l->cur));
+    if (spaces == U32_MAX) {
+      l->cur += 32;
+      continue;
+    }
+    u32 start = ctz(~spaces);
+    u32 after = spaces >> start;
+    u8* current = l->cur + start;
+    if (after) {
+      l->cur = current + ctz(after);
+    } else {
+      l->cur = current + bytes_find_space(current, l->end - current);
+    }
+    String result = {current, (u64)l->cur - (u64)current};
+    return result;
   }
+#endif
+  l->cur += bytes_skip_space(l->cur, l->end - l->cur);
   if (l->cur == l->end) return {};
   u8* current = l->cur;
-  while (l->cur < l->end && !char_is_space(*l->cur)) {
-    l->cur++;
-  }
+  l->cur += bytes_find_space(l->cur, l->end - l->cur);
   String result = {current, (u64)l->cur - (u64)current};
   return result;
 }
 
-String lexer_next_integer(Lexer* l) {
-  while (l->cur < l->end && char_is_space(*l->cur)) {
-    l->cur++;
+u32 lexer_next_f32_array(Lexer* l, f32* out, u32 count) {
+  Loop (i, count) {
+    l->cur += bytes_skip_space(l->cur, l->end - l->cur);
+    u8* next = f32_parse(l->cur, l->end, &out[i]);
+    if (!next) return i;
+    l->cur = next;
   }
+  return count;
+}
+
+String lexer_next_integer(Lexer* l) {
+  l->cur += bytes_skip_space(l->cur, l->end - l->cur);
   if (l->cur == l->end) return {};
-  while (!char_is_digit(*l->cur)) {
+  while (l->cur < l->end && !char_is_digit(*l->cur)) {
     ++l->cur;
   }
   u8* current = l->cur;
-  while (char_is_digit(*l->cur)) {
+  while (l->cur < l->end && char_is_digit(*l->cur)) {
     ++l->cur;
   }
   String result = {current, (u64)l->cur - (u64)current};
@@ -14,7 +14,7 @@ struct DString {
   void init(Allocator alloc_);
   void add(String str);
   void clear();
-  operator String();
+  operator String() const;
 };
 
 struct StringArray {
@@ -34,6 +34,50 @@ struct StringList {
   u32 total_size;
 };
 
+// Appends go into a list of allocator blocks, growing never moves what is already written.
+// finalize gathers into one buffer only when it's needed, os_file_write_builder writes blocks as is.
+const u32 STR_BUILDER_FIRST_CHUNK = KB(1);
+const u32 STR_BUILDER_MAX_CHUNK = KB(64);
+// add_ref links shorter strings by copy, a node costs more than that
+const u32 STR_BUILDER_MIN_REF = 64;
+
+template<typename... Args> struct FmtStr;
+template<typename T> struct FmtNoDeduceT { using Type = T; };
+template<typename T> using FmtNoDeduce = typename FmtNoDeduceT<T>::Type;
+
+struct StrBuilderChunk {
+  StrBuilderChunk* next;
+  u8* str;
+  u32 size;
+  u32 cap; // == size for referenced strings, nothing more goes into them
+};
+
+struct StrBuilder {
+  StrBuilderChunk* first;
+  StrBuilderChunk* last;
+  u64 total_size;
+  u32 chunk_count;
+  u32 next_cap;
+  Allocator alloc;
+  void init(Allocator alloc_);
+  // contiguous space for size bytes at the end, commit says how many were written
+  u8* reserve(u32 size);
+  void commit(u32 size);
+  // reserve and commit all of size
+  u8* push(u32 size);
+  void add(String str);
+  // links str without copying it, str has to outlive the builder
+  void add_ref(String str);
+  template<typename... Args>
+  void addf(FmtStr<FmtNoDeduce<Args>...> fmt, Args... args);
+  void addf(String fmt, ...);
+  void addfv(String fmt, VaList args);
+  // drops content, blocks stay in the allocator like any other arena memory
+  void clear();
+  // null terminated, a single owned block is returned in place
+  String finalize(Allocator arena);
+};
+
 u64 cstr_length(const void* c);
 
 ////////////////////////////////////////////////////////////////////////
@@ -50,6 +94,16 @@ u8 char_to_upper(u8 c);
 u8 char_to_correct_slash(u8 c);
 b32 char_is_number_cont(u8 c);
 
+////////////////////////////////////////////////////////////////////////
+// Byte Scanning
+// Each returns index of the first hit, or size when there is none.
+
+u64 bytes_find(u8* data, u64 size, u8 c);
+u64 bytes_mismatch(u8* a, u8* b, u64 size);
+// space is ' ', '\n', '\t', same as char_is_space
+u64 bytes_find_space(u8* data, u64 size);
+u64 bytes_skip_space(u8* data, u64 size);
+
 ////////////////////////////////////////////////////////////////////////
 // String Constructors
 
@@ -133,9 +187,265 @@ i32 str_index_of(String str, u8 c);
 u64 u64_from_str(String str);
 i64 i64_from_str(String str);
 f64 f64_from_str(String str);
+f32 f32_from_str(String str);
 INLINE u32 u32_from_str(String str) { return u64_from_str(str); };
 INLINE i32 i32_from_str(String str) { return i64_from_str(str); };
-INLINE f32 f32_from_str(String str) { return f64_from_str(str); };
+
+////////////////////////////////////////////////////////////////////////
+// Number => String
+// Write into dest and return written size, dest must have room for the max chars.
+// %g/%g32 in push_strf print shortest round-trip floats, %f/%.Nf round it to N digits.
+
+const u32 FLOAT_SHORTEST_MAX_CHARS = 32;
+const u32 FLOAT_FIXED_MAX_CHARS = 330; // 309 integer digits of f64 max + precision up to 9
+
+u32 u64_write(u8* dest, u64 value);
+u32 f64_write(u8* dest, f64 value, u32 precision);
+u32 f64_write_shortest(u8* dest, f64 value);
+u32 f32_write_shortest(u8* dest, f32 value);
+
+////////////////////////////////////////////////////////////////////////
+// Compile-time Formatting
+// A literal format passed with arguments to push_strf, Info and others becomes a FmtStr. Its
+// consteval constructor parses the format and checks argument count and types, so a bad
+// format doesn't compile. Writing then has no format parsing, the buffer is sized from an
+// upper bound and filled in one pass. String formats known only at runtime use my_sprintf.
+
+enum FmtKind : u8 {
+  FmtKind_U32,        // %u
+  FmtKind_U64,        // %u64
+  FmtKind_I32,        // %i
+  FmtKind_I64,        // %i64
+  FmtKind_Char,       // %c
+  FmtKind_Pointer,    // %p
+  FmtKind_Fixed,      // %f, %.Nf
+  FmtKind_Shortest64, // %g
+  FmtKind_Shortest32, // %g32
+  FmtKind_String,     // %s
+};
+
+struct FmtSpec {
+  FmtKind kind;
+  u8 precision;
+};
+
+struct FmtPiece {
+  u16 start;
+  u16 size;
+};
+
+// every %% splits a literal run, this caps how many pieces FmtStr keeps
+const u32 FMT_MAX_ESCAPES = 8;
+
+// never defined, calling one during constant evaluation is the compile error
+void fmt_error_unknown_specifier();
+void fmt_error_not_enough_arguments();
+void fmt_error_too_many_arguments();
+void fmt_error_argument_type_mismatch();
+void fmt_error_too_many_escapes();
+
+enum FmtArgClass : u8 {
+  FmtArgClass_None,
+  FmtArgClass_Int32,
+  FmtArgClass_Int64,
+  FmtArgClass_Float,
+  FmtArgClass_String,
+  FmtArgClass_Pointer,
+};
+
+template<typename T> constexpr b32 fmt_is_pointer = false;
+template<typename T> constexpr b32 fmt_is_pointer<T*> = true;
+
+template<typename T>
+consteval FmtArgClass fmt_arg_class() {
+  if constexpr (__is_same(T, f32) || __is_same(T, f64)) {
+    return FmtArgClass_Float;
+  } else if constexpr (__is_enum(T) || (!__is_class(T) && requires (T v) { v % v; })) {
+    return sizeof(T) <= 4 ? FmtArgClass_Int32 : FmtArgClass_Int64;
+  } else if constexpr (requires (T v) { String(v); }) {
+    return FmtArgClass_String;
+  } else if constexpr (fmt_is_pointer<T>) {
+    return FmtArgClass_Pointer;
+  } else {
+    return FmtArgClass_None;
+  }
+}
+
+consteval b32 fmt_kind_accepts(FmtKind kind, FmtArgClass arg) {
+  switch (kind) {
+    case FmtKind_U32: case FmtKind_I32: case FmtKind_Char: return arg == FmtArgClass_Int32;
+    case FmtKind_U64: case FmtKind_I64:                    return arg == FmtArgClass_Int64;
+    case FmtKind_Pointer:    return arg == FmtArgClass_Pointer || arg == FmtArgClass_Int64;
+    case FmtKind_Fixed: case FmtKind_Shortest64: case FmtKind_Shortest32: return arg == FmtArgClass_Float;
+    case FmtKind_String:     return arg == FmtArgClass_String;
+  }
+  return false;
+}
+
+template<typename... Args>
+struct FmtStr {
+  static constexpr u32 ARG_COUNT = sizeof...(Args);
+  const char* text;
+  u32 size;
+  u32 literal_size;
+  FmtSpec specs[ARG_COUNT + 1];
+  // pieces before argument i end at arg_piece_end[i], the rest follow the last argument
+  u8 arg_piece_end[ARG_COUNT + 1];
+  u8 piece_count;
+  FmtPiece pieces[ARG_COUNT + 1 + FMT_MAX_ESCAPES];
+
+  template<u32 N>
+  consteval FmtStr(const char (&fmt)[N]) : text(fmt), size(N - 1), literal_size(0), specs{}, arg_piece_end{}, piece_count(0), pieces{} {
+    FmtArgClass arg_classes[] = {fmt_arg_class<Args>()..., FmtArgClass_None};
+    u32 arg = 0;
+    u32 piece_start = 0;
+    for (u32 i = 0; i < size; ++i) {
+      if (fmt[i] != '%') continue;
+      // %% keeps the first '%' as the end of the piece and skips the second
+      b32 escape = i + 1 < size && fmt[i+1] == '%';
+      add_piece(piece_start, i + escape);
+      if (escape) {
+        piece_start = i + 2;
+        ++i;
+        continue;
+      }
+      FmtSpec spec = {};
+      u32 p = i + 1;
+      auto next_is = [&](const char* suffix) {
+        return p + 2 <= size && fmt[p+1] == suffix[0] && fmt[p+2] == suffix[1];
+      };
+      if (p >= size) fmt_error_unknown_specifier();
+      switch (fmt[p]) {
+        case 'u': spec.kind = next_is("64") ? (p += 2, FmtKind_U64) : FmtKind_U32; break;
+        case 'i': spec.kind = next_is("64") ? (p += 2, FmtKind_I64) : FmtKind_I32; break;
+        case 'g': spec.kind = next_is("32") ? (p += 2, FmtKind_Shortest32) : FmtKind_Shortest64; break;
+        case 'c': spec.kind = FmtKind_Char; break;
+        case 'p': spec.kind = FmtKind_Pointer; break;
+        case 's': spec.kind = FmtKind_String; break;
+        case 'f': spec.kind = FmtKind_Fixed; spec.precision = 6; break;
+        case '.': {
+          if (p + 2 >= size || fmt[p+1] < '0' || fmt[p+1] > '9' || fmt[p+2] != 'f') fmt_error_unknown_specifier();
+          spec.kind = FmtKind_Fixed;
+          spec.precision = fmt[p+1] - '0';
+          p += 2;
+        } break;
+        default: fmt_error_unknown_specifier();
+      }
+      if (arg >= ARG_COUNT) fmt_error_not_enough_arguments();
+      if (!fmt_kind_accepts(spec.kind, arg_classes[arg])) fmt_error_argument_type_mismatch();
+      specs[arg] = spec;
+      arg_piece_end[arg] = piece_count;
+      ++arg;
+      i = p;
+      piece_start = p + 1;
+    }
+    add_piece(piece_start, size);
+    if (arg != ARG_COUNT) fmt_error_too_many_arguments();
+  }
+
+  consteval void add_piece(u32 start, u32 end) {
+    if (end <= start) return;
+    if (piece_count == ArrayCount(pieces)) fmt_error_too_many_escapes();
+    pieces[piece_count++] = {(u16)start, (u16)(end - start)};
+    literal_size += end - start;
+  }
+
+  operator String() const { return {(u8*)text, size}; }
+};
+
+u32 fmt_int_write(u8* dest, FmtSpec spec, u64 bits);
+u32 fmt_float_bound(FmtSpec spec, f64 value);
+u32 fmt_float_write(u8* dest, FmtSpec spec, f64 value);
+
+constexpr u32 fmt_int_bound(FmtSpec spec) {
+  switch (spec.kind) {
+    case FmtKind_U32:     return 10;
+    case FmtKind_I32:     return 11;
+    case FmtKind_U64:     return 20;
+    case FmtKind_I64:     return 20;
+    case FmtKind_Char:    return 1;
+    case FmtKind_Pointer: return 16;
+    default:              return 0;
+  }
+}
+
+template<typename T>
+INLINE u64 fmt_arg_bound(FmtSpec spec, const T& value) {
+  constexpr FmtArgClass arg_class = fmt_arg_class<T>();
+  if constexpr (arg_class == FmtArgClass_Float) {
+    return fmt_float_bound(spec, value);
+  } else if constexpr (arg_class == FmtArgClass_String) {
+    return String(value).size;
+  } else {
+    return fmt_int_bound(spec);
+  }
+}
+
+template<typename T>
+INLINE u64 fmt_arg_write(u8* dest, FmtSpec spec, const T& value) {
+  constexpr FmtArgClass arg_class = fmt_arg_class<T>();
+  if constexpr (arg_class == FmtArgClass_Float) {
+    return fmt_float_write(dest, spec, value);
+  } else if constexpr (arg_class == FmtArgClass_String) {
+    String str = value;
+    MemCopy(dest, str.str, str.size);
+    return str.size;
+  } else if constexpr (arg_class == FmtArgClass_Pointer) {
+    return fmt_int_write(dest, spec, (u64)value);
+  } else if constexpr (sizeof(T) <= 4) {
+    // same bits va_arg would have read, %u of a negative i32 wraps like before
+    return fmt_int_write(dest, spec, (u32)value);
+  } else {
+    return fmt_int_write(dest, spec, (u64)value);
+  }
+}
+
+// values may differ from Args when the checked arguments were stored and reloaded, see log_push
+template<typename... Args, typename... Values>
+u64 fmt_bound(const FmtStr<Args...>& fmt, const Values&... args) {
+  u64 bound = fmt.literal_size;
+  u32 arg = 0;
+  ((bound += fmt_arg_bound(fmt.specs[arg++], args)), ...);
+  return bound;
+}
+
+template<typename... Args, typename... Values>
+u64 fmt_write(u8* dest, const FmtStr<Args...>& fmt, const Values&... args) {
+  u8* start = dest;
+  u32 piece = 0;
+  u32 arg = 0;
+  auto write_pieces = [&](u32 end) {
+    for (; piece < end; ++piece) {
+      MemCopy(dest, (u8*)fmt.text + fmt.pieces[piece].start, fmt.pieces[piece].size);
+      dest += fmt.pieces[piece].size;
+    }
+  };
+  ((write_pieces(fmt.arg_piece_end[arg]), dest += fmt_arg_write(dest, fmt.specs[arg], args), ++arg), ...);
+  write_pieces(fmt.piece_count);
+  return dest - start;
+}
+
+template<typename... Args>
+String push_strf(Allocator arena, FmtStr<FmtNoDeduce<Args>...> fmt, Args... args) {
+  u64 bound = fmt_bound(fmt, args...);
+  u8* buf = push_buffer(arena, bound + 1); // for C-str
+  u64 size = fmt_write(buf, fmt, args...);
+  buf[size] = 0;
+  // hands the unused tail back, in place for an arena
+  buf = mem_realloc(arena, buf, bound + 1, size + 1);
+  return {buf, size};
+}
+
+template<typename... Args>
+void StrBuilder::addf(FmtStr<FmtNoDeduce<Args>...> fmt, Args... args) {
+  u8* dest = reserve(fmt_bound(fmt, args...));
+  commit(fmt_write(dest, fmt, args...));
+}
+
+template<typename... Args>
+StringNode* str_list_pushf(Allocator arena, StringList* list, FmtStr<FmtNoDeduce<Args>...> fmt, Args... args) {
+  return str_list_push(arena, list, push_strf(arena, fmt, args...));
+}
 
 ////////////////////////////////////////////////////////////////////////
 // String Path Helpers
@@ -155,6 +465,25 @@ String str_chop_last_dot(String string);
 // name.fmt -> fmt
 String str_skip_last_dot(String string);
 
+////////////////////////////////////////////////////////////////////////
+// Unicode
+// Decoders write U+FFFD for invalid input, utf8_validate rejects it instead.
+// Output needs room for: utf32/utf16 from utf8 - size units, utf8 from utf16 - count*3,
+// utf8 from utf32 - count*4 bytes.
+
+const u32 UNICODE_REPLACEMENT = 0xFFFD;
+
+b32 utf8_validate(u8* data, u64 size);
+u64 utf32_from_utf8(u32* out, u8* in, u64 size);
+u64 utf16_from_utf8(u16* out, u8* in, u64 size);
+u64 utf8_from_utf32(u8* out, u32* in, u64 count);
+u64 utf8_from_utf16(u8* out, u16* in, u64 count);
+// null terminated
+String push_str_utf16(Allocator arena, u16* in, u64 count);
+String push_str_utf32(Allocator arena, u32* in, u64 count);
+Slice<u16> push_utf16_from_str(Allocator arena, String str);
+Slice<u32> push_utf32_from_str(Allocator arena, String str);
+
 ////////////////////////////////////////////////////////////////////////
 // Wchar stuff
 
@@ -169,4 +498,6 @@ struct Lexer {
 Lexer lexer_init(String buffer);
 String lexer_next_token(Lexer* l);
 String lexer_next_integer(Lexer* l);
+// parses up to count whitespace separated floats, returns how many were read
+u32    lexer_next_f32_array(Lexer* l, f32* out, u32 count);
 
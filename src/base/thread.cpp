@@ -7,77 +7,129 @@ global ThreadPool thread_pool;
 void task_queue_init() {
   ThreadPool& g = thread_pool;
   TaskQueue& queue = g.queue;
-  queue.mutex = os_mutex_alloc();
-  queue.cond_not_empty = os_cond_var_alloc();
-  queue.cond_not_full = os_cond_var_alloc();
-  queue.finished = os_cond_var_alloc();
+  queue.tasks.init();
+  queue.remaining_tasks = 0;
 }
 
 void task_queue_push(Task t) {
   ThreadPool& g = thread_pool;
   TaskQueue& queue = g.queue;
-  os_mutex_take(queue.mutex);
-  while (queue.count == MAX_TASKS) {
-    os_cond_var_wait(queue.cond_not_full, queue.mutex);
-  }
-  queue.tasks[queue.tail] = t;
-  queue.tail = ModPow2(queue.tail + 1, MAX_TASKS);
-  ++queue.count;
-  ++queue.remaining_tasks;
-  os_cond_var_signal(queue.cond_not_empty);
-  os_mutex_drop(queue.mutex);
+  atomic_u32_inc(&queue.remaining_tasks);
+  queue.tasks.push(t);
 }
 
 Task task_queue_pop() {
   ThreadPool& g = thread_pool;
   TaskQueue& queue = g.queue;
-  os_mutex_take(queue.mutex);
-  while (queue.count == 0) {
-    // TimeBlock("sleep", ProfileType_Sleep);
-    os_cond_var_wait(queue.cond_not_empty, queue.mutex);
-  }
-  if (queue.count == MAX_TASKS) {
-    os_cond_var_signal(queue.cond_not_full);
+  // TimeBlock("sleep", ProfileType_Sleep);
+  return queue.tasks.pop();
+}
+
+intern void task_run(Task t) {
+  TaskQueue& queue = thread_pool.queue;
+  TimeBlock("doing job");
+  t.func(t.arg);
+  if (atomic_u32_dec(&queue.remaining_tasks) == 1) {
+    os_futex_wake_all(&queue.remaining_tasks);
   }
-  Task t = queue.tasks[queue.head];
-  queue.head = ModPow2(queue.head + 1, MAX_TASKS);
-  --queue.count;
-  os_mutex_drop(queue.mutex);
-  return t;
+}
+
+b32 task_queue_try_run() {
+  Task t;
+  if (!thread_pool.queue.tasks.try_pop(&t)) return false;
+  task_run(t);
+  return true;
 }
 
 void thread_worker(void* arg) {
-  TaskQueue& queue = thread_pool.queue;
   tctx_init();
+  // the slot comes from the pool, other threads may have taken thread ids before it
+  profiler_thread_init((u32)(u64)arg);
   while (true) {
-    Task t = task_queue_pop();
-    TimeBlock("doing job");
-    t.func(t.arg);
-    os_mutex_take(queue.mutex);
-    --queue.remaining_tasks;
-    if (queue.remaining_tasks == 0) {
-      os_cond_var_signal(queue.finished);
-    }
-    os_mutex_drop(queue.mutex);
+    task_run(task_queue_pop());
   }
 }
 
 void thread_pool_init(u32 num_threads) {
   TimeFunction;
   ThreadPool& g = thread_pool;
-  g.num_threads = num_threads;
+  g.num_threads = Clamp(1, num_threads, THREAD_MAX);
   task_queue_init();
-  Loop (i, num_threads) {
-    g.threads[i] = os_thread_launch(thread_worker, null);
+  Loop (i, g.num_threads) {
+    g.threads[i] = os_thread_launch(thread_worker, (void*)(u64)(i + 1));
   }
 }
 
+u32 thread_pool_count() {
+  return thread_pool.num_threads;
+}
+
 void thread_wait_for() {
   // TimeBlock("wait for workers", ProfileType_Sleep);
   TaskQueue& queue = thread_pool.queue;
-  os_mutex_take(queue.mutex);
-  if (queue.remaining_tasks > 0) {
-    os_cond_var_wait(queue.finished, queue.mutex);
+  for (;;) {
+    u32 remaining = atomic_u32_load(&queue.remaining_tasks);
+    if (remaining == 0) break;
+    os_futex_wait(&queue.remaining_tasks, remaining);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////
+// Spin lock
+
+void spin_lock(u32* lock) {
+  for (;;) {
+    if (!__atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE)) return;
+    while (__atomic_load_n(lock, __ATOMIC_RELAXED)) {
+#if ARCH_X64
+      _mm_pause();
+#endif
+    }
+  }
+}
+
+void spin_unlock(u32* lock) {
+  __atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+}
+
+////////////////////////////////////////////////////////////////////////
+// Epoch
+
+struct EpochState {
+  u64 global_epoch;
+  u32 slot_count;
+  alignas(64) u64 slots[EPOCH_MAX_THREADS]; // 0 - thread isn't reading
+};
+
+global EpochState epoch_st = { .global_epoch = 1 };
+global thread_local u32 epoch_slot;  // idx+1, 0 - not registered yet
+global thread_local u32 epoch_depth;
+
+void epoch_enter() {
+  if (epoch_depth++) return;
+  if (!epoch_slot) {
+    epoch_slot = atomic_u32_inc(&epoch_st.slot_count) + 1;
+    AssertAlways(epoch_slot <= EPOCH_MAX_THREADS);
+  }
+  u64 epoch = atomic_u64_load(&epoch_st.global_epoch);
+  atomic_u64_store(&epoch_st.slots[epoch_slot-1], epoch);
+}
+
+void epoch_exit() {
+  if (--epoch_depth) return;
+  __atomic_store_n(&epoch_st.slots[epoch_slot-1], 0, __ATOMIC_RELEASE);
+}
+
+// returns epoch the memory unlinked before this call belongs to
+u64 epoch_advance() {
+  return __atomic_fetch_add(&epoch_st.global_epoch, 1, __ATOMIC_SEQ_CST);
+}
+
+b32 epoch_is_safe(u64 retire_epoch) {
+  u32 count = atomic_u32_load(&epoch_st.slot_count);
+  Loop (i, Min(count, EPOCH_MAX_THREADS)) {
+    u64 epoch = atomic_u64_load(&epoch_st.slots[i]);
+    if (epoch && epoch <= retire_epoch) return false;
   }
-  os_mutex_drop(queue.mutex);
+  return true;
 }
@@ -1,5 +1,124 @@
 #pragma once
 #include "os/os_core.h"
+#include "containers.h"
+#include "maths.h"
+
+////////////////////////////////////////////////////////////////////////
+// MPMC queue
+
+// Bounded multi-producer multi-consumer queue (Vyukov). Each slot carries a sequence
+// number that tells whose turn it is: seq == pos - free for the producer at pos,
+// seq == pos+1 - filled for the consumer at pos. Producers and consumers only race
+// on their own index with a CAS, blocking variants sleep on a futex.
+const u32 MPMC_QUEUE_SPIN_COUNT = 64;
+
+template<typename T, u32 N>
+struct MPMCQueue {
+  static_assert(N && (N & (N-1)) == 0, "N must be power of 2");
+  struct Slot {
+    u32 seq;
+    T data;
+  };
+  alignas(64) u32 head;        // next push position
+  alignas(64) u32 tail;        // next pop position
+  alignas(64) u32 pushed;      // futex, bumped after every push
+  u32 pop_waiters;
+  alignas(64) u32 popped;      // futex, bumped after every pop
+  u32 push_waiters;
+  alignas(64) Slot slots[N];
+
+  void init() {
+    head = tail = 0;
+    pushed = popped = 0;
+    pop_waiters = push_waiters = 0;
+    Loop (i, N) {
+      slots[i].seq = i;
+    }
+  }
+  b32 try_push(T val) {
+    u32 pos = __atomic_load_n(&head, __ATOMIC_RELAXED);
+    for (;;) {
+      Slot& slot = slots[pos & (N-1)];
+      u32 seq = __atomic_load_n(&slot.seq, __ATOMIC_ACQUIRE);
+      i32 diff = (i32)(seq - pos);
+      if (diff == 0) {
+        if (__atomic_compare_exchange_n(&head, &pos, pos+1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+          slot.data = val;
+          __atomic_store_n(&slot.seq, pos+1, __ATOMIC_RELEASE);
+          signal(&pushed, &pop_waiters);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false; // full
+      } else {
+        pos = __atomic_load_n(&head, __ATOMIC_RELAXED);
+      }
+    }
+  }
+  b32 try_pop(T* out) {
+    u32 pos = __atomic_load_n(&tail, __ATOMIC_RELAXED);
+    for (;;) {
+      Slot& slot = slots[pos & (N-1)];
+      u32 seq = __atomic_load_n(&slot.seq, __ATOMIC_ACQUIRE);
+      i32 diff = (i32)(seq - (pos+1));
+      if (diff == 0) {
+        if (__atomic_compare_exchange_n(&tail, &pos, pos+1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+          *out = slot.data;
+          __atomic_store_n(&slot.seq, pos+N, __ATOMIC_RELEASE);
+          signal(&popped, &push_waiters);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false; // empty
+      } else {
+        pos = __atomic_load_n(&tail, __ATOMIC_RELAXED);
+      }
+    }
+  }
+  void push(T val) {
+    for (u32 spin = 0;; ++spin) {
+      u32 seen = atomic_u32_load(&popped);
+      if (try_push(val)) return;
+      wait(&popped, &push_waiters, seen, spin);
+    }
+  }
+  T pop() {
+    T result;
+    for (u32 spin = 0;; ++spin) {
+      u32 seen = atomic_u32_load(&pushed);
+      if (try_pop(&result)) return result;
+      wait(&pushed, &pop_waiters, seen, spin);
+    }
+  }
+  // approximate, other threads can change it right away
+  u32 count() {
+    u32 h = atomic_u32_load(&head);
+    u32 t = atomic_u32_load(&tail);
+    return (i32)(h - t) > 0 ? h - t : 0;
+  }
+  // waker bumps the counter before checking waiters, waiter registers before sleeping on
+  // the old counter value, so one of them always sees the other
+  void signal(u32* futex, u32* waiters) {
+    atomic_u32_inc(futex);
+    if (atomic_u32_load(waiters)) {
+      os_futex_wake(futex);
+    }
+  }
+  void wait(u32* futex, u32* waiters, u32 seen, u32 spin) {
+    if (spin < MPMC_QUEUE_SPIN_COUNT) {
+#if ARCH_X64
+      _mm_pause();
+#endif
+      return;
+    }
+    atomic_u32_inc(waiters);
+    os_futex_wait(futex, seen);
+    atomic_u32_dec(waiters);
+  }
+};
+
+////////////////////////////////////////////////////////////////////////
+// Thread pool
 
 #define MAX_TASKS 1024
 
@@ -9,19 +128,12 @@ struct Task {
 };
 
 struct TaskQueue {
-  Task tasks[MAX_TASKS];
-  u32 head;
-  u32 tail;
-  u32 count;
-  u32 remaining_tasks;
-  Mutex mutex;
-  CondVar cond_not_empty;
-  CondVar cond_not_full;
-  CondVar finished;
+  MPMCQueue<Task, MAX_TASKS> tasks;
+  alignas(64) u32 remaining_tasks; // futex, pushed but not finished yet
 };
 
 struct ThreadPool {
-  Thread threads[16];
+  Thread threads[THREAD_MAX];
   u32 num_threads;
   TaskQueue queue;
 };
@@ -29,6 +141,198 @@ struct ThreadPool {
 void task_queue_init();
 void task_queue_push(Task t);
 Task task_queue_pop();
+// runs one queued task on the calling thread, false if there was none
+b32  task_queue_try_run();
 void thread_worker(void* arg);
+// clamped to 1..THREAD_MAX
 void thread_pool_init(u32 num_threads);
+u32  thread_pool_count();
 void thread_wait_for();
+
+////////////////////////////////////////////////////////////////////////
+// Spin lock
+
+void spin_lock(u32* lock);
+void spin_unlock(u32* lock);
+
+////////////////////////////////////////////////////////////////////////
+// Epoch
+
+// Readers pin the global epoch while they hold pointers into shared memory.
+// Memory retired at epoch E can be released once no reader is pinned at or before E.
+const u32 EPOCH_MAX_THREADS = 64;
+
+void epoch_enter();
+void epoch_exit();
+u64  epoch_advance();
+b32  epoch_is_safe(u64 retire_epoch);
+
+////////////////////////////////////////////////////////////////////////
+// Concurrent map
+
+// Insert-only hashmap shared between threads. Keys are split over lock-striped shards,
+// each shard is an open addressing table like Map. Readers never lock, writers take
+// the shard lock; a grown table is published atomically and the old one is released
+// through the epoch once no reader can still see it.
+// Entries can't be removed or overwritten, so a published value never changes.
+const u32 CONCURRENT_MAP_SHARD_BITS = 4;
+const u32 CONCURRENT_MAP_MIN_CAPACITY = 64;
+
+template<typename Key, typename T>
+struct ConcurrentMapTable {
+  u32 cap;
+  u32 count;
+  u64 mem_size;
+  u64 retire_epoch;
+  ConcurrentMapTable* next_retired;
+  MapSlot* states;
+  Key* keys;
+  T* data;
+};
+
+template<typename Key, typename T>
+struct ConcurrentMap {
+  using Table = ConcurrentMapTable<Key, T>;
+  static constexpr f32 LF = 0.8;
+  static constexpr u32 shard_count = 1 << CONCURRENT_MAP_SHARD_BITS;
+  struct alignas(64) Shard {
+    Table* table;
+    Table* retired;
+    u32 lock;
+  };
+  Shard shards[shard_count];
+
+  void init() { *this = {}; }
+  void deinit() {
+    for (Shard& shard : shards) {
+      if (shard.table) table_release(shard.table);
+      for (Table* t = shard.retired; t;) {
+        Table* next = t->next_retired;
+        table_release(t);
+        t = next;
+      }
+    }
+    *this = {};
+  }
+  b32 get(Key key, T* out) {
+    u64 h = hash(key);
+    Shard& shard = shards[ModPow2(h, shard_count)];
+    b32 found = false;
+    epoch_enter();
+    Table* table = __atomic_load_n(&shard.table, __ATOMIC_SEQ_CST);
+    if (table) {
+      u64 idx = ModPow2(h >> CONCURRENT_MAP_SHARD_BITS, table->cap);
+      Loop (i, table->cap) {
+        MapSlot state = __atomic_load_n(&table->states[idx], __ATOMIC_ACQUIRE);
+        if (state == MapSlot_Empty) {
+          break;
+        }
+        if (equal(table->keys[idx], key)) {
+          *out = table->data[idx];
+          found = true;
+          break;
+        }
+        idx = ModPow2(idx + 1, table->cap);
+      }
+    }
+    epoch_exit();
+    return found;
+  }
+  // returns the value stored under the key, which is val only if this call inserted it
+  T get_or_add(Key key, T val, b32* out_was_added = null) {
+    u64 h = hash(key);
+    Shard& shard = shards[ModPow2(h, shard_count)];
+    spin_lock(&shard.lock);
+    T result = val;
+    b32 was_added = false;
+    u64 idx = table_find(shard.table, h, key);
+    if (shard.table && shard.table->states[idx] == MapSlot_Occupied) {
+      result = shard.table->data[idx];
+    } else {
+      if (!shard.table || shard.table->count + 1 > shard.table->cap*LF) {
+        grow(shard);
+        idx = table_find(shard.table, h, key);
+      }
+      Table* table = shard.table;
+      table->keys[idx] = key;
+      table->data[idx] = val;
+      __atomic_store_n(&table->states[idx], MapSlot_Occupied, __ATOMIC_RELEASE);
+      ++table->count;
+      was_added = true;
+    }
+    spin_unlock(&shard.lock);
+    if (out_was_added) *out_was_added = was_added;
+    return result;
+  }
+  b32 add(Key key, T val) {
+    b32 was_added;
+    get_or_add(key, val, &was_added);
+    return was_added;
+  }
+  u32 count() {
+    u32 result = 0;
+    for (Shard& shard : shards) {
+      Table* table = __atomic_load_n(&shard.table, __ATOMIC_SEQ_CST);
+      if (table) result += __atomic_load_n(&table->count, __ATOMIC_RELAXED);
+    }
+    return result;
+  }
+  // writer side, shard lock is held
+  u64 table_find(Table* table, u64 h, Key key) {
+    if (!table) return 0;
+    u64 idx = ModPow2(h >> CONCURRENT_MAP_SHARD_BITS, table->cap);
+    while (table->states[idx] == MapSlot_Occupied) {
+      if (equal(table->keys[idx], key)) break;
+      idx = ModPow2(idx + 1, table->cap);
+    }
+    return idx;
+  }
+  void grow(Shard& shard) {
+    Table* old = shard.table;
+    u32 cap = old ? old->cap*DEFAULT_RESIZE_FACTOR : CONCURRENT_MAP_MIN_CAPACITY;
+    u64 states_offset = AlignUp(sizeof(Table), alignof(MapSlot));
+    u64 keys_offset = AlignUp(states_offset + sizeof(MapSlot)*cap, alignof(Key));
+    u64 data_offset = AlignUp(keys_offset + sizeof(Key)*cap, alignof(T));
+    u64 mem_size = AlignUp(data_offset + sizeof(T)*cap, PAGE_SIZE);
+    u8* mem = os_reserve(mem_size);
+    os_commit(mem, mem_size);
+    Table* table = (Table*)mem;
+    *table = {
+      .cap = cap,
+      .mem_size = mem_size,
+      .states = (MapSlot*)Offset(mem, states_offset),
+      .keys = (Key*)Offset(mem, keys_offset),
+      .data = (T*)Offset(mem, data_offset),
+    };
+    if (old) {
+      Loop (i, old->cap) {
+        if (old->states[i] == MapSlot_Occupied) {
+          u64 idx = table_find(table, hash(old->keys[i]), old->keys[i]);
+          table->keys[idx] = old->keys[i];
+          table->data[idx] = old->data[i];
+          table->states[idx] = MapSlot_Occupied;
+        }
+      }
+      table->count = old->count;
+    }
+    __atomic_store_n(&shard.table, table, __ATOMIC_SEQ_CST);
+    if (old) {
+      old->retire_epoch = epoch_advance();
+      old->next_retired = shard.retired;
+      shard.retired = old;
+    }
+    Table** it = &shard.retired;
+    while (*it) {
+      Table* t = *it;
+      if (epoch_is_safe(t->retire_epoch)) {
+        *it = t->next_retired;
+        table_release(t);
+      } else {
+        it = &t->next_retired;
+      }
+    }
+  }
+  void table_release(Table* table) {
+    os_release(table, table->mem_size);
+  }
+};
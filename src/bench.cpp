@@ -0,0 +1,1329 @@
+#include "common.h"
+
+////////////////////////////////////////////////////////////////////////
+// Bench
+
+// Not part of the regular startup, build with the bench CMake option to run them.
+#if BENCH_BUILD
+
+///////////////////////////////////
+// Helpers
+
+const u32 BENCH_MAX_THREADS = 8;
+
+struct BenchWorkers {
+  void (*job)(u32 thread_idx, void* ctx);
+  void* ctx;
+  u32 thread_count;
+  u32 generation;
+  u32 done;
+  u32 launched;
+};
+
+struct BenchWorker {
+  BenchWorkers* workers;
+  u32 idx;
+};
+
+global BenchWorkers bench_workers;
+global BenchWorker bench_worker_args[BENCH_MAX_THREADS];
+
+intern void bench_worker(void* arg) {
+  BenchWorker* w = (BenchWorker*)arg;
+  BenchWorkers& g = *w->workers;
+  tctx_init();
+  u32 seen_generation = 0;
+  for (;;) {
+    u32 generation = atomic_u32_load(&g.generation);
+    if (generation == seen_generation) {
+      os_sleep_us(50);
+      continue;
+    }
+    seen_generation = generation;
+    if (w->idx < g.thread_count) {
+      g.job(w->idx, g.ctx);
+      atomic_u32_inc(&g.done);
+    }
+  }
+}
+
+// runs job on thread_count threads at once and returns wall time in seconds
+intern f64 bench_run_parallel(u32 thread_count, void (*job)(u32 thread_idx, void* ctx), void* ctx) {
+  BenchWorkers& g = bench_workers;
+  Assert(thread_count <= BENCH_MAX_THREADS);
+  if (!g.launched) {
+    g.launched = true;
+    Loop (i, BENCH_MAX_THREADS) {
+      bench_worker_args[i] = {&g, (u32)i};
+      os_thread_launch(bench_worker, &bench_worker_args[i]);
+    }
+  }
+  g.job = job;
+  g.ctx = ctx;
+  g.thread_count = thread_count;
+  atomic_u32_store(&g.done, 0);
+  u64 begin = os_now_ns();
+  atomic_u32_inc(&g.generation);
+  while (atomic_u32_load(&g.done) != thread_count) {
+    os_sleep_us(10);
+  }
+  return f64(os_now_ns() - begin) / 1e9;
+}
+
+///////////////////////////////////
+// Concurrent map
+
+const u32 BENCH_MAP_KEYS = 1 << 16;
+const u32 BENCH_MAP_OPS = 1 << 20;
+
+struct BenchMapCtx {
+  ConcurrentMap<u64, u64>* map;
+  u32 write_percent;
+};
+
+intern void bench_map_job(u32 thread_idx, void* ctx_) {
+  BenchMapCtx& ctx = *(BenchMapCtx*)ctx_;
+  u64 seed = thread_idx + 1;
+  u64 next_key = BENCH_MAP_KEYS + (u64)thread_idx * BENCH_MAP_OPS;
+  u64 sum = 0;
+  Loop (i, BENCH_MAP_OPS) {
+    seed = squirrel3(seed);
+    if (seed % 100 < ctx.write_percent) {
+      ctx.map->add(next_key, next_key);
+      ++next_key;
+    } else {
+      u64 val;
+      if (ctx.map->get(seed % BENCH_MAP_KEYS, &val)) sum += val;
+    }
+  }
+  UnusedVariable(sum);
+}
+
+intern void bench_concurrent_map() {
+  u32 write_percents[] = {5, 50};
+  String names[] = {"read heavy", "write heavy"};
+  for EachElement (mode, write_percents) {
+    for (u32 thread_count = 1; thread_count <= BENCH_MAX_THREADS; thread_count *= 2) {
+      ConcurrentMap<u64, u64> map;
+      map.init();
+      Loop (i, BENCH_MAP_KEYS) {
+        map.add(i, i);
+      }
+      BenchMapCtx ctx = {&map, write_percents[mode]};
+      f64 seconds = bench_run_parallel(thread_count, bench_map_job, &ctx);
+      f64 mops = f64(thread_count) * BENCH_MAP_OPS / seconds / 1e6;
+      Info("concurrent map %s, %u threads: %.2f Mops/s", names[mode], thread_count, mops);
+      map.deinit();
+    }
+  }
+}
+
+///////////////////////////////////
+// MPMC queue
+
+const u32 BENCH_QUEUE_OPS = 1 << 20;
+const u32 BENCH_QUEUE_CAP = 1024;
+
+// same ring the thread pool used before MPMCQueue, kept as a baseline
+struct BenchMutexQueue {
+  u64 data[BENCH_QUEUE_CAP];
+  u32 head;
+  u32 tail;
+  u32 count;
+  Mutex mutex;
+  CondVar not_empty;
+  CondVar not_full;
+  void push(u64 val) {
+    os_mutex_take(mutex);
+    while (count == BENCH_QUEUE_CAP) os_cond_var_wait(not_full, mutex);
+    data[tail] = val;
+    tail = ModPow2(tail + 1, BENCH_QUEUE_CAP);
+    ++count;
+    os_cond_var_signal(not_empty);
+    os_mutex_drop(mutex);
+  }
+  u64 pop() {
+    os_mutex_take(mutex);
+    while (count == 0) os_cond_var_wait(not_empty, mutex);
+    u64 val = data[head];
+    head = ModPow2(head + 1, BENCH_QUEUE_CAP);
+    --count;
+    os_cond_var_signal(not_full);
+    os_mutex_drop(mutex);
+    return val;
+  }
+};
+
+template<typename Queue>
+struct BenchQueueCtx {
+  Queue* queue;
+  u32 producers;
+  u32 consumers;
+  u64 sum;
+};
+
+// first producers threads push, the rest pop an equal share
+template<typename Queue>
+intern void bench_queue_job(u32 thread_idx, void* ctx_) {
+  BenchQueueCtx<Queue>& ctx = *(BenchQueueCtx<Queue>*)ctx_;
+  if (thread_idx < ctx.producers) {
+    Loop (i, BENCH_QUEUE_OPS) {
+      ctx.queue->push(i + 1);
+    }
+  } else {
+    u32 pop_count = BENCH_QUEUE_OPS * ctx.producers / ctx.consumers;
+    u64 sum = 0;
+    Loop (i, pop_count) {
+      sum += ctx.queue->pop();
+    }
+    __atomic_fetch_add(&ctx.sum, sum, __ATOMIC_RELAXED);
+  }
+}
+
+template<typename Queue>
+intern f64 bench_queue_run(Queue* queue, u32 producers, u32 consumers) {
+  BenchQueueCtx<Queue> ctx = {queue, producers, consumers};
+  f64 seconds = bench_run_parallel(producers + consumers, bench_queue_job<Queue>, &ctx);
+  u64 expected = u64(BENCH_QUEUE_OPS) * (BENCH_QUEUE_OPS + 1) / 2 * producers;
+  Assert(ctx.sum == expected);
+  return f64(producers) * BENCH_QUEUE_OPS / seconds / 1e6;
+}
+
+intern void bench_mpmc_queue() {
+  Scratch scratch;
+  using Queue = MPMCQueue<u64, BENCH_QUEUE_CAP>;
+  Queue* mpmc = push_struct(scratch, Queue);
+  BenchMutexQueue* locked = push_struct_zero(scratch, BenchMutexQueue);
+  locked->mutex = os_mutex_alloc();
+  locked->not_empty = os_cond_var_alloc();
+  locked->not_full = os_cond_var_alloc();
+  v2u configs[] = {{1,1}, {1,4}, {4,1}, {2,2}, {4,4}};
+  for (v2u c : configs) {
+    mpmc->init();
+    f64 mpmc_mops = bench_queue_run(mpmc, c.x, c.y);
+    f64 locked_mops = bench_queue_run(locked, c.x, c.y);
+    Info("mpmc queue %u producers, %u consumers: %.2f Mops/s, mutex queue: %.2f Mops/s", c.x, c.y, mpmc_mops, locked_mops);
+  }
+  os_cond_var_release(locked->not_full);
+  os_cond_var_release(locked->not_empty);
+  os_mutex_release(locked->mutex);
+}
+
+///////////////////////////////////
+// Number formatting
+
+const u32 BENCH_FMT_VALUES = 1 << 20;
+const u32 BENCH_FMT_ROUNDS = 10;
+
+// formatting str.cpp used before the Ryu based one, kept as a baseline
+intern u32 bench_old_u64_write(u8* dest, u64 value) {
+  u8 tmp[20];
+  u32 length = 0;
+  do {
+    tmp[length++] = '0' + (value % 10);
+    value /= 10;
+  } while (value);
+  Loop (i, length) {
+    dest[i] = tmp[length - 1 - i];
+  }
+  return length;
+}
+
+intern u32 bench_old_f64_write(u8* dest, f64 value, u32 precision) {
+  u32 len = 0;
+  if (value < 0.0f) {
+    dest[len++] = '-';
+    value = -value;
+  }
+  u64 integer_part = value;
+  value -= integer_part;
+  len += bench_old_u64_write(dest + len, integer_part);
+  if (precision > 0) {
+    dest[len++] = '.';
+    u64 multiplier = 1;
+    for (u32 i = 0; i < precision; ++i) multiplier *= 10;
+    u64 frac_part = (u64)(value * multiplier + 0.5);
+    u8 frac[20];
+    u32 frac_len = bench_old_u64_write(frac, frac_part);
+    for (u32 i = frac_len; i < precision; ++i) {
+      dest[len++] = '0';
+    }
+    MemCopy(dest + len, frac, frac_len);
+    len += frac_len;
+  }
+  return len;
+}
+
+// values the engine logs: small coordinates, times, large counters, tiny deltas
+intern f64 bench_fmt_value(u64 seed) {
+  f64 unit = f64(seed >> 11) / f64(1ull << 53);
+  switch (seed % 4) {
+    case 0: return unit * 200 - 100;
+    case 1: return unit;
+    case 2: return unit * 1e9;
+    default: return unit * 1e-3;
+  }
+}
+
+intern void bench_number_format() {
+  Scratch scratch;
+  f64* values = push_array(scratch, f64, BENCH_FMT_VALUES);
+  u64* ints = push_array(scratch, u64, BENCH_FMT_VALUES);
+  u64 seed = 1;
+  Loop (i, BENCH_FMT_VALUES) {
+    seed = squirrel3(seed);
+    values[i] = bench_fmt_value(seed);
+    ints[i] = seed >> (seed % 64);
+  }
+  u8 buf[FLOAT_FIXED_MAX_CHARS];
+  u64 total = 0;
+  #define BenchFmt(name, expr) { \
+    u64 begin = os_now_ns(); \
+    Loop (round, BENCH_FMT_ROUNDS) { \
+      Loop (i, BENCH_FMT_VALUES) { \
+        total += expr; \
+      } \
+    } \
+    f64 ns = f64(os_now_ns() - begin) / (f64(BENCH_FMT_ROUNDS) * BENCH_FMT_VALUES); \
+    Info("format %s: %.2f ns/value", String(name), ns); \
+  }
+  BenchFmt("f64 %f old",         bench_old_f64_write(buf, values[i], 6));
+  BenchFmt("f64 %f",             f64_write(buf, values[i], 6));
+  BenchFmt("f64 %g",             f64_write_shortest(buf, values[i]));
+  BenchFmt("f32 %g32",           f32_write_shortest(buf, (f32)values[i]));
+  BenchFmt("f64 snprintf %.17g", (u32)snprintf((char*)buf, sizeof(buf), "%.17g", values[i]));
+  BenchFmt("u64 old",            bench_old_u64_write(buf, ints[i]));
+  BenchFmt("u64",                u64_write(buf, ints[i]));
+  #undef BenchFmt
+  UnusedVariable(total);
+}
+
+///////////////////////////////////
+// Format strings
+
+const u32 BENCH_FORMAT_CALLS = 1 << 18;
+
+intern void bench_format_string() {
+  Scratch scratch;
+  String name = "mesh_load_obj";
+  // a String variable can't become FmtStr, so it takes the runtime my_sprintf path
+  String runtime_fmt = "%s: %u vertices, %u64 bytes, %.3f ms";
+  u64 total = 0;
+
+  u64 begin = os_now_ns();
+  Loop (i, BENCH_FORMAT_CALLS) {
+    Temp temp = temp_begin(scratch.temp.arena);
+    total += push_strf(scratch, runtime_fmt, name, i, u64(i) * 32, f64(i) * 0.001).size;
+    temp_end(temp);
+  }
+  f64 ns = f64(os_now_ns() - begin) / BENCH_FORMAT_CALLS;
+  Info("push_strf runtime format: %.2f ns/call", ns);
+
+  begin = os_now_ns();
+  Loop (i, BENCH_FORMAT_CALLS) {
+    Temp temp = temp_begin(scratch.temp.arena);
+    total += push_strf(scratch, "%s: %u vertices, %u64 bytes, %.3f ms", name, i, u64(i) * 32, f64(i) * 0.001).size;
+    temp_end(temp);
+  }
+  ns = f64(os_now_ns() - begin) / BENCH_FORMAT_CALLS;
+  Info("push_strf compile-time format: %.2f ns/call", ns);
+  UnusedVariable(total);
+}
+
+///////////////////////////////////
+// Logging
+
+// fits in one thread's ring, so the calls measure the copy and not waiting for the logger
+const u32 BENCH_LOG_CALLS = 1 << 12;
+
+intern void bench_logger() {
+  Scratch scratch;
+  String name = "mesh_load_obj";
+  FmtStr<String, u32, f64> fmt = "%s: %u vertices, %.3f ms";
+
+  // synchronous path, format and write on the caller, /dev/null stands in for the terminal
+  OS_Handle null_file = os_file_open("/dev/null", OS_AccessFlag_Write);
+  u64 begin = os_now_ns();
+  Loop (i, BENCH_LOG_CALLS) {
+    Temp temp = temp_begin(scratch.temp.arena);
+    String line = log_format(scratch, log_level_prefix(LogLevel_Info), true, fmt, name, (u32)i, f64(i) * 0.001);
+    os_file_write(null_file, line.size, line.str);
+    temp_end(temp);
+  }
+  f64 sync_ns = f64(os_now_ns() - begin) / BENCH_LOG_CALLS;
+  os_file_close(null_file);
+
+  // the logger thread still formats everything, console off keeps the output readable
+  log_init({});
+  log_flush();
+  log_set_console(false);
+  begin = os_now_ns();
+  Loop (i, BENCH_LOG_CALLS) {
+    Info("%s: %u vertices, %.3f ms", name, (u32)i, f64(i) * 0.001);
+  }
+  f64 async_ns = f64(os_now_ns() - begin) / BENCH_LOG_CALLS;
+  begin = os_now_ns();
+  log_flush();
+  f64 flush_us = f64(os_now_ns() - begin) / 1000;
+
+  begin = os_now_ns();
+  Loop (i, BENCH_LOG_CALLS) {
+    LogEvent(Assets, Info, "mesh loaded", log_kv("name", name), log_kv("verts", (u32)i), log_kv("ms", f64(i) * 0.001));
+  }
+  f64 event_ns = f64(os_now_ns() - begin) / BENCH_LOG_CALLS;
+  log_flush();
+  log_set_console(true);
+
+  // a category below its level, the arguments are never touched
+  u8 vk_level = log_levels[LogCategory_Vk];
+  log_set_level(LogCategory_Vk, LogLevel_Info);
+  u32 evaluated = 0;
+  begin = os_now_ns();
+  Loop (i, BENCH_LOG_CALLS) {
+    Log(Vk, Trace, "%s: %u vertices, %.3f ms", name, ++evaluated, f64(i) * 0.001);
+  }
+  f64 disabled_ns = f64(os_now_ns() - begin) / BENCH_LOG_CALLS;
+  log_set_level(LogCategory_Vk, (LogLevel)vk_level);
+
+  Info("log sync format+write: %.2f ns/call", sync_ns);
+  Info("log async record: %.2f ns/call", async_ns);
+  Info("log flush of %u records: %.2f us", BENCH_LOG_CALLS, flush_us);
+  Info("log async event with 3 fields: %.2f ns/call", event_ns);
+  Info("log disabled category: %.2f ns/call, %u evaluated", disabled_ns, evaluated);
+}
+
+///////////////////////////////////
+// Float parsing
+
+const u32 BENCH_PARSE_FLOATS = 1 << 19;
+
+// f64_from_str before Eisel-Lemire, kept as a baseline
+intern f64 bench_old_f64_from_str(String str) {
+  f64 x = 0.0;
+  f64 frac = 0.0;
+  f64 factor = 0.1;
+  b32 negative = false;
+  i32 j = 0;
+  if (str.size > 0 && str.str[j] == '-') {
+    negative = true;
+    j++;
+  }
+  for (; j < str.size; ++j) {
+    u8 ch = str.str[j];
+    if (ch == '.') {
+      ++j;
+      break;
+    }
+    x = x * 10 + (ch - '0');
+  }
+  for (; j < str.size; ++j) {
+    u8 ch = str.str[j];
+    frac += (ch - '0') * factor;
+    factor *= 0.1;
+  }
+  x += frac;
+  return negative ? -x : x;
+}
+
+intern void bench_float_parse() {
+  Scratch scratch;
+  // obj-like text: "v -1.234567 0.500000 12.000000\n"
+  u8* text_mem = push_array(scratch, u8, BENCH_PARSE_FLOATS * 16);
+  String text = {text_mem, 0};
+  u64 seed = 1;
+  Loop (i, BENCH_PARSE_FLOATS / 3) {
+    text.str[text.size++] = 'v';
+    Loop (j, 3) {
+      seed = squirrel3(seed);
+      text.str[text.size++] = ' ';
+      text.size += f64_write(text.str + text.size, f64(i64(seed % 2000000) - 1000000) / 1000.0, 6);
+    }
+    text.str[text.size++] = '\n';
+  }
+  f32* out = push_array(scratch, f32, BENCH_PARSE_FLOATS);
+  f64 mb = f64(text.size) / MB(1);
+
+  u64 begin = os_now_ns();
+  u32 count = 0;
+  {
+    Lexer lexer = lexer_init(text);
+    while (lexer_next_token(&lexer).size) {
+      count += lexer_next_f32_array(&lexer, out + count, 3);
+    }
+  }
+  f64 seconds = f64(os_now_ns() - begin) / 1e9;
+  Info("parse floats lexer_next_f32_array: %.2f MB/s", mb / seconds);
+
+  begin = os_now_ns();
+  count = 0;
+  {
+    Lexer lexer = lexer_init(text);
+    while (lexer_next_token(&lexer).size) {
+      Loop (i, 3) {
+        out[count++] = bench_old_f64_from_str(lexer_next_token(&lexer));
+      }
+    }
+  }
+  seconds = f64(os_now_ns() - begin) / 1e9;
+  Info("parse floats old f64_from_str: %.2f MB/s", mb / seconds);
+
+  begin = os_now_ns();
+  count = 0;
+  {
+    char* p = (char*)text.str;
+    char* end = p + text.size;
+    while (p < end) {
+      p += 2; // "v "
+      Loop (i, 3) {
+        out[count++] = strtof(p, &p);
+      }
+      ++p; // '\n'
+    }
+  }
+  seconds = f64(os_now_ns() - begin) / 1e9;
+  Info("parse floats strtof: %.2f MB/s", mb / seconds);
+}
+
+///////////////////////////////////
+// Tokenizing
+
+const u64 BENCH_TOKENIZE_SIZE = MB(100);
+
+// lexer_next_token before byte scanning, kept as a baseline
+intern String bench_old_lexer_next_token(Lexer* l) {
+  while (l->cur < l->end && char_is_space(*l->cur)) {
+    l->cur++;
+  }
+  if (l->cur == l->end) return {};
+  u8* current = l->cur;
+  while (l->cur < l->end && !char_is_space(*l->cur)) {
+    l->cur++;
+  }
+  String result = {current, (u64)l->cur - (u64)current};
+  return result;
+}
+
+intern void bench_tokenize() {
+  // bigger than scratch reserve, so it gets its own pages
+  u64 cap = BENCH_TOKENIZE_SIZE + KB(4);
+  u8* text_mem = os_reserve(cap);
+  os_commit(text_mem, cap);
+  String text = {text_mem, 0};
+  // obj-like text, indentation and comments give the skipper some long runs
+  u64 seed = 1;
+  for (u32 i = 0; text.size < BENCH_TOKENIZE_SIZE; ++i) {
+    seed = squirrel3(seed);
+    u32 kind = seed % 8;
+    if (kind < 3) {
+      text.str[text.size++] = 'v';
+      Loop (j, 3) {
+        seed = squirrel3(seed);
+        text.str[text.size++] = ' ';
+        text.size += f64_write(text.str + text.size, f64(i64(seed % 2000000) - 1000000) / 1000.0, 6);
+      }
+    } else if (kind < 7) {
+      text.str[text.size++] = 'f';
+      Loop (j, 3) {
+        seed = squirrel3(seed);
+        text.str[text.size++] = ' ';
+        text.size += u64_write(text.str + text.size, seed % 100000);
+        text.str[text.size++] = '/';
+        text.size += u64_write(text.str + text.size, (seed >> 20) % 100000);
+      }
+    } else {
+      String comment = "\t\t\t\t            # exported by some tool, long line of words to skip";
+      MemCopy(text.str + text.size, comment.str, comment.size);
+      text.size += comment.size;
+    }
+    text.str[text.size++] = '\n';
+  }
+  f64 mb = f64(text.size) / MB(1);
+
+  u64 begin = os_now_ns();
+  u64 tokens = 0;
+  {
+    Lexer lexer = lexer_init(text);
+    while (lexer_next_token(&lexer).size) ++tokens;
+  }
+  f64 seconds = f64(os_now_ns() - begin) / 1e9;
+  Info("tokenize lexer_next_token: %.2f MB/s, %u64 tokens", mb / seconds, tokens);
+
+  begin = os_now_ns();
+  tokens = 0;
+  {
+    Lexer lexer = lexer_init(text);
+    while (bench_old_lexer_next_token(&lexer).size) ++tokens;
+  }
+  seconds = f64(os_now_ns() - begin) / 1e9;
+  Info("tokenize old byte loop: %.2f MB/s, %u64 tokens", mb / seconds, tokens);
+
+  begin = os_now_ns();
+  u64 lines = 0;
+  for (u64 i = 0; i < text.size; ++lines) {
+    i += bytes_find(text.str + i, text.size - i, '\n') + 1;
+  }
+  seconds = f64(os_now_ns() - begin) / 1e9;
+  Info("count lines bytes_find: %.2f MB/s, %u64 lines", mb / seconds, lines);
+
+  begin = os_now_ns();
+  lines = 0;
+  for (u64 i = 0; i < text.size; ++lines) {
+    u8* found = (u8*)memchr(text.str + i, '\n', text.size - i);
+    i = found ? found - text.str + 1 : text.size;
+  }
+  seconds = f64(os_now_ns() - begin) / 1e9;
+  Info("count lines memchr: %.2f MB/s, %u64 lines", mb / seconds, lines);
+
+  os_release(text_mem, cap);
+}
+
+///////////////////////////////////
+// String building
+
+const u32 BENCH_BUILD_LINES = 200000;
+
+intern void bench_str_builder() {
+  Scratch scratch;
+  String name = "profile_anchor";
+
+  u64 begin = os_now_ns();
+  DString dstr;
+  dstr.init(scratch);
+  Loop (i, BENCH_BUILD_LINES) {
+    dstr.add(push_strf(scratch, "%s %u: %.3f ms\n", name, i, f64(i) * 0.001));
+  }
+  f64 seconds = f64(os_now_ns() - begin) / 1e9;
+  Info("build DString + push_strf: %.2f MB/s", f64(dstr.size) / MB(1) / seconds);
+
+  begin = os_now_ns();
+  StrBuilder sb;
+  sb.init(scratch);
+  Loop (i, BENCH_BUILD_LINES) {
+    sb.addf("%s %u: %.3f ms\n", name, i, f64(i) * 0.001);
+  }
+  seconds = f64(os_now_ns() - begin) / 1e9;
+  Info("build StrBuilder addf: %.2f MB/s, %u blocks", f64(sb.total_size) / MB(1) / seconds, sb.chunk_count);
+
+  begin = os_now_ns();
+  String gathered = sb.finalize(scratch);
+  seconds = f64(os_now_ns() - begin) / 1e9;
+  Info("StrBuilder finalize: %.2f MB/s", f64(gathered.size) / MB(1) / seconds);
+
+  OS_Handle null_file = os_file_open("/dev/null", OS_AccessFlag_Write);
+  begin = os_now_ns();
+  os_file_write_builder(null_file, &sb);
+  seconds = f64(os_now_ns() - begin) / 1e9;
+  Info("StrBuilder writev to /dev/null: %.2f MB/s", f64(sb.total_size) / MB(1) / seconds);
+  os_file_close(null_file);
+}
+
+///////////////////////////////////
+// UTF-8
+
+const u64 BENCH_UTF8_SIZE = MB(8);
+
+// byte at a time validation, kept as a baseline
+intern b32 bench_scalar_utf8_validate(u8* p, u64 size) {
+  u8* end = p + size;
+  while (p < end) {
+    u8 c = *p;
+    u32 length = c < 0x80 ? 1 : (c & 0xE0) == 0xC0 ? 2 : (c & 0xF0) == 0xE0 ? 3 : (c & 0xF8) == 0xF0 ? 4 : 0;
+    if (!length || (u64)(end - p) < length) return false;
+    u32 cp = length == 1 ? c : c & (0x7F >> length);
+    for (u32 i = 1; i < length; ++i) {
+      if ((p[i] & 0xC0) != 0x80) return false;
+      cp = (cp << 6) | (p[i] & 0x3F);
+    }
+    u32 min = length == 2 ? 0x80 : length == 3 ? 0x800 : length == 4 ? 0x10000 : 0;
+    if (cp < min || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) return false;
+    p += length;
+  }
+  return true;
+}
+
+intern void bench_utf8_run(String name, String text, u16* wide) {
+  f64 mb = f64(text.size) / MB(1);
+  u64 begin = os_now_ns();
+  b32 valid = utf8_validate(text.str, text.size);
+  f64 seconds = f64(os_now_ns() - begin) / 1e9;
+  Info("%s utf8_validate: %.2f MB/s", name, mb / seconds);
+  Assert(valid);
+
+  begin = os_now_ns();
+  valid = bench_scalar_utf8_validate(text.str, text.size);
+  seconds = f64(os_now_ns() - begin) / 1e9;
+  Info("%s scalar validate: %.2f MB/s", name, mb / seconds);
+  Assert(valid);
+
+  begin = os_now_ns();
+  u64 count = utf16_from_utf8(wide, text.str, text.size);
+  seconds = f64(os_now_ns() - begin) / 1e9;
+  Info("%s utf16_from_utf8: %.2f MB/s", name, mb / seconds);
+
+  begin = os_now_ns();
+  u64 size = utf8_from_utf16(text.str, wide, count);
+  seconds = f64(os_now_ns() - begin) / 1e9;
+  Info("%s utf8_from_utf16: %.2f MB/s", name, mb / seconds);
+  Assert(size == text.size);
+}
+
+intern void bench_utf8() {
+  Scratch scratch;
+  u16* wide = push_array(scratch, u16, BENCH_UTF8_SIZE);
+  String text = {push_buffer(scratch, BENCH_UTF8_SIZE), 0};
+  u64 seed = 1;
+  while (text.size < BENCH_UTF8_SIZE) {
+    seed = squirrel3(seed);
+    text.str[text.size++] = 'a' + seed % 26;
+  }
+  bench_utf8_run("ascii", text, wide);
+
+  // latin, cyrillic, cjk and emoji words
+  String words[] = {"hello ", "fa\xc3\xa7" "ade ", "\xd0\xbf\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82 ",
+                    "\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e ", "\xf0\x9f\x98\x80 "};
+  text.size = 0;
+  while (text.size + 16 < BENCH_UTF8_SIZE) {
+    seed = squirrel3(seed);
+    String word = words[seed % ArrayCount(words)];
+    MemCopy(text.str + text.size, word.str, word.size);
+    text.size += word.size;
+  }
+  bench_utf8_run("mixed", text, wide);
+}
+
+///////////////////////////////////
+// JSON
+
+const u32 BENCH_JSON_NODES = 1 << 14;
+
+// json.cpp before the tape parser, a port of sj.h, kept as a baseline
+struct BenchSjReader {
+  u8* cur;
+  u8* end;
+  i32 depth;
+  String error;
+  JsonValue base_obj;
+};
+
+intern JsonValue bench_sj_read(BenchSjReader* r) {
+  JsonValue res = {};
+  top:
+  if (r->error.str) { return { .type = JsonType_Error, .str = str_range(r->cur, r->end)}; }
+  u8* start = r->cur;
+  switch (*r->cur) {
+    case ' ': case '\n': case '\r': case '\t':
+    case ':': case ',': {
+      ++r->cur;
+      goto top;
+    }
+    case '-': case '0': case '1': case '2': case '3': case '4':
+    case '5': case '6': case '7': case '8': case '9': {
+      res.type = JsonType_Number;
+      while (r->cur != r->end && char_is_number_cont(*r->cur)) { ++r->cur; }
+    } break;
+    case '"': {
+      res.type = JsonType_String;
+      start = ++r->cur;
+      while (true) {
+        if (r->cur == r->end) { r->error = "unclosed string"; goto top; }
+        if (*r->cur == '"')   { break; }
+        if (*r->cur == '\\')  { r->cur++; }
+        if (r->cur != r->end) { r->cur++; }
+      }
+      res.str = str_range(start, r->cur++);
+      return res;
+    }
+    case '{': case '[': {
+      res.type = (*r->cur == '{') ? JsonType_Object : JsonType_Array;
+      // the tape index field holds the depth here
+      res.idx = ++r->depth;
+      r->cur++;
+    } break;
+    case '}': case ']': {
+      res.type = JsonType_End;
+      if (--r->depth < 0) {
+        r->error = (*r->cur == '}') ? "stray '}'" : "stray ']'";
+        goto top;
+      }
+      r->cur++;
+    } break;
+    case 'n': case 't': case 'f': {
+      res.type = (*r->cur == 'n') ? JsonType_Null : JsonType_Bool;
+      if (str_match(String(r->cur, 4),  "null")) { r->cur += 4; break; }
+      if (str_match(String(r->cur, 4),  "true")) { r->cur += 4; break; }
+      if (str_match(String(r->cur, 5), "false")) { r->cur += 5; break; }
+    } // fallthrough
+    default: {
+      r->error = "unknown token";
+      goto top;
+    }
+  }
+  res.str = str_range(start, r->cur);
+  return res;
+}
+
+intern void bench_sj_discard_until(BenchSjReader* r, i32 depth) {
+  JsonValue val;
+  val.type = JsonType_Null;
+  while (r->depth != depth && val.type != JsonType_Error) {
+    val = bench_sj_read(r);
+  }
+}
+
+intern b32 bench_sj_iter_object(BenchSjReader* r, JsonValue obj, JsonValue *key, JsonValue *val) {
+  bench_sj_discard_until(r, obj.idx);
+  *key = bench_sj_read(r);
+  if (key->type == JsonType_Error || key->type == JsonType_End) { return false; }
+  *val = bench_sj_read(r);
+  if (val->type == JsonType_End)   { r->error = "unexpected object end"; return false; }
+  if (val->type == JsonType_Error) { return false; }
+  return true;
+}
+
+intern b32 bench_sj_iter_array(BenchSjReader* r, JsonValue arr, JsonValue* val) {
+  bench_sj_discard_until(r, arr.idx);
+  *val = bench_sj_read(r);
+  if (val->type == JsonType_Error || val->type == JsonType_End) { return false; }
+  return true;
+}
+
+// glTF shaped: nodes with transforms, accessors with bounds, buffer views
+intern String bench_json_gltf(Allocator arena) {
+  StrBuilder sb;
+  sb.init(arena);
+  sb.add("{\"asset\": {\"generator\": \"bench\", \"version\": \"2.0\"},\n\"nodes\": [\n");
+  u64 seed = 1;
+  auto rand_f = [&]() { seed = squirrel3(seed); return f64(seed % 2000000) / 1000000.0 - 1.0; };
+  Loop (i, BENCH_JSON_NODES) {
+    sb.addf("  {\"name\": \"node_%u\", \"mesh\": %u, \"rotation\": [%f, %f, %f, %f], \"scale\": [1, 1, 1], \"translation\": [%f, %f, %f]}%s\n",
+            i, i, rand_f(), rand_f(), rand_f(), rand_f(), rand_f() * 100, rand_f() * 100, rand_f() * 100, String(i + 1 < BENCH_JSON_NODES ? "," : ""));
+  }
+  sb.add("],\n\"accessors\": [\n");
+  Loop (i, BENCH_JSON_NODES) {
+    sb.addf("  {\"bufferView\": %u, \"componentType\": 5126, \"count\": %u, \"type\": \"VEC3\", \"max\": [%f, %f, %f], \"min\": [%f, %f, %f]}%s\n",
+            i, i % 1000 + 24, rand_f(), rand_f(), rand_f(), rand_f(), rand_f(), rand_f(), String(i + 1 < BENCH_JSON_NODES ? "," : ""));
+  }
+  sb.add("],\n\"bufferViews\": [\n");
+  Loop (i, BENCH_JSON_NODES) {
+    sb.addf("  {\"buffer\": 0, \"byteLength\": %u, \"byteOffset\": %u}%s\n", i % 1000 * 12, i * 12000, String(i + 1 < BENCH_JSON_NODES ? "," : ""));
+  }
+  sb.add("],\n\"buffers\": [{\"byteLength\": 1, \"uri\": \"bench.bin\"}]\n}\n");
+  return sb.finalize(arena);
+}
+
+intern void bench_json() {
+  Scratch scratch;
+  String text = bench_json_gltf(scratch);
+  f64 mb = f64(text.size) / MB(1);
+
+  // what mesh_load_gltf does: a few fields of accessors and bufferViews, nodes skipped
+  u64 begin = os_now_ns();
+  u64 sj_sum = 0;
+  {
+    BenchSjReader r = {.cur = text.str, .end = text.str + text.size};
+    r.base_obj = bench_sj_read(&r);
+    for (JsonValue k, v; bench_sj_iter_object(&r, r.base_obj, &k, &v);) {
+      if (k.match("accessors") || k.match("bufferViews")) {
+        for (JsonValue obj; bench_sj_iter_array(&r, v, &obj);) {
+          for (JsonValue key, val; bench_sj_iter_object(&r, obj, &key, &val);) {
+            if (key.match("count") || key.match("byteLength")) sj_sum += u32_from_str(val.str);
+          }
+        }
+      }
+    }
+  }
+  f64 sj_seconds = f64(os_now_ns() - begin) / 1e9;
+
+  u64 tape_sum = 0;
+  begin = os_now_ns();
+  JsonReader r = json_reader_init(text);
+  f64 parse_seconds = f64(os_now_ns() - begin) / 1e9;
+  JSON_OBJ(r, r.base_obj) {
+    if (k.match("accessors") || k.match("bufferViews")) {
+      JSON_ARR(r, v) JSON_OBJ_(r, obj) {
+        if (key.match("count") || key.match("byteLength")) tape_sum += (u64)val.number;
+      }
+    }
+  }
+  f64 tape_seconds = f64(os_now_ns() - begin) / 1e9;
+  json_reader_deinit(&r);
+  Assert(sj_sum == tape_sum);
+
+  // the way json_reader_init walks it, a chunk of indices at a time
+  u32* indices = push_array(scratch, u32, JSON_CHUNK_SIZE);
+  JsonScan scan = {};
+  u32 index_count = 0;
+  begin = os_now_ns();
+  for (u64 chunk = 0; chunk < text.size; chunk += JSON_CHUNK_SIZE) {
+    index_count += json_find_structurals(&scan, text.str, text.size, chunk, Min(chunk + JSON_CHUNK_SIZE, text.size), indices);
+  }
+  f64 stage1_seconds = f64(os_now_ns() - begin) / 1e9;
+
+  Info("json %.2f MB, %u structurals", mb, index_count);
+  Info("json sj reader, gltf fields: %.2f MB/s", mb / sj_seconds);
+  Info("json tape stage 1: %.2f MB/s", mb / stage1_seconds);
+  Info("json tape parse: %.2f MB/s, with gltf fields: %.2f MB/s", mb / parse_seconds, mb / tape_seconds);
+}
+
+///////////////////////////////////
+// IO
+
+const u32 BENCH_IO_SMALL_FILES = 1000;
+const u64 BENCH_IO_SMALL_SIZE = KB(4);
+const u64 BENCH_IO_BIG_SIZE = GB(1);
+const u64 BENCH_IO_CHUNK = MB(1);
+const u32 BENCH_IO_DEPTH = 64;
+
+// keeps the queue full until every read is back
+intern void bench_io_drain(OS_IoQueue queue, OS_IoRead* reads, u32 count) {
+  OS_IoCompletion done[BENCH_IO_DEPTH];
+  u32 next = 0;
+  while (next < count || os_io_in_flight(queue)) {
+    next += os_io_submit(queue, reads + next, count - next);
+    u32 got = os_io_complete(queue, done, ArrayCount(done), 1);
+    Loop (i, got) {
+      Assert(done[i].result == (i64)reads[done[i].user_data].size);
+    }
+  }
+}
+
+intern void bench_io_make_file(String path, u64 size, u8* pattern, u64 pattern_size) {
+  OS_Handle file = os_file_open(path, OS_AccessFlag_Write);
+  for (u64 written = 0; written < size; written += pattern_size) {
+    os_file_write(file, Min(pattern_size, size - written), pattern);
+  }
+  os_file_close(file);
+}
+
+intern void bench_io() {
+  Scratch scratch;
+  String dir = os_directory_create_temp(scratch, "bench_io");
+  if (dir.size == 0) {
+    Warn("io: no temp directory, skipped");
+    return;
+  }
+  u8* pattern = push_array(scratch, u8, BENCH_IO_CHUNK);
+  u64 seed = 1;
+  Loop (i, BENCH_IO_CHUNK) {
+    seed = squirrel3(seed);
+    pattern[i] = (u8)seed;
+  }
+  // just written, so both paths read from a warm page cache
+  String* paths = push_array(scratch, String, BENCH_IO_SMALL_FILES);
+  Loop (i, BENCH_IO_SMALL_FILES) {
+    paths[i] = push_strf(scratch, "%s/small_%u.bin", dir, i);
+    bench_io_make_file(paths[i], BENCH_IO_SMALL_SIZE, pattern + i, BENCH_IO_SMALL_SIZE);
+  }
+  String big_path = push_str_cat(scratch, dir, "/big.bin");
+  bench_io_make_file(big_path, BENCH_IO_BIG_SIZE, pattern, BENCH_IO_CHUNK);
+
+  OS_IoQueue queue = os_io_queue_alloc(scratch, BENCH_IO_DEPTH);
+  u8* small_mem = push_array(scratch, u8, BENCH_IO_SMALL_FILES * BENCH_IO_SMALL_SIZE);
+  u8* big_mem = os_reserve(BENCH_IO_BIG_SIZE);
+  os_commit(big_mem, BENCH_IO_BIG_SIZE);
+  // pinning the big buffer would need a large RLIMIT_MEMLOCK, small reads gain the most anyway
+  Slice<u8> small_buffer = {small_mem, BENCH_IO_SMALL_FILES * BENCH_IO_SMALL_SIZE};
+  b32 registered = os_io_register_buffers(queue, &small_buffer, 1);
+
+  u64 begin = os_now_ns();
+  Loop (i, BENCH_IO_SMALL_FILES) {
+    Temp temp = temp_begin(scratch.temp.arena);
+    os_file_path_read_all(scratch, paths[i]);
+    temp_end(temp);
+  }
+  f64 small_blocking_ms = f64(os_now_ns() - begin) / 1e6;
+
+  // opened a queue depth at a time, a thousand descriptors can run into the fd limit
+  begin = os_now_ns();
+  OS_Handle files[BENCH_IO_DEPTH];
+  OS_IoRead reads[BENCH_IO_DEPTH];
+  for (u32 first = 0; first < BENCH_IO_SMALL_FILES; first += BENCH_IO_DEPTH) {
+    u32 count = Min(BENCH_IO_DEPTH, BENCH_IO_SMALL_FILES - first);
+    Loop (i, count) {
+      files[i] = os_file_open(paths[first + i], OS_AccessFlag_Read);
+      reads[i] = {
+        .file = files[i],
+        .size = BENCH_IO_SMALL_SIZE,
+        .dest = small_mem + (first + i) * BENCH_IO_SMALL_SIZE,
+        .user_data = (u64)i,
+      };
+    }
+    bench_io_drain(queue, reads, count);
+    Loop (i, count) os_file_close(files[i]);
+  }
+  f64 small_queue_ms = f64(os_now_ns() - begin) / 1e6;
+
+  begin = os_now_ns();
+  {
+    OS_Handle file = os_file_open(big_path, OS_AccessFlag_Read);
+    for (u64 offset = 0; offset < BENCH_IO_BIG_SIZE;) {
+      u64 read = os_file_read(file, BENCH_IO_BIG_SIZE - offset, big_mem + offset);
+      if (read == 0 || read == U64_MAX) break;
+      offset += read;
+    }
+    os_file_close(file);
+  }
+  f64 big_blocking_seconds = f64(os_now_ns() - begin) / 1e9;
+
+  begin = os_now_ns();
+  {
+    OS_Handle file = os_file_open(big_path, OS_AccessFlag_Read);
+    u32 chunk_count = BENCH_IO_BIG_SIZE / BENCH_IO_CHUNK;
+    OS_IoRead* chunks = push_array(scratch, OS_IoRead, chunk_count);
+    Loop (i, chunk_count) {
+      chunks[i] = {
+        .file = file,
+        .offset = i * BENCH_IO_CHUNK,
+        .size = BENCH_IO_CHUNK,
+        .dest = big_mem + i * BENCH_IO_CHUNK,
+        .user_data = (u64)i,
+      };
+    }
+    bench_io_drain(queue, chunks, chunk_count);
+    os_file_close(file);
+  }
+  f64 big_queue_seconds = f64(os_now_ns() - begin) / 1e9;
+  Assert(MemMatch(big_mem + BENCH_IO_BIG_SIZE - BENCH_IO_CHUNK, pattern, BENCH_IO_CHUNK));
+
+  os_io_queue_release(queue);
+  os_release(big_mem, BENCH_IO_BIG_SIZE);
+  Loop (i, BENCH_IO_SMALL_FILES) os_file_path_delete(paths[i]);
+  os_file_path_delete(big_path);
+  os_directory_delete(dir);
+  f64 big_gb = f64(BENCH_IO_BIG_SIZE) / GB(1);
+  Info("io %u files of %u64 bytes: blocking %.2f ms, io queue %.2f ms%s", BENCH_IO_SMALL_FILES, BENCH_IO_SMALL_SIZE,
+       small_blocking_ms, small_queue_ms, String(registered ? ", registered buffers" : ""));
+  Info("io %.2f GB file: blocking %.2f GB/s, io queue in %u64 KB reads: %.2f GB/s", big_gb,
+       big_gb / big_blocking_seconds, BENCH_IO_CHUNK / KB(1), big_gb / big_queue_seconds);
+}
+
+const u32 BENCH_MODEL_ITERS = 100;
+
+// defined further down in common.cpp
+intern Mesh mesh_load_obj(Allocator arena, String name, u64* source_hash);
+intern Mesh mesh_load_glb(Allocator arena, String name, u64* source_hash);
+
+// the bundled glb and obj models, begin logs label as skipped when there is no models directory
+struct BenchModel {
+  String name;
+  String path;       // on disk
+  String asset_path; // through the vfs
+  u64 size;
+  b32 glb;
+};
+
+struct BenchModelIter {
+  OS_FileIter* files;
+};
+
+intern BenchModelIter bench_models_begin(Allocator arena, String label) {
+  String dir = g_st->models_dir;
+  if (!os_directory_path_exist(dir)) {
+    Info("%s: %s not found, skipped", label, dir);
+    return {};
+  }
+  return {os_file_iter_begin(arena, dir, OS_FileIterFlag_SkipFolders)};
+}
+
+intern b32 bench_models_next(Allocator arena, BenchModelIter* it, BenchModel* out) {
+  if (!it->files) return false;
+  for (OS_FileInfo info = {}; os_file_iter_next(arena, it->files, &info);) {
+    String format = str_skip_last_dot(info.name);
+    if (!str_match(format, "glb") && !str_match(format, "obj")) continue;
+    *out = {
+      .name = info.name,
+      .path = push_strf(arena, "%s/%s", g_st->models_dir, info.name),
+      .asset_path = push_strf(arena, "models/%s", info.name),
+      .size = info.props.size,
+      .glb = str_match(format, "glb"),
+    };
+    return true;
+  }
+  return false;
+}
+
+intern void bench_models_end(BenchModelIter* it) {
+  if (it->files) os_file_iter_end(it->files);
+}
+
+intern Mesh bench_model_mesh(Allocator arena, BenchModel& model) {
+  return model.glb ? mesh_load_glb(arena, model.asset_path, null) : mesh_load_obj(arena, model.asset_path, null);
+}
+
+// the bundled models: copied into scratch like the loaders used to vs mapped, then the whole
+// load through the vfs, peak rss is for the process so far, not just this bench
+intern void bench_model_load() {
+  Scratch scratch;
+  BenchModelIter it = bench_models_begin(scratch, "models");
+  for (BenchModel model; bench_models_next(scratch, &it, &model);) {
+    u64 sink = 0;
+
+    u64 begin = os_now_ns();
+    Loop (i, BENCH_MODEL_ITERS) {
+      Temp temp = temp_begin(scratch.temp.arena);
+      Slice<u8> buf = os_file_path_read_all(scratch, model.path);
+      sink += hash_memory(buf.data, buf.count);
+      temp_end(temp);
+    }
+    f64 copy_ms = f64(os_now_ns() - begin) / 1e6 / BENCH_MODEL_ITERS;
+
+    begin = os_now_ns();
+    Loop (i, BENCH_MODEL_ITERS) {
+      Slice<u8> buf = os_file_path_map(model.path, OS_MapFlag_WillNeed);
+      sink += hash_memory(buf.data, buf.count);
+      os_file_unmap(buf.data, buf.count);
+    }
+    f64 map_ms = f64(os_now_ns() - begin) / 1e6 / BENCH_MODEL_ITERS;
+
+    begin = os_now_ns();
+    Loop (i, BENCH_MODEL_ITERS) {
+      Temp temp = temp_begin(scratch.temp.arena);
+      Mesh mesh = bench_model_mesh(scratch, model);
+      sink += mesh.index_count;
+      temp_end(temp);
+    }
+    f64 load_ms = f64(os_now_ns() - begin) / 1e6 / BENCH_MODEL_ITERS;
+
+    // what a compressed pack entry costs on top of the mapping
+    Slice<u8> raw = os_file_path_read_all(scratch, model.path);
+    u64 bound = lz4_compress_bound(raw.count);
+    u8* packed = push_buffer(scratch, bound);
+    u64 packed_size = lz4_compress(raw.data, raw.count, packed, bound);
+    u8* unpacked = push_buffer(scratch, raw.count);
+    begin = os_now_ns();
+    Loop (i, BENCH_MODEL_ITERS) {
+      sink += lz4_decompress(packed, packed_size, unpacked, raw.count);
+    }
+    f64 lz4_seconds = f64(os_now_ns() - begin) / 1e9 / BENCH_MODEL_ITERS;
+    Assert(MemMatch(unpacked, raw.data, raw.count));
+
+    Info("model %s %u64 KB: read into scratch %.3f ms, mapped %.3f ms, mapped load %.3f ms (%u64)",
+         model.name, model.size / KB(1), copy_ms, map_ms, load_ms, sink & 1);
+    Info("model %s lz4: %.2f of the size, decode %.2f MB/s", model.name, f64(packed_size) / f64(raw.count),
+         f64(raw.count) / MB(1) / lz4_seconds);
+  }
+  bench_models_end(&it);
+  Info("models: peak rss %u64 MB", os_peak_rss() / MB(1));
+}
+
+intern Mesh bench_mesh_copy(Allocator arena, Mesh source) {
+  Mesh mesh = source;
+  mesh.vertices = push_array(arena, Vertex, source.vert_count);
+  mesh.indices = push_array(arena, u32, source.index_count);
+  MemCopy(mesh.vertices, source.vertices, source.vert_count * sizeof(Vertex));
+  MemCopy(mesh.indices, source.indices, source.index_count * sizeof(u32));
+  return mesh;
+}
+
+// what the cook step in mesh_read does to each bundled model, on the loader's order
+intern void bench_mesh_optimize() {
+  Scratch scratch;
+  BenchModelIter it = bench_models_begin(scratch, "mesh optimize");
+  for (BenchModel model; bench_models_next(scratch, &it, &model);) {
+    Mesh source = bench_model_mesh(scratch, model);
+    if (!source.indices) continue;
+    VertexCacheStats before = mesh_vertex_cache_stats(source.indices, source.index_count, source.vert_count);
+
+    u64 begin = os_now_ns();
+    Loop (i, BENCH_MODEL_ITERS) {
+      Temp temp = temp_begin(scratch.temp.arena);
+      Mesh mesh = bench_mesh_copy(scratch, source);
+      mesh_optimize(scratch, &mesh);
+      temp_end(temp);
+    }
+    f64 ms = f64(os_now_ns() - begin) / 1e6 / BENCH_MODEL_ITERS;
+    Mesh mesh = bench_mesh_copy(scratch, source);
+    mesh_optimize(scratch, &mesh);
+    VertexCacheStats after = mesh_vertex_cache_stats(mesh.indices, mesh.lods[0].index_count, mesh.vert_count);
+    VertexCacheStats cache_only = before;
+    {
+      Temp temp = temp_begin(scratch.temp.arena);
+      u32* indices = push_array(scratch, u32, source.index_count);
+      MemCopy(indices, source.indices, source.index_count * sizeof(u32));
+      mesh_optimize_vertex_cache(indices, source.index_count, source.vert_count);
+      cache_only = mesh_vertex_cache_stats(indices, source.index_count, source.vert_count);
+      temp_end(temp);
+    }
+
+    Info("mesh optimize %s %u tris: acmr %.3f -> %.3f (tipsify alone %.3f), atvr %.3f -> %.3f, %.3f ms with lods", model.name,
+         mesh.lods[0].index_count / 3, before.acmr, after.acmr, cache_only.acmr, before.atvr, after.atvr, ms);
+  }
+  bench_models_end(&it);
+}
+
+// triangles a frame submits for KB(1) instances of each bundled model scattered like the static
+// entities in scene_init, seen from the middle at 1080p and the game's 45 degree fov
+intern void bench_mesh_lod() {
+  Scratch scratch;
+  const u32 instance_count = KB(1);
+  f32 pixel_scale = 1080 * 0.5f / Tan(degtorad(45) / 2);
+  BenchModelIter it = bench_models_begin(scratch, "mesh lod");
+  for (BenchModel model; bench_models_next(scratch, &it, &model);) {
+    Mesh mesh = bench_model_mesh(scratch, model);
+    if (!mesh.indices) continue;
+    mesh_optimize(scratch, &mesh);
+    Loop (i, mesh.lod_count) {
+      Info("mesh lod %s %i: %u tris, error %.4f", model.name, i, mesh.lods[i].index_count / 3, mesh.lods[i].error);
+    }
+
+    // the scene's range and a tighter one where most instances are close
+    u32 ranges[] = {KB(1), 64};
+    for EachElement (r, ranges) {
+      u64 seed = 5;
+      u64 full = 0;
+      u64 drawn = 0;
+      u32 per_lod[MESH_LOD_MAX] = {};
+      u64 begin = os_now_ns();
+      Loop (i, instance_count) {
+        f32 pos[3];
+        Loop (k, 3) {
+          seed = squirrel3(seed);
+          pos[k] = (f32(seed % 10000) / 5000 - 1) * ranges[r];
+        }
+        u32 lod = mesh_lod_select(mesh.lods, mesh.lod_count, 1, v3_length({pos[0], pos[1], pos[2]}), pixel_scale);
+        per_lod[lod]++;
+        full += mesh.lods[0].index_count / 3;
+        drawn += mesh.lods[lod].index_count / 3;
+      }
+      f64 select_ns = f64(os_now_ns() - begin) / instance_count;
+      Info("mesh lod %s, %u instances within %u: %u64 -> %u64 tris a frame, per lod %u %u %u %u, %.1f ns each",
+           model.name, instance_count, ranges[r], full, drawn, per_lod[0], per_lod[1], per_lod[2], per_lod[3], select_ns);
+    }
+  }
+  bench_models_end(&it);
+}
+
+// clusters mesh_optimize builds for each bundled model, and how many the cone test drops when
+// the model is seen from each side along the axes
+intern void bench_meshlets() {
+  Scratch scratch;
+  BenchModelIter it = bench_models_begin(scratch, "meshlets");
+  for (BenchModel model; bench_models_next(scratch, &it, &model);) {
+    Mesh mesh = bench_model_mesh(scratch, model);
+    if (!mesh.indices) continue;
+    mesh_optimize(scratch, &mesh);
+
+    u64 begin = os_now_ns();
+    Loop (i, BENCH_MODEL_ITERS) {
+      Temp temp = temp_begin(scratch.temp.arena);
+      mesh_build_meshlets(scratch, mesh.indices, mesh.lods[0].index_count, mesh.vertices, mesh.vert_count);
+      temp_end(temp);
+    }
+    f64 ms = f64(os_now_ns() - begin) / 1e6 / BENCH_MODEL_ITERS;
+
+    Meshlets meshlets = mesh.meshlets;
+    f32 extent = mesh_extent(mesh.vertices, mesh.vert_count);
+    v3 views[] = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
+    u32 culled = 0;
+    for EachElement (i, views) {
+      Loop (m, meshlets.count) culled += meshlet_backfacing(&meshlets.bounds[m], views[i] * extent * 4);
+    }
+    u32 cones = 0;
+    Loop (m, meshlets.count) cones += meshlets.bounds[m].cone_cutoff < 1;
+    Info("meshlets %s %u tris: %u meshlets, %.1f verts %.1f tris each, %u with a cone, %.1f%% cone culled, %.3f ms",
+         model.name, mesh.lods[0].index_count / 3, meshlets.count, f32(meshlets.vertex_count) / meshlets.count,
+         f32(meshlets.triangle_count) / meshlets.count, cones, 100.f * culled / (meshlets.count * ArrayCount(views)), ms);
+  }
+  bench_models_end(&it);
+}
+
+// vertex bytes a bundled model takes packed against full floats, what packing and unpacking cost,
+// and the worst position error as a fraction of the model's size
+intern void bench_vertex_quantization() {
+  Scratch scratch;
+  BenchModelIter it = bench_models_begin(scratch, "vertex quantization");
+  for (BenchModel model; bench_models_next(scratch, &it, &model);) {
+    Mesh mesh = bench_model_mesh(scratch, model);
+    if (!mesh.vert_count) continue;
+
+    PackedVertex* packed = push_array(scratch, PackedVertex, mesh.vert_count);
+    Vertex* decoded = push_array(scratch, Vertex, mesh.vert_count);
+    VertexQuantization quantization = mesh_vertex_quantization(mesh.vertices, mesh.vert_count);
+    u64 begin = os_now_ns();
+    Loop (i, BENCH_MODEL_ITERS) mesh_encode_vertices(packed, mesh.vertices, mesh.vert_count, quantization);
+    u64 encode_ns = (os_now_ns() - begin) / BENCH_MODEL_ITERS;
+    begin = os_now_ns();
+    Loop (i, BENCH_MODEL_ITERS) mesh_decode_vertices(decoded, packed, mesh.vert_count, quantization);
+    u64 decode_ns = (os_now_ns() - begin) / BENCH_MODEL_ITERS;
+
+    f32 error = 0;
+    Loop (i, mesh.vert_count) error = Max(error, v3_length(mesh.vertices[i].pos - decoded[i].pos));
+    u64 full_size = (u64)mesh.vert_count * sizeof(Vertex);
+    u64 packed_size = (u64)mesh.vert_count * sizeof(PackedVertex);
+    Info("vertex quantization %s %u verts: %u64 -> %u64 bytes, encode %.0f decode %.0f Mverts/s, max pos error %.1f ppm of extent",
+         model.name, mesh.vert_count, full_size, packed_size, mesh.vert_count * 1e3 / Max(encode_ns, 1ull),
+         mesh.vert_count * 1e3 / Max(decode_ns, 1ull), error / mesh_extent(mesh.vertices, mesh.vert_count) * 1e6);
+  }
+  bench_models_end(&it);
+}
+
+// each buffer of a cooked mesh raw, through lz4 alone, the codec, and the codec then lz4, with
+// the codec's decode speed in bytes of output
+intern void bench_mesh_compression() {
+  Scratch scratch;
+  BenchModelIter it = bench_models_begin(scratch, "mesh compression");
+  for (BenchModel model; bench_models_next(scratch, &it, &model);) {
+    Mesh mesh = bench_model_mesh(scratch, model);
+    if (!mesh.vert_count) continue;
+    mesh_optimize(scratch, &mesh);
+
+    PackedVertex* packed = push_array(scratch, PackedVertex, mesh.vert_count);
+    mesh_encode_vertices(packed, mesh.vertices, mesh.vert_count, mesh_vertex_quantization(mesh.vertices, mesh.vert_count));
+    var report = [&](const char* buffer, void* data, u64 raw_size, u64 encoded_size, u8* encoded, u64 decode_ns) {
+      u8* lz4 = push_array(scratch, u8, lz4_compress_bound(raw_size));
+      u64 lz4_size = lz4_compress((u8*)data, raw_size, lz4, lz4_compress_bound(raw_size));
+      u8* both = push_array(scratch, u8, lz4_compress_bound(encoded_size));
+      u64 both_size = lz4_compress(encoded, encoded_size, both, lz4_compress_bound(encoded_size));
+      Info("mesh compression %s %s: %u64 bytes, lz4 %.2fx, codec %.2fx, codec+lz4 %.2fx, decode %.2f GB/s",
+           model.name, buffer, raw_size, (f64)raw_size / lz4_size, (f64)raw_size / encoded_size,
+           (f64)raw_size / both_size, (f64)raw_size / Max(decode_ns, 1ull));
+    };
+    var vertices = [&](const char* buffer, void* data, u32 vertex_size) {
+      u64 raw_size = (u64)mesh.vert_count * vertex_size;
+      u64 cap = mesh_compress_vertices_bound(mesh.vert_count, vertex_size);
+      u8* encoded = push_array(scratch, u8, cap);
+      u64 size = mesh_compress_vertices(data, mesh.vert_count, vertex_size, encoded, cap);
+      u8* decoded = push_array(scratch, u8, raw_size);
+      u64 begin = os_now_ns();
+      Loop (i, BENCH_MODEL_ITERS) mesh_decompress_vertices(encoded, size, decoded, mesh.vert_count, vertex_size);
+      u64 decode_ns = (os_now_ns() - begin) / BENCH_MODEL_ITERS;
+      Assert(MemMatch(decoded, data, raw_size));
+      report(buffer, data, raw_size, size, encoded, decode_ns);
+    };
+    vertices("vertices", mesh.vertices, sizeof(Vertex));
+    vertices("packed vertices", packed, sizeof(PackedVertex));
+
+    u64 raw_size = (u64)mesh.index_count * sizeof(u32);
+    u64 cap = mesh_compress_indices_bound(mesh.index_count, mesh.vert_count);
+    u8* encoded = push_array(scratch, u8, cap);
+    u64 size = mesh_compress_indices(mesh.indices, mesh.index_count, encoded, cap);
+    u32* decoded = push_array(scratch, u32, mesh.index_count);
+    u64 begin = os_now_ns();
+    Loop (i, BENCH_MODEL_ITERS) mesh_decompress_indices(encoded, size, decoded, mesh.index_count);
+    u64 decode_ns = (os_now_ns() - begin) / BENCH_MODEL_ITERS;
+    report("indices", mesh.indices, raw_size, size, encoded, decode_ns);
+  }
+  bench_models_end(&it);
+}
+
+void bench() {
+  bench_concurrent_map();
+  bench_mpmc_queue();
+  bench_number_format();
+  bench_format_string();
+  bench_logger();
+  bench_float_parse();
+  bench_tokenize();
+  bench_str_builder();
+  bench_utf8();
+  bench_json();
+  bench_io();
+  bench_model_load();
+  bench_mesh_optimize();
+  bench_mesh_lod();
+  bench_meshlets();
+  bench_vertex_quantization();
+  bench_mesh_compression();
+}
+
+#endif
@@ -2,7 +2,10 @@
 #include "game.cpp"
 #include "common.h"
 #include "json.cpp"
+#include "pack.cpp"
+#include "mesh.cpp"
 #include "test.cpp"
+#include "bench.cpp"
 
 u64 hash(Vertex x) { return hash_memory(&x, sizeof(x)); }
 b32 equal(Vertex a, Vertex b) { return MemMatchStruct(&a, &b); }
@@ -51,40 +54,52 @@ v3& Handle<StaticEntity>::pos() { return trans().pos; }
 v3& Handle<StaticEntity>::rot() { return trans().rot; }
 v3& Handle<StaticEntity>::scale() { return trans().scale; }
 
-intern Mesh mesh_load_obj(Allocator arena, String name) {
+// source_hash, when set, gets the content hash of the file from the bytes already read
+intern Mesh mesh_load_obj(Allocator arena, String name, u64* source_hash) {
   Scratch scratch(arena);
   Darray<v3> positions(scratch);
   Darray<v3> normals(scratch);
   Darray<v2> uvs(scratch);
   Darray<v3u> indexes(scratch);
-  Slice buf = os_file_path_read_all(scratch, name);
+  // one counting pass and one parsing pass, both front to back
+  VFile file = vfs_open(g_st->vfs, scratch, name, OS_MapFlag_Sequential|OS_MapFlag_WillNeed);
+  Slice buf = file.data;
+  // arrays are interleaved in scratch, so reserve up front instead of regrowing with copies
+  {
+    u32 v_count = 0, vn_count = 0, vt_count = 0, f_count = 0;
+    for (u64 i = 0; i + 1 < buf.count; i += bytes_find(buf.data + i, buf.count - i, '\n') + 1) {
+      u8 c0 = buf.data[i], c1 = buf.data[i+1];
+      if (c0 == 'v' && c1 == ' ') ++v_count;
+      else if (c0 == 'v' && c1 == 'n') ++vn_count;
+      else if (c0 == 'v' && c1 == 't') ++vt_count;
+      else if (c0 == 'f' && c1 == ' ') ++f_count;
+    }
+    positions.reserve(v_count);
+    normals.reserve(vn_count);
+    uvs.reserve(vt_count);
+    indexes.reserve(f_count * 3);
+  }
   Lexer lexer = lexer_init({buf.data, buf.count});
   String word;
   while ((word = lexer_next_token(&lexer)).size) {
     // vert
     if (str_match(word, "v")) {
       v3 v = {};
-      for (f32& e : v.v) {
-        e = f32_from_str(lexer_next_token(&lexer));
-      }
+      lexer_next_f32_array(&lexer, v.v, 3);
       // Info("v %f, %f, %f", v.x, v.y, v.z);
       positions.add(v);
     }
     // norm
     else if (str_match(word, "vn")) {
       v3 v = {};
-      for (f32& e : v.v) {
-        e = f32_from_str(lexer_next_token(&lexer));
-      }
+      lexer_next_f32_array(&lexer, v.v, 3);
       // Info("vn %f, %f, %f", v.x, v.y, v.z);
       normals.add(v);
     }
     // uv
     else if (str_match(word, "vt")) {
       v2 v = {};
-      for (f32& e : v.v) {
-        e = f32_from_str(lexer_next_token(&lexer));
-      }
+      lexer_next_f32_array(&lexer, v.v, 2);
       // Info("vt %f, %f", v.x, v.y);
       uvs.add(v);
     }
@@ -101,8 +116,12 @@ intern Mesh mesh_load_obj(Allocator arena, String name) {
       }
     }
   }
-  Darray<Vertex> vertices(arena);
+  if (source_hash) { *source_hash = vfs_file_hash(file); }
+  vfs_close(file);
+  // final_indices size is known, vertices is reserved last so it can grow in place in arena
   Darray<u32> final_indices(arena);
+  final_indices.reserve(indexes.count);
+  Darray<Vertex> vertices(arena);
   Map<Vertex, u32> map(scratch);
   for (v3u idx : indexes) {
     Vertex vertex = {
@@ -129,10 +148,12 @@ intern Mesh mesh_load_obj(Allocator arena, String name) {
   return mesh;
 }
 
-intern Mesh mesh_load_gltf(Allocator arena, String name) {
+intern Mesh mesh_load_gltf(Allocator arena, String name, u64* source_hash) {
   Scratch scratch(arena);
-  Slice buf = os_file_path_read_all(scratch, name);
+  VFile file = vfs_open(g_st->vfs, scratch, name, OS_MapFlag_Sequential);
+  Slice buf = file.data;
   JsonReader r = json_reader_init({buf.data, buf.count});
+  defer(json_reader_deinit(&r));
   struct MeshInfo {
     // u32 pos_idx;
     // u32 norm_idx;
@@ -184,10 +205,10 @@ intern Mesh mesh_load_gltf(Allocator arena, String name) {
         JSON_OBJ(r, obj) {
           if (k.match("count")) {
             if (i == 0) {
-              info.vert_count = u32_from_str(v.str);
+              info.vert_count = (u32)v.number;
             }
             else if (i == 3) {
-              info.index_count = u32_from_str(v.str);
+              info.index_count = (u32)v.number;
             }
           }
         }
@@ -199,10 +220,10 @@ intern Mesh mesh_load_gltf(Allocator arena, String name) {
       JSON_ARR(r, v) {
         JSON_OBJ(r, obj) {
           if (k.match("byteLength")) {
-            info.ranges[i].size = u32_from_str(v.str);
+            info.ranges[i].size = (u32)v.number;
           }
           else if (k.match("byteOffset")) {
-            info.ranges[i].offset = u32_from_str(v.str);
+            info.ranges[i].offset = (u32)v.number;
           }
         }
         ++i;
@@ -212,7 +233,7 @@ intern Mesh mesh_load_gltf(Allocator arena, String name) {
       JSON_ARR(r, v) {
         JSON_OBJ(r, obj) {
           if (k.match("byteLength")) {
-            info.file_size = u32_from_str(v.str);
+            info.file_size = (u32)v.number;
           }
           else if (k.match("uri")) {
             info.file_name = v.str;
@@ -222,7 +243,12 @@ intern Mesh mesh_load_gltf(Allocator arena, String name) {
     }
   }
   String model_dir = str_chop_last_slash(name);
-  Slice buf1 = os_file_path_read_all(scratch, push_strf(scratch, "%s/%s", model_dir, info.file_name));
+  // strings in the tape point into the json file
+  String bin_path = push_strf(scratch, "%s/%s", model_dir, info.file_name);
+  if (source_hash) { *source_hash = vfs_file_hash(file); }
+  vfs_close(file);
+  VFile bin_file = vfs_open(g_st->vfs, scratch, bin_path, OS_MapFlag_WillNeed);
+  Slice buf1 = bin_file.data;
   v3* vertices_pos = (v3*)Offset(buf1.data, info.ranges[0].offset);
   v3* vertices_norm = (v3*)Offset(buf1.data, info.ranges[1].offset);
   v2* vertices_uv = (v2*)Offset(buf1.data, info.ranges[2].offset);
@@ -239,6 +265,7 @@ intern Mesh mesh_load_gltf(Allocator arena, String name) {
       .uv = vertices_uv[i],
     };
   }
+  vfs_close(bin_file);
   Mesh mesh = {
     .vertices = vertices,
     .indices = (u32*)indices,
@@ -248,9 +275,11 @@ intern Mesh mesh_load_gltf(Allocator arena, String name) {
   return mesh;
 }
 
-intern Mesh mesh_load_glb(Allocator arena, String name) {
+intern Mesh mesh_load_glb(Allocator arena, String name, u64* source_hash) {
   Scratch scratch(arena);
-  Slice buf = os_file_path_read_all(scratch, name);
+  // json and binary chunks are read straight out of the mapping, the binary one out of order
+  VFile file = vfs_open(g_st->vfs, scratch, name, OS_MapFlag_WillNeed);
+  Slice buf = file.data;
   struct FileHeader {
     u32 magic;
     u32 version;
@@ -283,7 +312,8 @@ intern Mesh mesh_load_glb(Allocator arena, String name) {
     String file_name;
     u32 file_size;
   } info = {};
-  JsonReader r = json_reader_init({(u8*)&json_chunk->chunk_data, buf.count});
+  JsonReader r = json_reader_init({(u8*)&json_chunk->chunk_data, json_chunk->chunk_length});
+  defer(json_reader_deinit(&r));
   JSON_OBJ(r, r.base_obj) {
     if (k.match("meshes")) {
       JSON_ARR(r, v) JSON_OBJ(r, obj) {
@@ -292,18 +322,18 @@ intern Mesh mesh_load_glb(Allocator arena, String name) {
             if (k.match("attributes")) {
               JSON_OBJ_(r, v) {
                 if (key.match("POSITION")) {
-                  info.primitives.pos = u32_from_str(val.str);
+                  info.primitives.pos = (u32)val.number;
                 }
                 else if (key.match("NORMAL")) {
-                  info.primitives.norm = u32_from_str(val.str);
+                  info.primitives.norm = (u32)val.number;
                 }
                 else if (key.match("TEXCOORD_0")) {
-                  info.primitives.uv = u32_from_str(val.str);
+                  info.primitives.uv = (u32)val.number;
                 }
               }
             }
             else if (k.match("indices")) {
-              info.primitives.index = u32_from_str(v.str);
+              info.primitives.index = (u32)v.number;
             }
           }
         }
@@ -314,7 +344,7 @@ intern Mesh mesh_load_glb(Allocator arena, String name) {
       JSON_ARR(r, v) {
         JSON_OBJ(r, obj) {
           if (k.match("count")) {
-            info.accessors[i].count = u32_from_str(v.str);
+            info.accessors[i].count = (u32)v.number;
           }
         }
         ++i;
@@ -325,10 +355,10 @@ intern Mesh mesh_load_glb(Allocator arena, String name) {
       JSON_ARR(r, v) {
         JSON_OBJ(r, obj) {
           if (k.match("byteLength")) {
-            info.buffer_views[i].size = u32_from_str(v.str);
+            info.buffer_views[i].size = (u32)v.number;
           }
           else if (k.match("byteOffset")) {
-            info.buffer_views[i].offset = u32_from_str(v.str);
+            info.buffer_views[i].offset = (u32)v.number;
           }
         }
         ++i;
@@ -338,7 +368,7 @@ intern Mesh mesh_load_glb(Allocator arena, String name) {
       JSON_ARR(r, v) {
         JSON_OBJ(r, obj) {
           if (k.match("byteLength")) {
-            info.file_size = u32_from_str(v.str);
+            info.file_size = (u32)v.number;
           }
           else if (k.match("uri")) {
             info.file_name = v.str;
@@ -366,6 +396,8 @@ intern Mesh mesh_load_glb(Allocator arena, String name) {
       .uv = vertices_uv[i],
     };
   }
+  if (source_hash) { *source_hash = vfs_file_hash(file); }
+  vfs_close(file);
   Mesh mesh = {
     .vertices = vertices,
     .indices = indices,
@@ -380,8 +412,10 @@ intern Texture texture_image_load(String filepath) {
   Texture texture = {};
   u32 required_channel_count = 4;
   u32 channel_count;
-  Slice buf = os_file_path_read_all(scratch, filepath);
+  VFile file = vfs_open(g_st->vfs, scratch, filepath, OS_MapFlag_Sequential);
+  Slice buf = file.data;
   u8* data = stbi_load_from_memory(buf.data, buf.count, (i32*)&texture.width, (i32*)&texture.height, (i32*)&channel_count, required_channel_count);
+  vfs_close(file);
   Assert(data);
   texture.data = data;
   return texture;
@@ -392,7 +426,13 @@ intern Texture texture_image_load(String filepath) {
 
 // TODO: allocate in hotreload build?
 global String meshes_strs[Mesh_Load_COUNT] = {
-#define X(enum_name, name) [enum_name] = Stringify(name),
+#define X(enum_name, name, cook_flags) [enum_name] = Stringify(name),
+  MESH_LIST
+#undef X
+};
+
+global MeshCookFlags meshes_cook_flags[Mesh_Load_COUNT] = {
+#define X(enum_name, name, cook_flags) [enum_name] = cook_flags,
   MESH_LIST
 #undef X
 };
@@ -428,36 +468,319 @@ constexpr MaterialProps material_default_props() {
   return props;
 }
 
-Handle<GpuMesh> mesh_load(String name) {
-  GlobalState& g = *g_st;
+///////////////////////////////////
+// Mesh cache
+
+// Cooked meshes are written to g.mesh_cache_dir as <path hash>.mesh. The blobs are laid out
+// the way vk_mesh_load takes them, so a warm load maps the file and hands it over unparsed.
+// Meshes cooked with MeshCookFlag_Packed store their vertices packed instead and run them and
+// the indices through the buffer codecs on top. Load decodes the codecs and uploads the packed
+// vertices as they are.
+// NOTE: only the source file itself is tracked, not the .bin buffers a .gltf points to
+const u32 MESH_CACHE_MAGIC   = 'm' | 'e' << 8 | 's' << 16 | 'h' << 24;
+const u32 MESH_CACHE_VERSION = 6;
+const u32 MESH_CACHE_ALIGN   = 64;
+
+enum VertexFormat {
+  VertexFormat_Full,
+  VertexFormat_Packed,
+};
+
+struct MeshCacheHeader {
+  u32 magic;
+  u32 version;
+  u32 vertex_size;
+  u32 vert_count;
+  u32 index_count;
+  u32 vertex_format;
+  u64 vert_offset;
+  u64 index_offset;
+  u64 source_size;
+  DenseTime source_modified;
+  u64 source_hash;
+  u32 lod_count;
+  MeshLod lods[MESH_LOD_MAX];
+  u32 meshlet_count;
+  u32 meshlet_vertex_count;
+  u32 meshlet_triangle_count;
+  u64 meshlet_offset;
+  u64 meshlet_bounds_offset;
+  u64 meshlet_vertex_offset;
+  u64 meshlet_triangle_offset;
+  VertexQuantization quantization;
+  // with compressed set the vertex and index blocks hold codec streams of these sizes
+  b32 compressed;
+  u64 vert_stored_size;
+  u64 index_stored_size;
+};
+
+// for the startup report in asset_load
+global u32 mesh_cache_hits;
+
+struct MeshCacheMap {
+  Mesh mesh;
+  void* ptr;
+  u64 size;
+};
+
+// header.vertex_format says how the vertices are stored, a packed mesh brings its
+// packed_vertices and quantization along
+intern void mesh_cache_write(String cache_path, MeshCacheHeader header, Mesh mesh) {
   Scratch scratch;
-  String filepath = push_strf(scratch, "%s/%s", g.models_dir, name);
-  String format = str_skip_last_dot(name);
+  void* vertices = mesh.vertices;
+  void* indices = mesh.indices;
+  header.vertex_size = sizeof(Vertex);
+  header.compressed = false;
+  u64 vert_size = (u64)mesh.vert_count * sizeof(Vertex);
+  u64 index_size = (u64)mesh.index_count * sizeof(u32);
+  if (header.vertex_format == VertexFormat_Packed) {
+    PackedVertex* packed = mesh.packed_vertices;
+    header.quantization = mesh.quantization;
+    header.vertex_size = sizeof(PackedVertex);
+    header.compressed = true;
+    u64 vert_cap = mesh_compress_vertices_bound(mesh.vert_count, sizeof(PackedVertex));
+    u64 index_cap = mesh_compress_indices_bound(mesh.index_count, mesh.vert_count);
+    vertices = push_array(scratch, u8, vert_cap);
+    indices = push_array(scratch, u8, index_cap);
+    vert_size = mesh_compress_vertices(packed, mesh.vert_count, sizeof(PackedVertex), (u8*)vertices, vert_cap);
+    index_size = mesh_compress_indices(mesh.indices, mesh.index_count, (u8*)indices, index_cap);
+  }
+  header.vert_stored_size = vert_size;
+  header.index_stored_size = index_size;
+  header.magic = MESH_CACHE_MAGIC;
+  header.version = MESH_CACHE_VERSION;
+  header.vert_count = mesh.vert_count;
+  header.index_count = mesh.index_count;
+  header.lod_count = mesh.lod_count;
+  MemCopy(header.lods, mesh.lods, sizeof(header.lods));
+  header.meshlet_count = mesh.meshlets.count;
+  header.meshlet_vertex_count = mesh.meshlets.vertex_count;
+  header.meshlet_triangle_count = mesh.meshlets.triangle_count;
+  u64 meshlet_size = (u64)mesh.meshlets.count * sizeof(Meshlet);
+  u64 bounds_size = (u64)mesh.meshlets.count * sizeof(MeshletBounds);
+  u64 meshlet_vertex_size = (u64)mesh.meshlets.vertex_count * sizeof(u32);
+  u64 meshlet_triangle_size = (u64)mesh.meshlets.triangle_count * 3;
+  header.vert_offset = AlignUp(sizeof(MeshCacheHeader), MESH_CACHE_ALIGN);
+  header.index_offset = AlignUp(header.vert_offset + vert_size, MESH_CACHE_ALIGN);
+  header.meshlet_offset = AlignUp(header.index_offset + index_size, MESH_CACHE_ALIGN);
+  header.meshlet_bounds_offset = AlignUp(header.meshlet_offset + meshlet_size, MESH_CACHE_ALIGN);
+  header.meshlet_vertex_offset = AlignUp(header.meshlet_bounds_offset + bounds_size, MESH_CACHE_ALIGN);
+  header.meshlet_triangle_offset = AlignUp(header.meshlet_vertex_offset + meshlet_vertex_size, MESH_CACHE_ALIGN);
+  // written next to the target and renamed over it, so a crash never leaves half a mesh
+  String tmp_path = push_str_cat(scratch, cache_path, ".tmp");
+  OS_Handle file = os_file_open(tmp_path, OS_AccessFlag_Write);
+  if (file.v == 0) {
+    Log(Assets, Warn, "mesh cache: can't write %s", tmp_path);
+    return;
+  }
+  u8 pad[MESH_CACHE_ALIGN] = {};
+  u64 written = 0;
+  u64 end = 0;
+  var write_block = [&](u64 offset, u64 size, void* data) {
+    written += os_file_write(file, offset - end, pad);
+    written += os_file_write(file, size, data);
+    end = offset + size;
+  };
+  write_block(0, sizeof(header), &header);
+  write_block(header.vert_offset, vert_size, vertices);
+  write_block(header.index_offset, index_size, indices);
+  write_block(header.meshlet_offset, meshlet_size, mesh.meshlets.meshlets);
+  write_block(header.meshlet_bounds_offset, bounds_size, mesh.meshlets.bounds);
+  write_block(header.meshlet_vertex_offset, meshlet_vertex_size, mesh.meshlets.vertices);
+  write_block(header.meshlet_triangle_offset, meshlet_triangle_size, mesh.meshlets.triangles);
+  os_file_close(file);
+  if (written != header.meshlet_triangle_offset + meshlet_triangle_size) {
+    Log(Assets, Warn, "mesh cache: short write to %s", tmp_path);
+    return;
+  }
+  os_file_path_rename(cache_path, tmp_path);
+}
+
+// compressed blocks are decoded into arena, everything else points into the mapping, packed
+// vertices stay packed for the gpu. False if a codec stream turns out malformed
+intern b32 mesh_cache_mesh(Allocator arena, void* ptr, MeshCacheHeader& header, Mesh* result) {
+  u8* base = (u8*)ptr;
+  Mesh mesh = {
+    .vertices = (Vertex*)(base + header.vert_offset),
+    .indices = header.index_count ? (u32*)(base + header.index_offset) : null,
+    .vert_count = header.vert_count,
+    .index_count = header.index_count,
+    .lod_count = header.lod_count,
+    .meshlets = {
+      .meshlets = (Meshlet*)(base + header.meshlet_offset),
+      .bounds = (MeshletBounds*)(base + header.meshlet_bounds_offset),
+      .vertices = (u32*)(base + header.meshlet_vertex_offset),
+      .triangles = base + header.meshlet_triangle_offset,
+      .count = header.meshlet_count,
+      .vertex_count = header.meshlet_vertex_count,
+      .triangle_count = header.meshlet_triangle_count,
+    },
+  };
+  MemCopy(mesh.lods, header.lods, sizeof(mesh.lods));
+  if (header.vertex_format == VertexFormat_Packed) {
+    mesh.vertices = null;
+    mesh.packed_vertices = (PackedVertex*)(base + header.vert_offset);
+    mesh.quantization = header.quantization;
+  }
+  if (header.compressed) {
+    mesh.packed_vertices = push_array(arena, PackedVertex, header.vert_count);
+    mesh.indices = push_array(arena, u32, header.index_count);
+    if (!mesh_decompress_vertices(base + header.vert_offset, header.vert_stored_size, mesh.packed_vertices, header.vert_count, sizeof(PackedVertex)) ||
+        !mesh_decompress_indices(base + header.index_offset, header.index_stored_size, mesh.indices, header.index_count)) {
+      return false;
+    }
+  }
+  *result = mesh;
+  return true;
+}
+
+// maps the cooked mesh if it matches the source, ptr is null on a miss
+intern MeshCacheMap mesh_cache_open(Allocator arena, String cache_path, String filepath, FileProperties source,
+                                    VertexFormat vertex_format) {
+  MeshCacheMap result = {};
+  OS_Handle file = os_file_open(cache_path, OS_AccessFlag_Read);
+  if (file.v == 0) { return result; }
+  u64 size = os_file_size(file);
+  void* ptr = size >= sizeof(MeshCacheHeader) ? os_file_map(file, size) : null;
+  os_file_close(file);
+  if (!ptr) { return result; }
+
+  MeshCacheHeader header = *(MeshCacheHeader*)ptr;
+  u32 vertex_size = header.vertex_format == VertexFormat_Packed ? sizeof(PackedVertex) : sizeof(Vertex);
+  // compressed blocks only have to fit, the codecs check their own streams. A code byte per
+  // triangle and 2 header bits per 16 vertex bytes is as small as they get, which keeps a bad
+  // count from asking for more memory than the file could ever decode to
+  b32 stored_sizes = header.compressed ?
+    header.vertex_format == VertexFormat_Packed && header.vert_stored_size <= size && header.index_stored_size <= size &&
+    (u64)header.vert_count * sizeof(PackedVertex) / 64 <= header.vert_stored_size &&
+    header.index_count / 3 <= header.index_stored_size :
+    header.vert_stored_size == (u64)header.vert_count * vertex_size &&
+    header.index_stored_size == (u64)header.index_count * sizeof(u32);
+  // a mesh whose cook flags changed is cooked again
+  b32 valid = header.magic == MESH_CACHE_MAGIC && header.version == MESH_CACHE_VERSION &&
+              header.vertex_format == vertex_format && header.vertex_size == vertex_size &&
+              header.source_size == source.size && stored_sizes &&
+              header.vert_offset + header.vert_stored_size <= header.index_offset &&
+              header.index_offset + header.index_stored_size <= header.meshlet_offset &&
+              header.lod_count <= MESH_LOD_MAX &&
+              header.meshlet_offset + (u64)header.meshlet_count * sizeof(Meshlet) <= header.meshlet_bounds_offset &&
+              header.meshlet_bounds_offset + (u64)header.meshlet_count * sizeof(MeshletBounds) <= header.meshlet_vertex_offset &&
+              header.meshlet_vertex_offset + (u64)header.meshlet_vertex_count * sizeof(u32) <= header.meshlet_triangle_offset &&
+              header.meshlet_triangle_offset + (u64)header.meshlet_triangle_count * 3 <= size;
+  for (u32 i = 0; valid && i < header.lod_count; ++i) {
+    valid = (u64)header.lods[i].index_offset + header.lods[i].index_count <= header.index_count;
+  }
+  // the meshlets index into the blocks above, a bad offset would read out of the mapping
+  Meshlet* meshlets = (Meshlet*)((u8*)ptr + header.meshlet_offset);
+  for (u32 i = 0; valid && i < header.meshlet_count; ++i) {
+    Meshlet m = meshlets[i];
+    valid = (u64)m.vertex_offset + m.vertex_count <= header.meshlet_vertex_count &&
+            (u64)m.triangle_offset + m.triangle_count * 3 <= (u64)header.meshlet_triangle_count * 3;
+  }
+  b32 touched = false;
+  if (valid && header.source_modified != source.modified) {
+    // touched but maybe not changed, e.g. by a checkout, the content decides
+    valid = header.source_hash == vfs_content_hash(g_st->vfs, filepath);
+    touched = valid;
+  }
+  Mesh mesh = {};
+  if (!valid || !mesh_cache_mesh(arena, ptr, header, &mesh)) {
+    os_file_unmap(ptr, size);
+    return result;
+  }
+  result = {
+    .mesh = mesh,
+    .ptr = ptr,
+    .size = size,
+  };
+  if (touched) {
+    header.source_modified = source.modified;
+    mesh_cache_write(cache_path, header, result.mesh);
+  }
+  return result;
+}
+
+// safe on any thread, a cache hit leaves cached->ptr mapped until the mesh is uploaded
+intern Mesh mesh_read(Allocator arena, String name, MeshCookFlags cook_flags, MeshCacheMap* cached) {
+  GlobalState& g = *g_st;
+  Scratch scratch(arena);
+  String filepath = push_strf(scratch, "models/%s", name);
+  String cache_path = push_strf(scratch, "%s/%u64.mesh", g.mesh_cache_dir, hash(filepath));
+  FileProperties source = vfs_properties(g.vfs, filepath);
+  VertexFormat vertex_format = cook_flags & MeshCookFlag_Packed ? VertexFormat_Packed : VertexFormat_Full;
+  *cached = mesh_cache_open(arena, cache_path, filepath, source, vertex_format);
+  if (cached->ptr) {
+    atomic_u32_inc(&mesh_cache_hits);
+    return cached->mesh;
+  }
   Mesh mesh = {};
+  u64 source_hash = 0;
+  String format = str_skip_last_dot(name);
   if (str_match(format, "glb")) {
-    mesh = mesh_load_glb(scratch, filepath);
+    mesh = mesh_load_glb(arena, filepath, &source_hash);
   } else if (str_match(format, "gltf")) {
-    mesh = mesh_load_gltf(scratch, filepath);
+    mesh = mesh_load_gltf(arena, filepath, &source_hash);
   } else if (str_match(format, "obj")) {
-    mesh = mesh_load_obj(scratch, filepath);
+    mesh = mesh_load_obj(arena, filepath, &source_hash);
   } else {
     InvalidPath;
   }
+  if (vertex_format == VertexFormat_Packed) {
+    // before bounds, lods and meshlets are derived from the vertices, so they match what the gpu
+    // dequantizes. Packing the unpacked vertices again with the same quantization is exact
+    mesh.quantization = mesh_vertex_quantization(mesh.vertices, mesh.vert_count);
+    PackedVertex* packed = push_array(scratch, PackedVertex, mesh.vert_count);
+    mesh_encode_vertices(packed, mesh.vertices, mesh.vert_count, mesh.quantization);
+    mesh_decode_vertices(mesh.vertices, packed, mesh.vert_count, mesh.quantization);
+  }
+  // cooking happens once per source change, so the cost stays out of warm loads
+  VertexCacheStats before = mesh_vertex_cache_stats(mesh.indices, mesh.index_count, mesh.vert_count);
+  mesh_optimize(arena, &mesh);
+  VertexCacheStats after = mesh_vertex_cache_stats(mesh.indices, mesh.lods[0].index_count, mesh.vert_count);
+  LogEvent(Assets, Debug, "mesh optimized", log_kv("name", name), log_kv("acmr_before", before.acmr),
+           log_kv("acmr_after", after.acmr), log_kv("atvr_before", before.atvr), log_kv("atvr_after", after.atvr),
+           log_kv("lods", mesh.lod_count), log_kv("meshlets", mesh.meshlets.count));
+  if (vertex_format == VertexFormat_Packed) {
+    // optimize reordered the vertices, the gpu gets them packed like a warm load would
+    mesh.packed_vertices = push_array(arena, PackedVertex, mesh.vert_count);
+    mesh_encode_vertices(mesh.packed_vertices, mesh.vertices, mesh.vert_count, mesh.quantization);
+    mesh.vertices = null;
+  }
+  MeshCacheHeader header = {
+    .vertex_format = vertex_format,
+    .source_size = source.size,
+    .source_modified = source.modified,
+    .source_hash = source_hash,
+  };
+  mesh_cache_write(cache_path, header, mesh);
+  return mesh;
+}
+
+Handle<GpuMesh> mesh_load(String name, MeshCookFlags cook_flags) {
+  Scratch scratch;
+  u64 begin = cpu_timer_now();
+  MeshCacheMap cached;
+  Mesh mesh = mesh_read(scratch, name, cook_flags, &cached);
   Handle<GpuMesh> handle = vk_mesh_load(mesh);
+  os_file_unmap(cached.ptr, cached.size);
+  LogEvent(Assets, Debug, "mesh loaded", log_kv("name", name), log_kv("cached", (b32)(cached.ptr != null)),
+           log_kv("verts", mesh.vert_count), log_kv("indices", mesh.index_count),
+           log_kv("ms", tsc_to_ms(cpu_timer_now() - begin)));
   return handle;
 }
 
 Handle<GpuTexture> texture_load(String name) {
-  GlobalState& g = *g_st;
   Scratch scratch;
-  String filepath = push_strf(scratch, "%s/%s", g.textures_dir, name);
+  String filepath = push_strf(scratch, "textures/%s", name);
+  u64 begin = cpu_timer_now();
   Texture texture = texture_image_load(filepath);
   Handle<GpuTexture> handle = vk_texture_load(texture);
+  LogEvent(Assets, Debug, "texture loaded", log_kv("name", name), log_kv("width", texture.width),
+           log_kv("height", texture.height), log_kv("ms", tsc_to_ms(cpu_timer_now() - begin)));
   return handle;
 }
 
 Handle<GpuCubemap> cubemap_load(String name) {
-  GlobalState& g = *g_st;
   Scratch scratch;
   Texture textures[6];
   String sides[] = {
@@ -467,26 +790,101 @@ Handle<GpuCubemap> cubemap_load(String name) {
   };
   for EachElement(i, textures) {
     String texture_name = push_strf(scratch, "%s/%s%s", name, sides[i], String(".png"));
-    String filepath = push_strf(scratch, "%s/%s", g.textures_dir, texture_name);
+    String filepath = push_strf(scratch, "textures/%s", texture_name);
     textures[i] = texture_image_load(filepath);
   }
   vk_cubemap_load(textures);
   return {};
 }
 
+// Reads and decodes fan out to the pool, the main thread owns the gpu and uploads whatever
+// has finished in batches. Each material waits only on its own texture.
+const u32 ASSET_JOBS_MAX = 64;
+static_assert(Mesh_Load_COUNT + Texture_COUNT <= ASSET_JOBS_MAX);
+
+enum AssetKind {
+  AssetKind_Mesh,
+  AssetKind_Texture,
+};
+
+struct AssetJob {
+  AssetKind kind;
+  u32 id;
+  String name;
+  Arena arena;
+  Mesh mesh;
+  MeshCacheMap cached;
+  Texture texture;
+  MeshCookFlags cook_flags;
+  u64 tsc; // read and decode, on the worker
+  MPMCQueue<u32, ASSET_JOBS_MAX>* ready;
+  u32 idx;
+  // streaming only, the worker skips a cancelled job and gives meshes an index buffer
+  u32 cancelled;
+  b32 streamed;
+};
+
+struct AssetLoader {
+  MPMCQueue<u32, ASSET_JOBS_MAX> ready;
+  AssetJob jobs[ASSET_JOBS_MAX];
+  u32 job_count;
+};
+
+intern void asset_job(void* arg) {
+  AssetJob& job = *(AssetJob*)arg;
+  if (atomic_u32_load(&job.cancelled)) {
+    job.ready->push(job.idx);
+    return;
+  }
+  TimeBlockRuntime(job.name);
+  u64 begin = cpu_timer_now();
+  if (job.kind == AssetKind_Mesh) {
+    job.mesh = mesh_read(job.arena, job.name, job.cook_flags, &job.cached);
+    // placeholders are indexed, the replacement has to be too
+    if (job.streamed && !job.mesh.indices) {
+      job.mesh.indices = push_array(job.arena, u32, job.mesh.vert_count);
+      Loop (i, job.mesh.vert_count) job.mesh.indices[i] = i;
+      job.mesh.index_count = job.mesh.vert_count;
+    }
+  } else {
+    Scratch scratch;
+    job.texture = texture_image_load(push_strf(scratch, "textures/%s", job.name));
+  }
+  job.tsc = cpu_timer_now() - begin;
+  job.ready->push(job.idx);
+}
+
+intern void asset_job_push(AssetLoader* loader, AssetKind kind, u32 id, String name, MeshCookFlags cook_flags = 0) {
+  u32 idx = loader->job_count++;
+  AssetJob& job = loader->jobs[idx];
+  job = {
+    .kind = kind,
+    .id = id,
+    .name = name,
+    .cook_flags = cook_flags,
+    .ready = &loader->ready,
+    .idx = idx,
+  };
+  // arenas are made here, the allocator tracking list isn't thread safe
+  if (kind == AssetKind_Mesh) {
+    job.arena = arena_init_named(name);
+  }
+  task_queue_push({.func = asset_job, .arg = &job});
+}
+
 void asset_load() {
   GlobalState& g = *g_st;
-#define X(enum_name, name) \
-  g.meshes_handlers[enum_name] = mesh_load(meshes_strs[enum_name]); \
-  g.str_to_mesh.add(Stringify(name), g.meshes_handlers[enum_name]);
-  MESH_LIST
-#undef X
-
-#define X(enum_name, name) \
-  g.textures_handlers[enum_name] = texture_load(textures_strs[enum_name]); \
-  g.str_to_texture.add(Stringify(name), g.textures_handlers[enum_name]);
-  TEXTURE_LIST
-#undef X
+  Scratch scratch;
+  u64 begin = cpu_timer_now();
+  mesh_cache_hits = 0;
+  AssetLoader* loader = push_struct_zero(scratch, AssetLoader);
+  loader->ready.init();
+  Loop (i, Mesh_Load_COUNT) {
+    asset_job_push(loader, AssetKind_Mesh, i, meshes_strs[i], meshes_cook_flags[i]);
+  }
+  Loop (i, Texture_COUNT) {
+    asset_job_push(loader, AssetKind_Texture, i, textures_strs[i]);
+  }
 
   struct TakeMaterial { \
     String name = "e_texture";
@@ -506,18 +904,269 @@ void asset_load() {
       };
     }
   };
+  Material materials[Material_COUNT];
 #define X(enum_name, ...) \
   { \
     TakeMaterial mat = { \
       __VA_ARGS__ \
     }; \
-    Handle<GpuTexture>* texture_hanle = g.str_to_texture.get(mat.texture); \
-    if (texture_hanle) \
-      mat.texture_handle = *texture_hanle; \
-    g.materials_handlers[enum_name] = vk_material_load(mat); \
+    materials[enum_name] = mat; \
   }
   MATERIAL_LIST
 #undef X
+  // -1 once loaded, Texture_COUNT when there is no texture to wait for
+  i32 material_texture[Material_COUNT];
+  Loop (m, Material_COUNT) {
+    material_texture[m] = Texture_COUNT;
+    Loop (t, Texture_COUNT) {
+      if (str_match(materials[m].texture, textures_strs[t])) material_texture[m] = t;
+    }
+    if (material_texture[m] == Texture_COUNT) {
+      g.materials_handlers[m] = vk_material_load(materials[m]);
+      material_texture[m] = -1;
+    }
+  }
+
+  u32 remaining = loader->job_count;
+  u32 batch[ASSET_JOBS_MAX];
+  while (remaining) {
+    // the main thread helps with reads until something is ready to upload
+    while (!loader->ready.try_pop(&batch[0])) {
+      if (!task_queue_try_run()) {
+        batch[0] = loader->ready.pop();
+        break;
+      }
+    }
+    u32 batch_count = 1;
+    while (loader->ready.try_pop(&batch[batch_count])) batch_count++;
+    TimeBlock("asset upload");
+    Loop (i, batch_count) {
+      AssetJob& job = loader->jobs[batch[i]];
+      Atom atom = atom_from_str(job.name);
+      if (job.kind == AssetKind_Mesh) {
+        g.meshes_handlers[job.id] = vk_mesh_load(job.mesh);
+        g.str_to_mesh.add(atom, g.meshes_handlers[job.id]);
+        os_file_unmap(job.cached.ptr, job.cached.size);
+        arena_deinit(&job.arena);
+        LogEvent(Assets, Debug, "mesh loaded", log_kv("name", job.name), log_kv("cached", (b32)(job.cached.ptr != null)),
+                 log_kv("verts", job.mesh.vert_count), log_kv("indices", job.mesh.index_count),
+                 log_kv("read_ms", tsc_to_ms(job.tsc)));
+      } else {
+        Handle<GpuTexture> handle = vk_texture_load(job.texture);
+        g.textures_handlers[job.id] = handle;
+        g.str_to_texture.add(atom, handle);
+        Loop (m, Material_COUNT) {
+          if (material_texture[m] != (i32)job.id) continue;
+          materials[m].texture_handle = handle;
+          g.materials_handlers[m] = vk_material_load(materials[m]);
+          material_texture[m] = -1;
+        }
+        LogEvent(Assets, Debug, "texture loaded", log_kv("name", job.name), log_kv("width", job.texture.width),
+                 log_kv("height", job.texture.height), log_kv("read_ms", tsc_to_ms(job.tsc)));
+      }
+    }
+    remaining -= batch_count;
+  }
+  // cold is every mesh parsed and cooked, warm is every mesh mapped from the cache
+  Log(Assets, Info, "assets: %u jobs on %u threads, meshes %u/%u from cache, %.2f ms, peak rss %u64 MB", loader->job_count,
+      thread_pool_count(), mesh_cache_hits, (u32)Mesh_Load_COUNT, tsc_to_ms(cpu_timer_now() - begin), os_peak_rss() / MB(1));
+}
+
+///////////////////////////////////
+// Asset streaming
+
+// Requests wait here until there is room on the pool, highest priority first. Finished
+// reads are uploaded from asset_stream_update within the frame budget; one asset always
+// goes through so a large one can't stall forever.
+const u32 ASSET_STREAM_MAX = ASSET_JOBS_MAX;
+const u32 ASSET_STREAM_IN_FLIGHT_PER_THREAD = 2;
+const u64 ASSET_STREAM_FRAME_BUDGET = MB(8);
+
+enum AssetStreamState {
+  AssetStreamState_Free,
+  AssetStreamState_Queued,
+  AssetStreamState_Loading,
+  AssetStreamState_Ready,
+};
+
+struct AssetStreamSlot {
+  AssetJob job;
+  AssetStreamState state;
+  AssetPriority priority;
+  u32 seq;
+  String64 name;
+};
+
+struct AssetStreamer {
+  MPMCQueue<u32, ASSET_STREAM_MAX> ready;
+  AssetStreamSlot slots[ASSET_STREAM_MAX];
+  u32 seq;
+  u32 in_flight;
+  u64 frame_budget;
+  Handle<GpuMesh> mesh_placeholder;
+  Handle<GpuTexture> texture_placeholder;
+};
+
+void asset_stream_init() {
+  GlobalState& g = *g_st;
+  AssetStreamer* s = push_struct_zero(g.arena, AssetStreamer);
+  s->ready.init();
+  s->frame_budget = ASSET_STREAM_FRAME_BUDGET;
+  s->mesh_placeholder = mesh_get(Mesh_Sphere);
+  // magenta checker, obviously not the real thing
+  u32 checker[8*8];
+  Loop (i, ArrayCount(checker)) {
+    checker[i] = ((i ^ (i >> 3)) & 1) ? 0xFFFF00FF : 0xFF000000;
+  }
+  s->texture_placeholder = vk_texture_load({.width = 8, .height = 8, .data = (u8*)checker});
+  g.streamer = s;
+}
+
+void asset_stream_set_budget(u64 bytes) {
+  g_st->streamer->frame_budget = bytes;
+}
+
+u32 asset_stream_pending() {
+  AssetStreamer& s = *g_st->streamer;
+  u32 result = 0;
+  Loop (i, ASSET_STREAM_MAX) {
+    if (s.slots[i].state != AssetStreamState_Free) ++result;
+  }
+  return result;
+}
+
+intern b32 asset_stream_request(AssetKind kind, u32 handle, String name, AssetPriority priority,
+                                MeshCookFlags cook_flags = 0) {
+  AssetStreamer& s = *g_st->streamer;
+  Loop (i, ASSET_STREAM_MAX) {
+    AssetStreamSlot& slot = s.slots[i];
+    if (slot.state != AssetStreamState_Free) continue;
+    str_copy(slot.name, name);
+    slot.state = AssetStreamState_Queued;
+    slot.priority = priority;
+    slot.seq = s.seq++;
+    slot.job = {
+      .kind = kind,
+      .id = handle,
+      .name = slot.name,
+      .cook_flags = cook_flags,
+      .ready = &s.ready,
+      .idx = (u32)i,
+      .streamed = true,
+    };
+    return true;
+  }
+  Log(Assets, Warn, "asset stream full, %s stays a placeholder", name);
+  return false;
+}
+
+Handle<GpuMesh> mesh_load_async(String name, AssetPriority priority, MeshCookFlags cook_flags) {
+  AssetStreamer& s = *g_st->streamer;
+  // slots are never shared, replacing one can't change what other meshes draw
+  Handle<GpuMesh> handle = vk_mesh_placeholder(s.mesh_placeholder);
+  asset_stream_request(AssetKind_Mesh, handle.handle, name, priority, cook_flags);
+  return handle;
+}
+
+Handle<GpuTexture> texture_load_async(String name, AssetPriority priority) {
+  AssetStreamer& s = *g_st->streamer;
+  Handle<GpuTexture> handle = vk_texture_placeholder(s.texture_placeholder);
+  asset_stream_request(AssetKind_Texture, handle.handle, name, priority);
+  return handle;
+}
+
+intern void asset_stream_release(AssetStreamSlot& slot) {
+  AssetJob& job = slot.job;
+  if (job.kind == AssetKind_Mesh) {
+    os_file_unmap(job.cached.ptr, job.cached.size);
+    arena_deinit(&job.arena);
+  } else if (job.texture.data) {
+    stbi_image_free(job.texture.data);
+  }
+  slot.state = AssetStreamState_Free;
+}
+
+intern void asset_stream_cancel(AssetKind kind, u32 handle) {
+  AssetStreamer& s = *g_st->streamer;
+  Loop (i, ASSET_STREAM_MAX) {
+    AssetStreamSlot& slot = s.slots[i];
+    if (slot.state == AssetStreamState_Free || slot.job.kind != kind || slot.job.id != handle) continue;
+    if (slot.state == AssetStreamState_Queued) {
+      slot.state = AssetStreamState_Free;
+    } else if (slot.state == AssetStreamState_Ready) {
+      asset_stream_release(slot);
+    } else {
+      // the worker still owns it, released when it comes back through the ready queue
+      atomic_u32_inc(&slot.job.cancelled);
+    }
+  }
+}
+
+void mesh_load_cancel(Handle<GpuMesh> handle)       { asset_stream_cancel(AssetKind_Mesh, handle.handle); }
+void texture_load_cancel(Handle<GpuTexture> handle) { asset_stream_cancel(AssetKind_Texture, handle.handle); }
+
+// highest priority, then oldest
+intern AssetStreamSlot* asset_stream_next(AssetStreamState state) {
+  AssetStreamer& s = *g_st->streamer;
+  AssetStreamSlot* best = null;
+  Loop (i, ASSET_STREAM_MAX) {
+    AssetStreamSlot& slot = s.slots[i];
+    if (slot.state != state) continue;
+    if (!best || slot.priority > best->priority ||
+        (slot.priority == best->priority && (i32)(slot.seq - best->seq) < 0)) {
+      best = &slot;
+    }
+  }
+  return best;
+}
+
+intern u64 asset_stream_size(AssetJob& job) {
+  if (job.kind == AssetKind_Mesh) {
+    return (u64)job.mesh.vert_count * sizeof(Vertex) + (u64)job.mesh.index_count * sizeof(u32);
+  }
+  return (u64)job.texture.width * job.texture.height * 4;
+}
+
+void asset_stream_update() {
+  TimeFunction;
+  AssetStreamer& s = *g_st->streamer;
+  u32 idx;
+  while (s.ready.try_pop(&idx)) {
+    AssetStreamSlot& slot = s.slots[idx];
+    s.in_flight--;
+    slot.state = AssetStreamState_Ready;
+    if (atomic_u32_load(&slot.job.cancelled)) {
+      asset_stream_release(slot);
+    }
+  }
+
+  u64 uploaded = 0;
+  while (AssetStreamSlot* slot = asset_stream_next(AssetStreamState_Ready)) {
+    AssetJob& job = slot->job;
+    u64 size = asset_stream_size(job);
+    if (uploaded && uploaded + size > s.frame_budget) break;
+    uploaded += size;
+    if (job.kind == AssetKind_Mesh) {
+      vk_mesh_replace({job.id}, job.mesh);
+    } else {
+      vk_texture_replace({job.id}, job.texture);
+    }
+    LogEvent(Assets, Debug, "asset streamed", log_kv("name", job.name), log_kv("bytes", size),
+             log_kv("priority", (u32)slot->priority), log_kv("read_ms", tsc_to_ms(job.tsc)));
+    asset_stream_release(*slot);
+  }
+
+  while (s.in_flight < thread_pool_count() * ASSET_STREAM_IN_FLIGHT_PER_THREAD) {
+    AssetStreamSlot* slot = asset_stream_next(AssetStreamState_Queued);
+    if (!slot) break;
+    // arenas are made here, the allocator tracking list isn't thread safe
+    if (slot->job.kind == AssetKind_Mesh) {
+      slot->job.arena = arena_init_named(slot->job.name);
+    }
+    slot->state = AssetStreamState_Loading;
+    s.in_flight++;
+    task_queue_push({.func = asset_job, .arg = &slot->job});
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -771,7 +1420,7 @@ void profiler_draw_frame(Slice<ProfileAnchor> anchors, ProfileFrameTime frame_ti
       draw->AddRect(IM_RECT(rect), IM_COL32(200, 200, 200, 255));
       if (contains_2f32(rect, mouse)) {
         ImGui::BeginTooltip();
-        ImGui::Text("Label: %s", anchor.label.str);
+        ImGui::Text("Label: %s", atom_str(anchor.label).str);
         ImGui::Text("Percent: %f%%", width_percent * 100);
         // ImGui::Text("Hits: %lu", anchor.hit_count);
         ImGui::Text("Time: %fms", (f64)anchor.tsc_elapsed_inclusive / cpu_freq * 1000);
@@ -780,7 +1429,7 @@ void profiler_draw_frame(Slice<ProfileAnchor> anchors, ProfileFrameTime frame_ti
         ImGui::EndTooltip();
       }
       if (width_percent > 0.05 || width_percent_with_children > 0.05) {
-        ImString str = push_strf(scratch, "%s %.3f", anchor.label, (f64)anchor.tsc_elapsed_inclusive / cpu_freq * 1000);
+        ImString str = push_strf(scratch, "%s %.3f", atom_str(anchor.label), (f64)anchor.tsc_elapsed_inclusive / cpu_freq * 1000);
         v2 text_size = ImGui::CalcTextSize(str);
         v2 text_pos = {};
         if (text_size.x > size.x) {
@@ -856,10 +1505,11 @@ void profiler_view() {
             ui_handle_scroll(scroll_state, mouse_pos);
           }
           ImGui::Text("%.1ffps %.1fms CPU %.1fGhz", 1 / get_dt(), tsc_to_ms(tsc_elapsed), (f64)cpu_freq / Billion(1));
-          ImGui::Text("avg %.1fms, max %.1f, min %.1f", g.frame_avg_time, g.frame_max_time, g.frame_min_time);
+          ImGui::Text("avg %.1fms, max %.1f, min %.1f, %llu triangles", g.frame_avg_time, g.frame_max_time, g.frame_min_time,
+                      (unsigned long long)vk_triangles_drawn());
           f32 info_height = 40;
           cursor_pos.y += info_height;
-          for EachElement(i, g.prof_threads) {
+          Loop (i, thread_pool_count() + 1) {
             ProfileThread prof_thread = g.prof_threads[i];
             var anchors = prof_thread.recorded_anchors[(g_st->current_frame-1) % ArrayCount(g.frames_times)].slice();
             profiler_draw_frame(anchors, prev_frame.frame_time, avail_size.x, cursor_pos, scroll_state);
@@ -945,7 +1595,7 @@ void profiler_view() {
             draw->AddText(text_pos, ImGui::GetColorU32(ImGuiCol_Text), str);
           }
           {
-            Loop (i, THREAD_COUNT) {
+            Loop (i, thread_pool_count()) {
               thread_height_offset += thread_height;
               ImString str = push_strf(scratch, "Worker %i", i);
               v2 text_pos = (v2(0, thread_height_offset - 20) + cursor_pos) * scroll_state.scale + v2(0, + scroll_state.offset.y);
@@ -956,7 +1606,7 @@ void profiler_view() {
 
           ///////////////////////////////////
           // Draw graph per thread
-          for EachElement(i, g.prof_threads) {
+          Loop (i, thread_pool_count() + 1) {
             f32 width_offset = 0;
             ProfileThread prof_thread = g.prof_threads[i];
             for EachElement(j, g.frames_times) {
@@ -991,7 +1641,7 @@ void profiler_view() {
             draw->AddRectFilled(IM_RECT(rect), IM_COL32(50, 50, 50, 255));
             draw->AddRect(IM_RECT(rect), IM_COL32(200, 200, 200, 255));
 
-            ImString name_str = push_strf(scratch, "%s", anchor.label);
+            ImString name_str = push_strf(scratch, "%s", atom_str(anchor.label));
             ImString ms_str = push_strf(scratch, "%.3fms", (f64)anchor.tsc_elapsed_exclusive / cpu_freq * 1000);
             v2 name_offset = v2(0, height * i) + cursor_pos;
             v2 ms_offset = v2(avail_size.x * 0.82, height * i) + cursor_pos;
@@ -1181,6 +1831,9 @@ void profiler_view() {
                   ImGui::Text("%s", inclusive.str);
                   ImString exclusive = push_strf(scratch, "exclusive: %.2f%s", pos_exclusive.size, pos_exclusive.format);
                   ImGui::Text("%s", exclusive.str);
+                  MemFormatSize copied = mem_format_size(info.realloc_copied);
+                  ImString reallocs = push_strf(scratch, "reallocs: %u64, in place: %u64, copied: %.2f%s", info.reallocs, info.reallocs_in_place, copied.size, copied.format);
+                  ImGui::Text("%s", reallocs.str);
                   ImGui::EndTooltip();
                 }
               } break;
@@ -1205,7 +1858,7 @@ void profiler_view() {
                 MemFormatSize pos = mem_format_size(info.pos);
                 MemFormatSize cap = mem_format_size(info.cap);
                 ImString child_name_str = push_strf(scratch, "%s", info.name);
-                ImString child_meta_str = push_strf(scratch, "%.2f%s pos, %.2f%s cap, alloc count: %u, free count: %u, current alloc count: %u", pos.size, pos.format, cap.size, cap.format, info.allocs, info.frees, info.current_allocs);
+                ImString child_meta_str = push_strf(scratch, "%.2f%s pos, %.2f%s cap, alloc count: %u64, free count: %u64, current alloc count: %u64", pos.size, pos.format, cap.size, cap.format, info.allocs, info.frees, info.current_allocs);
                 draw->AddText(child_rect.min, ImGui::GetColorU32(ImGuiCol_Text), child_name_str);
                 draw->AddText(slice_x_2f32(child_rect, 0.3, 1).min, ImGui::GetColorU32(ImGuiCol_Text), child_meta_str);
               } break;
@@ -1251,11 +1904,13 @@ void watch_directory_add(String watch_name, WatchOp op, OS_WatchFlags flags) {
 void watch_update() {
   WatchState& g = g_st->watch;
   Scratch scratch;
+  LogEvery(600, Hotreload, Trace, "watching %u files, %u directories", g.watches.count, g.directories.count);
   for (WatchFile& x : g.watches) {
     FileProperties props = os_file_path_properties(x.path);
     if (props.modified > x.modified) {
       switch (x.op) {
         case WatchOp_NotifyHotreload: {
+          Log(Hotreload, Info, "%s changed, reloading", x.path);
           g_st->should_hotreload = true;
         } break;
         InvalidDefaultCase break;
@@ -1279,11 +1934,13 @@ void watch_update() {
           str_list_push(scratch, &list, shader_filepath);
           str_list_push(scratch, &list, "-o");
           str_list_push(scratch, &list, shader_compiled_filepath);
+          Log(Hotreload, Debug, "recompiling %s", name);
           os_process_launch(list);
         } break;
         case WatchOp_ShaderReload: {
           String shader_name_with_format = str_chop_last_dot(name);
           String shader_name = str_chop_last_dot(shader_name_with_format);
+          Log(Hotreload, Debug, "reloading shader %s", shader_name);
           vk_shader_reload(shader_name);
         } break;
         InvalidDefaultCase break;
@@ -1301,36 +1958,53 @@ void common_init() {
   profiler_launch_begin();
   {
     TimeBlock("init");
-    test();
-
-    g.gpa.init(g.arena);
-    g.transforms = push_array(g.arena, Transform, MaxEntities);
-    g.static_transforms = push_array(g.arena, Transform, MaxStaticEntities);
+    // before the benches, they load the bundled models
     g.asset_path = push_strf(g.arena, "%s/%s", os_get_current_directory(), String("../assets"));
     g.shader_dir = push_str_cat(g.arena, g.asset_path, "/shaders");
     g.shader_compiled_dir = push_str_cat(g.arena, g.shader_dir, "/compiled");
     g.models_dir = push_str_cat(g.arena, g.asset_path, "/models");
     g.textures_dir = push_str_cat(g.arena, g.asset_path, "/textures");
-    g.str_to_texture.init(g.gpa);
-    g.str_to_mesh.init(g.gpa);
-    g.str_to_material.init(g.gpa);
+    g.vfs = vfs_init(g.arena, g.asset_path, push_str_cat(g.arena, g.asset_path, ".pack"));
+    g.mesh_cache_dir = push_str_cat(g.arena, os_get_current_directory(), "/cache/meshes");
+    if (!os_directory_path_exist(g.mesh_cache_dir)) {
+      os_directory_create_p(g.mesh_cache_dir);
+    }
+
+    test();
+#if BENCH_BUILD
+    bench();
+#endif
+
+    g.gpa.init(g.arena);
+    g.transforms = push_array(g.arena, Transform, MaxEntities);
+    g.static_transforms = push_array(g.arena, Transform, MaxStaticEntities);
+    g.str_to_texture.init();
+    g.str_to_mesh.init();
+    g.str_to_material.init();
 
     g.watch.arena = g.arena;
     watch_directory_add(g.shader_dir, WatchOp_RecompileShader);
     watch_directory_add(g.shader_compiled_dir, WatchOp_ShaderReload);
+    // reloads have to see the edited spir-v, not the packed one
+    vfs_prefer_loose(g.vfs, "shaders");
 
     g.profile_win.root_scroll_state.scale = 1;
     g.profile_win.frames_scroll_state.scale = 1;
     g.profile_win.mem_scroll_state.scale = 1;
     g.profile_win.open = true;
 
-    thread_pool_init(THREAD_COUNT);
+    // one worker per core, the main thread also runs tasks while it waits
+    thread_pool_init(os_get_cpu_count() - 1);
+    log_init(push_str_cat(g.arena, os_get_current_directory(), "/log.txt"));
 
     g.vk_st = vk_init();
 #if DEAR_IMGUI
     vk_imgui_init();
 #endif
     game_init();
+#if BUILD_DEBUG
+    test_asset_stream(meshes_strs[0], textures_strs[0]);
+#endif
   }
   profiler_launch_end();
 }
@@ -1348,6 +2022,7 @@ void foo(f32 time) {
 
 void common_update() {
   input_update();
+  asset_stream_update();
   profiler_view();
   if (key_pressed(Key_F3)) g_st->imgui_demo_open = !g_st->imgui_demo_open;
   if (g_st->imgui_demo_open) {
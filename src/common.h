@@ -1,5 +1,6 @@
 #pragma once
 #include "lib.h"
+#include "pack.h"
 
 #define IM_VEC2_CLASS_EXTRA                               \
         constexpr ImVec2(const v2& f) : x(f.x), y(f.y) {} \
@@ -93,11 +94,74 @@ struct Vertex {
 u64 hash(Vertex vert);
 b32 equal(Vertex a, Vertex b);
 
+// Positions are 16 bit fractions of the mesh's bounds on each axis, normals octahedral in two
+// snorm16s, uvs half floats and colors unorm8. 20 bytes against the 44 of a Vertex. Errors are
+// half a step of each: bounds / 131070 on each axis, under 1e-4 radians on normals, 2^-12 on
+// uvs within 0..1 and 1/510 on colors. The gpu reads the rows as they are, see vertex_unpack
+// in com.slang.
+struct PackedVertex {
+  u16 pos[4];  // w is padding, the row reads as one R16G16B16A16 unorm
+  i16 norm[2];
+  u16 uv[2];
+  u8 color[4]; // alpha is padding
+};
+
+// pos = offset + q / 65535 * scale
+struct VertexQuantization {
+  v3 offset;
+  v3 scale;
+};
+
+// coarser index lists over the same vertices, lod 0 is full detail
+const u32 MESH_LOD_MAX = 4;
+
+struct MeshLod {
+  u32 index_offset; // into the mesh's indices
+  u32 index_count;
+  f32 error;        // in the mesh's units
+};
+
+// clusters of lod 0 small enough for one mesh shader workgroup, culled as a whole
+const u32 MESHLET_MAX_VERTICES  = 64;
+const u32 MESHLET_MAX_TRIANGLES = 124;
+
+struct Meshlet {
+  u32 vertex_offset;   // into Meshlets::vertices
+  u32 triangle_offset; // into Meshlets::triangles, 3 bytes a triangle
+  u32 vertex_count;
+  u32 triangle_count;
+};
+
+// all triangles face away when dot(normalize(cone_apex - camera), cone_axis) >= cone_cutoff
+struct MeshletBounds {
+  v3 center;
+  f32 radius;
+  v3 cone_apex;
+  v3 cone_axis;
+  f32 cone_cutoff; // 1 when the normals spread too far to ever cull
+};
+
+struct Meshlets {
+  Meshlet* meshlets;
+  MeshletBounds* bounds;
+  u32* vertices; // into the mesh's vertices
+  u8* triangles; // into the meshlet's own vertices
+  u32 count;
+  u32 vertex_count;
+  u32 triangle_count;
+};
+
 struct Mesh {
   Vertex* vertices;
   u32* indices;
   u32 vert_count;
-  u32 index_count;
+  u32 index_count; // of all lods
+  u32 lod_count;   // 0 until cooked, one lod over every index
+  MeshLod lods[MESH_LOD_MAX];
+  Meshlets meshlets;
+  // instead of vertices when the mesh was cooked with MeshCookFlag_Packed
+  PackedVertex* packed_vertices;
+  VertexQuantization quantization;
 };
 
 enum ShaderType {
@@ -164,13 +228,19 @@ f32 get_time();
 ////////////////////////////////////////////////////////////////////////
 // @Assets
 
+// how a mesh is cooked into the mesh cache
+typedef u32 MeshCookFlags;
+enum {
+  MeshCookFlag_Packed = Bit(0), // vertices quantized to PackedVertex, lossy, less than half to read, upload and keep on the gpu
+};
+
 #define MESH_LIST \
-  X(Mesh_MonkeyGlb, monkey.glb) \
-  X(Mesh_Cube, cube.glb) \
-  // X(Mesh_Castle, castle.obj) \
+  X(Mesh_MonkeyGlb, monkey.glb, MeshCookFlag_Packed) \
+  X(Mesh_Cube, cube.glb, 0) \
+  // X(Mesh_Castle, castle.obj, 0) \
 
 enum MeshId {
-#define X(enum_name, name) enum_name,
+#define X(enum_name, name, cook_flags) enum_name,
   MESH_LIST
 #undef X
   Mesh_Load_COUNT,
@@ -211,11 +281,31 @@ enum MaterialId {
 Handle<GpuMesh> mesh_get(MeshId id);
 void mesh_set(MeshId id, Handle<GpuMesh> mesh_handle);
 Handle<GpuMaterial> material_get(MaterialId id);
-Handle<GpuMesh> mesh_load(String name);
+Handle<GpuMesh> mesh_load(String name, MeshCookFlags cook_flags = 0);
 Handle<GpuShader> shader_load(Shader shader);
 Handle<GpuCubemap> cubemap_load(String name);
 void asset_load();
 
+// Streaming, the handle is usable right away and shows a placeholder until the asset is in
+enum AssetPriority {
+  AssetPriority_Low,
+  AssetPriority_Normal,
+  AssetPriority_High,
+};
+
+struct AssetStreamer;
+void asset_stream_init();
+// once per frame, uploads what has been read within the byte budget
+void asset_stream_update();
+void asset_stream_set_budget(u64 bytes);
+// requests not uploaded or released yet
+u32  asset_stream_pending();
+Handle<GpuMesh> mesh_load_async(String name, AssetPriority priority = AssetPriority_Normal, MeshCookFlags cook_flags = 0);
+Handle<GpuTexture> texture_load_async(String name, AssetPriority priority = AssetPriority_Normal);
+// the handle keeps the placeholder, does nothing once the asset is in
+void mesh_load_cancel(Handle<GpuMesh> handle);
+void texture_load_cancel(Handle<GpuTexture> handle);
+
 ////////////////////////////////////////////////////////////////////////
 // @Input
 
@@ -416,9 +506,12 @@ struct GlobalState {
   String shader_compiled_dir;
   String models_dir;
   String textures_dir;
-  Map<String, Handle<GpuTexture>> str_to_texture;
-  Map<String, Handle<GpuMesh>> str_to_mesh;
-  Map<String, Handle<GpuMaterial>> str_to_material;
+  String mesh_cache_dir;
+  Vfs* vfs;
+  ConcurrentMap<Atom, Handle<GpuTexture>> str_to_texture;
+  ConcurrentMap<Atom, Handle<GpuMesh>> str_to_mesh;
+  ConcurrentMap<Atom, Handle<GpuMaterial>> str_to_material;
+  AssetStreamer* streamer;
 
   ThreadPool thread_pool;
   WatchState watch;
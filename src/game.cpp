@@ -332,7 +332,7 @@ void scene_init() {
     // u32 range = KB(1);
     // e.pos() = v3_rand_range(-v3_scale(range), v3_scale(range));
     MeshId meshes[] = {
-      // Mesh_MonkeyGlb,
+      Mesh_MonkeyGlb,
       // Mesh_Triangle,
       Mesh_Cube,
     };
@@ -495,6 +495,7 @@ void game_init() {
   mesh_set(Mesh_Sphere, vk_mesh_load(sphere));
   cubemap_load("night_cubemap");
   asset_load();
+  asset_stream_init();
   scene_init();
 }
 
@@ -11,117 +11,469 @@ enum JsonType {
   JsonType_End,
 };
 
+// One tape entry per value, key and container end. Members of a container follow it, keys and
+// values alternating in objects, and its End entry closes them.
+struct JsonNode {
+  JsonType type;
+  u32 next;    // entry after this value and everything inside it, the next sibling or End
+  String str;  // string contents with escapes resolved, raw text of numbers and literals
+  f64 number;
+};
+
 struct JsonValue {
   JsonType type;
   String str;
-  i32 depth;
+  f64 number;
+  u32 idx; // tape entry, 0 is the root and never a member, so 0 also means "before the first"
   b32 match(String name) { return str_match(str, name); };
 };
 
 struct JsonReader {
-  u8* cur;
-  u8* end;
-  i32 depth;
+  JsonNode* tape;
+  u32 count;
+  u8* strings; // end of the unescaped strings, they follow the tape
+  u64 mem_size;
   String error;
   JsonValue base_obj;
 };
 
+// the tape and unescaped strings go to a mapping of the reader's own, sized by a counting pass
+// over buffer, strings without escapes point into buffer
 JsonReader json_reader_init(String buffer);
+void json_reader_deinit(JsonReader* r);
 b32 json_iter_object(JsonReader* r, JsonValue obj, JsonValue *key, JsonValue *val);
 b32 json_iter_array(JsonReader* r, JsonValue arr, JsonValue* val);
 
-#define JSON_OBJ(r, o) for (JsonValue k, v; json_iter_object(&r, o, &k, &v);)
-#define JSON_OBJ_(r, o) for (JsonValue key, val; json_iter_object(&r, o, &key, &val);)
-#define JSON_ARR(r, val) for (JsonValue obj; json_iter_array(&r, val, &obj);)
-
-// https://github.com/rxi/sj.h.git
-JsonValue json_read(JsonReader* r) {
-  JsonValue res = {};
-  top:
-  if (r->error.str) { return { .type = JsonType_Error, .str = str_range(r->cur, r->end)}; }
-  u8* start = r->cur;
-  switch (*r->cur) {
-    case ' ': case '\n': case '\r': case '\t':
-    case ':': case ',': {
-      ++r->cur;
-      goto top;
+#define JSON_OBJ(r, o) for (JsonValue k = {}, v = {}; json_iter_object(&r, o, &k, &v);)
+#define JSON_OBJ_(r, o) for (JsonValue key = {}, val = {}; json_iter_object(&r, o, &key, &val);)
+#define JSON_ARR(r, val) for (JsonValue obj = {}; json_iter_array(&r, val, &obj);)
+
+const u32 JSON_MAX_DEPTH = 1024;
+// stage 1 hands stage 2 this many bytes' worth of indices at a time, a multiple of 64
+const u64 JSON_CHUNK_SIZE = KB(64);
+
+////////////////////////////////////////////////////////////////////////
+// Stage 1
+// NOTE: 64 bytes per step, each byte class becomes one bit of a u64 mask. Quotes that aren't
+// escaped toggle a prefix-xor in-string mask, and the offsets of structural characters, quotes
+// and scalar starts outside strings go to an index list. Only stage 2 looks at bytes again.
+// The input goes through twice, once only counting to size the tape, then a chunk at a time so
+// the index list stays JSON_CHUNK_SIZE long whatever the input.
+
+struct JsonBlock {
+  u64 quote;
+  u64 backslash;
+  u64 structural; // {}[]:,
+  u64 space;
+};
+
+#if SIMD_AVX2
+intern void json_classify_32(u8* p, u32* masks) {
+  __m256i v = _mm256_loadu_si256((__m256i*)p);
+  // '[' | 0x20 is '{' and ']' | 0x20 is '}', no other byte maps to either
+  __m256i folded = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+  __m256i brace = _mm256_or_si256(_mm256_cmpeq_epi8(folded, _mm256_set1_epi8('{')), _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('}')));
+  __m256i punct = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(':')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8(',')));
+  __m256i space = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))),
+                                  _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))));
+  masks[0] = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')));
+  masks[1] = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\')));
+  masks[2] = _mm256_movemask_epi8(_mm256_or_si256(brace, punct));
+  masks[3] = _mm256_movemask_epi8(space);
+}
+#elif ARCH_X64
+intern void json_classify_16(u8* p, u32* masks) {
+  __m128i v = _mm_loadu_si128((__m128i*)p);
+  __m128i folded = _mm_or_si128(v, _mm_set1_epi8(0x20));
+  __m128i brace = _mm_or_si128(_mm_cmpeq_epi8(folded, _mm_set1_epi8('{')), _mm_cmpeq_epi8(folded, _mm_set1_epi8('}')));
+  __m128i punct = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(':')), _mm_cmpeq_epi8(v, _mm_set1_epi8(',')));
+  __m128i space = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))),
+                               _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))));
+  masks[0] = _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')));
+  masks[1] = _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\\')));
+  masks[2] = _mm_movemask_epi8(_mm_or_si128(brace, punct));
+  masks[3] = _mm_movemask_epi8(space);
+}
+#endif
+
+intern JsonBlock json_classify(u8* p) {
+  JsonBlock b = {};
+#if SIMD_AVX2
+  u32 lo[4], hi[4];
+  json_classify_32(p, lo);
+  json_classify_32(p + 32, hi);
+  b.quote      = lo[0] | (u64)hi[0] << 32;
+  b.backslash  = lo[1] | (u64)hi[1] << 32;
+  b.structural = lo[2] | (u64)hi[2] << 32;
+  b.space      = lo[3] | (u64)hi[3] << 32;
+#elif ARCH_X64
+  Loop (i, 4) {
+    u32 m[4];
+    json_classify_16(p + i*16, m);
+    b.quote      |= (u64)m[0] << (i*16);
+    b.backslash  |= (u64)m[1] << (i*16);
+    b.structural |= (u64)m[2] << (i*16);
+    b.space      |= (u64)m[3] << (i*16);
+  }
+#else
+  Loop (i, 64) {
+    u8 c = p[i];
+    u64 bit = 1ull << i;
+    if (c == '"')  b.quote |= bit;
+    if (c == '\\') b.backslash |= bit;
+    if (c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',') b.structural |= bit;
+    if (c == ' ' || c == '\n' || c == '\r' || c == '\t') b.space |= bit;
+  }
+#endif
+  return b;
+}
+
+// Bit i is set when byte i follows an odd run of backslashes. glTF strings almost never
+// escape anything, so runs are walked bit by bit instead of with an add-carry trick.
+intern u64 json_escaped(u64 backslash, u64* carry) {
+  u64 escaped = *carry;
+  // a backslash that is itself escaped escapes nothing
+  backslash &= ~escaped;
+  *carry = 0;
+  while (backslash) {
+    u32 i = __builtin_ctzll(backslash);
+    if (i == 63) {
+      *carry = 1;
+      break;
     }
-    case '-': case '0': case '1': case '2': case '3': case '4':
-    case '5': case '6': case '7': case '8': case '9': {
-      res.type = JsonType_Number;
-      while (r->cur != r->end && char_is_number_cont(*r->cur)) { ++r->cur; }
-    } break;
-    case '"': {
-      res.type = JsonType_String;
-      start = ++r->cur;
-      while (true) {
-        if (r->cur == r->end) { r->error = "unclosed string"; goto top; }
-        if (*r->cur == '"')   { break; }
-        if (*r->cur == '\\')  { r->cur++; }
-        if (r->cur != r->end) { r->cur++; }
-      }
-      res.str = str_range(start, r->cur++);
-      return res;
+    escaped |= 2ull << i;
+    backslash &= ~(3ull << i);
+  }
+  return escaped;
+}
+
+// bit i becomes the xor of bits 0..i
+intern u64 json_prefix_xor(u64 x) {
+  x ^= x << 1;
+  x ^= x << 2;
+  x ^= x << 4;
+  x ^= x << 8;
+  x ^= x << 16;
+  x ^= x << 32;
+  return x;
+}
+
+// carried from one block to the next, and so from one chunk to the next
+struct JsonScan {
+  u64 escape_carry;
+  u64 string_carry; // all ones when the previous block ended inside a string
+  u64 scalar_carry; // previous block ended on a scalar byte
+};
+
+// scans [begin, end) of the size bytes at data, begin a multiple of 64 and following the last
+// call's end, out needs end - begin entries or is null to only count, returns the count
+// NOTE: __builtin_ctzll and not ctz, which is out of line in the base lib, the loop below runs
+// once per structural character
+intern u32 json_find_structurals(JsonScan* s, u8* data, u64 size, u64 begin, u64 end, u32* out) {
+  u32 count = 0;
+  for (u64 base = begin; base < end; base += 64) {
+    u8* p = data + base;
+    u8 tail[64];
+    if (size - base < 64) {
+      MemSet(tail, ' ', sizeof(tail));
+      MemCopy(tail, p, size - base);
+      p = tail;
+    }
+    JsonBlock b = json_classify(p);
+    u64 quote = b.quote & ~json_escaped(b.backslash, &s->escape_carry);
+    // covers opening quotes and contents, closing quotes fall outside
+    u64 in_string = json_prefix_xor(quote) ^ s->string_carry;
+    s->string_carry = (u64)((i64)in_string >> 63);
+    u64 scalar = ~(b.structural | b.space | quote | in_string);
+    u64 scalar_start = scalar & ~(scalar << 1 | s->scalar_carry);
+    s->scalar_carry = scalar >> 63;
+    u64 mask = (b.structural & ~in_string) | quote | scalar_start;
+    if (!out) {
+      count += __builtin_popcountll(mask);
+      continue;
     }
-    case '{': case '[': {
-      res.type = (*r->cur == '{') ? JsonType_Object : JsonType_Array;
-      res.depth = ++r->depth;
-      r->cur++;
-    } break;
-    case '}': case ']': {
-      res.type = JsonType_End;
-      if (--r->depth < 0) {
-        r->error = (*r->cur == '}') ? "stray '}'" : "stray ']'";
-        goto top;
+    while (mask) {
+      out[count++] = (u32)(base + __builtin_ctzll(mask));
+      mask &= mask - 1;
+    }
+  }
+  return count;
+}
+
+////////////////////////////////////////////////////////////////////////
+// Stage 2
+
+intern u32 json_hex4(u8* p, b32* ok) {
+  u32 result = 0;
+  Loop (i, 4) {
+    u8 c = p[i];
+    u32 digit = (c >= '0' && c <= '9') ? c - '0' :
+                (c >= 'a' && c <= 'f') ? c - 'a' + 10 :
+                (c >= 'A' && c <= 'F') ? c - 'A' + 10 : 16;
+    if (digit == 16) *ok = false;
+    result = result << 4 | (digit & 0xf);
+  }
+  return result;
+}
+
+// escapes never make text longer, \uXXXX is 6 bytes for at most 3 of utf-8, so out needs
+// raw.size bytes and all strings together fit in the input's size
+intern String json_unescape(u8* out, String raw, String* error) {
+  u64 size = 0;
+  u8* p = raw.str;
+  u8* end = raw.str + raw.size;
+  while (p < end) {
+    if (*p != '\\') {
+      out[size++] = *p++;
+      continue;
+    }
+    if (p + 1 == end) break;
+    u8 c = p[1];
+    p += 2;
+    switch (c) {
+      case '"':  out[size++] = '"';  break;
+      case '\\': out[size++] = '\\'; break;
+      case '/':  out[size++] = '/';  break;
+      case 'b':  out[size++] = '\b'; break;
+      case 'f':  out[size++] = '\f'; break;
+      case 'n':  out[size++] = '\n'; break;
+      case 'r':  out[size++] = '\r'; break;
+      case 't':  out[size++] = '\t'; break;
+      case 'u': {
+        b32 ok = end - p >= 4;
+        u16 units[2];
+        u32 unit_count = 0;
+        if (ok) units[unit_count++] = json_hex4(p, &ok);
+        if (ok) p += 4;
+        // a surrogate pair is two escapes, a lone one decodes to U+FFFD
+        if (ok && units[0] >= 0xd800 && units[0] < 0xdc00 && end - p >= 6 && p[0] == '\\' && p[1] == 'u') {
+          b32 low_ok = true;
+          u32 low = json_hex4(p + 2, &low_ok);
+          if (low_ok && low >= 0xdc00 && low < 0xe000) {
+            units[unit_count++] = low;
+            p += 6;
+          }
+        }
+        if (!ok) {
+          *error = "bad \\u escape";
+          return {};
+        }
+        size += utf8_from_utf16(out + size, units, unit_count);
+      } break;
+      default: {
+        *error = "unknown escape";
+        return {};
       }
-      r->cur++;
-    } break;
-    case 'n': case 't': case 'f': {
-      res.type = (*r->cur == 'n') ? JsonType_Null : JsonType_Bool;
-      if (str_match(String(r->cur, 4),  "null")) { r->cur += 4; break; }
-      if (str_match(String(r->cur, 4),  "true")) { r->cur += 4; break; }
-      if (str_match(String(r->cur, 5), "false")) { r->cur += 5; break; }
-    } // fallthrough
-    default: {
-      r->error = "unknown token";
-      goto top;
     }
   }
-  res.str = str_range(start, r->cur);
-  return res;
+  return {out, size};
 }
 
-JsonReader json_reader_init(String buffer) {
-  JsonReader r = {
-    .cur = buffer.str,
-    .end = buffer.str + buffer.size,
+// -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+intern b32 json_number_valid(String str) {
+  u8* p = str.str;
+  u8* end = str.str + str.size;
+  auto digits = [&]() {
+    u8* start = p;
+    while (p < end && char_is_digit(*p)) ++p;
+    return p > start;
   };
-  r.base_obj = json_read(&r);
-  return r;
+  if (p < end && *p == '-') ++p;
+  if (p < end && *p == '0') {
+    ++p;
+  } else if (!digits()) {
+    return false;
+  }
+  if (p < end && *p == '.') {
+    ++p;
+    if (!digits()) return false;
+  }
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    ++p;
+    if (p < end && (*p == '+' || *p == '-')) ++p;
+    if (!digits()) return false;
+  }
+  return p == end;
+}
+
+intern JsonValue json_value(JsonReader* r, u32 idx) {
+  JsonNode& node = r->tape[idx];
+  return {.type = node.type, .str = node.str, .number = node.number, .idx = idx};
+}
+
+enum JsonExpect {
+  JsonExpect_Value,
+  JsonExpect_ValueOrEnd, // after '['
+  JsonExpect_Key,
+  JsonExpect_KeyOrEnd,   // after '{'
+  JsonExpect_Colon,
+  JsonExpect_CommaOrEnd,
+  JsonExpect_Done,
+};
+
+// the grammar state between chunks of indices
+struct JsonTapeState {
+  u32 stack[JSON_MAX_DEPTH];
+  u32 depth;
+  JsonExpect expect;
+};
+
+// checks the grammar while it appends to the tape, stops at the first error, every opening quote
+// in indices has to come with its closing one
+intern void json_build_tape(JsonReader* r, JsonTapeState* st, String buffer, u32* indices, u32 index_count) {
+  u8* data = buffer.str;
+  u32 count = r->count;
+  u32* stack = st->stack;
+  u32& depth = st->depth;
+  JsonExpect& expect = st->expect;
+  auto value_done = [&]() {
+    expect = depth ? JsonExpect_CommaOrEnd : JsonExpect_Done;
+  };
+  auto fail = [&](String error) {
+    r->error = error;
+  };
+  for (u32 i = 0; i < index_count && !r->error.str; ++i) {
+    u32 pos = indices[i];
+    u8 c = data[pos];
+    switch (c) {
+      case '{': case '[': {
+        if (expect != JsonExpect_Value && expect != JsonExpect_ValueOrEnd) { fail("unexpected container"); break; }
+        if (depth == JSON_MAX_DEPTH) { fail("nesting too deep"); break; }
+        stack[depth++] = count;
+        r->tape[count++] = {.type = c == '{' ? JsonType_Object : JsonType_Array, .str = {data + pos, 1}};
+        expect = c == '{' ? JsonExpect_KeyOrEnd : JsonExpect_ValueOrEnd;
+      } break;
+      case '}': case ']': {
+        if (depth == 0) { fail(c == '}' ? "stray '}'" : "stray ']'"); break; }
+        u32 open = stack[depth - 1];
+        b32 object = r->tape[open].type == JsonType_Object;
+        b32 can_close = expect == JsonExpect_CommaOrEnd || expect == (object ? JsonExpect_KeyOrEnd : JsonExpect_ValueOrEnd);
+        if (object != (c == '}') || !can_close) { fail("unexpected container end"); break; }
+        --depth;
+        r->tape[count] = {.type = JsonType_End, .next = count + 1, .str = {data + pos, 1}};
+        ++count;
+        r->tape[open].next = count;
+        value_done();
+      } break;
+      case ':': {
+        if (expect != JsonExpect_Colon) { fail("unexpected ':'"); break; }
+        expect = JsonExpect_Value;
+      } break;
+      case ',': {
+        if (expect != JsonExpect_CommaOrEnd) { fail("unexpected ','"); break; }
+        expect = r->tape[stack[depth - 1]].type == JsonType_Object ? JsonExpect_Key : JsonExpect_Value;
+      } break;
+      case '"': {
+        // stage 1 pairs every opening quote with a closing one
+        u32 close = indices[++i];
+        b32 key = expect == JsonExpect_Key || expect == JsonExpect_KeyOrEnd;
+        if (!key && expect != JsonExpect_Value && expect != JsonExpect_ValueOrEnd) { fail("unexpected string"); break; }
+        String str = {data + pos + 1, (u64)(close - pos - 1)};
+        if (bytes_find(str.str, str.size, '\\') < str.size) {
+          str = json_unescape(r->strings, str, &r->error);
+          if (r->error.str) break;
+          r->strings += str.size;
+        }
+        r->tape[count] = {.type = JsonType_String, .next = count + 1, .str = str};
+        ++count;
+        if (key) {
+          expect = JsonExpect_Colon;
+        } else {
+          value_done();
+        }
+      } break;
+      default: {
+        if (expect != JsonExpect_Value && expect != JsonExpect_ValueOrEnd) { fail("unexpected value"); break; }
+        u32 end = pos;
+        while (end < buffer.size && !char_is_space(data[end]) && data[end] != '\r' && data[end] != ',' &&
+               data[end] != '}' && data[end] != ']' && data[end] != ':' && data[end] != '"') {
+          ++end;
+        }
+        String str = {data + pos, (u64)(end - pos)};
+        JsonNode node = {.next = count + 1, .str = str};
+        if (str_match(str, "true") || str_match(str, "false")) {
+          node.type = JsonType_Bool;
+          node.number = c == 't';
+        } else if (str_match(str, "null")) {
+          node.type = JsonType_Null;
+        } else if (json_number_valid(str)) {
+          node.type = JsonType_Number;
+          node.number = f64_from_str(str);
+        } else {
+          fail("unknown token");
+          break;
+        }
+        r->tape[count++] = node;
+        value_done();
+      } break;
+    }
+  }
+  r->count = count;
 }
 
-intern void json_discard_until(JsonReader* r, i32 depth) {
-  JsonValue val;
-  val.type = JsonType_Null;
-  while (r->depth != depth && val.type != JsonType_Error) {
-    val = json_read(r);
+JsonReader json_reader_init(String buffer) {
+  JsonReader r = {};
+  JsonScan scan = {};
+  u32 total = 0;
+  if (buffer.size >= U32_MAX) {
+    r.error = "input too large";
+  } else if (!utf8_validate(buffer.str, buffer.size)) {
+    r.error = "invalid utf-8";
+  } else {
+    total = json_find_structurals(&scan, buffer.str, buffer.size, 0, buffer.size, null);
+    if (scan.string_carry) r.error = "unclosed string";
+  }
+  if (!r.error.str) {
+    // a string takes two indices and ':' ',' take none, so one entry per index is enough, and the
+    // unescaped strings fit in the input's size. Not an arena, readers are made on job threads
+    // and the arena tracking list isn't thread safe
+    u64 tape_size = (u64)(total + 1) * sizeof(JsonNode);
+    r.mem_size = tape_size + buffer.size;
+    r.tape = (JsonNode*)os_reserve(r.mem_size);
+    os_commit(r.tape, r.mem_size);
+    r.strings = (u8*)(r.tape + total + 1);
+    Scratch scratch;
+    // one more for an opening quote held back from the chunk before
+    u32* indices = push_array(scratch, u32, JSON_CHUNK_SIZE + 1);
+    JsonTapeState* st = push_struct_zero(scratch, JsonTapeState);
+    st->expect = JsonExpect_Value;
+    scan = {};
+    u32 held = 0;
+    for (u64 begin = 0; begin < buffer.size && !r.error.str; begin += JSON_CHUNK_SIZE) {
+      u64 end = Min(begin + JSON_CHUNK_SIZE, buffer.size);
+      u32 index_count = held + json_find_structurals(&scan, buffer.str, buffer.size, begin, end, indices + held);
+      // a chunk ending inside a string keeps its opening quote until the closing one turns up
+      held = scan.string_carry != 0;
+      json_build_tape(&r, st, buffer, indices, index_count - held);
+      if (held) indices[0] = indices[index_count - 1];
+    }
+    if (!r.error.str && st->expect != JsonExpect_Done) {
+      r.error = total ? "unexpected end" : "empty input";
+    }
   }
+  r.base_obj = r.error.str ? JsonValue{.type = JsonType_Error, .str = r.error} : json_value(&r, 0);
+  return r;
+}
+
+void json_reader_deinit(JsonReader* r) {
+  if (r->tape) os_release(r->tape, r->mem_size);
+  *r = {};
 }
 
 b32 json_iter_object(JsonReader* r, JsonValue obj, JsonValue *key, JsonValue *val) {
-  json_discard_until(r, obj.depth);
-  *key = json_read(r);
-  if (key->type == JsonType_Error || key->type == JsonType_End) { return false; }
-  *val = json_read(r);
-  if (val->type == JsonType_End)   { r->error = "unexpected object end"; return false; }
-  if (val->type == JsonType_Error) { return false; }
+  if (obj.type != JsonType_Object) { return false; }
+  u32 idx = val->idx ? r->tape[val->idx].next : obj.idx + 1;
+  if (r->tape[idx].type == JsonType_End) { return false; }
+  *key = json_value(r, idx);
+  *val = json_value(r, idx + 1);
   return true;
 }
 
 b32 json_iter_array(JsonReader* r, JsonValue arr, JsonValue* val) {
-  json_discard_until(r, arr.depth);
-  *val = json_read(r);
-  if (val->type == JsonType_Error || val->type == JsonType_End) { return false; }
+  if (arr.type != JsonType_Array) { return false; }
+  u32 idx = val->idx ? r->tape[val->idx].next : arr.idx + 1;
+  if (r->tape[idx].type == JsonType_End) { return false; }
+  *val = json_value(r, idx);
   return true;
 }
 
@@ -7,6 +7,7 @@
 #include "base/str.h"
 #include "base/thread_ctx.h"
 #include "base/thread.h"
+#include "base/atom.h"
 #include "base/profiler.h"
 
 #include "os/os_core.h"
@@ -26,6 +26,8 @@ i32 main(i32 count, char* args[]) {
 
   while (true) {
     st.update(&st.state);
+    // queued records point at the lib's formats
+    log_flush();
     os_lib_close(st.lib);
     os_sleep_ms(10);
     st.lib = os_lib_open(st.lib_filepath);
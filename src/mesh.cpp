@@ -0,0 +1,1424 @@
+#include "mesh.h"
+
+////////////////////////////////////////////////////////////////////////
+// Vertex cache
+// NOTE: a vertex is in the cache while fewer than cache_size others were shaded after it. Each
+// vertex keeps the time it went in and time only moves on a miss, so a flush is time += size.
+
+VertexCacheStats mesh_vertex_cache_stats(u32* indices, u32 index_count, u32 vert_count, u32 cache_size) {
+  Scratch scratch;
+  VertexCacheStats stats = {};
+  if (index_count < 3) { return stats; }
+  u32* cache_time = push_array_zero(scratch, u32, vert_count);
+  u32 time = cache_size + 1;
+  u32 used = 0;
+  Loop (i, index_count) {
+    u32 v = indices[i];
+    Assert(v < vert_count);
+    if (cache_time[v] == 0) { used++; }
+    if (time - cache_time[v] > cache_size) {
+      cache_time[v] = time++;
+      stats.misses++;
+    }
+  }
+  stats.acmr = f32(stats.misses) / f32(index_count / 3);
+  stats.atvr = f32(stats.misses) / f32(used);
+  return stats;
+}
+
+// NOTE: Tipsify (Sander, Nehab, Barczak 2007). Emits every triangle around a fanning vertex, then
+// moves to the neighbour that will still be cached after its own fan, else the most recently
+// emitted vertex with triangles left, else the next vertex in index order.
+void mesh_optimize_vertex_cache(u32* indices, u32 index_count, u32 vert_count, u32 cache_size) {
+  Scratch scratch;
+  u32 tri_count = index_count / 3;
+  if (tri_count == 0) { return; }
+
+  // triangles around each vertex, live counts the ones not emitted yet
+  u32* live = push_array_zero(scratch, u32, vert_count);
+  Loop (i, index_count) {
+    Assert(indices[i] < vert_count);
+    live[indices[i]]++;
+  }
+  u32* adjacency_offset = push_array(scratch, u32, vert_count + 1);
+  u32* adjacency_fill = push_array(scratch, u32, vert_count);
+  adjacency_offset[0] = 0;
+  Loop (v, vert_count) {
+    adjacency_fill[v] = adjacency_offset[v];
+    adjacency_offset[v + 1] = adjacency_offset[v] + live[v];
+  }
+  u32* adjacency = push_array(scratch, u32, index_count);
+  Loop (t, tri_count) {
+    Loop (k, 3) adjacency[adjacency_fill[indices[t * 3 + k]]++] = t;
+  }
+
+  u32* cache_time = push_array_zero(scratch, u32, vert_count);
+  b8* emitted = push_array_zero(scratch, b8, tri_count);
+  u32* dead_end = push_array(scratch, u32, index_count);
+  u32* candidates = push_array(scratch, u32, index_count);
+  u32* out = push_array(scratch, u32, index_count);
+  u32 dead_end_count = 0;
+  u32 out_count = 0;
+  u32 time = cache_size + 1;
+  u32 cursor = 0;
+  i64 fan = 0;
+  while (fan >= 0) {
+    u32 candidate_count = 0;
+    for (u32 a = adjacency_offset[fan]; a < adjacency_offset[fan + 1]; ++a) {
+      u32 t = adjacency[a];
+      if (emitted[t]) continue;
+      emitted[t] = true;
+      Loop (k, 3) {
+        u32 v = indices[t * 3 + k];
+        out[out_count++] = v;
+        dead_end[dead_end_count++] = v;
+        candidates[candidate_count++] = v;
+        live[v]--;
+        if (time - cache_time[v] > cache_size) { cache_time[v] = time++; }
+      }
+    }
+
+    fan = -1;
+    i64 best_priority = -1;
+    Loop (c, candidate_count) {
+      u32 v = candidates[c];
+      if (live[v] == 0) continue;
+      // fanning around v shades at most 2 new vertices per triangle, v has to survive that
+      i64 priority = 0;
+      if (time - cache_time[v] + 2 * live[v] <= cache_size) {
+        priority = time - cache_time[v];
+      }
+      if (priority > best_priority) {
+        fan = v;
+        best_priority = priority;
+      }
+    }
+    while (fan < 0 && dead_end_count) {
+      u32 v = dead_end[--dead_end_count];
+      if (live[v]) { fan = v; }
+    }
+    while (fan < 0 && cursor < vert_count) {
+      if (live[cursor]) { fan = cursor; }
+      cursor++;
+    }
+  }
+  Assert(out_count == tri_count * 3);
+  MemCopy(indices, out, tri_count * 3 * sizeof(u32));
+}
+
+// NOTE: after the cache pass, triangles that share nothing with the cache start a hard cluster.
+// Those are split again wherever the running ACMR gets within threshold of the cluster's own, so
+// reordering clusters costs little reuse. Clusters facing away from the mesh center go first.
+void mesh_optimize_overdraw(u32* indices, u32 index_count, Vertex* vertices, u32 vert_count, f32 threshold, u32 cache_size) {
+  Scratch scratch;
+  u32 tri_count = index_count / 3;
+  if (tri_count == 0) { return; }
+  u32* cache_time = push_array_zero(scratch, u32, vert_count);
+  u32 time = cache_size + 1;
+  var triangle_misses = [&](u32 t) {
+    u32 misses = 0;
+    Loop (k, 3) {
+      u32 v = indices[t * 3 + k];
+      if (time - cache_time[v] > cache_size) {
+        cache_time[v] = time++;
+        misses++;
+      }
+    }
+    return misses;
+  };
+
+  u32* hard = push_array(scratch, u32, tri_count);
+  u32 hard_count = 0;
+  Loop (t, tri_count) {
+    u32 misses = triangle_misses(t);
+    // a degenerate triangle can't miss 3 times, the first cluster starts at 0 regardless
+    if (t == 0 || misses == 3) { hard[hard_count++] = t; }
+  }
+
+  u32* clusters = push_array(scratch, u32, tri_count * 2 + 1);
+  u32 cluster_count = 0;
+  Loop (h, hard_count) {
+    u32 start = hard[h];
+    u32 end = h + 1 < hard_count ? hard[h + 1] : tri_count;
+    time += cache_size + 1;
+    u32 misses = 0;
+    for (u32 t = start; t < end; ++t) misses += triangle_misses(t);
+    f32 cluster_threshold = threshold * f32(misses) / f32(end - start);
+
+    clusters[cluster_count++] = start;
+    time += cache_size + 1;
+    u32 running_misses = 0;
+    u32 running_tris = 0;
+    for (u32 t = start; t < end; ++t) {
+      running_misses += triangle_misses(t);
+      running_tris++;
+      if (f32(running_misses) / f32(running_tris) <= cluster_threshold) {
+        clusters[cluster_count++] = t + 1;
+        time += cache_size + 1;
+        running_misses = 0;
+        running_tris = 0;
+      }
+    }
+    // whatever is left after the last split reuses little, it joins the cluster before it
+    if (clusters[cluster_count - 1] != start) { cluster_count--; }
+  }
+
+  struct ClusterSort {
+    f32 key;
+    u32 cluster;
+  };
+  // area weighted, the cross product is twice the area along the normal
+  v3* cluster_center = push_array(scratch, v3, cluster_count);
+  v3* cluster_normal = push_array(scratch, v3, cluster_count);
+  v3 mesh_center = {};
+  f32 mesh_area = 0;
+  Loop (c, cluster_count) {
+    u32 end = c + 1 < cluster_count ? clusters[c + 1] : tri_count;
+    v3 center = {};
+    v3 normal = {};
+    f32 area = 0;
+    for (u32 t = clusters[c]; t < end; ++t) {
+      v3 p0 = vertices[indices[t * 3 + 0]].pos;
+      v3 p1 = vertices[indices[t * 3 + 1]].pos;
+      v3 p2 = vertices[indices[t * 3 + 2]].pos;
+      v3 n = v3_cross(p1 - p0, p2 - p0);
+      f32 a = v3_length(n);
+      center += (p0 + p1 + p2) * (a / 3);
+      normal += n;
+      area += a;
+    }
+    mesh_center += center;
+    mesh_area += area;
+    cluster_center[c] = area > 0 ? center / area : vertices[indices[clusters[c] * 3]].pos;
+    cluster_normal[c] = normal;
+  }
+  if (mesh_area > 0) { mesh_center /= mesh_area; }
+
+  Slice<ClusterSort> order = push_slice(scratch, ClusterSort, cluster_count);
+  Loop (c, cluster_count) {
+    f32 length = v3_length(cluster_normal[c]);
+    f32 key = length > 0 ? v3_dot(cluster_center[c] - mesh_center, cluster_normal[c]) / length : 0;
+    order[c] = {key, (u32)c};
+  }
+  // far side first: radix sort on the float bits flipped to descending, 11 bits per pass. Stable,
+  // so clusters with the same key keep their cache order
+  Slice<ClusterSort> sorted = push_slice(scratch, ClusterSort, cluster_count);
+  u32* histogram = push_array(scratch, u32, 1 << 11);
+  var radix = [](f32 key) {
+    if (key == 0) { key = 0; } // -0 sorts with 0
+    u32 bits = *(u32*)&key;
+    return ~(bits >> 31 ? ~bits : bits | 0x80000000);
+  };
+  for (u32 shift = 0; shift < 32; shift += 11) {
+    MemSet(histogram, 0, (1 << 11) * sizeof(u32));
+    for (ClusterSort it : order) histogram[(radix(it.key) >> shift) & 0x7ff]++;
+    u32 sum = 0;
+    Loop (i, 1 << 11) {
+      u32 n = histogram[i];
+      histogram[i] = sum;
+      sum += n;
+    }
+    for (ClusterSort it : order) sorted[histogram[(radix(it.key) >> shift) & 0x7ff]++] = it;
+    Swap(order, sorted);
+  }
+
+  u32* out = push_array(scratch, u32, index_count);
+  u32 out_count = 0;
+  for (ClusterSort it : order) {
+    u32 end = it.cluster + 1 < cluster_count ? clusters[it.cluster + 1] : tri_count;
+    u32 size = (end - clusters[it.cluster]) * 3;
+    MemCopy(out + out_count, indices + clusters[it.cluster] * 3, size * sizeof(u32));
+    out_count += size;
+  }
+  Assert(out_count == tri_count * 3);
+  MemCopy(indices, out, out_count * sizeof(u32));
+}
+
+u32 mesh_optimize_vertex_fetch(Vertex* vertices, u32 vert_count, u32* indices, u32 index_count) {
+  Scratch scratch;
+  u32* remap = push_array(scratch, u32, vert_count);
+  MemSet(remap, 0xff, vert_count * sizeof(u32));
+  u32 next = 0;
+  Loop (i, index_count) {
+    u32& slot = remap[indices[i]];
+    if (slot == U32_MAX) { slot = next++; }
+    indices[i] = slot;
+  }
+  Vertex* old = push_array(scratch, Vertex, vert_count);
+  MemCopy(old, vertices, vert_count * sizeof(Vertex));
+  Loop (v, vert_count) {
+    if (remap[v] != U32_MAX) { vertices[remap[v]] = old[v]; }
+  }
+  return next;
+}
+
+////////////////////////////////////////////////////////////////////////
+// Simplification
+
+// squared distance to the planes of the triangles around a vertex, weighted by their area
+struct Quadric {
+  f32 a00, a11, a22;
+  f32 a01, a02, a12;
+  f32 b0, b1, b2;
+  f32 c;
+  f32 w;
+};
+
+// attributes next to squared positions in the unit cube
+const f32 MESH_SIMPLIFY_NORMAL_WEIGHT = 1e-3f;
+const f32 MESH_SIMPLIFY_UV_WEIGHT     = 1e-2f;
+const f32 MESH_SIMPLIFY_COLOR_WEIGHT  = 1e-3f;
+
+intern Quadric quadric_from_triangle(v3 p0, v3 p1, v3 p2) {
+  Quadric q = {};
+  v3 n = v3_cross(p1 - p0, p2 - p0);
+  f32 area = v3_length(n);
+  if (area == 0) { return q; }
+  n /= area;
+  f32 d = -v3_dot(n, p0);
+  q = {
+    n.x * n.x * area, n.y * n.y * area, n.z * n.z * area,
+    n.x * n.y * area, n.x * n.z * area, n.y * n.z * area,
+    n.x * d * area, n.y * d * area, n.z * d * area,
+    d * d * area,
+    area,
+  };
+  return q;
+}
+
+intern void quadric_add(Quadric* q, Quadric* r) {
+  q->a00 += r->a00; q->a11 += r->a11; q->a22 += r->a22;
+  q->a01 += r->a01; q->a02 += r->a02; q->a12 += r->a12;
+  q->b0 += r->b0; q->b1 += r->b1; q->b2 += r->b2;
+  q->c += r->c;
+  q->w += r->w;
+}
+
+intern f32 quadric_error(Quadric* q, v3 p) {
+  if (q->w == 0) { return 0; }
+  f32 ax = q->a00 * p.x + q->a01 * p.y + q->a02 * p.z;
+  f32 ay = q->a01 * p.x + q->a11 * p.y + q->a12 * p.z;
+  f32 az = q->a02 * p.x + q->a12 * p.y + q->a22 * p.z;
+  f32 e = p.x * ax + p.y * ay + p.z * az + 2 * (q->b0 * p.x + q->b1 * p.y + q->b2 * p.z) + q->c;
+  return Abs(e) / q->w;
+}
+
+intern f32 mesh_attribute_error(Vertex* a, Vertex* b) {
+  v3 n = a->norm - b->norm;
+  v2 uv = a->uv - b->uv;
+  v3 color = a->color - b->color;
+  return v3_dot(n, n) * MESH_SIMPLIFY_NORMAL_WEIGHT + (uv.x * uv.x + uv.y * uv.y) * MESH_SIMPLIFY_UV_WEIGHT +
+         v3_dot(color, color) * MESH_SIMPLIFY_COLOR_WEIGHT;
+}
+
+f32 mesh_extent(Vertex* vertices, u32 vert_count) {
+  if (vert_count == 0) { return 0; }
+  v3 lo = vertices[0].pos;
+  v3 hi = lo;
+  Loop (v, vert_count) {
+    v3 p = vertices[v].pos;
+    lo = {Min(lo.x, p.x), Min(lo.y, p.y), Min(lo.z, p.z)};
+    hi = {Max(hi.x, p.x), Max(hi.y, p.y), Max(hi.z, p.z)};
+  }
+  return Max(hi.x - lo.x, Max(hi.y - lo.y, hi.z - lo.z));
+}
+
+struct MeshCollapse {
+  u32 from;
+  u32 to;
+  f32 cost;
+};
+
+intern void mesh_weld_positions(Vertex* vertices, u32 vert_count, u32* canon, u32* wedge) {
+  Scratch scratch;
+  u32 table_size = 1;
+  while (table_size < vert_count * 2) table_size *= 2;
+  u32* table = push_array(scratch, u32, table_size);
+  MemSet(table, 0xff, table_size * sizeof(u32));
+  Loop (v, vert_count) {
+    u32 slot = hash_memory(&vertices[v].pos, sizeof(v3)) & (table_size - 1);
+    while (table[slot] != U32_MAX && !MemMatch(&vertices[table[slot]].pos, &vertices[v].pos, sizeof(v3))) {
+      slot = (slot + 1) & (table_size - 1);
+    }
+    if (table[slot] == U32_MAX) {
+      table[slot] = v;
+      canon[v] = v;
+      wedge[v] = v;
+    } else {
+      u32 first = table[slot];
+      canon[v] = first;
+      wedge[v] = wedge[first];
+      wedge[first] = v;
+    }
+  }
+}
+
+// NOTE: done in passes like meshoptimizer's simplifier. Every pass ranks all edges, then takes
+// collapses cheapest first while neither end moved yet this pass and no triangle flips over.
+// Positions are deduplicated first, so a seam or a flat shaded mesh collapses as one surface and
+// each wedge lands on the wedge of the target with the closest attributes.
+u32 mesh_simplify(u32* dst, u32* indices, u32 index_count, Vertex* vertices, u32 vert_count,
+                  u32 target_index_count, f32 target_error, f32* result_error) {
+  Scratch scratch;
+  *result_error = 0;
+  f32 extent = mesh_extent(vertices, vert_count);
+  f32 inv_extent = extent > 0 ? 1 / extent : 0;
+  v3 origin = vert_count ? vertices[0].pos : v3{};
+  v3* pos = push_array(scratch, v3, vert_count);
+  Loop (v, vert_count) pos[v] = (vertices[v].pos - origin) * inv_extent;
+
+  // canon is the first vertex at a position, wedge links the vertices there in a ring
+  u32* canon = push_array(scratch, u32, vert_count);
+  u32* wedge = push_array(scratch, u32, vert_count);
+  mesh_weld_positions(vertices, vert_count, canon, wedge);
+
+  // triangles with two corners at one position are dropped up front
+  u32* tris = push_array(scratch, u32, index_count);
+  u32 count = 0;
+  Quadric* quadrics = push_array_zero(scratch, Quadric, vert_count);
+  for (u32 i = 0; i + 2 < index_count; i += 3) {
+    u32 a = canon[indices[i]], b = canon[indices[i + 1]], c = canon[indices[i + 2]];
+    if (a == b || b == c || c == a) continue;
+    Quadric q = quadric_from_triangle(pos[a], pos[b], pos[c]);
+    quadric_add(&quadrics[a], &q);
+    quadric_add(&quadrics[b], &q);
+    quadric_add(&quadrics[c], &q);
+    MemCopy(tris + count, indices + i, 3 * sizeof(u32));
+    count += 3;
+  }
+
+  // triangles around each position, rebuilt every pass
+  u32* adjacency_offset = push_array(scratch, u32, vert_count + 1);
+  u32* adjacency_fill = push_array(scratch, u32, vert_count);
+  u32* adjacency = push_array(scratch, u32, index_count);
+  var build_adjacency = [&]() {
+    MemSet(adjacency_fill, 0, vert_count * sizeof(u32));
+    Loop (i, count) adjacency_fill[canon[tris[i]]]++;
+    adjacency_offset[0] = 0;
+    Loop (v, vert_count) {
+      adjacency_offset[v + 1] = adjacency_offset[v] + adjacency_fill[v];
+      adjacency_fill[v] = adjacency_offset[v];
+    }
+    Loop (i, count) adjacency[adjacency_fill[canon[tris[i]]]++] = i / 3;
+  };
+  var corner = [&](u32 t, u32 k) { return canon[tris[t * 3 + k]]; };
+
+  // an edge that isn't shared by exactly two opposite triangles is a border, it stays put
+  build_adjacency();
+  b8* locked = push_array_zero(scratch, b8, vert_count);
+  for (u32 t = 0; t < count / 3; ++t) {
+    Loop (k, 3) {
+      u32 a = corner(t, k), b = corner(t, (k + 1) % 3);
+      u32 same = 0, opposite = 0;
+      for (u32 i = adjacency_offset[a]; i < adjacency_offset[a + 1]; ++i) {
+        Loop (j, 3) {
+          u32 u = corner(adjacency[i], j), w = corner(adjacency[i], (j + 1) % 3);
+          same += u == a && w == b;
+          opposite += u == b && w == a;
+        }
+      }
+      if (same != 1 || opposite != 1) {
+        locked[a] = true;
+        locked[b] = true;
+      }
+    }
+  }
+
+  var closest_wedge = [&](u32 v, u32 to, f32* error) {
+    u32 best = to;
+    f32 best_error = F32_MAX;
+    u32 w = to;
+    do {
+      f32 e = mesh_attribute_error(&vertices[v], &vertices[w]);
+      if (e < best_error) {
+        best = w;
+        best_error = e;
+      }
+      w = wedge[w];
+    } while (w != to);
+    *error = best_error;
+    return best;
+  };
+  var collapse_cost = [&](u32 from, u32 to) {
+    f32 cost = quadric_error(&quadrics[from], pos[to]);
+    f32 attribute = 0;
+    u32 v = from;
+    do {
+      f32 e;
+      closest_wedge(v, to, &e);
+      attribute = Max(attribute, e);
+      v = wedge[v];
+    } while (v != from);
+    return cost + attribute;
+  };
+  var flips = [&](u32 from, u32 to) {
+    for (u32 i = adjacency_offset[from]; i < adjacency_offset[from + 1]; ++i) {
+      u32 t = adjacency[i];
+      u32 c[3] = {corner(t, 0), corner(t, 1), corner(t, 2)};
+      if (c[0] == to || c[1] == to || c[2] == to) continue;
+      v3 p[3] = {pos[c[0]], pos[c[1]], pos[c[2]]};
+      v3 before = v3_cross(p[1] - p[0], p[2] - p[0]);
+      Loop (k, 3) {
+        if (c[k] == from) p[k] = pos[to];
+      }
+      v3 after = v3_cross(p[1] - p[0], p[2] - p[0]);
+      if (v3_dot(before, after) <= 0) { return true; }
+    }
+    return false;
+  };
+
+  u32* vertex_target = push_array(scratch, u32, vert_count);
+  Loop (v, vert_count) vertex_target[v] = v;
+  b8* touched = push_array(scratch, b8, vert_count);
+  MeshCollapse* collapses = push_array(scratch, MeshCollapse, index_count);
+  MeshCollapse* sorted = push_array(scratch, MeshCollapse, index_count);
+  u32 histogram[1 << 11];
+  f32 error_limit = target_error * target_error;
+  f32 max_cost = 0;
+  while (count > target_index_count) {
+    build_adjacency();
+    // every interior edge shows up once with its ends in ascending order
+    u32 collapse_count = 0;
+    for (u32 t = 0; t < count / 3; ++t) {
+      Loop (k, 3) {
+        u32 a = corner(t, k), b = corner(t, (k + 1) % 3);
+        if (a > b || (locked[a] && locked[b])) continue;
+        f32 cost_ab = locked[a] ? F32_MAX : collapse_cost(a, b);
+        f32 cost_ba = locked[b] ? F32_MAX : collapse_cost(b, a);
+        collapses[collapse_count++] = cost_ab <= cost_ba ? MeshCollapse{a, b, cost_ab} : MeshCollapse{b, a, cost_ba};
+      }
+    }
+    if (collapse_count == 0) break;
+
+    // counting sort on the top bits, costs are positive so their bits order like the floats
+    MemSet(histogram, 0, sizeof(histogram));
+    var key = [](f32 cost) { return (*(u32*)&cost) >> 21; };
+    Loop (i, collapse_count) histogram[key(collapses[i].cost)]++;
+    u32 sum = 0;
+    for EachElement (i, histogram) {
+      u32 n = histogram[i];
+      histogram[i] = sum;
+      sum += n;
+    }
+    Loop (i, collapse_count) sorted[histogram[key(collapses[i].cost)]++] = collapses[i];
+
+    // a collapse removes about two triangles, half of the ones still to go are taken per pass and
+    // nothing much worse than those, so later passes see the quadrics the cheap collapses left
+    u32 edge_goal = (count - target_index_count) / 6;
+    f32 error_goal = edge_goal < collapse_count ? 1.5f * sorted[edge_goal].cost : F32_MAX;
+    MemSet(touched, 0, vert_count * sizeof(b8));
+    u32 removed = 0;
+    u32 applied = 0;
+    Loop (i, collapse_count) {
+      MeshCollapse c = sorted[i];
+      if (c.cost > error_limit || c.cost > error_goal) break;
+      if (touched[c.from] || touched[c.to] || flips(c.from, c.to)) continue;
+      u32 v = c.from;
+      do {
+        f32 e;
+        vertex_target[v] = closest_wedge(v, c.to, &e);
+        v = wedge[v];
+      } while (v != c.from);
+      quadric_add(&quadrics[c.to], &quadrics[c.from]);
+      for (u32 j = adjacency_offset[c.from]; j < adjacency_offset[c.from + 1]; ++j) {
+        u32 t = adjacency[j];
+        if (corner(t, 0) == c.to || corner(t, 1) == c.to || corner(t, 2) == c.to) removed += 3;
+      }
+      touched[c.from] = true;
+      touched[c.to] = true;
+      max_cost = Max(max_cost, c.cost);
+      applied++;
+      if (count - removed <= target_index_count) break;
+    }
+    if (applied == 0) break;
+
+    u32 kept = 0;
+    for (u32 i = 0; i < count; i += 3) {
+      u32 t[3] = {vertex_target[tris[i]], vertex_target[tris[i + 1]], vertex_target[tris[i + 2]]};
+      if (canon[t[0]] == canon[t[1]] || canon[t[1]] == canon[t[2]] || canon[t[2]] == canon[t[0]]) continue;
+      MemCopy(tris + kept, t, sizeof(t));
+      kept += 3;
+    }
+    count = kept;
+  }
+
+  MemCopy(dst, tris, count * sizeof(u32));
+  *result_error = Sqrt(max_cost);
+  return count;
+}
+
+u32 mesh_lod_select(MeshLod* lods, u32 lod_count, f32 scale, f32 distance, f32 pixel_scale) {
+  u32 lod = 0;
+  for (u32 i = 1; i < lod_count; ++i) {
+    if (lods[i].error * scale * pixel_scale > MESH_LOD_PIXEL_ERROR * distance) break;
+    lod = i;
+  }
+  return lod;
+}
+
+////////////////////////////////////////////////////////////////////////
+// Meshlets
+
+const f32 MESHLET_CONE_WEIGHT = 0.5f;
+
+Meshlets mesh_build_meshlets(Allocator arena, u32* indices, u32 index_count, Vertex* vertices, u32 vert_count) {
+  Scratch scratch(arena);
+  Meshlets result = {};
+  u32 tri_count = index_count / 3;
+  if (tri_count == 0) { return result; }
+
+  // triangles meet through positions, so seams and flat shaded faces still grow one cluster
+  u32* canon = push_array(scratch, u32, vert_count);
+  u32* wedge = push_array(scratch, u32, vert_count);
+  mesh_weld_positions(vertices, vert_count, canon, wedge);
+  u32* live = push_array_zero(scratch, u32, vert_count);
+  Loop (i, tri_count * 3) {
+    Assert(indices[i] < vert_count);
+    live[canon[indices[i]]]++;
+  }
+  u32* adjacency_offset = push_array(scratch, u32, vert_count + 1);
+  u32* adjacency_fill = push_array(scratch, u32, vert_count);
+  adjacency_offset[0] = 0;
+  Loop (v, vert_count) {
+    adjacency_fill[v] = adjacency_offset[v];
+    adjacency_offset[v + 1] = adjacency_offset[v] + live[v];
+  }
+  u32* adjacency = push_array(scratch, u32, tri_count * 3);
+  Loop (t, tri_count) {
+    Loop (k, 3) adjacency[adjacency_fill[canon[indices[t * 3 + k]]]++] = t;
+  }
+
+  // every triangle on its own is the worst case for all three
+  Meshlet* meshlets = push_array(scratch, Meshlet, tri_count);
+  u32* meshlet_vertices = push_array(scratch, u32, tri_count * 3);
+  u8* meshlet_triangles = push_array(scratch, u8, tri_count * 3);
+  u8* slot = push_array(scratch, u8, vert_count);
+  MemSet(slot, 0xff, vert_count);
+  b8* emitted = push_array_zero(scratch, b8, tri_count);
+  v3* normals = push_array(scratch, v3, tri_count);
+  Loop (t, tri_count) {
+    v3 p0 = vertices[indices[t * 3 + 0]].pos;
+    v3 n = v3_cross(vertices[indices[t * 3 + 1]].pos - p0, vertices[indices[t * 3 + 2]].pos - p0);
+    f32 length = v3_length(n);
+    normals[t] = length > 0 ? n / length : v3{};
+  }
+  Meshlet current = {};
+  v3 cone = {};
+  var new_vertices = [&](u32 t) {
+    u32 count = 0;
+    Loop (k, 3) count += slot[indices[t * 3 + k]] == 0xff;
+    return count;
+  };
+  var flush = [&]() {
+    Loop (i, current.vertex_count) slot[meshlet_vertices[current.vertex_offset + i]] = 0xff;
+    meshlets[result.count++] = current;
+    current = {result.vertex_count, result.triangle_count * 3, 0, 0};
+    cone = {};
+  };
+
+  u32 cursor = 0;
+  Loop (emitted_count, tri_count) {
+    // the neighbour adding the fewest vertices, any neighbour if none fits
+    i64 best = -1;
+    i64 any = -1;
+    f32 best_score = F32_MAX;
+    f32 cone_length = v3_length(cone);
+    v3 axis = cone_length > 0 ? cone / cone_length : v3{};
+    Loop (i, current.vertex_count) {
+      u32 v = canon[meshlet_vertices[current.vertex_offset + i]];
+      for (u32 a = adjacency_offset[v]; a < adjacency_fill[v]; ++a) {
+        u32 t = adjacency[a];
+        any = t;
+        u32 n = new_vertices(t);
+        // a normal far from the cluster's costs up to a vertex, so the cones stay narrow
+        f32 score = n + MESHLET_CONE_WEIGHT * (1 - v3_dot(normals[t], axis));
+        if (score < best_score && current.vertex_count + n <= MESHLET_MAX_VERTICES) {
+          best = t;
+          best_score = score;
+        }
+      }
+    }
+    if (best < 0 || current.triangle_count == MESHLET_MAX_TRIANGLES) {
+      if (current.triangle_count) { flush(); }
+      // next to the last meshlet if it has neighbours left, else the first triangle not taken
+      if (any >= 0) {
+        best = any;
+      } else {
+        while (emitted[cursor]) cursor++;
+        best = cursor;
+      }
+    }
+
+    emitted[best] = true;
+    cone += normals[best];
+    // taken triangles leave the adjacency, so the inside of a cluster is never scanned again
+    Loop (k, 3) {
+      u32 v = canon[indices[best * 3 + k]];
+      for (u32 a = adjacency_offset[v]; a < adjacency_fill[v]; ++a) {
+        if (adjacency[a] == best) {
+          adjacency[a] = adjacency[--adjacency_fill[v]];
+          break;
+        }
+      }
+    }
+    Loop (k, 3) {
+      u32 v = indices[best * 3 + k];
+      if (slot[v] == 0xff) {
+        slot[v] = (u8)current.vertex_count++;
+        meshlet_vertices[result.vertex_count++] = v;
+      }
+      meshlet_triangles[result.triangle_count * 3 + k] = slot[v];
+    }
+    result.triangle_count++;
+    current.triangle_count++;
+  }
+  flush();
+
+  result.meshlets = push_array(arena, Meshlet, result.count);
+  result.bounds = push_array(arena, MeshletBounds, result.count);
+  result.vertices = push_array(arena, u32, result.vertex_count);
+  result.triangles = push_array(arena, u8, result.triangle_count * 3);
+  MemCopy(result.meshlets, meshlets, result.count * sizeof(Meshlet));
+  MemCopy(result.vertices, meshlet_vertices, result.vertex_count * sizeof(u32));
+  MemCopy(result.triangles, meshlet_triangles, result.triangle_count * 3);
+  Loop (i, result.count) result.bounds[i] = meshlet_bounds(&result, i, vertices);
+  return result;
+}
+
+// NOTE: the sphere is Ritter's, grown from the two points farthest apart along a sweep. The cone
+// is meshoptimizer's: the axis averages the triangle normals, the apex sits behind every triangle
+// plane, and cutoff is the sine of the widest normal's angle to the axis.
+MeshletBounds meshlet_bounds(Meshlets* meshlets, u32 idx, Vertex* vertices) {
+  Meshlet m = meshlets->meshlets[idx];
+  u32* ids = meshlets->vertices + m.vertex_offset;
+  u8* tris = meshlets->triangles + m.triangle_offset;
+  MeshletBounds bounds = {};
+
+  var farthest = [&](v3 from) {
+    v3 result = from;
+    f32 best = -1;
+    Loop (i, m.vertex_count) {
+      f32 d = v3_length_squared(vertices[ids[i]].pos - from);
+      if (d > best) {
+        best = d;
+        result = vertices[ids[i]].pos;
+      }
+    }
+    return result;
+  };
+  v3 a = farthest(vertices[ids[0]].pos);
+  v3 b = farthest(a);
+  v3 center = (a + b) * 0.5f;
+  f32 radius = v3_length(b - a) * 0.5f;
+  Loop (i, m.vertex_count) {
+    v3 p = vertices[ids[i]].pos;
+    f32 d = v3_length(p - center);
+    if (d > radius) {
+      f32 grown = (radius + d) * 0.5f;
+      center += (p - center) * ((grown - radius) / d);
+      radius = grown;
+    }
+  }
+  bounds.center = center;
+  bounds.radius = radius;
+
+  v3 axis = {};
+  Loop (t, m.triangle_count) {
+    v3 p0 = vertices[ids[tris[t * 3 + 0]]].pos;
+    v3 p1 = vertices[ids[tris[t * 3 + 1]]].pos;
+    v3 p2 = vertices[ids[tris[t * 3 + 2]]].pos;
+    v3 n = v3_cross(p1 - p0, p2 - p0);
+    f32 length = v3_length(n);
+    if (length > 0) { axis += n / length; }
+  }
+  f32 axis_length = v3_length(axis);
+  bounds.cone_apex = center;
+  bounds.cone_axis = axis_length > 0 ? axis / axis_length : v3{0, 0, 1};
+  bounds.cone_cutoff = 1;
+  if (axis_length == 0) { return bounds; }
+
+  f32 min_dot = 1;
+  f32 apex_offset = 0;
+  Loop (t, m.triangle_count) {
+    v3 p0 = vertices[ids[tris[t * 3 + 0]]].pos;
+    v3 p1 = vertices[ids[tris[t * 3 + 1]]].pos;
+    v3 p2 = vertices[ids[tris[t * 3 + 2]]].pos;
+    v3 n = v3_cross(p1 - p0, p2 - p0);
+    f32 length = v3_length(n);
+    if (length == 0) continue;
+    n /= length;
+    f32 d = v3_dot(bounds.cone_axis, n);
+    min_dot = Min(min_dot, d);
+    // how far back along the axis this triangle's plane is from the center
+    if (d > 0) { apex_offset = Max(apex_offset, v3_dot(center - p0, n) / d); }
+  }
+  // past about 84 degrees the cone hardly ever culls, and at 90 it can't
+  if (min_dot <= 0.1f) { return bounds; }
+  bounds.cone_apex = center - bounds.cone_axis * apex_offset;
+  bounds.cone_cutoff = Sqrt(1 - min_dot * min_dot);
+  return bounds;
+}
+
+void frustum_planes(mat4 m, v4 planes[6]) {
+  // rows of the matrix, clip space is -w..w on every axis
+  v4 row[4];
+  Loop (r, 4) row[r] = {m.v[0][r], m.v[1][r], m.v[2][r], m.v[3][r]};
+  Loop (i, 3) {
+    planes[i * 2 + 0] = row[3] + row[i];
+    planes[i * 2 + 1] = row[3] - row[i];
+  }
+  Loop (i, 6) {
+    f32 length = v3_length(v3_of_v4(planes[i]));
+    if (length > 0) { planes[i] = planes[i] / length; }
+  }
+}
+
+b32 meshlet_frustum_culled(MeshletBounds* bounds, v4 planes[6]) {
+  Loop (i, 6) {
+    if (v3_dot(v3_of_v4(planes[i]), bounds->center) + planes[i].w < -bounds->radius) { return true; }
+  }
+  return false;
+}
+
+b32 meshlet_backfacing(MeshletBounds* bounds, v3 camera_pos) {
+  if (bounds->cone_cutoff >= 1) { return false; }
+  v3 dir = bounds->cone_apex - camera_pos;
+  return v3_dot(dir, bounds->cone_axis) >= bounds->cone_cutoff * v3_length(dir);
+}
+
+////////////////////////////////////////////////////////////////////////
+// Vertex quantization
+
+// NOTE: Fabian Giesen's conversions, rounding to nearest even. Too large values become infinity,
+// NaN stays NaN, and tiny values go subnormal through the float adder.
+u16 f32_to_f16(f32 value) {
+  u32 bits = *(u32*)&value;
+  u32 sign = (bits >> 16) & 0x8000;
+  bits &= 0x7fffffff;
+  u16 result;
+  if (bits >= (127 + 16) << 23) {
+    result = bits > 0x7f800000 ? 0x7e00 : 0x7c00;
+  } else if (bits < (127 - 14) << 23) {
+    u32 magic_bits = (127 - 15 + 23 - 10 + 1) << 23;
+    f32 magic = *(f32*)&magic_bits;
+    f32 sum = *(f32*)&bits + magic;
+    result = (u16)(*(u32*)&sum - magic_bits);
+  } else {
+    u32 odd = (bits >> 13) & 1;
+    bits += ((u32)(15 - 127) << 23) + 0xfff + odd;
+    result = (u16)(bits >> 13);
+  }
+  return result | sign;
+}
+
+f32 f16_to_f32(u16 value) {
+  u32 exponent_mask = 0x7c00 << 13;
+  u32 bits = (value & 0x7fff) << 13;
+  u32 exponent = bits & exponent_mask;
+  bits += (127 - 15) << 23;
+  if (exponent == exponent_mask) {
+    bits += (128 - 16) << 23;
+  } else if (exponent == 0) {
+    u32 magic_bits = 113 << 23;
+    bits += 1 << 23;
+    f32 result = *(f32*)&bits - *(f32*)&magic_bits;
+    bits = *(u32*)&result;
+  }
+  bits |= (value & 0x8000) << 16;
+  return *(f32*)&bits;
+}
+
+VertexQuantization mesh_vertex_quantization(Vertex* vertices, u32 vert_count) {
+  if (vert_count == 0) { return {}; }
+  v3 lo = vertices[0].pos;
+  v3 hi = vertices[0].pos;
+  Loop (i, vert_count) {
+    v3 p = vertices[i].pos;
+    lo = {Min(lo.x, p.x), Min(lo.y, p.y), Min(lo.z, p.z)};
+    hi = {Max(hi.x, p.x), Max(hi.y, p.y), Max(hi.z, p.z)};
+  }
+  return {lo, hi - lo};
+}
+
+intern u16 quantize_unorm16(f32 value, f32 offset, f32 scale) {
+  f32 t = scale > 0 ? (value - offset) / scale : 0;
+  return (u16)Round(Clamp(0.f, t, 1.f) * 65535);
+}
+
+void mesh_encode_vertices(PackedVertex* dst, Vertex* vertices, u32 vert_count, VertexQuantization quantization) {
+  Loop (i, vert_count) {
+    Vertex& v = vertices[i];
+    PackedVertex& p = dst[i];
+    p.pos[0] = quantize_unorm16(v.pos.x, quantization.offset.x, quantization.scale.x);
+    p.pos[1] = quantize_unorm16(v.pos.y, quantization.offset.y, quantization.scale.y);
+    p.pos[2] = quantize_unorm16(v.pos.z, quantization.offset.z, quantization.scale.z);
+    p.pos[3] = 0;
+
+    // the sphere flattened onto an octahedron, the lower half unfolded into the corners
+    f32 sum = Abs(v.norm.x) + Abs(v.norm.y) + Abs(v.norm.z);
+    f32 x = sum > 0 ? v.norm.x / sum : 0;
+    f32 y = sum > 0 ? v.norm.y / sum : 0;
+    if (v.norm.z < 0) {
+      f32 folded_x = (1 - Abs(y)) * (x >= 0 ? 1 : -1);
+      f32 folded_y = (1 - Abs(x)) * (y >= 0 ? 1 : -1);
+      x = folded_x;
+      y = folded_y;
+    }
+    p.norm[0] = (i16)Round(Clamp(-1.f, x, 1.f) * 32767);
+    p.norm[1] = (i16)Round(Clamp(-1.f, y, 1.f) * 32767);
+
+    p.uv[0] = f32_to_f16(v.uv.x);
+    p.uv[1] = f32_to_f16(v.uv.y);
+    p.color[0] = (u8)Round(Clamp01(v.color.x) * 255);
+    p.color[1] = (u8)Round(Clamp01(v.color.y) * 255);
+    p.color[2] = (u8)Round(Clamp01(v.color.z) * 255);
+    p.color[3] = 0;
+  }
+}
+
+void mesh_decode_vertices(Vertex* dst, PackedVertex* packed, u32 vert_count, VertexQuantization quantization) {
+  v3 step = quantization.scale / 65535;
+  Loop (i, vert_count) {
+    PackedVertex& p = packed[i];
+    Vertex& v = dst[i];
+    v.pos = {quantization.offset.x + p.pos[0] * step.x,
+             quantization.offset.y + p.pos[1] * step.y,
+             quantization.offset.z + p.pos[2] * step.z};
+
+    v3 n = {p.norm[0] / 32767.f, p.norm[1] / 32767.f, 0};
+    n.z = 1 - Abs(n.x) - Abs(n.y);
+    f32 t = Max(-n.z, 0.f);
+    n.x += n.x >= 0 ? -t : t;
+    n.y += n.y >= 0 ? -t : t;
+    v.norm = n / v3_length(n);
+
+    v.uv = {f16_to_f32(p.uv[0]), f16_to_f32(p.uv[1])};
+    v.color = {p.color[0] / 255.f, p.color[1] / 255.f, p.color[2] / 255.f};
+  }
+}
+
+////////////////////////////////////////////////////////////////////////
+// Buffer compression
+
+const u8  MESH_INDEX_CODEC_HEADER  = 0xe0;
+const u8  MESH_VERTEX_CODEC_HEADER = 0xa0;
+const u32 CODEC_FIFO_SIZE          = 16;
+const u32 VERTEX_BLOCK_BYTES       = 8192;
+const u32 VERTEX_BLOCK_MAX         = 256;
+const u32 VERTEX_GROUP_SIZE        = 16;
+// the first vertex goes last, padded so group decoding may read 24 bytes past any group
+const u32 VERTEX_TAIL_MIN          = 32;
+
+intern u8* codec_write_varint(u8* out, u32 value) {
+  while (value >= 0x80) {
+    *out++ = (u8)(value | 0x80);
+    value >>= 7;
+  }
+  *out++ = (u8)value;
+  return out;
+}
+
+intern b32 codec_read_varint(u8** p, u8* end, u32* value) {
+  u32 result = 0;
+  for (u32 shift = 0; shift < 35; shift += 7) {
+    if (*p == end) { return false; }
+    u8 byte = *(*p)++;
+    result |= (u32)(byte & 0x7f) << shift;
+    if (byte < 0x80) {
+      *value = result;
+      return true;
+    }
+  }
+  return false;
+}
+
+// both sides keep the same fifos, the decoder replays every push the encoder made
+struct IndexCodecState {
+  u32 edges[CODEC_FIFO_SIZE][2];
+  u32 vertices[CODEC_FIFO_SIZE];
+  u32 edge_offset;
+  u32 vertex_offset;
+  u32 next;
+  u32 last;
+};
+
+intern void index_codec_init(IndexCodecState* st) {
+  MemSet(st, 0xff, sizeof(st->edges) + sizeof(st->vertices));
+  st->edge_offset = 0;
+  st->vertex_offset = 0;
+  st->next = 0;
+  st->last = 0;
+}
+
+intern void index_codec_push_edge(IndexCodecState* st, u32 a, u32 b) {
+  st->edges[st->edge_offset][0] = a;
+  st->edges[st->edge_offset][1] = b;
+  st->edge_offset = (st->edge_offset + 1) & (CODEC_FIFO_SIZE - 1);
+}
+
+intern void index_codec_push_vertex(IndexCodecState* st, u32 v) {
+  st->vertices[st->vertex_offset] = v;
+  st->vertex_offset = (st->vertex_offset + 1) & (CODEC_FIFO_SIZE - 1);
+}
+
+// a nibble: 0 the next unused index, 1..depth that far back in the vertex fifo, 15 a delta in data
+intern u32 index_codec_encode_vertex(IndexCodecState* st, u32 v, u8** data, u32 depth = 14) {
+  if (v == st->next) {
+    st->next++;
+    index_codec_push_vertex(st, v);
+    return 0;
+  }
+  Loop (i, depth) {
+    if (st->vertices[(st->vertex_offset - 1 - i) & (CODEC_FIFO_SIZE - 1)] == v) { return i + 1; }
+  }
+  i32 delta = (i32)(v - st->last);
+  *data = codec_write_varint(*data, (u32)(delta << 1) ^ (u32)(delta >> 31));
+  st->last = v;
+  index_codec_push_vertex(st, v);
+  return 15;
+}
+
+intern b32 index_codec_decode_vertex(IndexCodecState* st, u32 code, u8** data, u8* end, u32* v) {
+  if (code == 0) {
+    *v = st->next++;
+  } else if (code < 15) {
+    *v = st->vertices[(st->vertex_offset - code) & (CODEC_FIFO_SIZE - 1)];
+    return true;
+  } else {
+    u32 zigzag;
+    if (!codec_read_varint(data, end, &zigzag)) { return false; }
+    st->last += (zigzag >> 1) ^ (0 - (zigzag & 1));
+    *v = st->last;
+  }
+  index_codec_push_vertex(st, *v);
+  return true;
+}
+
+u64 mesh_compress_indices_bound(u32 index_count, u32 vert_count) {
+  u32 bits = 1;
+  while (bits < 32 && vert_count > 1ull << bits) bits++;
+  // zigzag costs a bit, the code byte and the aux byte two more
+  u64 varint_size = (bits + 1 + 6) / 7;
+  return 1 + (u64)(index_count / 3) * (2 + 3 * varint_size);
+}
+
+// NOTE: a triangle sharing an edge with one of the last 15 is rotated so the shared edge comes
+// first. The code is the edge's place in the fifo in the high nibble and the third vertex in the
+// low one. Other triangles take 0xf in the high nibble. In the low one 0 says all three vertices
+// are the next ones, else it is the first vertex, with 14 standing in for next, and an aux byte
+// in data holds the other two. Neighbours walk a shared edge the other way around, so the fifo
+// holds each edge reversed.
+u64 mesh_compress_indices(u32* indices, u32 index_count, u8* dst, u64 cap) {
+  Assert(index_count % 3 == 0 && cap >= 1 + index_count / 3);
+  u32 tri_count = index_count / 3;
+  IndexCodecState st;
+  index_codec_init(&st);
+  dst[0] = MESH_INDEX_CODEC_HEADER;
+  u8* codes = dst + 1;
+  u8* data = codes + tri_count;
+  Loop (t, tri_count) {
+    u32 a = indices[t * 3 + 0], b = indices[t * 3 + 1], c = indices[t * 3 + 2];
+    i32 edge = -1;
+    for (u32 i = 0; i < 15 && edge < 0; ++i) {
+      u32* e = st.edges[(st.edge_offset - 1 - i) & (CODEC_FIFO_SIZE - 1)];
+      if (e[0] == a && e[1] == b) {
+        edge = i;
+      } else if (e[0] == b && e[1] == c) {
+        edge = i;
+        u32 first = a;
+        a = b, b = c, c = first;
+      } else if (e[0] == c && e[1] == a) {
+        edge = i;
+        u32 first = a;
+        a = c, c = b, b = first;
+      }
+    }
+    if (edge >= 0) {
+      u32 code = index_codec_encode_vertex(&st, c, &data);
+      codes[t] = (u8)(edge << 4 | code);
+      index_codec_push_edge(&st, c, b);
+      index_codec_push_edge(&st, a, c);
+    } else {
+      // a run of new vertices starts with the next one
+      if (b == st.next) {
+        u32 first = a;
+        a = b, b = c, c = first;
+      } else if (c == st.next) {
+        u32 first = a;
+        a = c, c = b, b = first;
+      }
+      if (a == st.next && b == st.next + 1 && c == st.next + 2) {
+        codes[t] = 0xf0;
+        Loop (k, 3) index_codec_encode_vertex(&st, st.next, &data);
+      } else {
+        u8* aux = data++;
+        u32 code_a = index_codec_encode_vertex(&st, a, &data, 13);
+        u32 code_b = index_codec_encode_vertex(&st, b, &data);
+        u32 code_c = index_codec_encode_vertex(&st, c, &data);
+        codes[t] = (u8)(0xf0 | (code_a == 0 ? 14 : code_a));
+        *aux = (u8)(code_b << 4 | code_c);
+      }
+      index_codec_push_edge(&st, b, a);
+      index_codec_push_edge(&st, c, b);
+      index_codec_push_edge(&st, a, c);
+    }
+    Assert((u64)(data - dst) <= cap);
+  }
+  return data - dst;
+}
+
+b32 mesh_decompress_indices(u8* src, u64 size, u32* dst, u32 index_count) {
+  u32 tri_count = index_count / 3;
+  if (index_count % 3 || size < 1 + (u64)tri_count || src[0] != MESH_INDEX_CODEC_HEADER) { return false; }
+  IndexCodecState st;
+  index_codec_init(&st);
+  u8* codes = src + 1;
+  u8* data = codes + tri_count;
+  u8* end = src + size;
+  Loop (t, tri_count) {
+    u32 code = codes[t];
+    u32 a, b, c;
+    if (code >> 4 != 0xf) {
+      u32* e = st.edges[(st.edge_offset - 1 - (code >> 4)) & (CODEC_FIFO_SIZE - 1)];
+      a = e[0];
+      b = e[1];
+      if (!index_codec_decode_vertex(&st, code & 0xf, &data, end, &c)) { return false; }
+      index_codec_push_edge(&st, c, b);
+      index_codec_push_edge(&st, a, c);
+    } else if (code == 0xf0) {
+      index_codec_decode_vertex(&st, 0, &data, end, &a);
+      index_codec_decode_vertex(&st, 0, &data, end, &b);
+      index_codec_decode_vertex(&st, 0, &data, end, &c);
+      index_codec_push_edge(&st, b, a);
+      index_codec_push_edge(&st, c, b);
+      index_codec_push_edge(&st, a, c);
+    } else {
+      if (data == end) { return false; }
+      u32 aux = *data++;
+      u32 code_a = (code & 0xf) == 14 ? 0 : code & 0xf;
+      if (!index_codec_decode_vertex(&st, code_a, &data, end, &a) ||
+          !index_codec_decode_vertex(&st, aux >> 4, &data, end, &b) ||
+          !index_codec_decode_vertex(&st, aux & 0xf, &data, end, &c)) {
+        return false;
+      }
+      index_codec_push_edge(&st, b, a);
+      index_codec_push_edge(&st, c, b);
+      index_codec_push_edge(&st, a, c);
+    }
+    dst[t * 3 + 0] = a;
+    dst[t * 3 + 1] = b;
+    dst[t * 3 + 2] = c;
+  }
+  return data == end;
+}
+
+intern u32 vertex_block_size(u32 vertex_size) {
+  return Min((VERTEX_BLOCK_BYTES / vertex_size) & ~(VERTEX_GROUP_SIZE - 1), VERTEX_BLOCK_MAX);
+}
+
+u64 mesh_compress_vertices_bound(u32 vert_count, u32 vertex_size) {
+  u32 block_size = vertex_block_size(vertex_size);
+  u64 block_count = (vert_count + block_size - 1) / block_size;
+  u64 header_size = (block_size / VERTEX_GROUP_SIZE + 3) / 4;
+  return 1 + block_count * vertex_size * (header_size + block_size) + Max(vertex_size, VERTEX_TAIL_MIN);
+}
+
+// lanes of 0, 2, 4 or 8 bits, values too big for theirs are stored after, in lane order
+intern u8* vertex_group_encode(u8* out, u8* group, u32 bits) {
+  if (bits == 0) { return out; }
+  if (bits == 3) {
+    MemCopy(out, group, VERTEX_GROUP_SIZE);
+    return out + VERTEX_GROUP_SIZE;
+  }
+  u32 width = bits == 1 ? 2 : 4;
+  u32 limit = (1 << width) - 1;
+  u32 per_byte = 8 / width;
+  u8* rest = out + VERTEX_GROUP_SIZE / per_byte;
+  MemSet(out, 0, VERTEX_GROUP_SIZE / per_byte);
+  Loop (i, VERTEX_GROUP_SIZE) {
+    u32 value = Min((u32)group[i], limit);
+    out[i / per_byte] |= value << (8 - width - i % per_byte * width);
+    if (value == limit) { *rest++ = group[i]; }
+  }
+  return rest;
+}
+
+intern u32 vertex_group_bits(u8* group) {
+  u32 over_2 = 0, over_4 = 0;
+  b32 zero = true;
+  Loop (i, VERTEX_GROUP_SIZE) {
+    zero &= group[i] == 0;
+    over_2 += group[i] >= 3;
+    over_4 += group[i] >= 15;
+  }
+  if (zero) { return 0; }
+  u32 size_2 = 4 + over_2, size_4 = 8 + over_4;
+  if (size_2 <= size_4 && size_2 < VERTEX_GROUP_SIZE) { return 1; }
+  return size_4 < VERTEX_GROUP_SIZE ? 2 : 3;
+}
+
+u64 mesh_compress_vertices(void* vertices, u32 vert_count, u32 vertex_size, u8* dst, u64 cap) {
+  Assert(vertex_size % 4 == 0 && vertex_size <= 256 && cap >= mesh_compress_vertices_bound(vert_count, vertex_size));
+  u8* src = (u8*)vertices;
+  u32 block_size = vertex_block_size(vertex_size);
+  u8 last[256] = {};
+  if (vert_count) { MemCopy(last, src, vertex_size); }
+  u8 column[VERTEX_BLOCK_MAX];
+  u8* out = dst;
+  *out++ = MESH_VERTEX_CODEC_HEADER;
+  for (u32 begin = 0; begin < vert_count; begin += block_size) {
+    u32 count = Min(block_size, vert_count - begin);
+    u32 group_count = (count + VERTEX_GROUP_SIZE - 1) / VERTEX_GROUP_SIZE;
+    Loop (k, vertex_size) {
+      u8 prev = last[k];
+      Loop (i, count) {
+        u8 value = src[(u64)(begin + i) * vertex_size + k];
+        u8 delta = value - prev;
+        column[i] = (u8)(delta << 1) ^ (u8)((i8)delta >> 7);
+        prev = value;
+      }
+      MemSet(column + count, 0, group_count * VERTEX_GROUP_SIZE - count);
+      u8* header = out;
+      out += (group_count + 3) / 4;
+      MemSet(header, 0, out - header);
+      Loop (g, group_count) {
+        u32 bits = vertex_group_bits(column + g * VERTEX_GROUP_SIZE);
+        header[g / 4] |= bits << (g % 4 * 2);
+        out = vertex_group_encode(out, column + g * VERTEX_GROUP_SIZE, bits);
+      }
+    }
+    MemCopy(last, src + (u64)(begin + count - 1) * vertex_size, vertex_size);
+  }
+  u32 tail_size = Max(vertex_size, VERTEX_TAIL_MIN);
+  MemSet(out, 0, tail_size - vertex_size);
+  out += tail_size - vertex_size;
+  if (vert_count) { MemCopy(out, src, vertex_size); }
+  out += vertex_size;
+  return out - dst;
+}
+
+intern u8* vertex_group_decode(u8* data, u8* out, u32 bits) {
+  if (bits == 0) {
+    MemSet(out, 0, VERTEX_GROUP_SIZE);
+    return data;
+  }
+  if (bits == 3) {
+    MemCopy(out, data, VERTEX_GROUP_SIZE);
+    return data + VERTEX_GROUP_SIZE;
+  }
+  u32 width = bits == 1 ? 2 : 4;
+  u32 limit = (1 << width) - 1;
+  u32 per_byte = 8 / width;
+  u8* rest = data + VERTEX_GROUP_SIZE / per_byte;
+  Loop (i, VERTEX_GROUP_SIZE) {
+    u8 value = (data[i / per_byte] >> (8 - width - i % per_byte * width)) & limit;
+    out[i] = value == limit ? *rest++ : value;
+  }
+  return rest;
+}
+
+#if SIMD_AVX2
+// for each 8 lane escape mask, which byte after the lanes each escaped lane takes
+struct VertexGroupShuffle {
+  u8 lanes[256][8];
+  u8 count[256];
+};
+
+intern constexpr VertexGroupShuffle vertex_group_shuffle_make() {
+  VertexGroupShuffle result = {};
+  for (u32 mask = 0; mask < 256; ++mask) {
+    u8 count = 0;
+    for (u32 i = 0; i < 8; ++i) {
+      result.lanes[mask][i] = mask >> i & 1 ? count++ : 0x80;
+    }
+    result.count[mask] = count;
+  }
+  return result;
+}
+
+global constexpr VertexGroupShuffle vertex_group_shuffle = vertex_group_shuffle_make();
+
+// NOTE: the lanes are spread to a byte each with shifts and unpacks, escapes compared out, and
+// pshufb pulls the escaped bytes from after the lanes into place. Reads up to 24 bytes.
+intern u8* vertex_group_decode_simd(u8* data, u8* out, u32 bits) {
+  __m128i sel;
+  __m128i rest;
+  __m128i mask;
+  u32 lane_bytes;
+  switch (bits) {
+    case 0: {
+      _mm_storeu_si128((__m128i*)out, _mm_setzero_si128());
+      return data;
+    }
+    case 1: {
+      i32 word;
+      MemCopy(&word, data, sizeof(word));
+      __m128i sel2 = _mm_cvtsi32_si128(word);
+      __m128i sel22 = _mm_unpacklo_epi8(_mm_srli_epi16(sel2, 4), sel2);
+      __m128i sel2222 = _mm_unpacklo_epi8(_mm_srli_epi16(sel22, 2), sel22);
+      sel = _mm_and_si128(sel2222, _mm_set1_epi8(3));
+      mask = _mm_cmpeq_epi8(sel, _mm_set1_epi8(3));
+      lane_bytes = 4;
+    } break;
+    case 2: {
+      __m128i sel4 = _mm_loadl_epi64((__m128i*)data);
+      __m128i sel44 = _mm_unpacklo_epi8(_mm_srli_epi16(sel4, 4), sel4);
+      sel = _mm_and_si128(sel44, _mm_set1_epi8(15));
+      mask = _mm_cmpeq_epi8(sel, _mm_set1_epi8(15));
+      lane_bytes = 8;
+    } break;
+    default: {
+      _mm_storeu_si128((__m128i*)out, _mm_loadu_si128((__m128i*)data));
+      return data + VERTEX_GROUP_SIZE;
+    }
+  }
+  rest = _mm_loadu_si128((__m128i*)(data + lane_bytes));
+  u32 escapes = (u32)_mm_movemask_epi8(mask);
+  u32 low = escapes & 0xff;
+  u32 high = escapes >> 8;
+  __m128i shuffle_low = _mm_loadl_epi64((__m128i*)vertex_group_shuffle.lanes[low]);
+  __m128i shuffle_high = _mm_add_epi8(_mm_loadl_epi64((__m128i*)vertex_group_shuffle.lanes[high]),
+                                      _mm_set1_epi8((char)vertex_group_shuffle.count[low]));
+  __m128i shuffle = _mm_unpacklo_epi64(shuffle_low, shuffle_high);
+  __m128i result = _mm_or_si128(_mm_shuffle_epi8(rest, shuffle), _mm_andnot_si128(mask, sel));
+  _mm_storeu_si128((__m128i*)out, result);
+  return data + lane_bytes + vertex_group_shuffle.count[low] + vertex_group_shuffle.count[high];
+}
+#endif
+
+// undoes the zigzag and sums the deltas down each column
+intern void vertex_block_deltas(u8* columns, u32 column_size, u32 count, u32 vertex_size, u8* last, u8* dst) {
+  Loop (k, vertex_size) {
+    u8 prev = last[k];
+    Loop (i, count) {
+      u8 v = columns[k * column_size + i];
+      prev += (v >> 1) ^ (0 - (v & 1));
+      dst[(u64)i * vertex_size + k] = prev;
+    }
+    last[k] = prev;
+  }
+}
+
+#if ARCH_X64
+// same as vertex_block_deltas 4 columns at a time, reads the columns up to the next whole group,
+// which the encoder pads with zeros
+intern void vertex_block_deltas_simd(u8* columns, u32 column_size, u32 count, u32 vertex_size, u8* last, u8* dst) {
+  for (u32 k = 0; k < vertex_size; k += 4) {
+    i32 word;
+    MemCopy(&word, last + k, sizeof(word));
+    __m128i prev = _mm_shuffle_epi32(_mm_cvtsi32_si128(word), 0);
+    for (u32 i = 0; i < count; i += VERTEX_GROUP_SIZE) {
+      __m128i r[4];
+      Loop (c, 4) {
+        __m128i v = _mm_loadu_si128((__m128i*)(columns + (k + c) * column_size + i));
+        __m128i odd = _mm_sub_epi8(_mm_setzero_si128(), _mm_and_si128(v, _mm_set1_epi8(1)));
+        r[c] = _mm_xor_si128(_mm_and_si128(_mm_srli_epi16(v, 1), _mm_set1_epi8(0x7f)), odd);
+      }
+      // byte i of the 4 columns next to each other, a vertex's 4 bytes per 32 bit lane
+      __m128i t0 = _mm_unpacklo_epi8(r[0], r[1]);
+      __m128i t1 = _mm_unpackhi_epi8(r[0], r[1]);
+      __m128i t2 = _mm_unpacklo_epi8(r[2], r[3]);
+      __m128i t3 = _mm_unpackhi_epi8(r[2], r[3]);
+      __m128i quads[4] = {_mm_unpacklo_epi16(t0, t2), _mm_unpackhi_epi16(t0, t2),
+                          _mm_unpacklo_epi16(t1, t3), _mm_unpackhi_epi16(t1, t3)};
+      Loop (q, 4) {
+        __m128i x = quads[q];
+        x = _mm_add_epi8(x, _mm_slli_si128(x, 4));
+        x = _mm_add_epi8(x, _mm_slli_si128(x, 8));
+        x = _mm_add_epi8(x, prev);
+        prev = _mm_shuffle_epi32(x, 0xff);
+        u32 first = i + q * 4;
+        u32 lanes = first < count ? Min(count - first, 4u) : 0;
+        u8* out = dst + (u64)first * vertex_size + k;
+        Loop (j, lanes) {
+          i32 lane = _mm_cvtsi128_si32(x);
+          MemCopy(out, &lane, sizeof(lane));
+          out += vertex_size;
+          x = _mm_srli_si128(x, 4);
+        }
+      }
+    }
+    word = _mm_cvtsi128_si32(prev);
+    MemCopy(last + k, &word, sizeof(word));
+  }
+}
+#endif
+
+b32 mesh_decompress_vertices(u8* src, u64 size, void* dst, u32 vert_count, u32 vertex_size) {
+  Assert(vertex_size % 4 == 0 && vertex_size <= 256);
+  u32 tail_size = Max(vertex_size, VERTEX_TAIL_MIN);
+  if (size < 1 + tail_size || src[0] != MESH_VERTEX_CODEC_HEADER) { return false; }
+  u8* end = src + size;
+  u8* data_end = end - tail_size;
+  u8 last[256];
+  MemCopy(last, end - vertex_size, vertex_size);
+  u32 block_size = vertex_block_size(vertex_size);
+  u8 columns[VERTEX_BLOCK_BYTES];
+  u8* data = src + 1;
+  for (u32 begin = 0; begin < vert_count; begin += block_size) {
+    u32 count = Min(block_size, vert_count - begin);
+    u32 group_count = (count + VERTEX_GROUP_SIZE - 1) / VERTEX_GROUP_SIZE;
+    Loop (k, vertex_size) {
+      u8* header = data;
+      data += (group_count + 3) / 4;
+      if (data > data_end) { return false; }
+      u8* column = columns + k * block_size;
+      Loop (g, group_count) {
+        u32 bits = header[g / 4] >> (g % 4 * 2) & 3;
+        // the tail keeps a group's widest read inside the buffer, anything past it is malformed
+        if (data > data_end) { return false; }
+#if SIMD_AVX2
+        data = vertex_group_decode_simd(data, column + g * VERTEX_GROUP_SIZE, bits);
+#else
+        data = vertex_group_decode(data, column + g * VERTEX_GROUP_SIZE, bits);
+#endif
+      }
+      if (data > data_end) { return false; }
+    }
+#if ARCH_X64
+    vertex_block_deltas_simd(columns, block_size, count, vertex_size, last, (u8*)dst + (u64)begin * vertex_size);
+#else
+    vertex_block_deltas(columns, block_size, count, vertex_size, last, (u8*)dst + (u64)begin * vertex_size);
+#endif
+  }
+  return data == data_end;
+}
+
+void mesh_optimize(Allocator arena, Mesh* mesh) {
+  if (!mesh->indices || mesh->index_count < 3) { return; }
+  Scratch scratch(arena);
+  mesh_optimize_vertex_cache(mesh->indices, mesh->index_count, mesh->vert_count);
+  mesh_optimize_overdraw(mesh->indices, mesh->index_count, mesh->vertices, mesh->vert_count, 1.05f);
+
+  // every lod aims for half the triangles of the one before, simplified from full detail
+  mesh->lods[0] = {0, mesh->index_count, 0};
+  mesh->lod_count = 1;
+  u32* lod_indices[MESH_LOD_MAX] = {mesh->indices};
+  u32 total = mesh->index_count;
+  f32 extent = mesh_extent(mesh->vertices, mesh->vert_count);
+  while (mesh->lod_count < MESH_LOD_MAX) {
+    MeshLod prev = mesh->lods[mesh->lod_count - 1];
+    u32 target = prev.index_count / 6 * 3;
+    if (target < 3) break;
+    u32* indices = push_array(scratch, u32, mesh->index_count);
+    f32 error;
+    u32 count = mesh_simplify(indices, mesh->indices, mesh->index_count, mesh->vertices, mesh->vert_count, target,
+                              MESH_LOD_MAX_ERROR, &error);
+    // a level that barely moved isn't worth a draw switch
+    if (count == 0 || count > prev.index_count / 4 * 3) break;
+    mesh_optimize_vertex_cache(indices, count, mesh->vert_count);
+    lod_indices[mesh->lod_count] = indices;
+    mesh->lods[mesh->lod_count++] = {total, count, Max(prev.error, error * extent)};
+    total += count;
+  }
+  if (mesh->lod_count > 1) {
+    u32* indices = push_array(arena, u32, total);
+    Loop (i, mesh->lod_count) {
+      MemCopy(indices + mesh->lods[i].index_offset, lod_indices[i], mesh->lods[i].index_count * sizeof(u32));
+    }
+    mesh->indices = indices;
+    mesh->index_count = total;
+  }
+  mesh->vert_count = mesh_optimize_vertex_fetch(mesh->vertices, mesh->vert_count, mesh->indices, mesh->index_count);
+  mesh->meshlets = mesh_build_meshlets(arena, mesh->indices, mesh->lods[0].index_count, mesh->vertices, mesh->vert_count);
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include "common.h"
+
+////////////////////////////////////////////////////////////////////////
+// Vertex cache
+// Post-transform cache modelled as a FIFO of recently shaded vertices. ACMR is misses per
+// triangle, 0.5 is the best a regular grid can do and 3 means no reuse. ATVR is misses per
+// vertex used, 1 is ideal.
+
+const u32 VERTEX_CACHE_SIZE = 16;
+
+struct VertexCacheStats {
+  u32 misses;
+  f32 acmr;
+  f32 atvr;
+};
+
+VertexCacheStats mesh_vertex_cache_stats(u32* indices, u32 index_count, u32 vert_count, u32 cache_size = VERTEX_CACHE_SIZE);
+
+// Tipsify: fans around the vertex that stays in cache longest, indices may be reordered in place
+void mesh_optimize_vertex_cache(u32* indices, u32 index_count, u32 vert_count, u32 cache_size = VERTEX_CACHE_SIZE);
+// sorts clusters of a cache optimized order so outward facing ones draw first, threshold is how
+// much worse than the input ACMR a cluster may get, 1.05 allows 5%
+void mesh_optimize_overdraw(u32* indices, u32 index_count, Vertex* vertices, u32 vert_count, f32 threshold, u32 cache_size = VERTEX_CACHE_SIZE);
+// vertices in the order indices first use them, unused ones dropped, returns the new count
+u32  mesh_optimize_vertex_fetch(Vertex* vertices, u32 vert_count, u32* indices, u32 index_count);
+
+////////////////////////////////////////////////////////////////////////
+// Simplification
+// Edge collapses ranked by quadric error, each vertex moving onto a neighbour so the vertex
+// buffer is shared by every lod. Errors are relative to the mesh's largest extent. Vertices at
+// one position collapse together, their attributes add to the cost, and vertices on open edges
+// never move.
+
+const f32 MESH_LOD_MAX_ERROR   = 0.05f;
+// how far a lod may be off on screen, in pixels, before a finer one is drawn
+const f32 MESH_LOD_PIXEL_ERROR = 1.f;
+
+f32 mesh_extent(Vertex* vertices, u32 vert_count);
+// dst needs index_count room, returns how many it got, stops at target_error even if above target
+u32 mesh_simplify(u32* dst, u32* indices, u32 index_count, Vertex* vertices, u32 vert_count,
+                  u32 target_index_count, f32 target_error, f32* result_error);
+// pixel_scale is the viewport height over 2 tan(fov / 2), lods have to be ordered by error
+u32 mesh_lod_select(MeshLod* lods, u32 lod_count, f32 scale, f32 distance, f32 pixel_scale);
+
+////////////////////////////////////////////////////////////////////////
+// Meshlets
+// Grown greedily from a seed triangle, always taking the neighbour that adds the fewest vertices
+// and turns the cluster's normal the least, so clusters stay compact, cull well by cone and follow
+// the triangle order they were given.
+
+Meshlets mesh_build_meshlets(Allocator arena, u32* indices, u32 index_count, Vertex* vertices, u32 vert_count);
+MeshletBounds meshlet_bounds(Meshlets* meshlets, u32 idx, Vertex* vertices);
+// left, right, bottom, top, near, far, normals point inside
+void frustum_planes(mat4 projection_view, v4 planes[6]);
+b32  meshlet_frustum_culled(MeshletBounds* bounds, v4 planes[6]);
+b32  meshlet_backfacing(MeshletBounds* bounds, v3 camera_pos);
+
+////////////////////////////////////////////////////////////////////////
+// Vertex quantization
+// PackedVertex is in common.h, next to Vertex
+
+u16 f32_to_f16(f32 value);
+f32 f16_to_f32(u16 value);
+VertexQuantization mesh_vertex_quantization(Vertex* vertices, u32 vert_count);
+void mesh_encode_vertices(PackedVertex* dst, Vertex* vertices, u32 vert_count, VertexQuantization quantization);
+void mesh_decode_vertices(Vertex* dst, PackedVertex* packed, u32 vert_count, VertexQuantization quantization);
+
+////////////////////////////////////////////////////////////////////////
+// Buffer compression
+// meshoptimizer's codecs, close to their first version. Indices go a triangle at a time, one code
+// byte naming an edge of a recent triangle and where the third vertex comes from: the next
+// unused index, a recent vertex or a varint delta. Vertices go in blocks of up to 256, each byte
+// of the vertex as its own column of deltas from the vertex before, zigzagged and packed 16 at a
+// time into 0, 2, 4 or 8 bit lanes with the ones that don't fit stored after. Both beat raw LZ4 by
+// far on cache and fetch optimized meshes, and still compress further with it.
+
+u64 mesh_compress_indices_bound(u32 index_count, u32 vert_count);
+// cap has to be at least the bound, returns the compressed size, triangles may come back rotated
+u64 mesh_compress_indices(u32* indices, u32 index_count, u8* dst, u64 cap);
+// false on malformed input
+b32 mesh_decompress_indices(u8* src, u64 size, u32* dst, u32 index_count);
+
+// vertex_size has to be a multiple of 4, up to 256
+u64 mesh_compress_vertices_bound(u32 vert_count, u32 vertex_size);
+u64 mesh_compress_vertices(void* vertices, u32 vert_count, u32 vertex_size, u8* dst, u64 cap);
+b32 mesh_decompress_vertices(u8* src, u64 size, void* dst, u32 vert_count, u32 vertex_size);
+
+// cache and overdraw order, a lod chain appended to the indices and meshlets of lod 0, all in
+// arena, then fetch order, run once when a mesh is cooked
+void mesh_optimize(Allocator arena, Mesh* mesh);
@@ -47,6 +47,13 @@ enum {
   OS_AccessFlag_ShareWrite = Bit(5),
 };
 
+typedef u32 OS_MapFlags;
+enum {
+  OS_MapFlag_Private    = Bit(0), // writable copy-on-write pages, writes never reach the file
+  OS_MapFlag_Sequential = Bit(1), // read front to back, pages behind can be dropped early
+  OS_MapFlag_WillNeed   = Bit(2), // start reading the whole range in now
+};
+
 typedef u32 OS_WatchFlags;
 enum {
   OS_WatchFlag_Create = Bit(0),
@@ -73,7 +80,11 @@ String os_get_current_directory();
 String os_get_current_binary_name();
 
 void os_init(String name);
+// flushes the log first
 void os_exit(i32 exit_code);
+// runs on the crashing thread for fatal signals, then the default action follows
+typedef void OS_CrashHandlerFn();
+void os_set_crash_handler(OS_CrashHandlerFn* handler);
 
 u64 os_timer_frequency();
 u64 os_timer_now();
@@ -81,6 +92,7 @@ u64 os_now_ns();
 void os_sleep_ms(u64 ms);
 void os_sleep_us(u64 us);
 void os_console_write(String message, u32 color);
+void os_console_write_builder(StrBuilder* sb, u32 color);
 String os_get_environment(String name);
 
 ///////////////////////////////////
@@ -90,6 +102,8 @@ u8*  os_reserve(u64 size);
 b32  os_commit(void* ptr, u64 size);
 void os_decommit(void* ptr, u64 size);
 void os_release(void* ptr, u64 size);
+// high water mark of resident memory for the process
+u64  os_peak_rss();
 
 //////////////////////////////////////////////////////////////////////////
 // Files
@@ -98,20 +112,65 @@ OS_Handle      os_file_open(String path, OS_AccessFlags flags);
 void           os_file_close(OS_Handle file);
 u64            os_file_read(OS_Handle file, u64 size, void* out_data);
 u64            os_file_write(OS_Handle file, u64 size, void* data);
+// blocks go out in one gathered syscall per batch, returns bytes written
+u64            os_file_write_builder(OS_Handle file, StrBuilder* sb);
 u64            os_file_size(OS_Handle file);
 FileProperties os_file_properties(OS_Handle file);
+// read-only view of the first size bytes, null on failure, stays valid after the file is closed
+void*          os_file_map(OS_Handle file, u64 size, OS_MapFlags flags = 0);
+void           os_file_unmap(void* ptr, u64 size);
+// whole file, empty on failure, release with os_file_unmap(data, count)
+Slice<u8>      os_file_path_map(String path, OS_MapFlags flags = 0);
 Slice<u8>      os_file_path_read_all(Allocator arena, String path);
 b32            os_file_path_exists(String path);
 b32            os_file_path_copy(String dst, String src);
+// replaces dst if it exists
+b32            os_file_path_rename(String dst, String src);
+b32            os_file_path_delete(String path);
 void           os_file_path_copy_mtime(String src, String dst);
 FileProperties os_file_path_properties(String path);
 b32            os_file_path_equal_mtime(String a, String b);
 
+// Async IO
+// Reads land in caller buffers and complete in any order, tagged with user_data. A queue
+// belongs to one thread. Reads can come back short like read(), result is the byte count
+// or a negative errno.
+struct OS_IoQueue { u64 v; };
+
+struct OS_IoRead {
+  OS_Handle file;
+  u64 offset;
+  u64 size;
+  void* dest;
+  u64 user_data;
+};
+
+struct OS_IoCompletion {
+  u64 user_data;
+  i64 result;
+};
+
+// depth is how many reads can be in flight at once
+OS_IoQueue os_io_queue_alloc(Allocator arena, u32 depth);
+void       os_io_queue_release(OS_IoQueue queue);
+// reads that fall inside one of these skip pinning pages on every read, register before
+// submitting anything, the array is kept by pointer
+b32        os_io_register_buffers(OS_IoQueue queue, Slice<u8>* buffers, u32 count);
+// takes as many reads as there is room for and submits them as one batch, returns how many
+u32        os_io_submit(OS_IoQueue queue, OS_IoRead* reads, u32 count);
+// returns up to cap completions, blocks until at least min_count are done
+u32        os_io_complete(OS_IoQueue queue, OS_IoCompletion* out, u32 cap, u32 min_count);
+u32        os_io_in_flight(OS_IoQueue queue);
+
 // Directory
 OS_Handle os_directory_open(String path);
 OS_Handle os_directory_create(String path);
 OS_Handle os_directory_create_p(String path);
 b32       os_directory_path_exist(String path);
+// only removes empty directories
+b32       os_directory_delete(String path);
+// a new empty directory under the system temp directory, empty on failure
+String    os_directory_create_temp(Allocator arena, String prefix);
 
 // Watch
 OS_Watch   os_watch_open(OS_WatchFlags flags);
@@ -137,6 +196,8 @@ i32       os_process_join(OS_Handle handle);
 Thread os_thread_launch(ThreadEntryPointFn* func, void *ptr);
 b32 os_thread_join(Thread handle);
 void os_thread_detach(Thread handle);
+// logical cores the process can run on, at least 1
+u32  os_get_cpu_count();
 
 ///////////////////////////////////
 // Sync primitives
@@ -161,6 +222,11 @@ Barrier   os_barrier_alloc(u32 count);
 void      os_barrier_release(Barrier barrier);
 void      os_barrier_wait(Barrier barrier);
 
+// sleeps while *addr == expected, can wake up spuriously
+void      os_futex_wait(u32* addr, u32 expected);
+void      os_futex_wake(u32* addr);
+void      os_futex_wake_all(u32* addr);
+
 ////////////////////////////////////////////////////////////////////////
 // Lib
 
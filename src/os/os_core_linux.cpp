@@ -4,11 +4,14 @@
 
 #include <dirent.h>
 #include <dlfcn.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <spawn.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <sys/inotify.h>
 #include <sys/mman.h>
+#include <sys/resource.h>
 #include <sys/sendfile.h>
 #include <sys/stat.h>
 #include <sys/time.h>
@@ -17,7 +20,14 @@
 #include <time.h>
 #include <unistd.h>
 #include <pthread.h>
+#include <signal.h>
 #include <semaphore.h>
+#include <linux/futex.h>
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#if ASAN_ENABLED
+  #include <sanitizer/common_interface_defs.h>
+#endif
 
 struct OS_LNX_FileIter {
   DIR* dir;
@@ -85,7 +95,39 @@ void os_init(String name) {
   os_st.binary_name = str_skip_last_slash(name);
 }
 
-void os_exit(i32 exit_code) { _exit(exit_code); }
+void os_exit(i32 exit_code) {
+  log_flush();
+  _exit(exit_code);
+}
+
+global OS_CrashHandlerFn* os_lnx_crash_handler;
+
+intern void os_lnx_crash_signal(int sig) {
+  os_lnx_crash_handler();
+  // SA_RESETHAND restored the default action, raising again takes it
+  raise(sig);
+}
+
+void os_set_crash_handler(OS_CrashHandlerFn* handler) {
+  os_lnx_crash_handler = handler;
+  struct sigaction action = {};
+  action.sa_handler = os_lnx_crash_signal;
+  action.sa_flags = SA_RESETHAND;
+  sigemptyset(&action.sa_mask);
+  // SIGTRAP stays with the debugger, DebugTrap flushes by itself
+  int signals[] = {
+    SIGABRT, SIGILL,
+#if !ASAN_ENABLED
+    SIGSEGV, SIGBUS, SIGFPE, // asan reports these, it calls back through the death callback
+#endif
+  };
+  for EachElement(i, signals) {
+    sigaction(signals[i], &action, null);
+  }
+#if ASAN_ENABLED
+  __sanitizer_set_death_callback(handler);
+#endif
+}
 
 u64 os_timer_frequency() { return Million(1); }
 
@@ -116,7 +158,7 @@ void os_sleep_us(u64 us) {
   nanosleep(&ts, null);
 }
 
-void os_console_write(String message, u32 color) {
+intern String os_lnx_console_color(u32 color) {
   String color_str;
   switch (color) {
     case 0: color_str = "\x1b[0m";  break; // Reset
@@ -126,6 +168,47 @@ void os_console_write(String message, u32 color) {
     case 4: color_str = "\x1b[33m"; break; // Yellow
     case 5: color_str = "\x1b[31m"; break; // Red
   }
+  return color_str;
+}
+
+// writev takes a bounded number of blocks and can stop early on pipes, so batch and resume
+intern u64 os_lnx_writev_builder(int fd, StrBuilderChunk* chunk, iovec* prefix) {
+  iovec iov[64];
+  u64 total = 0;
+  u32 count = 0;
+  if (prefix) {
+    iov[count++] = *prefix;
+  }
+  while (chunk || count) {
+    for (; chunk && count < ArrayCount(iov); chunk = chunk->next) {
+      if (chunk->size) {
+        iov[count++] = {.iov_base = chunk->str, .iov_len = chunk->size};
+      }
+    }
+    u32 done = 0;
+    while (done < count) {
+      ssize_t written = writev(fd, iov + done, count - done);
+      if (written < 0) {
+        if (errno == EINTR) continue;
+        return total;
+      }
+      total += written;
+      while (done < count && (u64)written >= iov[done].iov_len) {
+        written -= iov[done].iov_len;
+        ++done;
+      }
+      if (done < count) {
+        iov[done].iov_base = (u8*)iov[done].iov_base + written;
+        iov[done].iov_len -= written;
+      }
+    }
+    count = 0;
+  }
+  return total;
+}
+
+void os_console_write(String message, u32 color) {
+  String color_str = os_lnx_console_color(color);
   iovec iov[] = {
     {.iov_base = color_str.str, .iov_len = color_str.size},
     {.iov_base = message.str, .iov_len = message.size}
@@ -133,11 +216,17 @@ void os_console_write(String message, u32 color) {
   writev(STDOUT_FILENO, iov, ArrayCount(iov));
 }
 
+void os_console_write_builder(StrBuilder* sb, u32 color) {
+  String color_str = os_lnx_console_color(color);
+  iovec prefix = {.iov_base = color_str.str, .iov_len = color_str.size};
+  os_lnx_writev_builder(STDOUT_FILENO, sb->first, &prefix);
+}
+
 String os_get_environment(String name) {
   Scratch scratch;
   String name_c = push_str_copy(scratch, name);
-  String result = getenv((char*)name_c.str);
-  return result;
+  char* value = getenv((char*)name_c.str);
+  return value ? String(value) : String();
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -148,6 +237,13 @@ b32  os_commit(void* ptr, u64 size)        { return mprotect(ptr, size, PROT_REA
 void os_decommit(void* ptr, u64 size)      { mprotect(ptr, size, PROT_NONE);}
 void os_release(void* ptr, u64 size)       { munmap(ptr, size);}
 
+u64 os_peak_rss() {
+  struct rusage usage = {};
+  getrusage(RUSAGE_SELF, &usage);
+  // ru_maxrss is in kilobytes on linux
+  return (u64)usage.ru_maxrss * KB(1);
+}
+
 //////////////////////////////////////////////////////////////////////////
 // Files
 
@@ -210,6 +306,12 @@ u64 os_file_write(OS_Handle file, u64 size, void* data) {
   return size_written;
 }
 
+u64 os_file_write_builder(OS_Handle file, StrBuilder* sb) {
+  if (file.v == 0) { return 0; }
+  int fd = file.v;
+  return os_lnx_writev_builder(fd, sb->first, null);
+}
+
 u64 os_file_size(OS_Handle file) {
   FileProperties props = os_file_properties(file);
   return props.size;
@@ -228,6 +330,22 @@ FileProperties os_file_properties(OS_Handle file) {
   return props;
 }
 
+void* os_file_map(OS_Handle file, u64 size, OS_MapFlags flags) {
+  if (file.v == 0 || size == 0) { return null; }
+  int fd = file.v;
+  int prot = PROT_READ | (flags & OS_MapFlag_Private ? PROT_WRITE : 0);
+  void* ptr = mmap(null, size, prot, MAP_PRIVATE, fd, 0);
+  if (ptr == MAP_FAILED) { return null; }
+  // hints only, a failure still leaves a valid mapping
+  if (flags & OS_MapFlag_Sequential) { madvise(ptr, size, MADV_SEQUENTIAL); }
+  if (flags & OS_MapFlag_WillNeed)   { madvise(ptr, size, MADV_WILLNEED); }
+  return ptr;
+}
+
+void os_file_unmap(void* ptr, u64 size) {
+  if (ptr) { munmap(ptr, size); }
+}
+
 b32 os_file_path_exists(String path) {
   Scratch scratch;
   String path_c = push_str_copy(scratch, path);
@@ -255,6 +373,19 @@ b32 os_file_path_copy(String dst, String src) {
   return result;
 }
 
+b32 os_file_path_rename(String dst, String src) {
+  Scratch scratch;
+  String src_c = push_str_copy(scratch, src);
+  String dst_c = push_str_copy(scratch, dst);
+  return rename((char*)src_c.str, (char*)dst_c.str) == 0;
+}
+
+b32 os_file_path_delete(String path) {
+  Scratch scratch;
+  String path_c = push_str_copy(scratch, path);
+  return unlink((char*)path_c.str) == 0;
+}
+
 void os_file_path_copy_mtime(String src, String dst) {
   Scratch scratch;
   String src_c = push_str_copy(scratch, src);
@@ -276,6 +407,16 @@ FileProperties os_file_path_properties(String path) {
   return props;
 }
 
+Slice<u8> os_file_path_map(String path, OS_MapFlags flags) {
+  OS_Handle f = os_file_open(path, OS_AccessFlag_Read);
+  if (f.v == 0) { return {}; }
+  u64 size = os_file_size(f);
+  u8* ptr = (u8*)os_file_map(f, size, flags);
+  os_file_close(f);
+  if (ptr == null) { return {}; }
+  return {ptr, size};
+}
+
 Slice<u8> os_file_path_read_all(Allocator arena, String path) {
   Scratch scratch(arena);
   OS_Handle f = os_file_open(path, OS_AccessFlag_Read);
@@ -295,6 +436,309 @@ b32 os_file_path_equal_mtime(String a, String b) {
   return false;
 }
 
+// Async IO
+
+// io_uring through the raw syscalls, liburing isn't a dependency. When the kernel refuses a
+// ring (too old, seccomp) or can't do IORING_OP_READ (before 5.6) the queue is served by a
+// few threads doing pread instead.
+const u32 OS_LNX_IO_FALLBACK_THREADS = 4;
+// the kernel clamps the probe to the ops it knows
+const u32 OS_LNX_IO_PROBE_OPS = 256;
+// the kernel caps a single read at this anyway
+const u64 OS_LNX_IO_MAX_READ = 0x7ffff000;
+
+struct OS_LNX_IoRing {
+  int fd;
+  u32* sq_head;
+  u32* sq_tail;
+  u32* sq_array;
+  u32 sq_mask;
+  io_uring_sqe* sqes;
+  u32* cq_head;
+  u32* cq_tail;
+  u32 cq_mask;
+  io_uring_cqe* cqes;
+  u8* sq_map;
+  u64 sq_map_size;
+  u8* cq_map;
+  u64 cq_map_size;
+  u64 sqes_size;
+  Slice<u8>* buffers;
+  u32 buffer_count;
+  OS_IoCompletion* done; // ring of depth, reads the kernel didn't take and were done in submit
+  u32 done_head;
+  u32 done_count;
+};
+
+struct OS_LNX_IoFallback {
+  Mutex mutex;
+  CondVar work_cv;
+  CondVar done_cv;
+  OS_IoRead* reads;      // ring of depth
+  u32 read_head;
+  u32 read_count;
+  OS_IoCompletion* done; // ring of depth
+  u32 done_head;
+  u32 done_count;
+  b32 quit;
+  Thread threads[OS_LNX_IO_FALLBACK_THREADS];
+};
+
+struct OS_LNX_IoQueue {
+  u32 depth;
+  u32 in_flight;
+  b32 uring;
+  OS_LNX_IoRing ring;
+  OS_LNX_IoFallback fallback;
+};
+
+intern b32 os_lnx_io_ring_can_read(int fd) {
+  Scratch scratch;
+  u64 size = sizeof(io_uring_probe) + OS_LNX_IO_PROBE_OPS * sizeof(io_uring_probe_op);
+  io_uring_probe* probe = (io_uring_probe*)push_array_zero(scratch, u8, size);
+  // the probe came with 5.6 too, failing it means the kernel is older
+  int result = syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, OS_LNX_IO_PROBE_OPS);
+  if (result < 0 || probe->last_op < IORING_OP_READ) { return false; }
+  return probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED;
+}
+
+intern b32 os_lnx_io_ring_init(OS_LNX_IoRing* ring, u32* depth) {
+  io_uring_params params = {};
+  int fd = syscall(__NR_io_uring_setup, *depth, &params);
+  if (fd < 0) { return false; }
+  if (!os_lnx_io_ring_can_read(fd)) {
+    close(fd);
+    return false;
+  }
+  ring->fd = fd;
+  ring->sq_map_size = params.sq_off.array + params.sq_entries * sizeof(u32);
+  ring->cq_map_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  ring->sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+  b32 single_map = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (single_map) {
+    ring->sq_map_size = ring->cq_map_size = Max(ring->sq_map_size, ring->cq_map_size);
+  }
+  void* sq_map = mmap(null, ring->sq_map_size, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  void* cq_map = single_map ? sq_map : mmap(null, ring->cq_map_size, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+  void* sqes = mmap(null, ring->sqes_size, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, fd, IORING_OFF_SQES);
+  if (sq_map == MAP_FAILED || cq_map == MAP_FAILED || sqes == MAP_FAILED) {
+    if (sq_map != MAP_FAILED) munmap(sq_map, ring->sq_map_size);
+    if (!single_map && cq_map != MAP_FAILED) munmap(cq_map, ring->cq_map_size);
+    if (sqes != MAP_FAILED) munmap(sqes, ring->sqes_size);
+    close(fd);
+    return false;
+  }
+  ring->sq_map = (u8*)sq_map;
+  ring->cq_map = (u8*)cq_map;
+  ring->sq_head = (u32*)(ring->sq_map + params.sq_off.head);
+  ring->sq_tail = (u32*)(ring->sq_map + params.sq_off.tail);
+  ring->sq_array = (u32*)(ring->sq_map + params.sq_off.array);
+  ring->sq_mask = *(u32*)(ring->sq_map + params.sq_off.ring_mask);
+  ring->sqes = (io_uring_sqe*)sqes;
+  ring->cq_head = (u32*)(ring->cq_map + params.cq_off.head);
+  ring->cq_tail = (u32*)(ring->cq_map + params.cq_off.tail);
+  ring->cq_mask = *(u32*)(ring->cq_map + params.cq_off.ring_mask);
+  ring->cqes = (io_uring_cqe*)(ring->cq_map + params.cq_off.cqes);
+  // the completion ring is twice as big, so keeping depth reads in flight can't overflow it
+  *depth = params.sq_entries;
+  return true;
+}
+
+intern void os_lnx_io_worker(void* ptr) {
+  OS_LNX_IoQueue* q = (OS_LNX_IoQueue*)ptr;
+  OS_LNX_IoFallback& f = q->fallback;
+  os_mutex_take(f.mutex);
+  for (;;) {
+    while (!f.read_count && !f.quit) {
+      os_cond_var_wait(f.work_cv, f.mutex);
+    }
+    if (f.quit) break;
+    OS_IoRead read = f.reads[f.read_head];
+    f.read_head = (f.read_head + 1) % q->depth;
+    f.read_count--;
+    os_mutex_drop(f.mutex);
+    i64 result = pread((int)read.file.v, read.dest, read.size, read.offset);
+    if (result < 0) result = -errno;
+    os_mutex_take(f.mutex);
+    f.done[(f.done_head + f.done_count) % q->depth] = {read.user_data, result};
+    f.done_count++;
+    os_cond_var_signal(f.done_cv);
+  }
+  os_mutex_drop(f.mutex);
+}
+
+OS_IoQueue os_io_queue_alloc(Allocator arena, u32 depth) {
+  OS_LNX_IoQueue* q = push_struct_zero(arena, OS_LNX_IoQueue);
+  q->depth = depth;
+  q->uring = os_lnx_io_ring_init(&q->ring, &q->depth);
+  if (q->uring) {
+    q->ring.done = push_array(arena, OS_IoCompletion, q->depth);
+  } else {
+    OS_LNX_IoFallback& f = q->fallback;
+    f.mutex = os_mutex_alloc();
+    f.work_cv = os_cond_var_alloc();
+    f.done_cv = os_cond_var_alloc();
+    f.reads = push_array(arena, OS_IoRead, depth);
+    f.done = push_array(arena, OS_IoCompletion, depth);
+    Loop (i, OS_LNX_IO_FALLBACK_THREADS) {
+      f.threads[i] = os_thread_launch(os_lnx_io_worker, q);
+    }
+  }
+  return {(u64)q};
+}
+
+void os_io_queue_release(OS_IoQueue queue) {
+  OS_LNX_IoQueue* q = (OS_LNX_IoQueue*)queue.v;
+  if (q->uring) {
+    OS_LNX_IoRing& ring = q->ring;
+    munmap(ring.sqes, ring.sqes_size);
+    if (ring.cq_map != ring.sq_map) munmap(ring.cq_map, ring.cq_map_size);
+    munmap(ring.sq_map, ring.sq_map_size);
+    close(ring.fd);
+  } else {
+    OS_LNX_IoFallback& f = q->fallback;
+    os_mutex_take(f.mutex);
+    f.quit = true;
+    os_cond_var_broadcast(f.work_cv);
+    os_mutex_drop(f.mutex);
+    Loop (i, OS_LNX_IO_FALLBACK_THREADS) {
+      os_thread_join(f.threads[i]);
+    }
+    os_cond_var_release(f.work_cv);
+    os_cond_var_release(f.done_cv);
+    os_mutex_release(f.mutex);
+  }
+}
+
+b32 os_io_register_buffers(OS_IoQueue queue, Slice<u8>* buffers, u32 count) {
+  OS_LNX_IoQueue* q = (OS_LNX_IoQueue*)queue.v;
+  if (!q->uring) { return false; }
+  Scratch scratch;
+  iovec* iovecs = push_array(scratch, iovec, count);
+  Loop (i, count) {
+    iovecs[i] = {buffers[i].data, buffers[i].count};
+  }
+  // can fail on RLIMIT_MEMLOCK, reads still work, just without the fixed buffers
+  int result = syscall(__NR_io_uring_register, q->ring.fd, IORING_REGISTER_BUFFERS, iovecs, count);
+  if (result < 0) { return false; }
+  q->ring.buffers = buffers;
+  q->ring.buffer_count = count;
+  return true;
+}
+
+u32 os_io_submit(OS_IoQueue queue, OS_IoRead* reads, u32 count) {
+  OS_LNX_IoQueue* q = (OS_LNX_IoQueue*)queue.v;
+  u32 n = Min(count, q->depth - q->in_flight);
+  if (n == 0) { return 0; }
+  if (q->uring) {
+    OS_LNX_IoRing& ring = q->ring;
+    u32 tail = *ring.sq_tail;
+    Loop (i, n) {
+      OS_IoRead& read = reads[i];
+      u32 idx = tail & ring.sq_mask;
+      io_uring_sqe* sqe = &ring.sqes[idx];
+      MemSet(sqe, 0, sizeof(*sqe));
+      sqe->opcode = IORING_OP_READ;
+      sqe->fd = (int)read.file.v;
+      sqe->off = read.offset;
+      sqe->addr = (u64)read.dest;
+      sqe->len = (u32)Min(read.size, OS_LNX_IO_MAX_READ);
+      sqe->user_data = read.user_data;
+      Loop (b, ring.buffer_count) {
+        u8* start = ring.buffers[b].data;
+        if ((u8*)read.dest >= start && (u8*)read.dest + sqe->len <= start + ring.buffers[b].count) {
+          sqe->opcode = IORING_OP_READ_FIXED;
+          sqe->buf_index = b;
+          break;
+        }
+      }
+      ring.sq_array[idx] = idx;
+      tail++;
+    }
+    __atomic_store_n(ring.sq_tail, tail, __ATOMIC_RELEASE);
+    u32 submitted = 0;
+    while (submitted < n) {
+      int result = syscall(__NR_io_uring_enter, ring.fd, n - submitted, 0, 0, null, 0);
+      if (result > 0) {
+        submitted += result;
+      } else if (result < 0 && errno == EINTR) {
+        continue;
+      } else {
+        break;
+      }
+    }
+    if (submitted < n) {
+      // EAGAIN or EBUSY, the kernel only reads entries on enter, so the rest can be taken back
+      // out of the ring and read here, completions are handed out before the ring's
+      __atomic_store_n(ring.sq_tail, tail - (n - submitted), __ATOMIC_RELEASE);
+      for (u32 i = submitted; i < n; ++i) {
+        OS_IoRead& read = reads[i];
+        i64 result = pread((int)read.file.v, read.dest, Min(read.size, OS_LNX_IO_MAX_READ), read.offset);
+        if (result < 0) result = -errno;
+        ring.done[(ring.done_head + ring.done_count) % q->depth] = {read.user_data, result};
+        ring.done_count++;
+      }
+    }
+  } else {
+    OS_LNX_IoFallback& f = q->fallback;
+    os_mutex_take(f.mutex);
+    Loop (i, n) {
+      f.reads[(f.read_head + f.read_count) % q->depth] = reads[i];
+      f.read_count++;
+    }
+    os_cond_var_broadcast(f.work_cv);
+    os_mutex_drop(f.mutex);
+  }
+  q->in_flight += n;
+  return n;
+}
+
+u32 os_io_complete(OS_IoQueue queue, OS_IoCompletion* out, u32 cap, u32 min_count) {
+  OS_LNX_IoQueue* q = (OS_LNX_IoQueue*)queue.v;
+  min_count = Min(min_count, Min(cap, q->in_flight));
+  u32 got = 0;
+  if (q->uring) {
+    OS_LNX_IoRing& ring = q->ring;
+    while (ring.done_count && got < cap) {
+      out[got++] = ring.done[ring.done_head];
+      ring.done_head = (ring.done_head + 1) % q->depth;
+      ring.done_count--;
+    }
+    for (;;) {
+      u32 head = *ring.cq_head;
+      u32 tail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+      while (head != tail && got < cap) {
+        io_uring_cqe* cqe = &ring.cqes[head & ring.cq_mask];
+        out[got++] = {cqe->user_data, cqe->res};
+        head++;
+      }
+      __atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+      if (got >= min_count) break;
+      syscall(__NR_io_uring_enter, ring.fd, 0, min_count - got, IORING_ENTER_GETEVENTS, null, 0);
+    }
+  } else {
+    OS_LNX_IoFallback& f = q->fallback;
+    os_mutex_take(f.mutex);
+    for (;;) {
+      while (f.done_count && got < cap) {
+        out[got++] = f.done[f.done_head];
+        f.done_head = (f.done_head + 1) % q->depth;
+        f.done_count--;
+      }
+      if (got >= min_count) break;
+      os_cond_var_wait(f.done_cv, f.mutex);
+    }
+    os_mutex_drop(f.mutex);
+  }
+  q->in_flight -= got;
+  return got;
+}
+
+u32 os_io_in_flight(OS_IoQueue queue) {
+  OS_LNX_IoQueue* q = (OS_LNX_IoQueue*)queue.v;
+  return q->in_flight;
+}
+
 // Directory
 
 OS_Handle os_directory_open(String path) {
@@ -345,6 +789,21 @@ b32 os_directory_path_exist(String path) {
   return false;
 }
 
+b32 os_directory_delete(String path) {
+  Scratch scratch;
+  String path_c = push_str_copy(scratch, path);
+  return rmdir((char*)path_c.str) == 0;
+}
+
+String os_directory_create_temp(Allocator arena, String prefix) {
+  String temp_dir = os_get_environment("TMPDIR");
+  if (temp_dir.size == 0) { temp_dir = "/tmp"; }
+  // mkdtemp fills in the Xs in place
+  String path = push_strf(arena, "%s/%s_XXXXXX", temp_dir, prefix);
+  if (!mkdtemp((char*)path.str)) { return {}; }
+  return path;
+}
+
 // Watch
 
 OS_Watch os_watch_open(OS_WatchFlags flags) {
@@ -513,6 +972,11 @@ void os_thread_detach(Thread handle) {
   pthread_detach(handle.v);
 }
 
+u32 os_get_cpu_count() {
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+  return count > 0 ? (u32)count : 1;
+}
+
 ///////////////////////////////////
 // Sync primitives
 
@@ -606,6 +1070,18 @@ void os_barrier_wait(Barrier barrier) {
   pthread_barrier_wait(&entity->barrier);
 }
 
+void os_futex_wait(u32* addr, u32 expected) {
+  syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, expected, null, null, 0);
+}
+
+void os_futex_wake(u32* addr) {
+  syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, 1, null, null, 0);
+}
+
+void os_futex_wake_all(u32* addr) {
+  syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, INT32_MAX, null, null, 0);
+}
+
 ////////////////////////////////////////////////////////////////////////
 // Lib
 
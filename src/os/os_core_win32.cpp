@@ -4,6 +4,7 @@
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
 #include <windowsx.h>
+#include <psapi.h>
 
 struct OS_State {
   Arena* arena;
@@ -138,6 +139,24 @@ void os_console_write(String message, u32 color) {
   WriteConsoleA(GetStdHandle(STD_OUTPUT_HANDLE), message.str, message.size, number_written, 0);
 }
 
+void os_console_write_builder(StrBuilder* sb, u32 color) {
+  for EachNode(chunk, StrBuilderChunk, sb->first) {
+    os_console_write({chunk->str, chunk->size}, color);
+  }
+}
+
+global OS_CrashHandlerFn* win32_crash_handler;
+
+intern LONG WINAPI win32_crash_filter(EXCEPTION_POINTERS* info) {
+  win32_crash_handler();
+  return EXCEPTION_CONTINUE_SEARCH;
+}
+
+void os_set_crash_handler(OS_CrashHandlerFn* handler) {
+  win32_crash_handler = handler;
+  SetUnhandledExceptionFilter(win32_crash_filter);
+}
+
 void os_message_box(String message) { 
   Scratch scratch;
   String message_c = push_str_copy(scratch, message);
@@ -193,6 +212,21 @@ void  os_release(void* ptr, u64 size)       { VirtualFree(ptr, 0, MEM_RELEASE);
 void* os_reserve_large(u64 size)            { return VirtualAlloc(0, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE); } // we commit on reserve because windows
 b32   os_commit_large(void* ptr, u64 size)  { return 1; }
 
+u64 os_peak_rss() {
+  PROCESS_MEMORY_COUNTERS counters = {};
+  GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+  return counters.PeakWorkingSetSize;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Threads
+
+u32 os_get_cpu_count() {
+  SYSTEM_INFO info = {};
+  GetSystemInfo(&info);
+  return info.dwNumberOfProcessors ? info.dwNumberOfProcessors : 1;
+}
+
 //////////////////////////////////////////////////////////////////////////
 // File
 
@@ -327,6 +361,14 @@ u64 os_file_write(OS_Handle file, u64 size, void* data) {
   return bytes_wrote;
 }
 
+u64 os_file_write_builder(OS_Handle file, StrBuilder* sb) {
+  u64 total = 0;
+  for EachNode(chunk, StrBuilderChunk, sb->first) {
+    total += os_file_write(file, chunk->size, chunk->str);
+  }
+  return total;
+}
+
 u64 os_file_size(OS_Handle file) {
   u32 hsize;
   u32 lsize = GetFileSize((HANDLE)file, (LPDWORD)&hsize);
@@ -334,6 +376,36 @@ u64 os_file_size(OS_Handle file) {
   return result;
 }
 
+void* os_file_map(OS_Handle file, u64 size, OS_MapFlags flags) {
+  if (file == 0 || size == 0) { return null; }
+  b32 is_private = flags & OS_MapFlag_Private;
+  HANDLE mapping = CreateFileMappingA((HANDLE)file, null, is_private ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, null);
+  if (mapping == null) { return null; }
+  void* ptr = MapViewOfFile(mapping, is_private ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, size);
+  // the view keeps the mapping alive
+  CloseHandle(mapping);
+  // no sequential hint for views, the cache manager picks up linear access on its own
+  if (ptr && (flags & OS_MapFlag_WillNeed)) {
+    WIN32_MEMORY_RANGE_ENTRY range = {ptr, size};
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+  }
+  return ptr;
+}
+
+Slice<u8> os_file_path_map(String path, OS_MapFlags flags) {
+  OS_Handle f = os_file_open(path, OS_AccessFlag_Read|OS_AccessFlag_ShareRead);
+  if (f == 0) { return {}; }
+  u64 size = os_file_size(f);
+  u8* ptr = (u8*)os_file_map(f, size, flags);
+  os_file_close(f);
+  if (ptr == null) { return {}; }
+  return {ptr, size};
+}
+
+void os_file_unmap(void* ptr, u64 size) {
+  if (ptr) { UnmapViewOfFile(ptr); }
+}
+
 FileProperties os_properties_from_file(OS_Handle file) {
   BY_HANDLE_FILE_INFORMATION info;
   GetFileInformationByHandle((HANDLE)file, &info);
@@ -361,11 +433,96 @@ FileProperties os_properties_from_file_path(String path) {
   return props;
 }
 
+// Async IO
+// TODO: overlapped reads on a completion port, for now reads run at submit and
+// os_io_complete hands the results back
+
+struct OS_W32_IoQueue {
+  u32 depth;
+  u32 in_flight;
+  u32 done_head;
+  OS_IoCompletion* done; // ring of depth
+};
+
+OS_IoQueue os_io_queue_alloc(Allocator arena, u32 depth) {
+  OS_W32_IoQueue* q = push_struct_zero(arena, OS_W32_IoQueue);
+  q->depth = depth;
+  q->done = push_array(arena, OS_IoCompletion, depth);
+  return {(u64)q};
+}
+
+void os_io_queue_release(OS_IoQueue queue) {}
+
+b32 os_io_register_buffers(OS_IoQueue queue, Slice<u8>* buffers, u32 count) { return false; }
+
+u32 os_io_submit(OS_IoQueue queue, OS_IoRead* reads, u32 count) {
+  OS_W32_IoQueue* q = (OS_W32_IoQueue*)queue.v;
+  u32 n = Min(count, q->depth - q->in_flight);
+  Loop (i, n) {
+    OS_IoRead& read = reads[i];
+    OVERLAPPED overlapped = {};
+    overlapped.Offset = (DWORD)read.offset;
+    overlapped.OffsetHigh = (DWORD)(read.offset >> 32);
+    DWORD bytes_read = 0;
+    b32 ok = ReadFile((HANDLE)read.file.v, read.dest, (DWORD)Min(read.size, U32_MAX), &bytes_read, &overlapped);
+    i64 result = ok ? (i64)bytes_read : -(i64)GetLastError();
+    q->done[(q->done_head + q->in_flight) % q->depth] = {read.user_data, result};
+    q->in_flight++;
+  }
+  return n;
+}
+
+u32 os_io_complete(OS_IoQueue queue, OS_IoCompletion* out, u32 cap, u32 min_count) {
+  OS_W32_IoQueue* q = (OS_W32_IoQueue*)queue.v;
+  u32 got = 0;
+  while (q->in_flight && got < cap) {
+    out[got++] = q->done[q->done_head];
+    q->done_head = (q->done_head + 1) % q->depth;
+    q->in_flight--;
+  }
+  return got;
+}
+
+u32 os_io_in_flight(OS_IoQueue queue) {
+  OS_W32_IoQueue* q = (OS_W32_IoQueue*)queue.v;
+  return q->in_flight;
+}
+
 b32 os_copy_file_path(String dst, String src) {
   b32 result = CopyFile((char*)src.str, (char*)dst.str, false);
   return result;
 }
 
+b32 os_file_path_rename(String dst, String src) {
+  b32 result = MoveFileExA((char*)src.str, (char*)dst.str, MOVEFILE_REPLACE_EXISTING);
+  return result;
+}
+
+b32 os_file_path_delete(String path) {
+  Scratch scratch;
+  String path_c = push_str_copy(scratch, path);
+  return DeleteFileA((char*)path_c.str);
+}
+
+b32 os_directory_delete(String path) {
+  Scratch scratch;
+  String path_c = push_str_copy(scratch, path);
+  return RemoveDirectoryA((char*)path_c.str);
+}
+
+String os_directory_create_temp(Allocator arena, String prefix) {
+  char temp_dir[MAX_PATH + 1];
+  DWORD size = GetTempPathA(ArrayCount(temp_dir), temp_dir);
+  if (size == 0 || size > MAX_PATH) { return {}; }
+  // the path ends in a slash, the process id and a counter make the name unique
+  Loop (i, 100) {
+    String path = push_strf(arena, "%s%s_%u_%i", String((u8*)temp_dir, size), prefix, (u32)GetCurrentProcessId(), i);
+    if (CreateDirectoryA((char*)path.str, null)) { return path; }
+    if (GetLastError() != ERROR_ALREADY_EXISTS) { break; }
+  }
+  return {};
+}
+
 b32 os_file_path_exists(String path) {
   DWORD attributes = GetFileAttributesA((char*)path.str);
   return (attributes != INVALID_FILE_ATTRIBUTES && !(attributes & FILE_ATTRIBUTE_DIRECTORY));
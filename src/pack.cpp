@@ -0,0 +1,387 @@
+#include "pack.h"
+
+////////////////////////////////////////////////////////////////////////
+// LZ4
+// NOTE: a sequence is a token (literal count << 4 | match length - 4), the literals, a 16 bit
+// offset back into the output and the match. Counts of 15 and up continue in bytes of 255.
+// The last sequence is literals only and the last 5 bytes are always literals.
+
+const u32 LZ4_MIN_MATCH     = 4;
+const u32 LZ4_LAST_LITERALS = 5;
+const u32 LZ4_MATCH_LIMIT   = 12; // no match starts in the last 12 bytes
+const u32 LZ4_MAX_OFFSET    = 65535;
+const u32 LZ4_HASH_BITS     = 12;
+
+intern u32 lz4_read32(u8* p) {
+  u32 result;
+  MemCopy(&result, p, sizeof(result));
+  return result;
+}
+
+// the token nibble already says 15
+intern u8* lz4_write_count(u8* out, u64 count) {
+  count -= 15;
+  while (count >= 255) {
+    *out++ = 255;
+    count -= 255;
+  }
+  *out++ = (u8)count;
+  return out;
+}
+
+// offset 0 is the closing literals-only sequence
+intern u8* lz4_write_sequence(u8* out, u8* literals, u64 literal_count, u32 offset, u64 match_length) {
+  u8* token = out++;
+  *token = (u8)(Min(literal_count, 15) << 4);
+  if (literal_count >= 15) { out = lz4_write_count(out, literal_count); }
+  MemCopy(out, literals, literal_count);
+  out += literal_count;
+  if (offset) {
+    out[0] = (u8)offset;
+    out[1] = (u8)(offset >> 8);
+    out += 2;
+    u64 match_code = match_length - LZ4_MIN_MATCH;
+    *token |= (u8)Min(match_code, 15);
+    if (match_code >= 15) { out = lz4_write_count(out, match_code); }
+  }
+  return out;
+}
+
+// one extra count byte per 255 literals when nothing matches
+u64 lz4_compress_bound(u64 size) { return size + size / 255 + 16; }
+
+u64 lz4_compress(u8* src, u64 size, u8* dst, u64 cap) {
+  Assert(cap >= lz4_compress_bound(size));
+  Assert(size < U32_MAX);
+  // last position seen for each 4 byte hash, greedy, first match found is taken
+  u32 table[1 << LZ4_HASH_BITS] = {};
+  u8* out = dst;
+  u64 anchor = 0;
+  u64 pos = 0;
+  while (pos + LZ4_MATCH_LIMIT < size) {
+    u32 seq = lz4_read32(src + pos);
+    u32 slot = (seq * 2654435761u) >> (32 - LZ4_HASH_BITS);
+    u64 ref = table[slot];
+    table[slot] = (u32)pos;
+    if (ref >= pos || pos - ref > LZ4_MAX_OFFSET || lz4_read32(src + ref) != seq) {
+      ++pos;
+      continue;
+    }
+    while (pos > anchor && ref > 0 && src[pos - 1] == src[ref - 1]) {
+      --pos;
+      --ref;
+    }
+    u64 length = LZ4_MIN_MATCH;
+    u64 limit = size - LZ4_LAST_LITERALS;
+    while (pos + length < limit && src[ref + length] == src[pos + length]) {
+      ++length;
+    }
+    out = lz4_write_sequence(out, src + anchor, pos - anchor, (u32)(pos - ref), length);
+    pos += length;
+    anchor = pos;
+  }
+  out = lz4_write_sequence(out, src + anchor, size - anchor, 0, 0);
+  return out - dst;
+}
+
+intern b32 lz4_read_count(u8** in, u8* in_end, u64* count) {
+  u8 byte;
+  do {
+    if (*in == in_end) { return false; }
+    byte = *(*in)++;
+    *count += byte;
+  } while (byte == 255);
+  return true;
+}
+
+u64 lz4_decompress(u8* src, u64 size, u8* dst, u64 cap) {
+  u8* in = src;
+  u8* in_end = src + size;
+  u8* out = dst;
+  u8* out_end = dst + cap;
+  while (in < in_end) {
+    u8 token = *in++;
+    u64 literal_count = token >> 4;
+    if (literal_count == 15 && !lz4_read_count(&in, in_end, &literal_count)) { return U64_MAX; }
+    if ((u64)(in_end - in) < literal_count || (u64)(out_end - out) < literal_count) { return U64_MAX; }
+    MemCopy(out, in, literal_count);
+    in += literal_count;
+    out += literal_count;
+    if (in == in_end) { break; }
+
+    if (in_end - in < 2) { return U64_MAX; }
+    u64 offset = in[0] | in[1] << 8;
+    in += 2;
+    if (offset == 0 || offset > (u64)(out - dst)) { return U64_MAX; }
+    u64 length = token & 15;
+    if (length == 15 && !lz4_read_count(&in, in_end, &length)) { return U64_MAX; }
+    length += LZ4_MIN_MATCH;
+    if ((u64)(out_end - out) < length) { return U64_MAX; }
+    u8* match = out - offset;
+    if (offset >= length) {
+      MemCopy(out, match, length);
+    } else {
+      // overlapping, a run repeats the last offset bytes
+      Loop (i, length) out[i] = match[i];
+    }
+    out += length;
+  }
+  return out - dst;
+}
+
+////////////////////////////////////////////////////////////////////////
+// Pack
+
+Slice<u8> pack_build(Allocator arena, PackInput* inputs, u32 count) {
+  Scratch scratch(arena);
+  struct Item {
+    u64 path_hash;
+    u32 input;
+  };
+  struct Blob {
+    u8* raw;
+    u8* data;
+    u64 size;
+    u64 raw_size;
+    u64 offset;
+    PackCompression compression;
+  };
+  // sorted before blobs are made, so the output doesn't depend on the order files were listed in
+  Slice<Item> items = push_slice(scratch, Item, count);
+  Loop (i, count) {
+    items[i] = {hash_memory(inputs[i].path.str, inputs[i].path.size), i};
+  }
+  sort_insert(items, [](Item a, Item b) { return a.path_hash < b.path_hash; });
+
+  PackEntry* entries = push_array_zero(scratch, PackEntry, count);
+  u32* entry_blob = push_array(scratch, u32, count);
+  Darray<Blob> blobs(scratch);
+  Map<u64, u32> blob_of_content(scratch);
+  u64 names_size = 0;
+  Loop (i, count) {
+    PackInput& input = inputs[items[i].input];
+    AssertMsg(i == 0 || items[i].path_hash != items[i - 1].path_hash, "pack: same path twice or a hash collision");
+    Assert(input.path.size <= U16_MAX);
+    u64 content_hash = hash_memory(input.data.data, input.data.count);
+    u32* found = blob_of_content.get(content_hash);
+    if (found) {
+      Blob& blob = blobs[*found];
+      AssertMsg(blob.raw_size == input.data.count && MemMatch(blob.raw, input.data.data, blob.raw_size), "pack: content hash collision");
+      entry_blob[i] = *found;
+    } else {
+      Blob blob = {.raw = input.data.data, .data = input.data.data, .size = input.data.count, .raw_size = input.data.count};
+      u64 bound = lz4_compress_bound(input.data.count);
+      u8* packed = push_buffer(scratch, bound);
+      u64 packed_size = lz4_compress(input.data.data, input.data.count, packed, bound);
+      // already compressed formats like png and jpg barely shrink, they're stored as is
+      if (packed_size < blob.raw_size - blob.raw_size / 8) {
+        blob.data = packed;
+        blob.size = packed_size;
+        blob.compression = PackCompression_LZ4;
+      }
+      entry_blob[i] = blobs.count;
+      blob_of_content.add(content_hash, blobs.count);
+      blobs.add(blob);
+    }
+    entries[i] = {
+      .path_hash = items[i].path_hash,
+      .content_hash = content_hash,
+      .name_offset = (u32)names_size,
+      .name_size = (u16)input.path.size,
+    };
+    names_size += input.path.size;
+  }
+
+  u64 toc_offset = sizeof(PackHeader);
+  u64 names_offset = toc_offset + (u64)count * sizeof(PackEntry);
+  u64 data_offset = AlignUp(names_offset + names_size, PACK_ALIGN);
+  u64 total = data_offset;
+  for (Blob& blob : blobs) {
+    blob.offset = total;
+    total = AlignUp(total + blob.size, PACK_ALIGN);
+  }
+
+  u8* out = push_buffer_zero(arena, total, PACK_ALIGN);
+  *(PackHeader*)out = {
+    .magic = PACK_MAGIC,
+    .version = PACK_VERSION,
+    .entry_count = count,
+    .blob_count = blobs.count,
+    .toc_offset = toc_offset,
+    .names_offset = names_offset,
+    .names_size = names_size,
+    .data_offset = data_offset,
+  };
+  Loop (i, count) {
+    Blob& blob = blobs[entry_blob[i]];
+    entries[i].offset = blob.offset;
+    entries[i].size = blob.size;
+    entries[i].raw_size = blob.raw_size;
+    entries[i].compression = blob.compression;
+    String path = inputs[items[i].input].path;
+    MemCopy(out + names_offset + entries[i].name_offset, path.str, path.size);
+  }
+  MemCopy(out + toc_offset, entries, (u64)count * sizeof(PackEntry));
+  for (Blob& blob : blobs) {
+    MemCopy(out + blob.offset, blob.data, blob.size);
+  }
+  return {out, total};
+}
+
+b32 pack_from_memory(Pack* pack, Slice<u8> data) {
+  *pack = {};
+  if (data.count < sizeof(PackHeader)) { return false; }
+  PackHeader* header = (PackHeader*)data.data;
+  if (header->magic != PACK_MAGIC || header->version != PACK_VERSION) { return false; }
+  u64 toc_end = header->toc_offset + (u64)header->entry_count * sizeof(PackEntry);
+  if (toc_end > data.count || header->names_offset + header->names_size > data.count) { return false; }
+  PackEntry* entries = (PackEntry*)(data.data + header->toc_offset);
+  Loop (i, header->entry_count) {
+    PackEntry& entry = entries[i];
+    if (entry.offset + entry.size > data.count || entry.name_offset + entry.name_size > header->names_size) { return false; }
+    if (entry.compression > PackCompression_LZ4) { return false; }
+  }
+  *pack = {
+    .data = data,
+    .header = header,
+    .entries = entries,
+  };
+  return true;
+}
+
+String pack_entry_name(Pack* pack, PackEntry* entry) {
+  return {pack->data.data + pack->header->names_offset + entry->name_offset, entry->name_size};
+}
+
+PackEntry* pack_find(Pack* pack, String path) {
+  if (!pack->header) { return null; }
+  u64 path_hash = hash_memory(path.str, path.size);
+  u32 lo = 0;
+  u32 hi = pack->header->entry_count;
+  while (lo < hi) {
+    u32 mid = lo + (hi - lo) / 2;
+    if (pack->entries[mid].path_hash < path_hash) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo == pack->header->entry_count || pack->entries[lo].path_hash != path_hash) { return null; }
+  PackEntry* entry = &pack->entries[lo];
+  // a different path with the same hash isn't in the pack
+  return str_match(pack_entry_name(pack, entry), path) ? entry : null;
+}
+
+Slice<u8> pack_read(Pack* pack, PackEntry* entry, Allocator arena) {
+  u8* stored = pack->data.data + entry->offset;
+  if (entry->compression == PackCompression_None) {
+    return {stored, entry->size};
+  }
+  u8* out = push_buffer(arena, entry->raw_size);
+  u64 size = lz4_decompress(stored, entry->size, out, entry->raw_size);
+  if (size != entry->raw_size) {
+    Log(Assets, Error, "pack: %s is corrupt", pack_entry_name(pack, entry));
+    return {};
+  }
+  return {out, size};
+}
+
+////////////////////////////////////////////////////////////////////////
+// Virtual files
+
+Vfs* vfs_init(Allocator arena, String root, String pack_path) {
+  Vfs* vfs = push_struct_zero(arena, Vfs);
+  vfs->root = push_str_copy(arena, root);
+#if HOTRELOAD_BUILD
+  vfs->loose_first = true;
+#endif
+  Slice<u8> data = os_file_path_map(pack_path);
+  if (!data.data) {
+    return vfs;
+  }
+  if (!pack_from_memory(&vfs->pack, data)) {
+    Log(Assets, Warn, "pack: %s is invalid, loading loose files", pack_path);
+    os_file_unmap(data.data, data.count);
+    return vfs;
+  }
+  vfs->pack.modified = os_file_path_properties(pack_path).modified;
+  Log(Assets, Info, "pack: %s, %u entries", pack_path, vfs->pack.header->entry_count);
+  return vfs;
+}
+
+void vfs_release(Vfs* vfs) {
+  os_file_unmap(vfs->pack.data.data, vfs->pack.data.count);
+  vfs->pack = {};
+}
+
+void vfs_prefer_loose(Vfs* vfs, String dir) {
+  AssertAlways(vfs->loose_dir_count < VFS_LOOSE_DIRS_MAX);
+  vfs->loose_dirs[vfs->loose_dir_count++] = dir;
+}
+
+intern b32 vfs_is_loose(Vfs* vfs, String path) {
+  if (vfs->loose_first) { return true; }
+  Loop (i, vfs->loose_dir_count) {
+    String dir = vfs->loose_dirs[i];
+    if (path.size > dir.size && path.str[dir.size] == '/' && str_match(str_prefix(path, dir.size), dir)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// the pack entry that answers for path, null when it comes from disk
+intern PackEntry* vfs_entry(Vfs* vfs, String path) {
+  if (vfs_is_loose(vfs, path)) {
+    Scratch scratch;
+    if (os_file_path_exists(push_strf(scratch, "%s/%s", vfs->root, path))) { return null; }
+  }
+  return pack_find(&vfs->pack, path);
+}
+
+VFile vfs_open(Vfs* vfs, Allocator arena, String path, OS_MapFlags flags) {
+  Scratch scratch(arena);
+  VFile file = {};
+  PackEntry* entry = vfs_entry(vfs, path);
+  if (entry) {
+    file.data = pack_read(&vfs->pack, entry, arena);
+    file.content_hash = entry->content_hash;
+  } else {
+    Slice<u8> data = os_file_path_map(push_strf(scratch, "%s/%s", vfs->root, path), flags);
+    file = {.data = data, .map = data.data, .map_size = data.count};
+  }
+  return file;
+}
+
+void vfs_close(VFile file) {
+  os_file_unmap(file.map, file.map_size);
+}
+
+FileProperties vfs_properties(Vfs* vfs, String path) {
+  Scratch scratch;
+  PackEntry* entry = vfs_entry(vfs, path);
+  if (!entry) {
+    return os_file_path_properties(push_strf(scratch, "%s/%s", vfs->root, path));
+  }
+  FileProperties props = {
+    .size = entry->raw_size,
+    .modified = vfs->pack.modified,
+  };
+  return props;
+}
+
+u64 vfs_content_hash(Vfs* vfs, String path) {
+  PackEntry* entry = vfs_entry(vfs, path);
+  if (entry) {
+    return entry->content_hash;
+  }
+  Scratch scratch;
+  VFile file = vfs_open(vfs, scratch, path, OS_MapFlag_Sequential);
+  u64 result = vfs_file_hash(file);
+  vfs_close(file);
+  return result;
+}
+
+u64 vfs_file_hash(VFile file) {
+  return file.content_hash ? file.content_hash : hash_memory(file.data.data, file.data.count);
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include "lib.h"
+
+////////////////////////////////////////////////////////////////////////
+// LZ4
+// Block format only, no frames. Decoding checks every length and offset against both buffers.
+
+u64 lz4_compress_bound(u64 size);
+// cap has to be at least lz4_compress_bound(size), returns the compressed size
+u64 lz4_compress(u8* src, u64 size, u8* dst, u64 cap);
+// returns the decompressed size, U64_MAX on malformed input or if dst is too small
+u64 lz4_decompress(u8* src, u64 size, u8* dst, u64 cap);
+
+////////////////////////////////////////////////////////////////////////
+// Pack
+// One file mapped whole: header, table of contents sorted by path hash, the paths, then the
+// blobs, each 64 byte aligned. Paths with the same content share one blob.
+
+const u32 PACK_MAGIC   = 'p' | 'a' << 8 | 'c' << 16 | 'k' << 24;
+const u32 PACK_VERSION = 1;
+const u32 PACK_ALIGN   = 64;
+
+enum PackCompression : u8 {
+  PackCompression_None,
+  PackCompression_LZ4,
+};
+
+struct PackHeader {
+  u32 magic;
+  u32 version;
+  u32 entry_count;
+  u32 blob_count;
+  u64 toc_offset;
+  u64 names_offset;
+  u64 names_size;
+  u64 data_offset;
+  u64 pad[2];
+};
+static_assert(sizeof(PackHeader) == PACK_ALIGN);
+
+struct PackEntry {
+  u64 path_hash;
+  u64 content_hash; // of the uncompressed bytes, same function as mesh cache source hashes
+  u64 offset;       // from the start of the pack
+  u64 size;         // as stored
+  u64 raw_size;
+  u32 name_offset;  // into the names block
+  u16 name_size;
+  PackCompression compression;
+  u8 pad;
+};
+static_assert(sizeof(PackEntry) == 48);
+
+struct Pack {
+  Slice<u8> data;
+  PackHeader* header;
+  PackEntry* entries;
+  DenseTime modified;
+};
+
+struct PackInput {
+  String path; // relative to the asset root, forward slashes
+  Slice<u8> data;
+};
+
+// the whole image is built in arena, write it out as is
+Slice<u8>  pack_build(Allocator arena, PackInput* inputs, u32 count);
+b32        pack_from_memory(Pack* pack, Slice<u8> data);
+PackEntry* pack_find(Pack* pack, String path);
+String     pack_entry_name(Pack* pack, PackEntry* entry);
+// stored entries are a view into the pack, compressed ones are decoded into arena, empty on failure
+Slice<u8>  pack_read(Pack* pack, PackEntry* entry, Allocator arena);
+
+////////////////////////////////////////////////////////////////////////
+// Virtual files
+// Asset paths relative to the asset root, looked up in the pack and then on disk. Hotreload
+// builds check the disk first so edited files show up without repacking, other builds do
+// that only for the directories marked with vfs_prefer_loose.
+const u32 VFS_LOOSE_DIRS_MAX = 8;
+
+struct Vfs {
+  String root;
+  Pack pack;
+  b32 loose_first;
+  String loose_dirs[VFS_LOOSE_DIRS_MAX];
+  u32 loose_dir_count;
+};
+
+struct VFile {
+  Slice<u8> data;
+  // loose files are mapped, pack entries live as long as the pack or the arena
+  void* map;
+  u64 map_size;
+  u64 content_hash; // pack entries bring theirs, 0 for loose files
+};
+
+// a missing pack is fine, everything comes from root
+Vfs*           vfs_init(Allocator arena, String root, String pack_path);
+void           vfs_release(Vfs* vfs);
+// files under dir are read from disk when they exist there, for directories that are watched
+// for edits. dir is relative to root and kept by reference
+void           vfs_prefer_loose(Vfs* vfs, String dir);
+// flags only reach loose files, data is empty if the file doesn't exist
+VFile          vfs_open(Vfs* vfs, Allocator arena, String path, OS_MapFlags flags = 0);
+void           vfs_close(VFile file);
+// pack entries report the raw size and the pack's modified time
+FileProperties vfs_properties(Vfs* vfs, String path);
+u64            vfs_content_hash(Vfs* vfs, String path);
+// same as vfs_content_hash, from a file already open, loose files are hashed from data
+u64            vfs_file_hash(VFile file);
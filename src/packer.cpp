@@ -0,0 +1,65 @@
+#include "lib.h"
+#include "pack.h"
+#include "pack.cpp"
+
+// packer <asset dir> <out file> <sub dir>...
+// every file under the sub dirs goes in, named by its path from the asset dir, e.g.
+//   packer ../assets ../assets.pack models textures shaders/compiled
+
+intern void packer_collect(Allocator arena, Darray<PackInput>* inputs, String root, String dir) {
+  String full_dir = push_strf(arena, "%s/%s", root, dir);
+  if (!os_directory_path_exist(full_dir)) {
+    Log(Assets, Warn, "packer: %s doesn't exist", full_dir);
+    return;
+  }
+  OS_FileIter* it = os_file_iter_begin(arena, full_dir, 0);
+  for (OS_FileInfo info = {}; os_file_iter_next(arena, it, &info);) {
+    if (info.name.str[0] == '.') continue;
+    String path = push_strf(arena, "%s/%s", dir, info.name);
+    if (info.props.flags & FilePropertyFlag_IsFolder) {
+      packer_collect(arena, inputs, root, path);
+    } else {
+      inputs->add({path, os_file_path_read_all(arena, push_strf(arena, "%s/%s", root, path))});
+    }
+  }
+  os_file_iter_end(it);
+}
+
+i32 main(i32 args_count, char* args[]) {
+  tctx_init();
+  os_init(args[0]);
+  if (args_count < 4) {
+    Log(General, Error, "usage: packer <asset dir> <out file> <sub dir>...");
+    os_exit(1);
+  }
+  u64 begin = os_now_ns();
+  // sources and the image are all held in memory, fine for what's in assets/
+  Arena arena = arena_init();
+  String root = String(args[1]);
+  String out_path = String(args[2]);
+  Darray<PackInput> inputs(arena);
+  for (i32 i = 3; i < args_count; ++i) {
+    packer_collect(arena, &inputs, root, String(args[i]));
+  }
+  Slice<u8> image = pack_build(arena, inputs.data, inputs.count);
+
+  // written next to the target and renamed over it, a running game may have the old one mapped
+  String tmp_path = push_str_cat(arena, out_path, ".tmp");
+  OS_Handle file = os_file_open(tmp_path, OS_AccessFlag_Write);
+  u64 written = 0;
+  if (file.v) {
+    written = os_file_write(file, image.count, image.data);
+    os_file_close(file);
+  }
+  if (written != image.count || !os_file_path_rename(out_path, tmp_path)) {
+    Log(General, Error, "packer: can't write %s", out_path);
+    os_exit(1);
+  }
+
+  u64 raw_size = 0;
+  for (PackInput& input : inputs) raw_size += input.data.count;
+  PackHeader* header = (PackHeader*)image.data;
+  Log(General, Info, "packer: %u files, %u blobs, %u64 KB -> %u64 KB in %.2f ms", header->entry_count, header->blob_count,
+      raw_size / KB(1), image.count / KB(1), f64(os_now_ns() - begin) / 1e6);
+  os_exit(0);
+}
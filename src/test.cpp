@@ -221,6 +221,48 @@ intern void test_object_pool() {
   }
 }
 
+intern void test_darray() {
+  Arena arena = arena_init();
+  // inline storage, no allocation until N is exceeded
+  {
+    Darray<u32, 16> arr(arena);
+    Loop (i, 16) {
+      arr.add(i);
+    }
+    Assert(arr.is_inline());
+    Assert(arena.pos == 0);
+    arr.add(16);
+    Assert(!arr.is_inline());
+    Loop (i, arr.count) {
+      Assert(arr[i] == (u32)i);
+    }
+  }
+  // last arena allocation grows in place
+  {
+    arena_clear(&arena);
+    Darray<u64> arr(arena);
+    arr.add(0);
+    u64* data = arr.data;
+    Loop (i, 1000) {
+      arr.add(i+1);
+    }
+    Assert(arr.data == data);
+    Assert(arena.pos == arr.cap * sizeof(u64));
+    Loop (i, arr.count) {
+      Assert(arr[i] == (u64)i);
+    }
+    // not last anymore, has to copy
+    push_buffer(arena, 1);
+    u32 cap = arr.cap;
+    Loop (i, cap) {
+      arr.add(i);
+    }
+    Assert(arr.data != data);
+    Assert(arr[0] == 0 && arr[999] == 999);
+  }
+  arena_deinit(&arena);
+}
+
 intern void test_handle_darray() {
   Scratch scratch;
   struct A {
@@ -333,6 +375,966 @@ intern void test_id_pool() {
   }
 }
 
+intern void test_bitset() {
+  Scratch scratch;
+  {
+    Bitset<TEST_SAMPLES> set = {};
+    Array<u32, TEST_SAMPLES> expected = {};
+    Loop (i, TEST_SAMPLES) {
+      if (rand_rng_u32(0, 2) == 0) {
+        set.set(i);
+        expected.add(i);
+      }
+    }
+    Assert(set.count() == expected.count);
+    u32 found = 0;
+    set.for_each_set([&](u32 idx) {
+      Assert(idx == expected[found]);
+      ++found;
+    });
+    Assert(found == expected.count);
+    u32 it = set.find_first();
+    Loop (i, expected.count) {
+      Assert(it == expected[i]);
+      it = set.find_next(it + 1);
+    }
+    Assert(it == INVALID_ID);
+
+    Bitset<TEST_SAMPLES> other = {};
+    Loop (i, TEST_SAMPLES) {
+      if (i % 3 == 0) other.set(i);
+    }
+    Bitset<TEST_SAMPLES> a = set;
+    a.bit_and(other);
+    Bitset<TEST_SAMPLES> o = set;
+    o.bit_or(other);
+    Bitset<TEST_SAMPLES> n = set;
+    n.bit_andnot(other);
+    Loop (i, TEST_SAMPLES) {
+      Assert(a.has(i) == (set.has(i) && other.has(i)));
+      Assert(o.has(i) == (set.has(i) || other.has(i)));
+      Assert(n.has(i) == (set.has(i) && !other.has(i)));
+    }
+    Assert(a.count() + n.count() == set.count());
+
+    Assert(set.set_atomic(expected.count ? expected[0] : 0) == (expected.count != 0));
+    set.clear_all();
+    Assert(set.count() == 0);
+    Assert(set.find_first() == INVALID_ID);
+    Assert(!set.set_atomic(5));
+    Assert(set.clear_atomic(5));
+    Assert(!set.has(5));
+  }
+  {
+    DBitset set(scratch);
+    set.set(1000);
+    set.set(3);
+    Assert(set.cap >= 1001);
+    Assert(set.has(1000) && set.has(3) && !set.has(4));
+    Assert(set.count() == 2);
+    Assert(set.find_first() == 3);
+    Assert(set.find_next(4) == 1000);
+    set.clear(1000);
+    Assert(set.find_next(4) == INVALID_ID);
+  }
+}
+
+intern void test_concurrent_map() {
+  ConcurrentMap<u64, u32> map;
+  map.init();
+  Loop (i, TEST_SAMPLES*10) {
+    Assert(map.add(i*7, i));
+  }
+  Assert(map.count() == TEST_SAMPLES*10);
+  Loop (i, TEST_SAMPLES*10) {
+    u32 val;
+    Assert(map.get(i*7, &val));
+    Assert(val == (u32)i);
+    b32 was_added;
+    Assert(map.get_or_add(i*7, 0, &was_added) == (u32)i);
+    Assert(!was_added);
+  }
+  u32 val;
+  Assert(!map.get(1, &val));
+  b32 was_added;
+  Assert(map.get_or_add(1, 42, &was_added) == 42 && was_added);
+  Assert(map.get(1, &val) && val == 42);
+  map.deinit();
+}
+
+intern void test_mpmc_queue() {
+  Scratch scratch;
+  using Queue = MPMCQueue<u32, 64>;
+  Queue* queue = push_struct(scratch, Queue);
+  queue->init();
+  u32 val;
+  Assert(!queue->try_pop(&val));
+  // wrap around the ring a few times
+  u32 next_push = 0, next_pop = 0;
+  Loop (round, 5) {
+    while (queue->try_push(next_push)) {
+      ++next_push;
+    }
+    Assert(queue->count() == 64);
+    Loop (i, 40) {
+      Assert(queue->try_pop(&val) && val == next_pop);
+      ++next_pop;
+    }
+  }
+  while (queue->try_pop(&val)) {
+    Assert(val == next_pop++);
+  }
+  Assert(next_pop == next_push && queue->count() == 0);
+  queue->push(7);
+  Assert(queue->pop() == 7);
+}
+
+intern void test_atom() {
+  Scratch scratch;
+  Atom a = atom_from_str("monkey.glb");
+  Atom b = atom_from_str(push_str_cat(scratch, "monkey", ".glb"));
+  Assert(a == b);
+  Assert(a == atom_lit("monkey.glb"));
+  Assert(a != atom_lit("cube.glb"));
+  Assert(str_match(atom_str(a), "monkey.glb"));
+  Assert(atom_str(atom_lit("never interned")).size == 0);
+}
+
+///////////////////////////////////
+// Strings
+
+intern void test_float_format() {
+  Scratch scratch;
+  Assert(str_match(push_strf(scratch, "%g", 0.1), "0.1"));
+  Assert(str_match(push_strf(scratch, "%g32", 0.1f), "0.1"));
+  Assert(str_match(push_strf(scratch, "%g", 100.0), "100"));
+  Assert(str_match(push_strf(scratch, "%g", -0.00025), "-0.00025"));
+  Assert(str_match(push_strf(scratch, "%g", 1e22), "1e22"));
+  Assert(str_match(push_strf(scratch, "%g", 1.5e-7), "1.5e-7"));
+  Assert(str_match(push_strf(scratch, "%f", -2.5), "-2.500000"));
+  Assert(str_match(push_strf(scratch, "%.2f", 1234.5678), "1234.57"));
+  Assert(str_match(push_strf(scratch, "%.1f", 0.25), "0.2"));
+  Assert(str_match(push_strf(scratch, "%.0f", 0.5), "0"));
+  Assert(str_match(push_strf(scratch, "%.2f", 0.999), "1.00"));
+  // rounded from the binary value, 2.675 is 2.67499999... and 1.005 is 1.00499999...
+  Assert(str_match(push_strf(scratch, "%.2f", 2.675), "2.67"));
+  Assert(str_match(push_strf(scratch, "%.2f", 1.005), "1.00"));
+  Assert(str_match(push_strf(scratch, "%.3f", 1e-300), "0.000"));
+  Assert(str_match(push_strf(scratch, "%u64", U64_MAX), "18446744073709551615"));
+  // shortest output has to read back to the same bits
+  u64 seed = 1;
+  Loop (i, TEST_SAMPLES*100) {
+    seed = squirrel3(seed);
+    f64 val64 = *(f64*)&seed;
+    f32 val32 = *(f32*)&seed;
+    // skip nans by bits, fast-math folds x == x
+    if (((seed >> 52) & 0x7FF) != 0x7FF) {
+      String str = push_strf(scratch, "%g", val64);
+      f64 back = strtod((char*)str.str, null);
+      Assert(MemMatch(&back, &val64, sizeof(f64)));
+    }
+    if (((seed >> 23) & 0xFF) != 0xFF) {
+      String str = push_strf(scratch, "%g32", val32);
+      f32 back = strtof((char*)str.str, null);
+      Assert(MemMatch(&back, &val32, sizeof(f32)));
+    }
+  }
+  // fixed precision matches printf digit for digit below 2^53
+  Loop (i, TEST_SAMPLES*10) {
+    seed = squirrel3(seed);
+    f64 scale = 1;
+    Loop (k, seed % 13) scale *= 10;
+    f64 value = (f64)(i64)(seed % 2000000000000) / scale * (seed >> 63 ? -1 : 1);
+    u32 precision = (seed >> 40) % 10;
+    char expect[64];
+    u32 n = snprintf(expect, sizeof(expect), "%.*f", precision, value);
+    u8 got[FLOAT_FIXED_MAX_CHARS];
+    Assert(str_match({got, f64_write(got, value, precision)}, {(u8*)expect, n}));
+  }
+}
+
+intern void test_format_string() {
+  Scratch scratch;
+  // same output from the compile-time path and the runtime my_sprintf path
+  String runtime_fmt = "%s|%u|%i|%u64|%i64|%c|%.2f|%g|%g32|%%|%p";
+  String a = push_strf(scratch, runtime_fmt, String("name"), 7u, -3, U64_MAX, (i64)-5, 'x', 1.005, 0.1, 0.1f, (u64)0xBEEF);
+  String b = push_strf(scratch, "%s|%u|%i|%u64|%i64|%c|%.2f|%g|%g32|%%|%p", String("name"), 7u, -3, U64_MAX, (i64)-5, 'x', 1.005, 0.1, 0.1f, (u64)0xBEEF);
+  Assert(str_match(a, b));
+  Assert(b.str[b.size] == 0);
+  Assert(str_match(push_strf(scratch, "100%% of %u", -1), "100% of 4294967295"));
+  Assert(push_strf(scratch, "%.1f", 1e300).size == 303); // bound falls back to the full f64 width
+  StrBuilder sb;
+  sb.init(scratch);
+  sb.addf("%s=%u;", String("a"), 1);
+  sb.addf("%s=%u;", String("b"), 2);
+  Assert(str_match(sb.finalize(scratch), "a=1;b=2;"));
+}
+
+intern void test_float_parse() {
+  Scratch scratch;
+  Assert(f64_from_str("0.1") == 0.1);
+  Assert(f64_from_str("-2.25e3") == -2250.0);
+  Assert(f64_from_str("1.7976931348623157e308") == 1.7976931348623157e308);
+  Assert(f64_from_str("4.9e-324") == 4.9e-324);
+  Assert(f64_from_str("9007199254740993") == 9007199254740992.0); // tie rounds to even
+  Assert(f64_from_str("3.14159265358979323846264338327950288") == 3.141592653589793);
+  Assert(f32_from_str("1.00000005960464477539063") == 1.0000001f);
+  Assert(f32_from_str("-0.000001") == -0.000001f);
+  Lexer lexer = lexer_init("v 1.5 -2 0.25e1\nf");
+  f32 xyz[3];
+  lexer_next_token(&lexer);
+  Assert(lexer_next_f32_array(&lexer, xyz, 3) == 3);
+  Assert(xyz[0] == 1.5f && xyz[1] == -2.0f && xyz[2] == 2.5f);
+  Assert(lexer_next_f32_array(&lexer, xyz, 1) == 0);
+  // shortest formatting and parsing have to agree on every bit
+  u64 seed = 2;
+  Loop (i, TEST_SAMPLES*100) {
+    seed = squirrel3(seed);
+    if (((seed >> 52) & 0x7FF) != 0x7FF) {
+      f64 val64 = *(f64*)&seed;
+      f64 back = f64_from_str(push_strf(scratch, "%g", val64));
+      Assert(MemMatch(&back, &val64, sizeof(f64)));
+    }
+    if (((seed >> 23) & 0xFF) != 0xFF) {
+      f32 val32 = *(f32*)&seed;
+      f32 back = f32_from_str(push_strf(scratch, "%g32", val32));
+      Assert(MemMatch(&back, &val32, sizeof(f32)));
+    }
+  }
+}
+
+intern void test_bytes_scan() {
+  // every length and hit position around the 16 and 32 byte blocks and the scalar tail
+  u8 a[80], b[80];
+  Loop (size, 80) {
+    Loop (hit, size + 1) {
+      Loop (i, 80) {
+        a[i] = 'a' + i % 20;
+        b[i] = a[i];
+      }
+      if (hit < size) {
+        a[hit] = '\n';
+        b[hit] = '!';
+      }
+      Assert(bytes_find(a, size, '\n') == (u64)hit);
+      Assert(bytes_find_space(a, size) == (u64)hit);
+      Assert(bytes_mismatch(a, b, size) == (u64)hit);
+      Loop (i, 80) {
+        a[i] = i < hit ? " \t\n"[i % 3] : 'x';
+      }
+      Assert(bytes_skip_space(a, size) == (u64)hit);
+    }
+  }
+  // bytes above 0x7f must not look like space to the shuffle lookup
+  u8 high[32];
+  Loop (i, 32) high[i] = 0x80 | ' ' | (i & 0x0f);
+  Assert(bytes_find_space(high, 32) == 32);
+  Assert(str_index_of("hello_world_hello_world_hello_world!", '!') == 35);
+  Assert(str_index_of("hello", 'z') == -1);
+  Assert(str_match("0123456789abcdef0123456789abcdef_", "0123456789abcdef0123456789abcdef_"));
+  Assert(!str_match("0123456789abcdef0123456789abcdef_", "0123456789abcdef0123456789abcdef-"));
+  Lexer lexer = lexer_init("                                         first\t\n second_token_that_is_longer_than_32_bytes  f 1/2/3");
+  Assert(str_match(lexer_next_token(&lexer), "first"));
+  Assert(str_match(lexer_next_token(&lexer), "second_token_that_is_longer_than_32_bytes"));
+  Assert(str_match(lexer_next_token(&lexer), "f"));
+  Assert(str_match(lexer_next_integer(&lexer), "1"));
+  Assert(str_match(lexer_next_integer(&lexer), "2"));
+  Assert(str_match(lexer_next_integer(&lexer), "3"));
+  Assert(lexer_next_token(&lexer).size == 0);
+}
+
+intern void test_str_builder() {
+  Scratch scratch;
+  StrBuilder sb;
+  sb.init(scratch);
+  Assert(sb.finalize(scratch).size == 0);
+  DString expected;
+  expected.init(scratch);
+  // crosses several growing blocks, a referenced block and splits of add across block ends
+  u8 big[300];
+  Loop (i, ArrayCount(big)) big[i] = 'a' + i % 26;
+  Loop (i, 200) {
+    String line = push_strf(scratch, "line %u value %g\n", i, f64(i) * 0.25);
+    sb.addf("line %u value %g\n", i, f64(i) * 0.25);
+    expected.add(line);
+    if (i % 50 == 0) {
+      sb.add_ref({big, ArrayCount(big)});
+      expected.add({big, ArrayCount(big)});
+    }
+    sb.add("|");
+    expected.add("|");
+  }
+  Assert(sb.total_size == expected.size);
+  Assert(sb.chunk_count > 4);
+  String result = sb.finalize(scratch);
+  Assert(str_match(result, expected));
+  Assert(result.str[result.size] == 0);
+  sb.clear();
+  sb.add("short");
+  Assert(str_match(sb.finalize(scratch), "short"));
+}
+
+intern void test_log_record() {
+  Scratch scratch;
+  char name[] = "mesh";
+  FmtStr<String, u32, f64> fmt = "%s: %u vertices, %.2f ms";
+  u64 size = log_record_size(fmt, String(name), 42u, 0.5);
+  LogRecord* record = (LogRecord*)push_buffer(scratch, size);
+  log_record_fill(record, LogCategory_General, LogLevel_Warn, true, fmt, String(name), 42u, 0.5);
+  // the record owns a copy, the caller's buffer may change before the logger thread runs
+  name[0] = 'X';
+  StrBuilder sb;
+  sb.init(scratch);
+  String line = record->format(&sb, log_level_prefix(LogLevel_Warn), record->newline, (u8*)(record + 1));
+  Assert(str_match(line, "[WARN]:  mesh: 42 vertices, 0.50 ms\n"));
+  Assert(str_match(line, log_format(scratch, log_level_prefix(LogLevel_Warn), true, fmt, String("mesh"), 42u, 0.5)));
+  // no prefix or newline for print
+  log_record_fill(record, LogCategory_General, (LogLevel)0, false, fmt, String(name), 7u, 1.0);
+  line = record->format(&sb, log_level_prefix((LogLevel)0), record->newline, (u8*)(record + 1));
+  Assert(str_match(line, "Xesh: 7 vertices, 1.00 ms"));
+}
+
+intern void test_log_categories() {
+  Scratch scratch;
+  u8 prefix[LOG_PREFIX_MAX_SIZE];
+  Assert(str_match(log_prefix(prefix, LogLevel_Warn, LogCategory_Vk), "[WARN]:  [vk] "));
+  Assert(str_match(log_prefix(prefix, LogLevel_Info, LogCategory_General), "[INFO]:  "));
+
+  // fields keep their types, strings are quoted
+  char name[] = "cube.glb";
+  LogField<String> name_field = log_kv("name", name);
+  LogField<u32> verts_field = log_kv("verts", 24u);
+  LogField<i32> offset_field = log_kv("offset", -3);
+  LogField<f64> ms_field = log_kv("ms", 0.5);
+  u64 size = log_event_size(name_field, verts_field, offset_field, ms_field);
+  LogRecord* record = (LogRecord*)push_buffer(scratch, size);
+  log_event_fill(record, LogCategory_Assets, LogLevel_Info, "mesh loaded", name_field, verts_field, offset_field, ms_field);
+  name[0] = 'X';
+  StrBuilder sb;
+  sb.init(scratch);
+  String line = record->format(&sb, log_prefix(prefix, LogLevel_Info, LogCategory_Assets), record->newline, (u8*)(record + 1));
+  Assert(str_match(line, "[INFO]:  [assets] mesh loaded name=\"cube.glb\" verts=24 offset=-3 ms=0.5\n"));
+
+  u8 saved[LogCategory_Count];
+  MemCopy(saved, log_levels, sizeof(saved));
+  log_set_levels("warn, vk=trace,Assets = off");
+  Assert(log_levels[LogCategory_General] == LogLevel_Warn && log_levels[LogCategory_Hotreload] == LogLevel_Warn);
+  Assert(log_levels[LogCategory_Vk] == LogLevel_Trace && log_levels[LogCategory_Assets] == LogLevel_Off);
+  Assert(!log_enabled(LogCategory_Assets, LogLevel_Error) && log_enabled(LogCategory_Vk, LogLevel_Trace));
+  // arguments of a disabled line aren't evaluated
+  u32 evaluated = 0;
+  Loop (i, 8) {
+    Log(Assets, Error, "%u", ++evaluated);
+    LogEvery(2, Hotreload, Info, "%u", ++evaluated);
+  }
+  Assert(evaluated == 0);
+  MemCopy(log_levels, saved, sizeof(saved));
+
+  // burst of 2, the third line in the same second is dropped and counted
+  LogLimiter limiter = {};
+  Assert(log_limiter_take(&limiter, LogCategory_Profiler, LogLevel_Trace, 1, 2));
+  Assert(log_limiter_take(&limiter, LogCategory_Profiler, LogLevel_Trace, 1, 2));
+  Assert(!log_limiter_take(&limiter, LogCategory_Profiler, LogLevel_Trace, 1, 2));
+  Assert(limiter.suppressed == 1);
+}
+
+intern void test_utf8() {
+  Scratch scratch;
+  Assert(utf8_validate((u8*)"plain ascii", 11));
+  Assert(!utf8_validate((u8*)"\xc0\xaf", 2));          // overlong '/'
+  Assert(!utf8_validate((u8*)"\xed\xa0\x80", 3));      // surrogate
+  Assert(!utf8_validate((u8*)"\xf4\x90\x80\x80", 4));  // above U+10FFFF
+  Assert(utf8_validate((u8*)"\xf4\x8f\xbf\xbf", 4));
+  // errors on both sides of the 32 byte block edge and in the tail
+  u8 text[80];
+  Loop (pos, 75) {
+    Loop (i, ArrayCount(text)) text[i] = 'a';
+    text[pos] = 0xE2; text[pos+1] = 0x82; text[pos+2] = 0xAC; // euro sign
+    Assert(utf8_validate(text, ArrayCount(text)));
+    Assert(!utf8_validate(text, pos + 2));
+    text[pos+2] = 'a';
+    Assert(!utf8_validate(text, ArrayCount(text)));
+  }
+  String mixed = "a\xc3\xa7\xd0\xbf\xe6\x97\xa5\xf0\x9f\x98\x80 and a long ascii run after it, past 32 bytes";
+  Slice<u16> wide = push_utf16_from_str(scratch, mixed);
+  Assert(wide[0] == 'a' && wide[1] == 0xE7 && wide[2] == 0x43F && wide[3] == 0x65E5);
+  Assert(wide[4] == 0xD83D && wide[5] == 0xDE00);
+  Assert(str_match(push_str_utf16(scratch, wide.data, wide.count), mixed));
+  Slice<u32> points = push_utf32_from_str(scratch, mixed);
+  Assert(points[4] == 0x1F600);
+  Assert(str_match(push_str_utf32(scratch, points.data, points.count), mixed));
+  // invalid input decodes to replacement characters instead of failing
+  Slice<u32> bad = push_utf32_from_str(scratch, "x\xffy");
+  Assert(bad.count == 3 && bad[1] == UNICODE_REPLACEMENT);
+}
+
+intern void test_json() {
+  Scratch scratch;
+  String text = R"({"name": "a\"b\\c\n\u00e7\ud83d\ude00", "skip": {"deep": [1, [2, {"x": 3}]]},
+                    "nums": [0, -1.5, 2e3, 1E-2], "flags": [true, false, null], "plain": "no escapes"})";
+  JsonReader r = json_reader_init(text);
+  Assert(!r.error.str);
+  u32 seen = 0;
+  JSON_OBJ(r, r.base_obj) {
+    seen++;
+    if (k.match("name")) {
+      Assert(v.type == JsonType_String && str_match(v.str, "a\"b\\c\n\xc3\xa7\xf0\x9f\x98\x80"));
+    } else if (k.match("nums")) {
+      f64 expect[] = {0, -1.5, 2000, 0.01};
+      u32 i = 0;
+      JSON_ARR(r, v) { Assert(obj.type == JsonType_Number && obj.number == expect[i++]); }
+      Assert(i == 4);
+    } else if (k.match("flags")) {
+      JsonType types[] = {JsonType_Bool, JsonType_Bool, JsonType_Null};
+      u32 i = 0;
+      JSON_ARR(r, v) { Assert(obj.type == types[i]); Assert(obj.number == (i == 0)); i++; }
+    } else if (k.match("plain")) {
+      // unescaped strings point into the input
+      Assert(v.str.str > text.str && v.str.str < text.str + text.size);
+    }
+  }
+  Assert(seen == 5);
+  json_reader_deinit(&r);
+  // a lone surrogate decodes to U+FFFD instead of failing
+  JsonReader lone = json_reader_init("[\"\\ud800\"]");
+  JSON_ARR(lone, lone.base_obj) { Assert(str_match(obj.str, "\xef\xbf\xbd")); }
+  json_reader_deinit(&lone);
+
+  // backslash runs crossing the 64 byte block edge
+  Loop (pos, 70) {
+    Loop (run, 4) {
+      StrBuilder sb;
+      sb.init(scratch);
+      sb.add("[\"");
+      Loop (i, pos) sb.add("a");
+      Loop (i, run * 2) sb.add("\\");
+      sb.add("\", \"x\"]");
+      JsonReader rr = json_reader_init(sb.finalize(scratch));
+      Assert(!rr.error.str);
+      u32 count = 0;
+      JSON_ARR(rr, rr.base_obj) {
+        if (count++ == 0) { Assert(obj.str.size == pos + run); }
+        else              { Assert(str_match(obj.str, "x")); }
+      }
+      Assert(count == 2);
+      json_reader_deinit(&rr);
+    }
+  }
+
+  // values and strings crossing stage 1 chunks, one string spanning several of them
+  {
+    StrBuilder sb;
+    sb.init(scratch);
+    sb.add("[\"");
+    Loop (i, JSON_CHUNK_SIZE * 5 / 2) sb.add(i % 64 ? "a" : "\\n");
+    sb.add("\"");
+    u32 value_count = JSON_CHUNK_SIZE / 2;
+    Loop (i, value_count) sb.addf(", {\"k\": \"v\\t%u\"}", i);
+    sb.add("]");
+    JsonReader rr = json_reader_init(sb.finalize(scratch));
+    Assert(!rr.error.str);
+    u32 count = 0;
+    JSON_ARR(rr, rr.base_obj) {
+      if (count++ == 0) {
+        Assert(obj.type == JsonType_String && obj.str.size == JSON_CHUNK_SIZE * 5 / 2);
+        continue;
+      }
+      JSON_OBJ(rr, obj) { Assert(str_match(v.str, push_strf(scratch, "v\t%u", count - 2))); }
+    }
+    Assert(count == value_count + 1);
+    json_reader_deinit(&rr);
+  }
+
+  String bad[] = {"", "{\"a\" 1}", "[1,]", "[1 2]", "{\"a\": 1", "[\"open]", "]", "[01]", "[1.]", "[tru]", "[\"\\q\"]", "[\"\\u12g4\"]"};
+  for EachElement (i, bad) {
+    JsonReader rr = json_reader_init(bad[i]);
+    Assert(rr.error.str && rr.base_obj.type == JsonType_Error);
+    json_reader_deinit(&rr);
+  }
+}
+
+intern void test_lz4() {
+  Scratch scratch;
+  u64 seed = 7;
+  Loop (kind, 3) {
+    u32 sizes[] = {0, 1, 12, 13, 100, 70000};
+    for EachElement (s, sizes) {
+      u32 size = sizes[s];
+      u8* src = push_array(scratch, u8, size);
+      Loop (i, size) {
+        seed = squirrel3(seed);
+        // noise, a short alphabet, and long runs that make matches overlap their own output
+        src[i] = kind == 0 ? (u8)seed : kind == 1 ? "abcab"[seed % 5] : (u8)(i / 1000);
+      }
+      u64 bound = lz4_compress_bound(size);
+      u8* packed = push_array(scratch, u8, bound);
+      u64 packed_size = lz4_compress(src, size, packed, bound);
+      Assert(packed_size <= bound);
+      u8* out = push_array(scratch, u8, size + 1);
+      Assert(lz4_decompress(packed, packed_size, out, size) == size);
+      Assert(MemMatch(out, src, size));
+      if (size) {
+        Assert(lz4_decompress(packed, packed_size, out, size - 1) == U64_MAX);
+      }
+      if (kind == 2 && size == 70000) {
+        Assert(packed_size < size / 50);
+      }
+    }
+  }
+  // made by the reference lz4 -9, covers long literals, a long match and an overlapping one
+  String golden_src = "LZ4 golden vector, 0123456789ABCDEF. LZ4 golden vector, 0123456789ABCDEF. "
+                      "LZ4 golden vector, 0123456789ABCDEF. zzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzztail literals";
+  u8 golden[] = {
+    0xff, 0x16, 0x4c, 0x5a, 0x34, 0x20, 0x67, 0x6f, 0x6c, 0x64, 0x65, 0x6e, 0x20, 0x76, 0x65, 0x63,
+    0x74, 0x6f, 0x72, 0x2c, 0x20, 0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x41,
+    0x42, 0x43, 0x44, 0x45, 0x46, 0x2e, 0x20, 0x25, 0x00, 0x37, 0x1f, 0x7a, 0x01, 0x00, 0x14, 0xd0,
+    0x74, 0x61, 0x69, 0x6c, 0x20, 0x6c, 0x69, 0x74, 0x65, 0x72, 0x61, 0x6c, 0x73,
+  };
+  u8 golden_out[256];
+  Assert(lz4_decompress(golden, sizeof(golden), golden_out, sizeof(golden_out)) == golden_src.size);
+  Assert(MemMatch(golden_out, golden_src.str, golden_src.size));
+
+  // offset 0 and an offset before the start of the output
+  u8 zero_offset[] = {0x14, 'a', 0, 0};
+  u8 early_offset[] = {0x14, 'a', 2, 0};
+  u8 out[64];
+  Assert(lz4_decompress(zero_offset, sizeof(zero_offset), out, sizeof(out)) == U64_MAX);
+  Assert(lz4_decompress(early_offset, sizeof(early_offset), out, sizeof(out)) == U64_MAX);
+}
+
+intern void test_pack() {
+  Scratch scratch;
+  u8* text = push_array(scratch, u8, 5000);
+  u8* noise = push_array(scratch, u8, 3000);
+  Loop (i, 5000) text[i] = "the quick brown fox "[i % 20];
+  u64 seed = 3;
+  Loop (i, 3000) {
+    seed = squirrel3(seed);
+    noise[i] = (u8)seed;
+  }
+  PackInput inputs[] = {
+    {"models/a.glb", {text, 5000}},
+    {"textures/b.png", {noise, 3000}},
+    {"models/copy_of_a.glb", {text, 5000}},
+  };
+  Slice<u8> image = pack_build(scratch, inputs, ArrayCount(inputs));
+  Pack pack;
+  Assert(pack_from_memory(&pack, image));
+  Assert(pack.header->entry_count == 3 && pack.header->blob_count == 2);
+  for EachElement (i, inputs) {
+    PackEntry* entry = pack_find(&pack, inputs[i].path);
+    Assert(entry && entry->offset % PACK_ALIGN == 0);
+    Slice<u8> data = pack_read(&pack, entry, scratch);
+    Assert(data.count == inputs[i].data.count && MemMatch(data.data, inputs[i].data.data, data.count));
+    // a cold cook hashes the bytes it loaded, the cache check later takes the entry's hash
+    Assert(entry->content_hash == vfs_file_hash({.data = data}));
+  }
+  Assert(pack_find(&pack, "models/a.glb")->compression == PackCompression_LZ4);
+  Assert(pack_find(&pack, "textures/b.png")->compression == PackCompression_None);
+  Assert(pack_find(&pack, "models/a.glb")->offset == pack_find(&pack, "models/copy_of_a.glb")->offset);
+  Assert(!pack_find(&pack, "models/a.gl"));
+
+  // listing order doesn't change the image
+  PackInput reordered[] = {inputs[2], inputs[0], inputs[1]};
+  Slice<u8> image2 = pack_build(scratch, reordered, ArrayCount(reordered));
+  Assert(image2.count == image.count && MemMatch(image2.data, image.data, image.count));
+
+  Assert(!pack_from_memory(&pack, {image.data, image.count - PACK_ALIGN}));
+  image.data[0] ^= 1;
+  Assert(!pack_from_memory(&pack, image));
+}
+
+///////////////////////////////////
+// Mesh optimization
+
+// side by side quads in the xy plane facing +z, vertex i sits at (i % (side+1), i / (side+1))
+intern Mesh test_grid_mesh(Allocator arena, u32 side) {
+  u32 vert_side = side + 1;
+  Mesh mesh = {.vert_count = vert_side * vert_side, .index_count = side * side * 6};
+  mesh.vertices = push_array_zero(arena, Vertex, mesh.vert_count);
+  Loop (i, mesh.vert_count) {
+    mesh.vertices[i].pos = {f32(i % vert_side), f32(i / vert_side), 0};
+    mesh.vertices[i].norm = {0, 0, 1};
+  }
+  mesh.indices = push_array(arena, u32, mesh.index_count);
+  Loop (y, side) Loop (x, side) {
+    u32 v = y * vert_side + x;
+    u32 quad[6] = {v, v + 1, v + vert_side, v + 1, v + vert_side + 1, v + vert_side};
+    MemCopy(mesh.indices + (y * side + x) * 6, quad, sizeof(quad));
+  }
+  return mesh;
+}
+
+// the same for every rotation of a triangle, different when the winding flips
+intern u64 test_triangle_key(u32 a, u32 b, u32 c) {
+  u32 v[3] = {a, b, c};
+  u32 first = v[0] < v[1] ? (v[0] < v[2] ? 0 : 2) : (v[1] < v[2] ? 1 : 2);
+  return u64(v[first]) << 40 | u64(v[(first + 1) % 3]) << 20 | v[(first + 2) % 3];
+}
+
+intern void test_mesh_optimize() {
+  Scratch scratch;
+  // a grid with its triangles shuffled, every vertex knows its grid index from its position
+  const u32 side = 32;
+  const u32 vert_side = side + 1;
+  Mesh grid = test_grid_mesh(scratch, side);
+  Vertex* vertices = grid.vertices;
+  u32* indices = grid.indices;
+  u32 vert_count = grid.vert_count;
+  u32 tri_count = grid.index_count / 3;
+  u64 seed = 7;
+  for (u32 t = tri_count - 1; t > 0; --t) {
+    seed = squirrel3(seed);
+    u32 other = seed % (t + 1);
+    Loop (k, 3) Swap(indices[t * 3 + k], indices[other * 3 + k]);
+  }
+
+  // triangles as keys that survive vertex reordering and keep the winding
+  var triangle_keys = [&](u32* ids, Vertex* verts) {
+    Slice<u64> keys = push_slice(scratch, u64, tri_count);
+    Loop (t, tri_count) {
+      u32 v[3];
+      Loop (k, 3) {
+        v3 pos = verts[ids[t * 3 + k]].pos;
+        v[k] = u32(pos.y) * vert_side + u32(pos.x);
+      }
+      keys[t] = test_triangle_key(v[0], v[1], v[2]);
+    }
+    sort_insert(keys, [](u64 a, u64 b) { return a < b; });
+    return keys;
+  };
+  Slice<u64> keys = triangle_keys(indices, vertices);
+
+  VertexCacheStats before = mesh_vertex_cache_stats(indices, tri_count * 3, vert_count);
+  Mesh mesh = {vertices, indices, vert_count, tri_count * 3};
+  mesh_optimize(scratch, &mesh);
+  Assert(mesh.lod_count > 1 && mesh.lods[0].index_offset == 0 && mesh.lods[0].index_count == tri_count * 3);
+  VertexCacheStats after = mesh_vertex_cache_stats(mesh.indices, tri_count * 3, mesh.vert_count);
+  Assert(before.acmr > 2.f);
+  Assert(after.acmr < 0.8f && after.atvr < 1.5f);
+  Assert(mesh.vert_count == vert_count);
+
+  Slice<u64> optimized = triangle_keys(mesh.indices, vertices);
+  Assert(MemMatch(keys.data, optimized.data, keys.count * sizeof(u64)));
+  // vertices come in the order they are first used, full detail first
+  u32 next = 0;
+  Loop (i, mesh.index_count) {
+    Assert(mesh.indices[i] <= next);
+    if (mesh.indices[i] == next) next++;
+  }
+
+  // a degenerate triangle misses the cache at most twice, none of them may be lost when one
+  // comes first or when there is nothing else
+  u32* degenerate = push_array(scratch, u32, tri_count * 3);
+  MemCopy(degenerate, mesh.indices, tri_count * 3 * sizeof(u32));
+  degenerate[1] = degenerate[0];
+  Slice<u64> degenerate_keys = triangle_keys(degenerate, vertices);
+  mesh_optimize_overdraw(degenerate, tri_count * 3, vertices, vert_count, 1.05f);
+  Assert(MemMatch(degenerate_keys.data, triangle_keys(degenerate, vertices).data, keys.count * sizeof(u64)));
+  Loop (t, tri_count) degenerate[t * 3 + 1] = degenerate[t * 3];
+  degenerate_keys = triangle_keys(degenerate, vertices);
+  mesh_optimize_overdraw(degenerate, tri_count * 3, vertices, vert_count, 1.05f);
+  Assert(MemMatch(degenerate_keys.data, triangle_keys(degenerate, vertices).data, keys.count * sizeof(u64)));
+
+  // vertices nothing points at are dropped
+  u32 strip[] = {0, 2, 3};
+  Assert(mesh_optimize_vertex_fetch(vertices, vert_count, strip, 3) == 3);
+  Assert(strip[0] == 0 && strip[1] == 1 && strip[2] == 2);
+}
+
+intern void test_mesh_simplify() {
+  Scratch scratch;
+  const u32 side = 16;
+  const u32 vert_side = side + 1;
+  Mesh grid = test_grid_mesh(scratch, side);
+  Vertex* vertices = grid.vertices;
+  u32* indices = grid.indices;
+  u32 vert_count = grid.vert_count;
+  u32 index_count = grid.index_count;
+  var area = [&](u32* ids, u32 count) {
+    f32 sum = 0;
+    for (u32 i = 0; i < count; i += 3) {
+      v3 p0 = vertices[ids[i]].pos, p1 = vertices[ids[i + 1]].pos, p2 = vertices[ids[i + 2]].pos;
+      sum += v3_cross(p1 - p0, p2 - p0).z / 2;
+    }
+    return sum;
+  };
+
+  // a flat grid loses its inside for free, the border stays where it was
+  u32* dst = push_array(scratch, u32, index_count);
+  f32 error;
+  u32 count = mesh_simplify(dst, indices, index_count, vertices, vert_count, index_count / 4, 0.01f, &error);
+  Assert(count <= index_count / 4 && count % 3 == 0);
+  Assert(error < 1e-3f);
+  Assert(Abs(area(dst, count) - side * side) < 1e-2f);
+  b8* used = push_array_zero(scratch, b8, vert_count);
+  Loop (i, count) used[dst[i]] = true;
+  Loop (i, vert_count) {
+    u32 x = i % vert_side, y = i / vert_side;
+    if (x == 0 || y == 0 || x == side || y == side) Assert(used[i]);
+  }
+
+  // bumps cost error, which stops the collapses well before the target
+  u64 seed = 11;
+  Loop (i, vert_count) {
+    seed = squirrel3(seed);
+    vertices[i].pos.z = f32(seed % 1000) / 1000;
+  }
+  count = mesh_simplify(dst, indices, index_count, vertices, vert_count, 0, 0.01f, &error);
+  Assert(count > index_count / 2 && error <= 0.01f);
+
+  // split normals along x = 8 only move along the seam, a quad on each side is the least there is
+  Vertex* split = push_array(scratch, Vertex, vert_count * 2);
+  u32* split_indices = push_array(scratch, u32, index_count);
+  Loop (i, vert_count) {
+    split[i] = vertices[i];
+    split[i].pos.z = 0;
+    split[vert_count + i] = split[i];
+    split[vert_count + i].norm = {1, 0, 0};
+  }
+  Loop (i, index_count) {
+    u32 v = indices[i];
+    // triangles right of the seam use the second copy
+    u32 t = i / 3;
+    u32 quad_x = t / 2 % side;
+    split_indices[i] = quad_x >= side / 2 ? v + vert_count : v;
+  }
+  count = mesh_simplify(dst, split_indices, index_count, split, vert_count * 2, 0, 0.01f, &error);
+  Assert(count < index_count / 4);
+  Loop (t, count / 3) {
+    b32 right = dst[t * 3] >= vert_count;
+    Loop (k, 3) Assert((dst[t * 3 + k] >= vert_count) == right);
+  }
+
+  MeshLod lods[] = {{0, 0, 0}, {0, 0, 0.01f}, {0, 0, 0.1f}};
+  Assert(mesh_lod_select(lods, 3, 1, 1, 1000) == 0);
+  Assert(mesh_lod_select(lods, 3, 1, 20, 1000) == 1);
+  Assert(mesh_lod_select(lods, 3, 1, 200, 1000) == 2);
+  Assert(mesh_lod_select(lods, 3, 10, 200, 1000) == 1);
+}
+
+intern void test_meshlets() {
+  Scratch scratch;
+  const u32 side = 32;
+  Mesh grid = test_grid_mesh(scratch, side);
+  Vertex* vertices = grid.vertices;
+  u32* indices = grid.indices;
+  u32 vert_count = grid.vert_count;
+  u32 tri_count = grid.index_count / 3;
+
+  Meshlets meshlets = mesh_build_meshlets(scratch, indices, tri_count * 3, vertices, vert_count);
+  Assert(meshlets.triangle_count == tri_count);
+  Assert(meshlets.count >= tri_count / MESHLET_MAX_TRIANGLES && meshlets.count <= tri_count / 32);
+  // every triangle comes back exactly once with its winding
+  Slice<u64> expected = push_slice(scratch, u64, tri_count);
+  Slice<u64> built = push_slice(scratch, u64, tri_count);
+  Loop (t, tri_count) expected[t] = test_triangle_key(indices[t * 3], indices[t * 3 + 1], indices[t * 3 + 2]);
+  u32 next = 0;
+  Loop (i, meshlets.count) {
+    Meshlet m = meshlets.meshlets[i];
+    Assert(m.vertex_count <= MESHLET_MAX_VERTICES && m.triangle_count <= MESHLET_MAX_TRIANGLES);
+    u32* ids = meshlets.vertices + m.vertex_offset;
+    u8* tris = meshlets.triangles + m.triangle_offset;
+    Loop (t, m.triangle_count) {
+      Loop (k, 3) Assert(tris[t * 3 + k] < m.vertex_count);
+      built[next++] = test_triangle_key(ids[tris[t * 3]], ids[tris[t * 3 + 1]], ids[tris[t * 3 + 2]]);
+    }
+    MeshletBounds bounds = meshlets.bounds[i];
+    Loop (v, m.vertex_count) Assert(v3_length(vertices[ids[v]].pos - bounds.center) <= bounds.radius * 1.0001f);
+  }
+  sort_insert(expected, [](u64 a, u64 b) { return a < b; });
+  sort_insert(built, [](u64 a, u64 b) { return a < b; });
+  Assert(MemMatch(expected.data, built.data, tri_count * sizeof(u64)));
+
+  // the grid faces +z, from below every meshlet is backfacing, from above none is
+  v3 middle = {side / 2.f, side / 2.f, 0};
+  Loop (i, meshlets.count) {
+    Assert(meshlets.bounds[i].cone_cutoff < 1);
+    Assert(!meshlet_backfacing(&meshlets.bounds[i], middle + v3{0, 0, 10}));
+    Assert(meshlet_backfacing(&meshlets.bounds[i], middle - v3{0, 0, 10}));
+  }
+
+  // looking down at the grid sees all of it, looking up sees none
+  v4 planes[6];
+  mat4 projection = mat4_perspective(degtorad(90), 1, 0.1f, 100);
+  frustum_planes(projection * mat4_look_at(middle + v3{0, 0, 20}, {0, 0, -1}, {0, 1, 0}), planes);
+  Loop (i, meshlets.count) Assert(!meshlet_frustum_culled(&meshlets.bounds[i], planes));
+  frustum_planes(projection * mat4_look_at(middle + v3{0, 0, 20}, {0, 0, 1}, {0, 1, 0}), planes);
+  Loop (i, meshlets.count) Assert(meshlet_frustum_culled(&meshlets.bounds[i], planes));
+  // and from close up only the middle
+  frustum_planes(projection * mat4_look_at(middle + v3{0, 0, 4}, {0, 0, -1}, {0, 1, 0}), planes);
+  u32 visible = 0;
+  Loop (i, meshlets.count) visible += !meshlet_frustum_culled(&meshlets.bounds[i], planes);
+  Assert(visible > 0 && visible < meshlets.count);
+
+  Assert(mesh_build_meshlets(scratch, indices, 0, vertices, vert_count).count == 0);
+}
+
+intern void test_vertex_quantization() {
+  Scratch scratch;
+  Assert(f16_to_f32(f32_to_f16(0)) == 0 && f16_to_f32(f32_to_f16(-2.5f)) == -2.5f);
+  Assert(f32_to_f16(65504) == 0x7bff && f32_to_f16(1e6f) == 0x7c00 && f32_to_f16(-1e6f) == 0xfc00);
+  Assert(f32_to_f16(1.f / 16384) == 0x0400 && f32_to_f16(1.f / 16777216) == 0x0001);
+  Assert(f16_to_f32(0x0001) == 1.f / 16777216 && f16_to_f32(0x7c00) > F32_MAX);
+  // halfway between 1 and the next half goes to the even one
+  Assert(f32_to_f16(1 + 1.f / 2048) == 0x3c00 && f32_to_f16(1 + 3.f / 2048) == 0x3c02);
+
+  u32 vert_count = 4096;
+  Vertex* vertices = push_array(scratch, Vertex, vert_count);
+  u64 seed = 3;
+  var random = [&](f32 lo, f32 hi) {
+    seed = squirrel3(seed);
+    return lo + (hi - lo) * f32(seed % 1000001) / 1000000;
+  };
+  Loop (i, vert_count) {
+    Vertex& v = vertices[i];
+    v.pos = {random(-50, 50), random(0, 2), random(-0.5f, 3)};
+    v3 n = {random(-1, 1), random(-1, 1), random(-1, 1)};
+    v.norm = v3_length(n) > 0.01f ? n / v3_length(n) : v3{0, 1, 0};
+    v.uv = {random(0, 1), random(0, 1)};
+    v.color = {random(0, 1), random(0, 1), random(0, 1)};
+  }
+  // the axes straight on, where the octahedron's folds are
+  vertices[0].norm = {0, 0, -1};
+  vertices[1].norm = {1, 0, 0};
+  vertices[2].norm = {0, -1, 0};
+
+  VertexQuantization quantization = mesh_vertex_quantization(vertices, vert_count);
+  PackedVertex* packed = push_array(scratch, PackedVertex, vert_count);
+  Vertex* decoded = push_array(scratch, Vertex, vert_count);
+  mesh_encode_vertices(packed, vertices, vert_count, quantization);
+  mesh_decode_vertices(decoded, packed, vert_count, quantization);
+  Assert(sizeof(PackedVertex) * 2 <= sizeof(Vertex));
+  v3 step = quantization.scale / 65535;
+  Loop (i, vert_count) {
+    Vertex& a = vertices[i];
+    Vertex& b = decoded[i];
+    Assert(Abs(a.pos.x - b.pos.x) <= step.x * 0.51f && Abs(a.pos.y - b.pos.y) <= step.y * 0.51f &&
+           Abs(a.pos.z - b.pos.z) <= step.z * 0.51f);
+    // the chord is the angle in radians this close
+    Assert(v3_length(a.norm - b.norm) <= 1e-4f);
+    Assert(Abs(a.uv.x - b.uv.x) <= 1.f / 4096 && Abs(a.uv.y - b.uv.y) <= 1.f / 4096);
+    Assert(Abs(a.color.x - b.color.x) <= 1.f / 510 + 1e-6f && Abs(a.color.z - b.color.z) <= 1.f / 510 + 1e-6f);
+  }
+
+  // what the mesh cache relies on, packing decoded vertices again changes nothing
+  PackedVertex* repacked = push_array(scratch, PackedVertex, vert_count);
+  VertexQuantization requantization = mesh_vertex_quantization(decoded, vert_count);
+  mesh_encode_vertices(repacked, decoded, vert_count, requantization);
+  Assert(MemMatch(packed, repacked, vert_count * sizeof(PackedVertex)));
+}
+
+intern void test_mesh_compression() {
+  Scratch scratch;
+  const u32 side = 48;
+  Mesh grid = test_grid_mesh(scratch, side);
+  Vertex* vertices = grid.vertices;
+  u32* indices = grid.indices;
+  u32 vert_count = grid.vert_count;
+  u32 index_count = grid.index_count;
+  Loop (i, vert_count) vertices[i].uv = {vertices[i].pos.x / side, vertices[i].pos.y / side};
+  mesh_optimize_vertex_cache(indices, index_count, vert_count);
+  vert_count = mesh_optimize_vertex_fetch(vertices, vert_count, indices, index_count);
+
+  // triangles come back in order, each maybe rotated but wound the same way
+  u64 cap = mesh_compress_indices_bound(index_count, vert_count);
+  u8* encoded = push_array(scratch, u8, cap);
+  u64 size = mesh_compress_indices(indices, index_count, encoded, cap);
+  Assert(size <= cap && size * 6 < index_count * sizeof(u32));
+  u32* decoded = push_array(scratch, u32, index_count);
+  Assert(mesh_decompress_indices(encoded, size, decoded, index_count));
+  Loop (t, index_count / 3) {
+    u32* a = indices + t * 3;
+    u32* b = decoded + t * 3;
+    Assert(test_triangle_key(a[0], a[1], a[2]) == test_triangle_key(b[0], b[1], b[2]));
+  }
+  // out of order and repeated indices still make it through
+  u32 scattered[] = {7, 900, 3, 3, 900, 12, 2400, 0, 7, 7, 7, 7};
+  size = mesh_compress_indices(scattered, ArrayCount(scattered), encoded, cap);
+  Assert(mesh_decompress_indices(encoded, size, decoded, ArrayCount(scattered)));
+  Loop (t, ArrayCount(scattered) / 3) {
+    u32* a = scattered + t * 3;
+    u32* b = decoded + t * 3;
+    Assert(test_triangle_key(a[0], a[1], a[2]) == test_triangle_key(b[0], b[1], b[2]));
+  }
+  size = mesh_compress_indices(indices, index_count, encoded, cap);
+  Assert(!mesh_decompress_indices(encoded, size - 1, decoded, index_count));
+  encoded[0] ^= 1;
+  Assert(!mesh_decompress_indices(encoded, size, decoded, index_count));
+
+  // vertices come back bit exact, packed ones shrink more than full floats
+  VertexQuantization quantization = mesh_vertex_quantization(vertices, vert_count);
+  PackedVertex* packed = push_array(scratch, PackedVertex, vert_count);
+  mesh_encode_vertices(packed, vertices, vert_count, quantization);
+  struct { void* data; u32 stride; } streams[] = {{vertices, sizeof(Vertex)}, {packed, sizeof(PackedVertex)}};
+  u64 sizes[2];
+  for EachElement (s, streams) {
+    u32 stride = streams[s].stride;
+    cap = mesh_compress_vertices_bound(vert_count, stride);
+    encoded = push_array(scratch, u8, cap);
+    size = mesh_compress_vertices(streams[s].data, vert_count, stride, encoded, cap);
+    Assert(size <= cap);
+    sizes[s] = size;
+    u8* out = push_array(scratch, u8, (u64)vert_count * stride);
+    Assert(mesh_decompress_vertices(encoded, size, out, vert_count, stride));
+    Assert(MemMatch(out, streams[s].data, (u64)vert_count * stride));
+    Assert(!mesh_decompress_vertices(encoded, size - 1, out, vert_count, stride));
+    encoded[0] ^= 1;
+    Assert(!mesh_decompress_vertices(encoded, size, out, vert_count, stride));
+  }
+  Assert(sizes[0] * 4 < vert_count * sizeof(Vertex) && sizes[1] * 2 < vert_count * sizeof(PackedVertex));
+  u8 empty[64];
+  size = mesh_compress_vertices(vertices, 0, sizeof(Vertex), empty, sizeof(empty));
+  Assert(mesh_decompress_vertices(empty, size, null, 0, sizeof(Vertex)));
+
+#if SIMD_AVX2
+  // every lane width with and without escapes decodes the same both ways
+  u64 seed = 9;
+  Loop (round, 256) {
+    u8 group[VERTEX_GROUP_SIZE];
+    u32 range = round % 4 == 0 ? 3 : round % 4 == 1 ? 15 : round % 4 == 2 ? 40 : 256;
+    Loop (i, VERTEX_GROUP_SIZE) {
+      seed = squirrel3(seed);
+      group[i] = (u8)(seed % range);
+    }
+    u8 stream[48] = {};
+    Loop (bits, 4) {
+      if (bits == 0) continue;
+      u8* stream_end = vertex_group_encode(stream, group, bits);
+      u8 scalar[VERTEX_GROUP_SIZE], simd[VERTEX_GROUP_SIZE];
+      Assert(vertex_group_decode(stream, scalar, bits) == stream_end);
+      Assert(vertex_group_decode_simd(stream, simd, bits) == stream_end);
+      Assert(MemMatch(scalar, group, VERTEX_GROUP_SIZE) && MemMatch(simd, group, VERTEX_GROUP_SIZE));
+    }
+  }
+#endif
+#if ARCH_X64
+  // partial groups and running sums that wrap come out the same both ways
+  const u32 column_size = 64;
+  u64 delta_seed = 21;
+  u32 vertex_sizes[] = {4, sizeof(PackedVertex), sizeof(Vertex)};
+  for EachElement (v, vertex_sizes) {
+    u32 vertex_size = vertex_sizes[v];
+    u32 counts[] = {1, 15, 16, 37, column_size};
+    for EachElement (n, counts) {
+      u32 count = counts[n];
+      u8* columns = push_array(scratch, u8, vertex_size * column_size);
+      Loop (i, vertex_size * column_size) {
+        delta_seed = squirrel3(delta_seed);
+        columns[i] = i % column_size < count ? (u8)delta_seed : 0;
+      }
+      u8 last_scalar[256], last_simd[256];
+      Loop (k, vertex_size) last_scalar[k] = last_simd[k] = (u8)(k * 37);
+      u8* scalar = push_array(scratch, u8, count * vertex_size);
+      u8* simd = push_array(scratch, u8, count * vertex_size);
+      vertex_block_deltas(columns, column_size, count, vertex_size, last_scalar, scalar);
+      vertex_block_deltas_simd(columns, column_size, count, vertex_size, last_simd, simd);
+      Assert(MemMatch(scalar, simd, count * vertex_size) && MemMatch(last_scalar, last_simd, vertex_size));
+    }
+  }
+#endif
+}
+
 ///////////////////////////////////
 // Profiler
 
@@ -683,6 +1685,33 @@ void test_link_list() {
 
 }
 
+// needs the renderer and the thread pool, so it runs after game_init instead of from test()
+void test_asset_stream(String mesh_name, String texture_name) {
+  VK_AssetMark mark = vk_asset_mark();
+  u32 pending = asset_stream_pending();
+  Handle<GpuMesh> mesh = mesh_load_async(mesh_name, AssetPriority_High);
+  Handle<GpuTexture> texture = texture_load_async(texture_name);
+  Handle<GpuMesh> dropped = mesh_load_async(mesh_name, AssetPriority_Low);
+  Assert(asset_stream_pending() == pending + 3);
+
+  // still queued, the slot is free right away
+  mesh_load_cancel(dropped);
+  Assert(asset_stream_pending() == pending + 2);
+
+  // on the pool now, thrown away when the worker hands it back
+  asset_stream_update();
+  texture_load_cancel(texture);
+  while (asset_stream_pending() > pending) {
+    thread_wait_for();
+    asset_stream_update();
+  }
+
+  // already uploaded, nothing to cancel
+  mesh_load_cancel(mesh);
+  Assert(asset_stream_pending() == pending);
+  vk_asset_release(mark);
+}
+
 void test() {
   TimeFunction;
   test_global_alloc();
@@ -691,6 +1720,27 @@ void test() {
   test_seglist_alloc();
   test_gpu_seglist_alloc();
   test_object_pool();
+  test_darray();
   test_handle_darray();
   test_id_pool();
+  test_bitset();
+  test_concurrent_map();
+  test_mpmc_queue();
+  test_atom();
+  test_float_format();
+  test_format_string();
+  test_float_parse();
+  test_bytes_scan();
+  test_str_builder();
+  test_log_record();
+  test_log_categories();
+  test_utf8();
+  test_json();
+  test_lz4();
+  test_pack();
+  test_mesh_optimize();
+  test_mesh_simplify();
+  test_meshlets();
+  test_vertex_quantization();
+  test_mesh_compression();
 }
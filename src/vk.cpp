@@ -1,5 +1,6 @@
 #include "vk.h"
 #include "common.h"
+#include "mesh.h"
 #include "vulkan/vulkan_core.h"
 
 typedef u32 VK_BufferUsageFlags;
@@ -21,7 +22,7 @@ enum VK_MemType {
   #define VK_CHECK(expr)                     \
     {                                        \
       if (expr != VK_SUCCESS) {              \
-        Error("%s", vk_result_string(expr)); \
+        Log(Vk, Error, "%s", vk_result_string(expr)); \
         InvalidPath;                         \
       }                                      \
     }
@@ -40,7 +41,7 @@ const u32 MaxTextures   = KB(1);
 const u32 MaxDrawCalls  = KB(1);
 const u32 MaxDebugLines = KB(1);
 
-struct VK_KeyToShaderPipeline { String name; ShaderState state; };
+struct VK_KeyToShaderPipeline { Atom name; ShaderState state; };
 intern u64 hash(VK_KeyToShaderPipeline x) { return hash(x.name) + hash_memory(&x.state, sizeof(ShaderState)); }
 intern b32 equal(VK_KeyToShaderPipeline a, VK_KeyToShaderPipeline b) { return equal(a.name, b.name) & MemMatchStruct(&a.state, &b.state); }
 
@@ -129,9 +130,6 @@ struct VK_RenderEntity {
   u32 entity_idx_in_array;
   u32 pipeline;
   Handle<GpuMesh> mesh;
-#if BUILD_DEBUG
-  b32 is_init;
-#endif
 };
 
 enum VK_RenderpassType {
@@ -183,9 +181,13 @@ struct VK_Image {
 
 struct VK_Mesh {
   u32 vert_count;
-  u64 vert_offset;
+  u64 vert_offset; // into packed_vert_buffer when packed
+  b32 packed;
+  VertexQuantization quantization;
   u32 index_count;
   u64 index_offset;
+  u32 lod_count;
+  MeshLod lods[MESH_LOD_MAX];
 };
 
 struct VK_Swapchain {
@@ -246,6 +248,10 @@ struct VK_DrawCallInfo {
     VkDrawIndexedIndirectCommand index_draw_command;
   };
   u32 entities_offset_id;
+  // packed meshes are dequantized in the vertex shader, pos = quant_offset + unorm * quant_scale
+  b32 packed;
+  alignas(16) v3 quant_offset;
+  alignas(16) v3 quant_scale;
 };
 
 struct VK_State {
@@ -274,6 +280,7 @@ struct VK_State {
   VK_Memory gpu_mem;
   VK_Memory cpu_mem;
   VK_Buffer vert_buffer;
+  VK_Buffer packed_vert_buffer;
   VK_Buffer index_buffer;
   VK_Buffer stage_buffer;
   VK_Buffer indirect_draw_buffer;
@@ -299,9 +306,20 @@ struct VK_State {
   u32 static_draw_indexed_offset;
   u32 static_draw_offset;
   u32 static_indexed_draw_count;
+  u32 static_packed_draw_count; // the first of the indexed ones
   u32 static_draw_count;
+  // static draws are rebuilt when set, e.g. a mesh was replaced or a static entity changed lod
+  b32 static_dirty;
+  u8 static_lods[MaxStaticEntities];
+  v3 lod_cam_pos;
+  f32 lod_pixel_scale;
+  u64 triangles_drawn;
+  u64 static_triangles_drawn;
 
   Array<VK_RenderEntity, MaxEntities+MaxStaticEntities> entities;
+#if BUILD_DEBUG
+  Bitset<MaxEntities+MaxStaticEntities> entities_renderable;
+#endif
   Array<VK_Mesh, MaxMeshes> meshes;
   Array<VK_Image, MaxTextures> textures;
 
@@ -328,12 +346,13 @@ struct VK_State {
   Darray<u32> draw_vert_offsets;
 
   Darray<VkPipeline> pipelines;
+  Darray<VkPipeline> packed_pipelines; // same shader and state reading PackedVertex
   Darray<VK_ShaderModuleEntry> modules;
   Darray<VK_RenderBatch> batches;
   Darray<GpuMaterial> materials;
   
-  Map<VK_KeyToShaderPipeline, u32> shader_to_pipeline;
-  Map<String, u32> shader_to_module;
+  ConcurrentMap<VK_KeyToShaderPipeline, u32> shader_to_pipeline;
+  Map<Atom, u32> shader_to_module;
 
   ///////////////////////////////////
   // Vulkan loader
@@ -576,7 +595,7 @@ intern String vk_result_string(VkResult result) {
       .hwnd = (HWND)os_get_window_handle()
     };
     VK_CHECK(vkCreateWin32SurfaceKHR(vk->instance, &surface_create_info, vk->allocator, &vk->surface));
-    Info("Vulkan win32 surface created");
+    Log(Vk, Info, "Vulkan win32 surface created");
   }
   #define VK_SURFACE_NAME VK_KHR_WIN32_SURFACE_EXTENSION_NAME
   
@@ -597,7 +616,7 @@ intern String vk_result_string(VkResult result) {
       };
       PFN_vkCreateXcbSurfaceKHR vkCreateXcbSurfaceKHR = (PFN_vkCreateXcbSurfaceKHR)vk->GetInstanceProcAddr(vk->instance, "vkCreateXcbSurfaceKHR");
       VK_CHECK(vkCreateXcbSurfaceKHR(vk->instance, &surfaceInfo, vk->allocator, &vk->surface));
-      Info("Vulkan XCB surface created");
+      Log(Vk, Info, "Vulkan XCB surface created");
     }
     #define VK_SURFACE_NAME VK_KHR_XCB_SURFACE_EXTENSION_NAME
 
@@ -616,7 +635,7 @@ intern String vk_result_string(VkResult result) {
       };
       PFN_vkCreateWaylandSurfaceKHR vkCreateWaylandSurfaceKHR = (PFN_vkCreateWaylandSurfaceKHR)vk->GetInstanceProcAddr(vk->instance, "vkCreateWaylandSurfaceKHR");
       VK_CHECK(vkCreateWaylandSurfaceKHR (vk->instance, &surfaceInfo, vk->allocator, &vk->surface));
-      Info("Vulkan wayland surface created");
+      Log(Vk, Info, "Vulkan wayland surface created");
     }
     #define VK_SURFACE_NAME VK_KHR_WAYLAND_SURFACE_EXTENSION_NAME
   #endif
@@ -860,8 +879,9 @@ intern VkPipeline vk_shader_pipeline_create(Shader shader) {
     Loop (i, 2) {
       String stage_type_strs[] = {"vert", "frag"};
       VkShaderStageFlagBits stage_types[] = {VK_SHADER_STAGE_VERTEX_BIT, VK_SHADER_STAGE_FRAGMENT_BIT};
-      String filepath = push_strf(scratch, "%s/%s.%s.spv", g_st->shader_compiled_dir, shader.name, stage_type_strs[i]);
-      Slice binary = os_file_path_read_all(scratch, filepath);
+      String filepath = push_strf(scratch, "shaders/compiled/%s.%s.spv", shader.name, stage_type_strs[i]);
+      VFile file = vfs_open(g_st->vfs, scratch, filepath);
+      Slice binary = file.data;
       VkShaderModuleCreateInfo module_info = {
         .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
         .codeSize = binary.size,
@@ -869,6 +889,7 @@ intern VkPipeline vk_shader_pipeline_create(Shader shader) {
       };
       VkShaderModule handle;
       VK_CHECK(vk->CreateShaderModule(vkdevice, &module_info, vk->allocator, &handle));
+      vfs_close(file);
       stages[i] = {
         .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
         .stage = stage_types[i],
@@ -1072,8 +1093,9 @@ VK_ShaderModule vk_shader_module_create(String name) {
   Loop (i, 2) {
     String stage_type_strs[] = {"vert", "frag"};
     VkShaderStageFlagBits stage_types[] = {VK_SHADER_STAGE_VERTEX_BIT, VK_SHADER_STAGE_FRAGMENT_BIT};
-    String filepath = push_strf(scratch, "%s/%s.%s.spv", g_st->shader_compiled_dir, name, stage_type_strs[i]);
-    Slice binary = os_file_path_read_all(scratch, filepath);
+    String filepath = push_strf(scratch, "shaders/compiled/%s.%s.spv", name, stage_type_strs[i]);
+    VFile file = vfs_open(g_st->vfs, scratch, filepath);
+    Slice binary = file.data;
     VkShaderModuleCreateInfo module_info = {
       .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
       .codeSize = binary.size,
@@ -1081,6 +1103,7 @@ VK_ShaderModule vk_shader_module_create(String name) {
     };
     VkShaderModule handle;
     VK_CHECK(vk->CreateShaderModule(vkdevice, &module_info, vk->allocator, &handle));
+    vfs_close(file);
     module.stages[i] = {
       .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
       .stage = stage_types[i],
@@ -1091,7 +1114,8 @@ VK_ShaderModule vk_shader_module_create(String name) {
   return module;
 }
 
-intern VkPipeline vk_shader_pipeline_create_(VK_ShaderModule module, ShaderState state) {
+// packed pipelines read PackedVertex rows, the shader sees the same inputs still quantized
+intern VkPipeline vk_shader_pipeline_create_(VK_ShaderModule module, ShaderState state, b32 packed = false) {
   // Dynamic rendering
   // VkFormat color_format = VK_FORMAT_R8G8B8A8_UNORM;
   VkFormat color_format = VK_FORMAT_B8G8R8A8_UNORM;
@@ -1136,6 +1160,18 @@ intern VkPipeline vk_shader_pipeline_create_(VK_ShaderModule module, ShaderState
       .offset = (u32)OffsetOf(Vertex, color),
     },
   };
+  if (packed) {
+    // norm comes in with z = 0, vertex_unpack unfolds it
+    binding_description.stride = sizeof(PackedVertex);
+    attribute_desriptions[0].format = VK_FORMAT_R16G16B16A16_UNORM;
+    attribute_desriptions[0].offset = (u32)OffsetOf(PackedVertex, pos);
+    attribute_desriptions[1].format = VK_FORMAT_R16G16_SNORM;
+    attribute_desriptions[1].offset = (u32)OffsetOf(PackedVertex, norm);
+    attribute_desriptions[2].format = VK_FORMAT_R16G16_SFLOAT;
+    attribute_desriptions[2].offset = (u32)OffsetOf(PackedVertex, uv);
+    attribute_desriptions[3].format = VK_FORMAT_R8G8B8A8_UNORM;
+    attribute_desriptions[3].offset = (u32)OffsetOf(PackedVertex, color);
+  }
   VkPipelineVertexInputStateCreateInfo vertex_input_state = {
     .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
     .vertexBindingDescriptionCount = 1,
@@ -1281,7 +1317,7 @@ intern VkPipeline vk_shader_pipeline_create_(VK_ShaderModule module, ShaderState
 }
 
 void vk_shader_reload(String name) {
-  u32* module_idx = vk->shader_to_module.get(name);
+  u32* module_idx = vk->shader_to_module.get(atom_from_str(name));
   VK_ShaderModuleEntry& entry = vk->modules[*module_idx];
   entry.module = vk_shader_module_create(name);
   Loop (i, entry.track_pipelines.count) {
@@ -1289,6 +1325,7 @@ void vk_shader_reload(String name) {
     u32 material_idx = entry.track_shader_states[i];
     ShaderState state = vk->materials[material_idx].shader_state;
     vk->pipelines[pipeline_idx] = vk_shader_pipeline_create_(entry.module, state);
+    vk->packed_pipelines[pipeline_idx] = vk_shader_pipeline_create_(entry.module, state, true);
   }
 }
 
@@ -1780,7 +1817,7 @@ intern void vk_texture_generate_mipmaps(VK_Image image) {
   vk->CmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, null, 0, null, 1, &barrier);
 }
 
-Handle<GpuTexture> vk_texture_load(Texture texture) {
+intern VK_Image vk_texture_upload(Texture texture) {
   u64 size = texture.width * texture.height * 4;
   MemCopy(vk->stage_buffer.mapped_mem, texture.data, size);
   VK_ImageInfo image_info = vk_image_info_default(texture.width, texture.height);
@@ -1795,6 +1832,10 @@ Handle<GpuTexture> vk_texture_load(Texture texture) {
     vk_texture_generate_mipmaps(image);
     vk_cmd_end_submit(cmd);
   }
+  return image;
+}
+
+intern void vk_texture_bind(u32 id, VK_Image image) {
   VkDescriptorImageInfo descriptor_image_info = {
     .sampler = vk->sampler,
     .imageView = image.view,
@@ -1804,22 +1845,74 @@ Handle<GpuTexture> vk_texture_load(Texture texture) {
     .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
     .dstSet = vk->descriptor_sets,
     .dstBinding = 1,
-    .dstArrayElement = vk->textures.count,
+    .dstArrayElement = id,
     .descriptorCount = 1,
     .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
     .pImageInfo = &descriptor_image_info,
   };
   VkWriteDescriptorSet descriptors[] = {texture_write_descriptor};
   vk->UpdateDescriptorSets(vkdevice, ArrayCount(descriptors), descriptors, 0, null);
+}
+
+Handle<GpuTexture> vk_texture_load(Texture texture) {
+  VK_Image image = vk_texture_upload(texture);
+  u32 id = vk->textures.count;
+  vk_texture_bind(id, image);
+  vk->textures.add(image);
+  Handle<GpuTexture> handle = {id};
+  return handle;
+}
+
+// the new slot samples the placeholder's image until vk_texture_replace
+Handle<GpuTexture> vk_texture_placeholder(Handle<GpuTexture> placeholder) {
+  VK_Image image = vk->textures[placeholder.handle];
   u32 id = vk->textures.count;
+  vk_texture_bind(id, image);
   vk->textures.add(image);
   Handle<GpuTexture> handle = {id};
   return handle;
 }
 
+// NOTE: the upload waits for the queue to go idle, so no frame in flight still reads the
+// old descriptor when it's rewritten
+void vk_texture_replace(Handle<GpuTexture> handle, Texture texture) {
+  VK_Image image = vk_texture_upload(texture);
+  vk_texture_bind(handle.handle, image);
+  vk->textures[handle.handle] = image;
+}
+
+VK_AssetMark vk_asset_mark() {
+  VK_AssetMark mark = {
+    .mesh_count = vk->meshes.count,
+    .texture_count = vk->textures.count,
+    .vert_pos = vk->vert_buffer.pos,
+    .packed_vert_pos = vk->packed_vert_buffer.pos,
+    .index_pos = vk->index_buffer.pos,
+  };
+  return mark;
+}
+
+// the released descriptors stay written, they are partially bound and nothing samples them
+void vk_asset_release(VK_AssetMark mark) {
+  VK_CHECK(vk->DeviceWaitIdle(vkdevice));
+  for (u32 i = mark.texture_count; i < vk->textures.count; ++i) {
+    // a placeholder samples the image of the slot it stands in for
+    b32 shared = false;
+    Loop (j, i) {
+      shared |= vk->textures[j].h == vk->textures[i].h;
+    }
+    if (!shared) vk_image_destroy(vk->textures[i]);
+  }
+  vk->textures.count = mark.texture_count;
+  vk->meshes.count = mark.mesh_count;
+  vk->vert_buffer.pos = mark.vert_pos;
+  vk->packed_vert_buffer.pos = mark.packed_vert_pos;
+  vk->index_buffer.pos = mark.index_pos;
+}
+
 intern void vk_texture_resize_target() {
   VK_CHECK(vk->DeviceWaitIdle(vkdevice));
-  Debug("texture target resized: x = %u y = %u", vk->width, vk->height);
+  Log(Vk, Debug, "texture target resized: x = %u y = %u", vk->width, vk->height);
   u32 width = vk->width * vk->scale;
   u32 height = vk->height * vk->scale;
   if (width == 0) width = 1;
@@ -1884,24 +1977,26 @@ intern void vk_texture_resize_target() {
 
 Handle<GpuMaterial> vk_material_load(Material material) {
   VK_State& g = *vk;
-  VK_KeyToShaderPipeline key = {material.shader.name, material.shader.state};
-  u32* pipeline_idx = g.shader_to_pipeline.get(key);
-  if (!pipeline_idx) {
-    u32* module_idx = g.shader_to_module.get(material.shader.name);
+  Atom shader_name = atom_from_str(material.shader.name);
+  VK_KeyToShaderPipeline key = {shader_name, material.shader.state};
+  u32 pipeline_idx;
+  if (!g.shader_to_pipeline.get(key, &pipeline_idx)) {
+    u32* module_idx = g.shader_to_module.get(shader_name);
     if (!module_idx) {
       VK_ShaderModule module = vk_shader_module_create(material.shader.name);
-      module_idx = g.shader_to_module.add(material.shader.name, g.modules.count);
+      module_idx = g.shader_to_module.add(shader_name, g.modules.count);
       VK_ShaderModuleEntry entry = vk_shader_module_entry_make(g.gpa);
       entry.module = module;
       g.modules.add(entry);
     }
-    VkPipeline pipeline = vk_shader_pipeline_create_(g.modules[*module_idx].module, material.shader.state);
-    pipeline_idx = g.shader_to_pipeline.add(key, g.pipelines.count);
-    g.pipelines.add(pipeline);
+    VK_ShaderModule module = g.modules[*module_idx].module;
+    pipeline_idx = g.shader_to_pipeline.get_or_add(key, g.pipelines.count);
+    g.pipelines.add(vk_shader_pipeline_create_(module, material.shader.state));
+    g.packed_pipelines.add(vk_shader_pipeline_create_(module, material.shader.state, true));
     g.batches.add(vk_render_batch_make(g.gpa));
 
     VK_ShaderModuleEntry& entry = g.modules[*module_idx];
-    entry.track_pipelines.add(*pipeline_idx);
+    entry.track_pipelines.add(pipeline_idx);
     entry.track_shader_states.add(g.materials.count);
   }
   g.gpu_materials[g.materials.count] = {
@@ -1912,7 +2007,7 @@ Handle<GpuMaterial> vk_material_load(Material material) {
     .texture = material.texture_handle, 
   };
   GpuMaterial mat = {
-    .pipeline_idx = *pipeline_idx,
+    .pipeline_idx = pipeline_idx,
     .shader_state = material.shader.state,
     .texture = material.texture_handle,
     .props = material.props,
@@ -2034,7 +2129,7 @@ intern VK_DevicePhysicalQueueFamilyInfo vk_device_physical_meets_requirements(
   vk->GetPhysicalDeviceQueueFamilyProperties(device, &queue_family_count, queue_families);
   
   // Look at each queue and see what queues it supports
-  Info("Graphics | Present | Computer | Transfer | Name");
+  Log(Vk, Info, "Graphics | Present | Computer | Transfer | Name");
   Loop (i, queue_family_count) {
     // Graphics queue?
     if ((queue_families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) && (queue_info.graphics_family_index == -1)) {
@@ -2070,7 +2165,7 @@ intern VK_DevicePhysicalQueueFamilyInfo vk_device_physical_meets_requirements(
   if (queue_info.transfer_family_index == -1) queue_info.transfer_family_index = queue_info.graphics_family_index;
   if (queue_info.compute_family_index == -1) queue_info.compute_family_index = queue_info.graphics_family_index;
 
-  Info("       %i |       %i |        %i |        %i | %s",
+  Log(Vk, Info, "       %i |       %i |        %i |        %i | %s",
     queue_info.graphics_family_index != -1,
     queue_info.present_family_index != -1,
     queue_info.compute_family_index != -1,
@@ -2088,11 +2183,11 @@ intern VK_DevicePhysicalQueueFamilyInfo vk_device_physical_meets_requirements(
     AssertMsg(false, "Device doesn't have needed queues");
   }
 
-  Info("Device meets queue requirements");
-  Trace("Grahics Family Index: %i", queue_info.graphics_family_index);
-  Trace("Present Family Index: %i", queue_info.present_family_index);
-  Trace("Transfer Family Index: %i", queue_info.transfer_family_index);
-  Trace("Compute Family Index: %i", queue_info.compute_family_index);
+  Log(Vk, Info, "Device meets queue requirements");
+  Log(Vk, Trace, "Grahics Family Index: %i", queue_info.graphics_family_index);
+  Log(Vk, Trace, "Present Family Index: %i", queue_info.present_family_index);
+  Log(Vk, Trace, "Transfer Family Index: %i", queue_info.transfer_family_index);
+  Log(Vk, Trace, "Compute Family Index: %i", queue_info.compute_family_index);
 
   *out_swapchain_support = vk_device_query_swapchain_support(device);
   Assert((out_swapchain_support->format_count >= 1) && (out_swapchain_support->present_mode_count >= 1) && "Required swapchain support not present");
@@ -2160,37 +2255,37 @@ intern VK_Device vk_device_select_physical() {
       &devices[i].swapchain_support
     );
 
-    Info("Available device: '%s'", String(properties.deviceName));
+    Log(Vk, Info, "Available device: '%s'", String(properties.deviceName));
     // GPU type, etc.
     switch (properties.deviceType) {
       default: break;
       case VK_PHYSICAL_DEVICE_TYPE_OTHER: {
-        Info("GPU type is Unkown");
+        Log(Vk, Info, "GPU type is Unkown");
         fallback_gpu_idx = i;
       } break;
       case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: {
-        Info("GPU type is Integrated");
+        Log(Vk, Info, "GPU type is Integrated");
         fallback_gpu_idx = i;
       } break;
       case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: {
         discrete_gpu_idx = i;
-      } Info("GPU type is Descrete");
+      } Log(Vk, Info, "GPU type is Descrete");
         break;
       case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: {
-        Info("GPU type is Virtual");
+        Log(Vk, Info, "GPU type is Virtual");
         fallback_gpu_idx = i;
       } break;
       case VK_PHYSICAL_DEVICE_TYPE_CPU: {
-        Info("GPU type is CPU");
+        Log(Vk, Info, "GPU type is CPU");
         fallback_gpu_idx = i;
       } break;
     }
 
-    Info("GPU Driver version: %i.%i.%i",
+    Log(Vk, Info, "GPU Driver version: %i.%i.%i",
       VK_VERSION_MAJOR(properties.driverVersion),
       VK_VERSION_MINOR(properties.driverVersion),
       VK_VERSION_PATCH(properties.driverVersion));
-    Info("GPU API version: %i.%i.%i",
+    Log(Vk, Info, "GPU API version: %i.%i.%i",
       VK_VERSION_MAJOR(properties.apiVersion),
       VK_VERSION_MINOR(properties.apiVersion),
       VK_VERSION_PATCH(properties.apiVersion));
@@ -2198,9 +2293,9 @@ intern VK_Device vk_device_select_physical() {
     Loop (j, memory.memoryHeapCount) {
       f32 memory_size_gib = (((f32)memory.memoryHeaps[j].size) / GB(1));
       if (memory.memoryHeaps[j].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
-        Info("Local GPU memory: %.2f GiB", memory_size_gib);
+        Log(Vk, Info, "Local GPU memory: %.2f GiB", memory_size_gib);
       else
-        Info("Shared System memory: %.2f GiB", memory_size_gib);
+        Log(Vk, Info, "Shared System memory: %.2f GiB", memory_size_gib);
     }
 
     devices[i].physical_device = physical_devices[i];
@@ -2217,12 +2312,12 @@ intern VK_Device vk_device_select_physical() {
   i32 selected_index;
   if (discrete_gpu_idx != -1) {
     selected_index = discrete_gpu_idx; 
-    Info("Discrete GPU was choosen");
+    Log(Vk, Info, "Discrete GPU was choosen");
   } else {
     selected_index = fallback_gpu_idx;
-    Info("Integrated GPU was choosen");
+    Log(Vk, Info, "Integrated GPU was choosen");
   }
-  Info("Physical device selected");
+  Log(Vk, Info, "Physical device selected");
   return devices[selected_index];
 }
 
@@ -2293,7 +2388,7 @@ intern void vk_device_create() {
     .pEnabledFeatures = &device_features,
   };
   VK_CHECK(vk->CreateDevice(vk->device.physical_device, &device_create_info, vk->allocator, &vk->device.logical_device));
-  Info("Logical device created");
+  Log(Vk, Info, "Logical device created");
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -2415,7 +2510,7 @@ intern void vk_swapchain_recreate() {
   VK_Swapchain old = vk->swapchain;
   vk_swapchain_create(true);
   vk_swapchain_destroy(old);
-  Info("Swapchain recreated x: %i y: %i", vk->width, vk->height);
+  Log(Vk, Info, "Swapchain recreated x: %i y: %i", vk->width, vk->height);
 }
 
 intern u32 vk_swapchain_acquire_next_image_index(VkSemaphore image_available_semaphore) {
@@ -2423,7 +2518,7 @@ intern u32 vk_swapchain_acquire_next_image_index(VkSemaphore image_available_sem
 #if GFX_X11 // NOTE: on x11 errors
   VkResult res = vk->AcquireNextImageKHR(vkdevice, vk->swapchain.h, U64_MAX, image_available_semaphore, null, &image_index);
   if (res != VK_SUCCESS) {
-    // Warn("%s", vk_result_string(res));
+    // Log(Vk, Warn, "%s", vk_result_string(res));
   }
 #else
   VK_CHECK(vk->AcquireNextImageKHR(vkdevice, vk->swapchain.handle, U64_MAX, image_available_semaphore, null, &image_index));
@@ -2444,7 +2539,7 @@ intern void vk_swapchain_present(VkSemaphore render_complete_semaphore, u32 pres
   VkResult res = vk->QueuePresentKHR(vk->device.graphics_queue, &present_info);
   UnusedVariable(res);
   // if (res != VK_SUCCESS) {
-  //   Error("%s", vk_result_string(res));
+  //   Log(Vk, Error, "%s", vk_result_string(res));
   // }
 #else
   VK_CHECK(vk->QueuePresentKHR(vk->device.graphics_queue, &present_info));
@@ -2454,13 +2549,16 @@ intern void vk_swapchain_present(VkSemaphore render_complete_semaphore, u32 pres
 ////////////////////////////////////////////////////////////////////////
 // @Mesh
 
-Handle<GpuMesh> vk_mesh_load(Mesh mesh) {
-  VK_Buffer& vert_buff = vk->vert_buffer;
-  u64 vert_size = mesh.vert_count*sizeof(Vertex);
+intern VK_Mesh vk_mesh_upload(Mesh mesh) {
+  // packed meshes are only drawn through the indexed batches
+  b32 packed = mesh.packed_vertices != null;
+  AssertMsg(!packed || mesh.indices, "packed meshes must be indexed");
+  VK_Buffer& vert_buff = packed ? vk->packed_vert_buffer : vk->vert_buffer;
+  u64 vert_size = mesh.vert_count*(packed ? sizeof(PackedVertex) : sizeof(Vertex));
   u64 vert_offset = vert_buff.pos;
   vert_buff.pos += vert_size;
   BufferRegion vert_range = { .offset = vert_offset, .size = vert_size };
-  vk_buffer_upload(vk->vert_buffer, vert_range, mesh.vertices);
+  vk_buffer_upload(vert_buff, vert_range, packed ? (void*)mesh.packed_vertices : (void*)mesh.vertices);
 
   VK_Buffer& index_buff = vk->index_buffer;
   u64 index_size = mesh.index_count*sizeof(u32);
@@ -2474,18 +2572,79 @@ Handle<GpuMesh> vk_mesh_load(Mesh mesh) {
   VK_Mesh vk_mesh = {
     .vert_count = mesh.vert_count,
     .vert_offset = vert_range.offset,
+    .packed = packed,
+    .quantization = mesh.quantization,
     .index_count = mesh.index_count,
     .index_offset = index_range.offset,
+    .lod_count = Max(mesh.lod_count, 1u),
   };
+  MemCopy(vk_mesh.lods, mesh.lods, sizeof(vk_mesh.lods));
+  if (mesh.lod_count == 0) {
+    vk_mesh.lods[0] = {0, mesh.index_count, 0};
+  }
+  return vk_mesh;
+}
+
+Handle<GpuMesh> vk_mesh_load(Mesh mesh) {
+  u32 id = vk->meshes.count;
+  vk->meshes.add(vk_mesh_upload(mesh));
+  Handle<GpuMesh> handle = {id};
+  return handle;
+}
+
+// the new slot draws the placeholder's geometry until vk_mesh_replace
+Handle<GpuMesh> vk_mesh_placeholder(Handle<GpuMesh> placeholder) {
+  VK_Mesh mesh = vk->meshes[placeholder.handle];
   u32 id = vk->meshes.count;
-  vk->meshes.add(vk_mesh);
+  vk->meshes.add(mesh);
   Handle<GpuMesh> handle = {id};
   return handle;
 }
 
+void vk_mesh_replace(Handle<GpuMesh> handle, Mesh mesh) {
+  // entities were put in the indexed or plain batch by what the slot held when they were made
+  AssertMsg((mesh.index_count != 0) == (vk->meshes[handle.handle].index_count != 0),
+            "mesh replacement must match the placeholder's indexing");
+  vk->meshes[handle.handle] = vk_mesh_upload(mesh);
+  vk->static_dirty = true;
+}
+
 ////////////////////////////////////////////////////////////////////////
 // @Drawing
 
+// picked per instance from how many pixels the lod's error covers at its distance
+intern u32 vk_mesh_lod(VK_Mesh& mesh, Transform& trans) {
+  if (mesh.lod_count <= 1) { return 0; }
+  f32 scale = Max(Abs(trans.scale.x), Max(Abs(trans.scale.y), Abs(trans.scale.z)));
+  f32 distance = v3_length(trans.pos - vk->lod_cam_pos);
+  return mesh_lod_select(mesh.lods, mesh.lod_count, scale, distance, vk->lod_pixel_scale);
+}
+
+// full meshes read Vertex through the material's pipeline, packed ones PackedVertex through its
+// packed twin
+intern void vk_draw_bind(VkCommandBuffer cmd, u32 pipeline_idx, b32 packed) {
+  VkDeviceSize offset = 0;
+  vk->CmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, packed ? vk->packed_pipelines[pipeline_idx] : vk->pipelines[pipeline_idx]);
+  vk->CmdBindVertexBuffers(cmd, 0, 1, packed ? &vk->packed_vert_buffer.h : &vk->vert_buffer.h, &offset);
+}
+
+intern VK_DrawCallInfo vk_draw_call_indexed(VK_Mesh& mesh, u32 lod, u32 instances, u32 entities_offset_id) {
+  VK_DrawCallInfo info = {
+    .index_draw_command = {
+      .indexCount = mesh.lods[lod].index_count,
+      .instanceCount = instances,
+      .firstIndex = (u32)(mesh.index_offset/sizeof(u32)) + mesh.lods[lod].index_offset,
+      .vertexOffset = (i32)(mesh.vert_offset/(mesh.packed ? sizeof(PackedVertex) : sizeof(Vertex))),
+      .firstInstance = 0,
+    },
+    .entities_offset_id = entities_offset_id,
+    .packed = mesh.packed,
+    .quant_offset = mesh.quantization.offset,
+    .quant_scale = mesh.quantization.scale,
+  };
+  return info;
+}
+
 void vk_draw() {
   GlobalStateGPU& shader_st = *vk->gpu_global_shader_st;
   shader_st.projection_view = vk->projection * vk->view;
@@ -2502,43 +2661,70 @@ void vk_draw() {
   u32 draw_call_mem_offset = 0;
   u32 entities_draw_count = 0;
   u32 entities_draw_id_offset = 0;
+  vk->triangles_drawn = 0;
+
+  // static entities only pick their lods again once the camera moved
+  vk->lod_pixel_scale = vk->height * 0.5f * vk->projection.y.y;
+  v3 cam_pos = v3_of_v4(mat4_inverse(vk->view).w);
+  if (cam_pos != vk->lod_cam_pos || vk->static_dirty) {
+    vk->lod_cam_pos = cam_pos;
+    Loop (i, vk->pipelines.count) {
+      for (VK_MeshBatch mesh_batch : vk->batches[i].static_batch_indexed.mesh_batches) {
+        VK_Mesh& mesh = vk->meshes[mesh_batch.mesh_handle.handle];
+        for (Handle<StaticEntity> entity_handle : mesh_batch.entities) {
+          u8 lod = (u8)vk_mesh_lod(mesh, entity_handle.trans());
+          vk->static_dirty |= vk->static_lods[entity_handle.idx()] != lod;
+          vk->static_lods[entity_handle.idx()] = lod;
+        }
+      }
+    }
+  }
 
   Loop (i, vk->pipelines.count) {
-    vk->CmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, vk->pipelines[i]);
     VK_RenderBatch& batch = vk->batches[i];
 
-    // Indexed Entities per shader
-    u32 per_shader_indexed_draw_count = 0;
-    for (VK_MeshBatch mesh_batch : batch.batch_indexed.mesh_batches) {
-      if (mesh_batch.entities.count == 0) continue;
-      for (Handle<Entity> entity_handle : mesh_batch.entities) {
-        u32 entity_idx = entity_handle.idx();
-        vk->gpu_entities[entity_idx].model = mat4_transform(entity_handle.trans());
-        vk->gpu_entities_indexes[entities_draw_count++] = entity_idx;
+    // Indexed Entities per shader, one draw per lod that has instances, packed meshes first
+    Loop (pass, 2) {
+      b32 packed = pass == 0;
+      u32 per_shader_indexed_draw_count = 0;
+      for (VK_MeshBatch mesh_batch : batch.batch_indexed.mesh_batches) {
+        if (mesh_batch.entities.count == 0) continue;
+        u32 mesh_idx = mesh_batch.mesh_handle.handle;
+        VK_Mesh mesh = vk->meshes[mesh_idx];
+        if (mesh.packed != packed) continue;
+        Scratch scratch;
+        u8* lods = push_array(scratch, u8, mesh_batch.entities.count);
+        u32 lod_instances[MESH_LOD_MAX] = {};
+        Loop (e, mesh_batch.entities.count) {
+          lods[e] = (u8)vk_mesh_lod(mesh, mesh_batch.entities[e].trans());
+          lod_instances[lods[e]]++;
+        }
+        Loop (lod, mesh.lod_count) {
+          if (lod_instances[lod] == 0) continue;
+          Loop (e, mesh_batch.entities.count) {
+            if (lods[e] != lod) continue;
+            Handle<Entity> entity_handle = mesh_batch.entities[e];
+            u32 entity_idx = entity_handle.idx();
+            vk->gpu_entities[entity_idx].model = mat4_transform(entity_handle.trans());
+            vk->gpu_entities_indexes[entities_draw_count++] = entity_idx;
+          }
+          vk->gpu_draw_call_infos[draw_call_count++] = vk_draw_call_indexed(mesh, lod, lod_instances[lod], entities_draw_id_offset);
+          entities_draw_id_offset += lod_instances[lod];
+          vk->triangles_drawn += (u64)mesh.lods[lod].index_count / 3 * lod_instances[lod];
+          ++per_shader_indexed_draw_count;
+        }
       }
-      u32 mesh_idx = mesh_batch.mesh_handle.handle;
-      VK_Mesh mesh = vk->meshes[mesh_idx];
-      VK_DrawCallInfo info = {
-        .index_draw_command = {
-          .indexCount = (u32)mesh.index_count,
-          .instanceCount = mesh_batch.entities.count,
-          .firstIndex = (u32)(mesh.index_offset/sizeof(u32)),
-          .vertexOffset = (i32)(mesh.vert_offset/sizeof(Vertex)),
-          .firstInstance = 0,
-        },
-        .entities_offset_id = entities_draw_id_offset,
-      };
-      vk->gpu_draw_call_infos[draw_call_count++] = info;
-      entities_draw_id_offset += mesh_batch.entities.count;
-      ++per_shader_indexed_draw_count;
-    }
-    if (per_shader_indexed_draw_count > 0) {
-      VK_PushConstant push = {.drawcall_offset = draw_call_mem_offset / (u32)sizeof(VK_DrawCallInfo)};
-      vk->CmdPushConstants(cmd, vk->pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(VK_PushConstant), &push);
-      vk->CmdDrawIndexedIndirect(cmd, vk->indirect_draw_buffer.h, draw_call_mem_offset, per_shader_indexed_draw_count, sizeof(VK_DrawCallInfo));
+      if (per_shader_indexed_draw_count > 0) {
+        vk_draw_bind(cmd, i, packed);
+        VK_PushConstant push = {.drawcall_offset = draw_call_mem_offset / (u32)sizeof(VK_DrawCallInfo)};
+        vk->CmdPushConstants(cmd, vk->pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(VK_PushConstant), &push);
+        vk->CmdDrawIndexedIndirect(cmd, vk->indirect_draw_buffer.h, draw_call_mem_offset, per_shader_indexed_draw_count, sizeof(VK_DrawCallInfo));
+      }
+      draw_call_mem_offset = draw_call_count * sizeof(VK_DrawCallInfo);
     }
 
     // Entities per shader
+    vk_draw_bind(cmd, i, false);
     u32 per_shader_draw_count = 0;
     for (VK_MeshBatch mesh_batch : batch.batch.mesh_batches) {
       if (mesh_batch.entities.count == 0) continue;
@@ -2560,50 +2746,55 @@ void vk_draw() {
       };
       vk->gpu_draw_call_infos[draw_call_count++] = info;
       entities_draw_id_offset += mesh_batch.entities.count;
+      vk->triangles_drawn += (u64)mesh.vert_count / 3 * mesh_batch.entities.count;
       ++per_shader_draw_count;
     }
     if (per_shader_draw_count > 0) {
-      u32 draw_call_indexed_mem_offset = draw_call_mem_offset + (u32)sizeof(VK_DrawCallInfo)*per_shader_indexed_draw_count;
-      VK_PushConstant push = {.drawcall_offset = draw_call_indexed_mem_offset / (u32)sizeof(VK_DrawCallInfo)};
+      VK_PushConstant push = {.drawcall_offset = draw_call_mem_offset / (u32)sizeof(VK_DrawCallInfo)};
       vk->CmdPushConstants(cmd, vk->pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(VK_PushConstant), &push);
-      vk->CmdDrawIndirect(cmd, vk->indirect_draw_buffer.h, draw_call_indexed_mem_offset , per_shader_draw_count, sizeof(VK_DrawCallInfo));
+      vk->CmdDrawIndirect(cmd, vk->indirect_draw_buffer.h, draw_call_mem_offset, per_shader_draw_count, sizeof(VK_DrawCallInfo));
     }
     draw_call_mem_offset = draw_call_count * sizeof(VK_DrawCallInfo);
 
     /////////////////////////////////
     // Rebuilding static buffer
-    if ((batch.static_entities_count_old != batch.static_entities_count) || (batch.static_entities_indexed_count_old != batch.static_entities_indexed_count)) {
+    if ((batch.static_entities_count_old != batch.static_entities_count) || (batch.static_entities_indexed_count_old != batch.static_entities_indexed_count) ||
+        (vk->static_dirty && (batch.static_entities_count || batch.static_entities_indexed_count))) {
       batch.static_entities_indexed_count_old = batch.static_entities_indexed_count;
       batch.static_entities_count_old = batch.static_entities_count;
 
       u32 static_draw_call_count = 0;
       u32 static_entities_draw_count = 0;
+      vk->static_triangles_drawn = 0;
       u32 static_entities_draw_id_offset = 0;
 
-      // Indexed Entities per shader
+      // Indexed Entities per shader, packed meshes first
       u32 per_shader_static_indexed_draw_count = 0;
-      for (VK_MeshBatch mesh_batch : batch.static_batch_indexed.mesh_batches) {
-        if (mesh_batch.entities.count == 0) continue;
-        for (Handle<StaticEntity> entity_handle : mesh_batch.entities) {
-          u32 entity_idx = entity_handle.idx();
-          vk->gpu_entities[MaxEntities+entity_idx].model = mat4_transform(entity_handle.trans());
-          vk->gpu_entities_indexes[MaxEntities+static_entities_draw_count++] = MaxEntities+entity_idx;
+      Loop (pass, 2) {
+        b32 packed = pass == 0;
+        for (VK_MeshBatch mesh_batch : batch.static_batch_indexed.mesh_batches) {
+          if (mesh_batch.entities.count == 0) continue;
+          u32 mesh_idx = mesh_batch.mesh_handle.handle;
+          VK_Mesh mesh = vk->meshes[mesh_idx];
+          if (mesh.packed != packed) continue;
+          Loop (lod, mesh.lod_count) {
+            u32 instances = 0;
+            for (Handle<StaticEntity> entity_handle : mesh_batch.entities) {
+              u32 entity_idx = entity_handle.idx();
+              if (vk->static_lods[entity_idx] != lod) continue;
+              vk->gpu_entities[MaxEntities+entity_idx].model = mat4_transform(entity_handle.trans());
+              vk->gpu_entities_indexes[MaxEntities+static_entities_draw_count++] = MaxEntities+entity_idx;
+              instances++;
+            }
+            if (instances == 0) continue;
+            VK_DrawCallInfo info = vk_draw_call_indexed(mesh, lod, instances, MaxEntities+static_entities_draw_id_offset);
+            vk->gpu_draw_call_infos[MaxDrawCalls+static_draw_call_count++] = info;
+            static_entities_draw_id_offset += instances;
+            vk->static_triangles_drawn += (u64)mesh.lods[lod].index_count / 3 * instances;
+            ++per_shader_static_indexed_draw_count;
+          }
         }
-        u32 mesh_idx = mesh_batch.mesh_handle.handle;
-        VK_Mesh mesh = vk->meshes[mesh_idx];
-        VK_DrawCallInfo info = {
-          .index_draw_command = {
-            .indexCount = (u32)mesh.index_count,
-            .instanceCount = mesh_batch.entities.count,
-            .firstIndex = (u32)(mesh.index_offset/sizeof(u32)),
-            .vertexOffset = (i32)(mesh.vert_offset/sizeof(Vertex)),
-            .firstInstance = 0,
-          },
-          .entities_offset_id = MaxEntities+static_entities_draw_id_offset,
-        };
-        vk->gpu_draw_call_infos[MaxDrawCalls+static_draw_call_count++] = info;
-        static_entities_draw_id_offset += mesh_batch.entities.count;
-        ++per_shader_static_indexed_draw_count;
+        if (packed) vk->static_packed_draw_count = per_shader_static_indexed_draw_count;
       }
       vk->static_draw_indexed_offset = MaxDrawCalls*sizeof(VK_DrawCallInfo);
       vk->static_draw_offset = vk->static_draw_indexed_offset + per_shader_static_indexed_draw_count*sizeof(VK_DrawCallInfo);
@@ -2630,6 +2821,7 @@ void vk_draw() {
         };
         vk->gpu_draw_call_infos[MaxDrawCalls+static_draw_call_count++] = info;
         static_entities_draw_id_offset += mesh_batch.entities.count;
+        vk->static_triangles_drawn += (u64)mesh.vert_count / 3 * mesh_batch.entities.count;
         ++per_shader_static_draw_count;
       }
 
@@ -2637,9 +2829,21 @@ void vk_draw() {
       vk->static_draw_count = per_shader_static_draw_count;
     }
     if (batch.static_entities_indexed_count) {
-      VK_PushConstant push = {MaxDrawCalls};
-      vk->CmdPushConstants(cmd, vk->pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(VK_PushConstant), &push);
-      vk->CmdDrawIndexedIndirect(cmd, vk->indirect_draw_buffer.h, vk->static_draw_indexed_offset, vk->static_indexed_draw_count, sizeof(VK_DrawCallInfo));
+      u32 packed_count = vk->static_packed_draw_count;
+      u32 full_count = vk->static_indexed_draw_count - packed_count;
+      if (packed_count) {
+        vk_draw_bind(cmd, i, true);
+        VK_PushConstant push = {MaxDrawCalls};
+        vk->CmdPushConstants(cmd, vk->pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(VK_PushConstant), &push);
+        vk->CmdDrawIndexedIndirect(cmd, vk->indirect_draw_buffer.h, vk->static_draw_indexed_offset, packed_count, sizeof(VK_DrawCallInfo));
+      }
+      vk_draw_bind(cmd, i, false);
+      if (full_count) {
+        VK_PushConstant push = {MaxDrawCalls+packed_count};
+        vk->CmdPushConstants(cmd, vk->pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(VK_PushConstant), &push);
+        vk->CmdDrawIndexedIndirect(cmd, vk->indirect_draw_buffer.h, vk->static_draw_indexed_offset + packed_count*sizeof(VK_DrawCallInfo),
+                                   full_count, sizeof(VK_DrawCallInfo));
+      }
     }
     if (batch.static_entities_count) {
       VK_PushConstant push = {MaxDrawCalls+vk->static_indexed_draw_count};
@@ -2648,6 +2852,13 @@ void vk_draw() {
     }
   }
 
+  vk->static_dirty = false;
+  vk->triangles_drawn += vk->static_triangles_drawn;
+
+  // stays compiled in, LOG_LEVELS=vk=trace shows it
+  LogEvery(600, Vk, Trace, "draw: %u draw calls, %u entities, %u64 triangles, %u debug lines", draw_call_count, entities_draw_count,
+           vk->triangles_drawn, vk->draw_lines.count);
+
   // Debug drawing
   if (vk->draw_lines.count > 0) {
     vk->CmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, vk->debug_line_shader);
@@ -2660,10 +2871,11 @@ void vk_draw() {
   vk->CmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, vk->cubemap_shader);
   Handle<GpuMesh> h = mesh_get(Mesh_Cube);
   VK_Mesh mesh = vk->meshes[h.handle];
+  AssertMsg(!mesh.packed, "the cubemap pipeline reads full vertices");
   vk->CmdBindVertexBuffers(cmd, 0, 1, &vk->vert_buffer.h, &mesh.vert_offset);
   if (mesh.index_count) {
     vk->CmdBindIndexBuffer(cmd, vk->index_buffer.h, mesh.index_offset, VK_INDEX_TYPE_UINT32);
-    vk->CmdDrawIndexed(cmd, mesh.index_count, 1, 0, 0, 0);
+    vk->CmdDrawIndexed(cmd, mesh.lods[0].index_count, 1, 0, 0, 0);
   } else {
     vk->CmdDraw(cmd, mesh.vert_count, 1, 0, 0);
   }
@@ -2724,9 +2936,9 @@ intern void vk_instance_create() {
 
   // Validation layer
   required_validation_layer_names.add("VK_LAYER_KHRONOS_validation");
-  Debug("%Required layers:");
+  Log(Vk, Debug, "%Required layers:");
   for (const char* x : required_validation_layer_names) {
-    Debug(x);
+    Log(Vk, Debug, x);
   }
   u32 available_layer_count = 0;
   VK_CHECK(vk->EnumerateInstanceLayerProperties(&available_layer_count, null));
@@ -2737,7 +2949,7 @@ intern void vk_instance_create() {
     Loop (j, available_layer_count) {
       if (str_match(required_validation_layer_names[i], available_layers[j].layerName)) {
         found = true;
-        Info("Validation layer %s found", String(required_validation_layer_names[i]));
+        Log(Vk, Info, "Validation layer %s found", String(required_validation_layer_names[i]));
         break;
       }
     }
@@ -2746,9 +2958,9 @@ intern void vk_instance_create() {
 
   // Extensions
   required_extensions.add(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
-  Debug("Required extensions:");
+  Log(Vk, Debug, "Required extensions:");
   for (const char* x : required_extensions) {
-    Debug(x);
+    Log(Vk, Debug, x);
   }
   u32 extension_count = 0;
   vk->EnumerateInstanceExtensionProperties(null, &extension_count, null);
@@ -2759,7 +2971,7 @@ intern void vk_instance_create() {
     Loop (j, extension_count) {
       if (str_match(required_extensions[i], props[j].extensionName)) {
         found = true;
-        Info("extension %s found", String(required_extensions[i]));
+        Log(Vk, Info, "extension %s found", String(required_extensions[i]));
         break;
       }
     }
@@ -2777,7 +2989,7 @@ intern void vk_instance_create() {
   };
   
   VK_CHECK(vk->CreateInstance(&instance_create_info, vk->allocator, &vk->instance));
-  Info("Vulkan insance created");
+  Log(Vk, Info, "Vulkan insance created");
 
 #if BUILD_DEBUG
   VkDebugUtilsMessengerCreateInfoEXT debug_create_info = {
@@ -2797,16 +3009,16 @@ intern void vk_instance_create() {
       switch (message_severity) {
         default:break;
         case VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT: {
-          Trace(String(callback_data->pMessage));
+          Log(Vk, Trace, String(callback_data->pMessage));
         } break;
         case VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT: {
-          Info(String(callback_data->pMessage));
+          Log(Vk, Info, String(callback_data->pMessage));
         } break;
         case VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT: {
-          Warn(String(callback_data->pMessage));
+          Log(Vk, Warn, String(callback_data->pMessage));
         } break;
         case VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT: {
-          Error(String(callback_data->pMessage));
+          Log(Vk, Error, String(callback_data->pMessage));
         } break;
       }
       return false;
@@ -2818,7 +3030,7 @@ intern void vk_instance_create() {
   AssertMsg(func, "Failed to create debug messenger");
 
   VK_CHECK(func(vk->instance, &debug_create_info, vk->allocator, &vk->debug_messenger));
-  Debug("Vulkan debugger created");
+  Log(Vk, Debug, "Vulkan debugger created");
 #endif
 }
 
@@ -2836,10 +3048,11 @@ void* vk_init() {
   g.draw_vert_offsets.init(a);
   g.draw_vert_offsets.init(a);
   g.pipelines.init(a);
+  g.packed_pipelines.init(a);
   g.modules.init(a);
   g.batches.init(a);
   g.materials.init(a);
-  g.shader_to_pipeline.init(a);
+  g.shader_to_pipeline.init();
   g.shader_to_module.init(a);
   
 #if VulkanUseAllocator
@@ -2859,7 +3072,7 @@ void* vk_init() {
     vk->GetDeviceQueue(vkdevice, vk->device.present_queue_index, 0, &vk->device.present_queue);
     vk->GetDeviceQueue(vkdevice, vk->device.transfer_queue_index, 0, &vk->device.transfer_queue);
     vk->GetDeviceQueue(vkdevice, vk->device.compute_queue_index, 0, &vk->device.compute_queue);
-    Info("Queues obtained");
+    Log(Vk, Info, "Queues obtained");
     
     VkCommandPoolCreateInfo graphics_pool_create_info = {
       .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
@@ -2867,7 +3080,7 @@ void* vk_init() {
       .queueFamilyIndex = vk->device.graphics_queue_index,
     };
     VK_CHECK(vk->CreateCommandPool(vkdevice, &graphics_pool_create_info, vk->allocator, &vk->device.cmd_pool));
-    Info("Graphics command pool created");
+    Log(Vk, Info, "Graphics command pool created");
 
     v2u win_size = os_get_window_size();
     vk->width = win_size.x;
@@ -2877,7 +3090,7 @@ void* vk_init() {
     vk->frames_in_flight = vk->images_in_flight - 1;
     vk_swapchain_query();
     vk_swapchain_create(false);
-    Info("Swapchain created");
+    Log(Vk, Info, "Swapchain created");
   
     vk->cmds = push_array(vk->arena, VkCommandBuffer, vk->frames_in_flight);
     // vk->compute_cmds = push_array(vk->arena, VkCommandBuffer, vk->frames_in_flight);
@@ -2886,7 +3099,7 @@ void* vk_init() {
       // vk->compute_cmds[i] = vk_cmd_alloc(vk->device.cmd_pool);
     }
     vk->upload_cmd = vk_cmd_alloc(vk->device.cmd_pool);
-    Info("Command buffers created");
+    Log(Vk, Info, "Command buffers created");
   }
 
   // Sync
@@ -2917,6 +3130,7 @@ void* vk_init() {
     vk->gpu_mem = vk_mem_alloc(VK_MemType_Gpu, MB(10));
     vk->cpu_mem = vk_mem_alloc(VK_MemType_Cpu, MB(100));
     vk->vert_buffer = vk_buffer_make(MB(1), VK_BufferUsageFlag_Vert | VK_BufferUsageFlag_Dst, VK_MemType_Gpu);
+    vk->packed_vert_buffer = vk_buffer_make(MB(1), VK_BufferUsageFlag_Vert | VK_BufferUsageFlag_Dst, VK_MemType_Gpu);
     vk->index_buffer = vk_buffer_make(MB(1), VK_BufferUsageFlag_Index | VK_BufferUsageFlag_Dst, VK_MemType_Gpu);
     vk->stage_buffer = vk_buffer_make(MB(10), VK_BufferUsageFlag_Src, VK_MemType_Cpu);
     vk->storage_buffer = vk_buffer_make(MB(50), VK_BufferUsageFlag_Storage, VK_MemType_Cpu);
@@ -2991,7 +3205,7 @@ void* vk_init() {
   vk->draw_squares_offset = vk->vert_buffer.pos;
   vk->vert_buffer.pos += sizeof(Vertex)*KB(1);
 
-  Info("Vulkan renderer initialized");
+  Log(Vk, Info, "Vulkan renderer initialized");
   return vk;
 }
 
@@ -3008,6 +3222,7 @@ void vk_shutdown() {
 
   {
     vk->DestroyBuffer(vkdevice, vk->vert_buffer.h, vk->allocator);
+    vk->DestroyBuffer(vkdevice, vk->packed_vert_buffer.h, vk->allocator);
     vk->DestroyBuffer(vkdevice, vk->index_buffer.h, vk->allocator);
     vk->DestroyBuffer(vkdevice, vk->stage_buffer.h, vk->allocator);
     vk->DestroyBuffer(vkdevice, vk->storage_buffer.h, vk->allocator);
@@ -3017,25 +3232,25 @@ void vk_shutdown() {
   
   // Device
   {
-    Debug("Destroying Vulkan device...");
+    Log(Vk, Debug, "Destroying Vulkan device...");
     vk->DestroyCommandPool(vkdevice, vk->device.cmd_pool, vk->allocator);
     vk->DestroyCommandPool(vkdevice, vk->device.cmd_pool, vk->allocator);
     vk->DestroyDevice(vkdevice, vk->allocator);
   }
   
-  Info("Releasing physical device resources...");
+  Log(Vk, Info, "Releasing physical device resources...");
   
-  Debug("Destroying Vulkan surface...");
+  Log(Vk, Debug, "Destroying Vulkan surface...");
   vk->DestroySurfaceKHR(vk->instance, vk->surface, vk->allocator);
   
 #if BUILD_DEBUG
-  Debug("Destroying Vulkan debugger...");
+  Log(Vk, Debug, "Destroying Vulkan debugger...");
   PFN_vkDestroyDebugUtilsMessengerEXT func = null;
   Assign(func, vk->GetInstanceProcAddr(vk->instance, "vkDestroyDebugUtilsMessengerEXT"));
   func(vk->instance, vk->debug_messenger, vk->allocator);
 #endif
 
-  Debug("Destroying Vulkan instance...");
+  Log(Vk, Debug, "Destroying Vulkan instance...");
   vk->DestroyInstance(vk->instance, vk->allocator);
 }
 
@@ -3305,8 +3520,8 @@ void vk_end_draw_frame() {
 void vk_make_renderable(Handle<Entity> entity_handle, Handle<GpuMesh> mesh_handle, Handle<GpuMaterial> material_handle) {
   VK_State& g = *vk;
   u32 entity_idx = entity_handle.idx();
-  Assert(!vk->entities[entity_idx].is_init);
-  DebugDo(vk->entities[entity_idx].is_init = true);
+  Assert(!vk->entities_renderable.has(entity_idx));
+  DebugDo(vk->entities_renderable.set(entity_idx));
   u32 material_idx = material_handle.idx();
   u32 pipeline_idx = vk->materials[material_idx].pipeline_idx;
   u32 mesh_idx = mesh_handle.idx();
@@ -3349,8 +3564,8 @@ void vk_make_renderable(Handle<Entity> entity_handle, Handle<GpuMesh> mesh_handl
 void vk_make_renderable_static(Handle<StaticEntity> entity_handle, Handle<GpuMesh> mesh_handle, Handle<GpuMaterial> material_handle) {
   VK_State& g = *vk;
   u32 entity_idx = entity_handle.idx() + MaxEntities;
-  Assert(!vk->entities[entity_idx].is_init);
-  DebugDo(vk->entities[entity_idx].is_init = true);
+  Assert(!vk->entities_renderable.has(entity_idx));
+  DebugDo(vk->entities_renderable.set(entity_idx));
   u32 material_idx = material_handle.idx();
   u32 pipeline_idx = vk->materials[material_idx].pipeline_idx;
   u32 mesh_idx = mesh_handle.handle;
@@ -3389,12 +3604,13 @@ void vk_make_renderable_static(Handle<StaticEntity> entity_handle, Handle<GpuMes
   }
   // vk->entities[entity_idx].shader_handle = vk->shaders[shader_idx].entities.add(entity_handle);
   vk->gpu_entities[entity_idx].material = material_handle.idx();
+  vk->static_dirty = true;
 }
 
 void vk_remove_renderable(Handle<Entity> entity_handle) {
   u32 entity_idx = entity_handle.idx();
-  Assert(vk->entities[entity_idx].is_init == true);
-  DebugDo(vk->entities[entity_idx].is_init = false);
+  Assert(vk->entities_renderable.has(entity_idx));
+  DebugDo(vk->entities_renderable.clear(entity_idx));
   u32 pipeline_idx = vk->entities[entity_idx].pipeline;
   u32 mesh_idx = vk->entities[entity_idx].mesh.handle;
   VK_Mesh mesh = vk->meshes[mesh_idx];
@@ -3435,6 +3651,7 @@ GlobalStateGPU* vk_get_shader_state() { return (GlobalStateGPU*)vk->storage_buff
 
 mat4& vk_get_view() { return vk->view; }
 mat4& vk_get_projection() { return vk->projection; };
+u64 vk_triangles_drawn() { return vk->triangles_drawn; }
 
 void vk_draw_line(v3 a, v3 b, v3 color) {
   Vertex vert[] = {
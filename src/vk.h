@@ -9,6 +9,21 @@ Handle<GpuTexture> vk_texture_load(Texture texture);
 Handle<GpuMaterial> vk_material_load(Material material);
 Handle<GpuCubemap> vk_cubemap_load(Texture* textures);
 Handle<GpuMesh> vk_mesh_load(Mesh mesh);
+Handle<GpuMesh> vk_mesh_placeholder(Handle<GpuMesh> placeholder);
+void vk_mesh_replace(Handle<GpuMesh> handle, Mesh mesh);
+Handle<GpuTexture> vk_texture_placeholder(Handle<GpuTexture> placeholder);
+void vk_texture_replace(Handle<GpuTexture> handle, Texture texture);
+// for checks that load real assets, release drops every mesh and texture slot taken after the
+// mark and the geometry uploaded for them
+struct VK_AssetMark {
+  u32 mesh_count;
+  u32 texture_count;
+  u64 vert_pos;
+  u64 packed_vert_pos;
+  u64 index_pos;
+};
+VK_AssetMark vk_asset_mark();
+void vk_asset_release(VK_AssetMark mark);
 
 void vk_shader_reload(String name);
 
@@ -22,6 +37,8 @@ void vk_set_entity_color(Handle<Entity> entity_handle, v4 color);
 
 mat4& vk_get_view();
 mat4& vk_get_projection();
+// submitted in the last vk_draw, every instance at the lod it was drawn with
+u64 vk_triangles_drawn();
 void vk_draw_line(v3 a, v3 b, v3 color);
 void vk_draw_aabb(v3 min, v3 max, v3 color);
 void vk_draw_quad(v2 min, v2 max, v3 color);